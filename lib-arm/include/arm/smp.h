@@ -36,6 +36,22 @@ extern void _init_core(void);
 
 extern uint32_t smp_get_core_number(void);
 #if defined (ARM_ALLOW_MULTI_CORE)
-extern void smp_start_core(uint32_t, start_fn_t);
+#include <stdbool.h>
+
+#define SMP_START_TIMEOUT_US	(100 * 1000)	///< A core not started within this time is not used
+
+extern bool smp_start_core(uint32_t, start_fn_t);
+#endif
+
+#if defined (H3) && defined (ARM_ALLOW_MULTI_CORE)
+
+#define SMP_IPI_WAKEUP			0			///< SGI used to wake up a core from WFI
+#define SMP_RUN_QUEUE_SIZE		16			///< Entries per core, power of 2
+
+typedef void (*smp_work_fn_t)(void *);
+
+extern void smp_send_ipi(uint32_t, uint32_t);
+extern bool smp_queue_work(uint32_t, smp_work_fn_t, void *);
+extern void smp_run_queue(void);
 #endif
 #endif /* SMP_H_ */
@@ -0,0 +1,118 @@
+/**
+ * @file spsc.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef SPSC_H_
+#define SPSC_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "arm/synchronize.h"
+
+/*
+ * Single producer, single consumer queue of pointers, lock-free.
+ * The producer and the consumer can run on different cores.
+ * The size must be a power of 2.
+ */
+
+struct spsc_queue {
+	volatile uint32_t head __attribute__ ((aligned (64)));	///< Written by the producer only
+	volatile uint32_t tail __attribute__ ((aligned (64)));	///< Written by the consumer only
+	uint32_t mask __attribute__ ((aligned (64)));
+	void **entries;
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+inline static void spsc_init(struct spsc_queue *q, void **entries, uint32_t size) {
+	q->head = 0;
+	q->tail = 0;
+	q->mask = size - 1;
+	q->entries = entries;
+	dmb();
+}
+
+inline static bool spsc_is_full(const struct spsc_queue *q) {
+	return (q->head - q->tail) > q->mask;
+}
+
+inline static bool spsc_is_empty(const struct spsc_queue *q) {
+	return q->head == q->tail;
+}
+
+inline static bool spsc_push(struct spsc_queue *q, void *p) {
+	const uint32_t head = q->head;
+
+	if ((head - q->tail) > q->mask) {
+		return false;
+	}
+
+	q->entries[head & q->mask] = p;
+	dmb();	// The entry must be visible before the new head
+	q->head = head + 1;
+
+	return true;
+}
+
+inline static void *spsc_pop(struct spsc_queue *q) {
+	const uint32_t tail = q->tail;
+
+	if (tail == q->head) {
+		return 0;
+	}
+
+	dmb();	// Read the entry after the head
+	void *p = q->entries[tail & q->mask];
+	dmb();	// The entry must be read before the slot is given back
+	q->tail = tail + 1;
+
+	return p;
+}
+
+/*
+ * The oldest entry stays in the queue, the producer cannot reuse its slot until spsc_release.
+ */
+inline static void *spsc_peek(const struct spsc_queue *q) {
+	if (q->tail == q->head) {
+		return 0;
+	}
+
+	dmb();	// Read the entry after the head
+	return q->entries[q->tail & q->mask];
+}
+
+inline static void spsc_release(struct spsc_queue *q) {
+	dmb();	// Everything read from the entry must be read before the slot is given back
+	q->tail = q->tail + 1;
+}
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SPSC_H_ */
@@ -107,6 +107,15 @@ enum {
 	ARTNET_UDP_PORT = 0x1936
 };
 
+/**
+ * Receive queue depth, a burst of universes from one controller must fit.
+ * At most ARTNET_RECV_BATCH packets are handled in one Run.
+ */
+enum {
+	ARTNET_RECV_QUEUE_DEPTH = 32,
+	ARTNET_RECV_BATCH = 8
+};
+
 /**
  * Table 4 – Style Codes
  * The Style code defines the general functionality of a Controller.
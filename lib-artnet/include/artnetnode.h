@@ -42,6 +42,7 @@
 #include "packets.h"
 
 #include "lightset.h"
+#include "universeindex.h"
 #include "ledblink.h"
 
 #include "artnettimecode.h"
@@ -144,10 +145,24 @@ struct TOutputPort {
 	TPortProtocol tPortProtocol;		///< Art-Net 4
 };
 
+enum {
+	ARTNET_MAX_SUBSCRIBERS = 8	///< Per input port. When more controllers subscribe, the input port falls back to broadcast.
+};
+
+struct TArtNetSubscriber {
+	uint32_t nIp;				///< The controller listening to the Port-Address, 0 = free
+	time_t nTime;				///< The latest time of the ArtPollReply received from this controller
+};
+
 struct TInputPort {
 	bool bIsEnabled;
 	TGenericPort port;
 	uint8_t nSequence;
+	uint8_t data[ARTNET_DMX_LENGTH];	///< Data sent
+	uint16_t nLength;					///< Length of sent DMX data
+	uint32_t nMillis;					///< The latest time an ArtDmx was sent
+	time_t nOverflowTime;				///< The latest time the subscribers table was full
+	struct TArtNetSubscriber subscribers[ARTNET_MAX_SUBSCRIBERS];
 };
 
 class ArtNetNode {
@@ -230,6 +245,13 @@ public:
 		return m_State.nNetworkDataLossTimeout;
 	}
 
+	void SetDmxInRefresh(uint32_t nMillis) {
+		m_nDmxInRefreshMillis = nMillis;
+	}
+	uint32_t GetDmxInRefresh(void) {
+		return m_nDmxInRefreshMillis;
+	}
+
 	void SetDisableMergeTimeout(bool);
 	bool GetDisableMergeTimeout(void) {
 		return m_State.bDisableMergeTimeout;
@@ -269,6 +291,7 @@ private:
 #endif
 
 	void GetType(void);
+	void HandlePacket(void);
 
 	void HandlePoll(void);
 	void HandleDmx(void);
@@ -281,7 +304,13 @@ private:
 	void HandleRdm(void);
 	void HandleIpProg(void);
 	//void HandleDirectory(void);
+	void HandlePollReply(void);
 	void HandleDmxIn(void);
+	void SendDmxIn(uint8_t);
+	void AddSubscriber(uint8_t, uint32_t);
+	void RunDiscovery(void);
+
+	void UpdatePortIndex(void);
 
 	uint16_t MakePortAddress(uint16_t, uint8_t nPage = 0);
 
@@ -313,7 +342,7 @@ private:
 	struct TArtNetNode m_Node;				///< Struct describing the node
 	struct TArtNetNodeState m_State;		///< The current state of the node
 
-	struct TArtNetPacket m_ArtNetPacket;	///< The received Art-Net package
+	struct TArtNetPacketRef m_ArtNetPacket;	///< The received Art-Net package
 	struct TArtPollReply m_PollReply;
 #if defined ( ENABLE_SENDDIAG )
 	struct TArtDiagData m_DiagData;
@@ -323,6 +352,7 @@ private:
 	struct TArtIpProgReply *m_pIpProgReply;
 
 	struct TOutputPort m_OutputPorts[ARTNET_MAX_PORTS * ARTNET_MAX_PAGES];
+	UniverseIndex m_PortIndex;	///< PortAddress -> enabled Art-Net output ports
 	struct TInputPort m_InputPorts[ARTNET_MAX_PORTS];
 
 	bool m_bDirectUpdate;
@@ -333,11 +363,13 @@ private:
 
 	bool m_IsLightSetRunning[ARTNET_MAX_PORTS * ARTNET_MAX_PAGES];
 	bool m_IsRdmResponder;
+	uint8_t m_nDiscoveryPorts;	///< Bit mask of the ports with a discovery in progress
 
 	alignas(uint32_t) char m_aSysName[16];
 	alignas(uint32_t) char m_aDefaultNodeLongName[ARTNET_LONG_NAME_LENGTH];
 
 	uint32_t m_nDestinationIp;
+	uint32_t m_nDmxInRefreshMillis;
 };
 
 #endif /* ARTNETNODE_H_ */
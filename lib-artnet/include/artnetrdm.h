@@ -40,6 +40,18 @@ public:
 	virtual void Copy(uint8_t nPort, uint8_t *)=0;
 
 	virtual const uint8_t *Handler(uint8_t nPort, const uint8_t *)=0;
+
+	/**
+	 * Non-blocking discovery, advanced from ArtNetNode::Run.
+	 * DiscoveryRun returns false when the TOD is complete.
+	 * The default falls back to the blocking Full().
+	 */
+	virtual void DiscoveryStart(uint8_t nPort, bool bInterleaveDmx) {
+		Full(nPort);
+	}
+	virtual bool DiscoveryRun(uint8_t nPort) {
+		return false;
+	}
 };
 
 #endif /* ARTNETRDM_H_ */
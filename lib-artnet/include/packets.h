@@ -463,4 +463,15 @@ struct TArtNetPacket {
 	union UArtPacket ArtPacket;		///<
 };
 
+/**
+ * As TArtNetPacket, the packet data is referenced in the network receive buffer (zero-copy)
+ */
+struct TArtNetPacketRef {
+	int length;						///<
+	uint32_t IPAddressFrom;			///<
+	uint32_t IPAddressTo;			///<
+	TOpCodes OpCode;				///<
+	union UArtPacket *pArtPacket;	///<
+};
+
 #endif /* PACKETS_H_ */
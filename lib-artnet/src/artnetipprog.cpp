@@ -65,7 +65,7 @@ void ArtNetNode::SetIpProgHandler(ArtNetIpProg *pArtNetIpProg) {
 }
 
 void ArtNetNode::HandleIpProg(void) {
-	struct TArtIpProg *packet = (struct TArtIpProg *) &(m_ArtNetPacket.ArtPacket.ArtIpProg);
+	struct TArtIpProg *packet = (struct TArtIpProg *) &(m_ArtNetPacket.pArtPacket->ArtIpProg);
 
 	m_pArtNetIpProg->Handler((const TArtNetIpProg *) &packet->Command, (TArtNetIpProgReply *) &m_pIpProgReply->ProgIpHi);
 
@@ -36,6 +36,7 @@
 #include "packets.h"
 
 #include "lightset.h"
+#include "lightsetdata.h"
 
 #include "artnetrdm.h"
 #include "artnettimecode.h"
@@ -60,10 +61,6 @@ union uip {
  #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
-#ifndef MAX
- #define MAX(a, b) ((a) > (b) ? (a) : (b))
-#endif
-
 #define NODE_DEFAULT_SHORT_NAME		"AvV Art-Net Node"
 #define NODE_DEFAULT_NET_SWITCH		0
 #define NODE_DEFAULT_SUBNET_SWITCH	0
@@ -78,6 +75,8 @@ static const uint8_t DEVICE_OEM_VALUE[] = { 0x20, 0xE0 };
 
 #define NETWORK_DATA_LOSS_TIMEOUT		10	///< Seconds
 
+#define DMX_IN_REFRESH_MILLIS			1000	///< Art-Net 4 : keep-alive when the input data does not change
+
 #define PORT_IN_STATUS_DISABLED_MASK	0x08
 
 ArtNetNode::ArtNetNode(uint8_t nVersion, uint8_t nPages) :
@@ -100,7 +99,9 @@ ArtNetNode::ArtNetNode(uint8_t nVersion, uint8_t nPages) :
 	m_nCurrentPacketTime(0),
 	m_nPreviousPacketTime(0),
 	m_IsRdmResponder(false),
-	m_nDestinationIp(0)
+	m_nDiscoveryPorts(0),
+	m_nDestinationIp(0),
+	m_nDmxInRefreshMillis(DMX_IN_REFRESH_MILLIS)
 {
 	assert(Hardware::Get() != 0);
 	assert(Network::Get() != 0);
@@ -174,7 +175,7 @@ void ArtNetNode::Start(void) {
 	FillDiagData();
 #endif
 
-	m_nHandle = Network::Get()->Begin(ARTNET_UDP_PORT);
+	m_nHandle = Network::Get()->BeginDepth(ARTNET_UDP_PORT, ARTNET_RECV_QUEUE_DEPTH);
 	assert(m_nHandle != -1);
 
 	m_State.status = ARTNET_ON;
@@ -227,6 +228,7 @@ int ArtNetNode::SetUniverseSwitch(uint8_t nPortIndex, TArtNetPortDir dir, uint8_
 			m_InputPorts[nPortIndex].bIsEnabled = false;
 			m_State.nActiveInputPorts = m_State.nActiveInputPorts - 1;
 		}
+		UpdatePortIndex();
 		return ARTNET_EOK;
 	}
 
@@ -238,6 +240,9 @@ int ArtNetNode::SetUniverseSwitch(uint8_t nPortIndex, TArtNetPortDir dir, uint8_
 		m_InputPorts[nPortIndex].bIsEnabled = true;
 		m_InputPorts[nPortIndex].port.nDefaultAddress = nAddress & (uint16_t) 0x0F;// Universe : Bits 3-0
 		m_InputPorts[nPortIndex].port.nPortAddress = MakePortAddress((uint16_t) nAddress, (nPortIndex / ARTNET_MAX_PORTS));
+		m_InputPorts[nPortIndex].nLength = 0;
+		m_InputPorts[nPortIndex].nOverflowTime = 0;
+		memset(m_InputPorts[nPortIndex].subscribers, 0, sizeof(m_InputPorts[nPortIndex].subscribers));
 
 		if (m_OutputPorts[nPortIndex].bIsEnabled) {
 			m_OutputPorts[nPortIndex].bIsEnabled = false;
@@ -260,6 +265,8 @@ int ArtNetNode::SetUniverseSwitch(uint8_t nPortIndex, TArtNetPortDir dir, uint8_
 		}
 	}
 
+	UpdatePortIndex();
+
 	if ((m_pArtNet4Handler != 0) && (m_State.status != ARTNET_ON)) {
 		m_pArtNet4Handler->SetPort(nPortIndex, dir);
 	}
@@ -303,6 +310,8 @@ void ArtNetNode::SetSubnetSwitch(uint8_t nAddress, uint8_t nPage) {
 		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress, (i / ARTNET_MAX_PORTS));
 	}
 
+	UpdatePortIndex();
+
 	if ((m_pArtNetStore != 0) && (m_State.status == ARTNET_ON)) {
 		if (nPage == 0) {
 			m_pArtNetStore->SaveSubnetSwitch(nAddress);
@@ -327,6 +336,8 @@ void ArtNetNode::SetNetSwitch(uint8_t nAddress, uint8_t nPage) {
 		m_OutputPorts[i].port.nPortAddress = MakePortAddress(m_OutputPorts[i].port.nPortAddress, (i / ARTNET_MAX_PORTS));
 	}
 
+	UpdatePortIndex();
+
 	if ((m_pArtNetStore != 0) && (m_State.status == ARTNET_ON)) {
 		if (nPage == 0) {
 			m_pArtNetStore->SaveNetSwitch(nAddress);
@@ -355,6 +366,16 @@ bool ArtNetNode::GetPortAddress(uint8_t nPortIndex, uint16_t &nAddress, TArtNetP
 	return m_OutputPorts[nPortIndex].bIsEnabled;
 }
 
+void ArtNetNode::UpdatePortIndex(void) {
+	m_PortIndex.Clear();
+
+	for (uint32_t i = 0; i < (ARTNET_MAX_PORTS * m_nPages); i++) {
+		if (m_OutputPorts[i].bIsEnabled && (m_OutputPorts[i].tPortProtocol == PORT_ARTNET_ARTNET)) {
+			m_PortIndex.Add(m_OutputPorts[i].port.nPortAddress, i);
+		}
+	}
+}
+
 uint16_t ArtNetNode::MakePortAddress(uint16_t nCurrentAddress, uint8_t nPage) {
 	// PortAddress Bit 15 = 0
 	uint16_t newAddress = (m_Node.NetSwitch[nPage] & 0x7F) << 8;	// Net : Bits 14-8
@@ -399,6 +420,8 @@ void ArtNetNode::SetPortProtocol(uint8_t nPortIndex, TPortProtocol tPortProtocol
 
 		m_OutputPorts[nPortIndex].tPortProtocol = tPortProtocol;
 
+		UpdatePortIndex();
+
 		if (tPortProtocol == PORT_ARTNET_SACN) {
 			m_OutputPorts[nPortIndex].port.nStatus |= GO_OUTPUT_IS_SACN;
 		} else {
@@ -557,6 +580,7 @@ void ArtNetNode::SendPollRelply(bool bResponse) {
 
 					if ((nStatus & GO_OUTPUT_IS_SACN) == 0) {
 						m_OutputPorts[nPortIndex].tPortProtocol = PORT_ARTNET_ARTNET;
+						UpdatePortIndex();
 					}
 
 					m_OutputPorts[nPortIndex].port.nStatus = nStatus;
@@ -595,34 +619,16 @@ void ArtNetNode::SendPollRelply(bool bResponse) {
 }
 
 bool ArtNetNode::IsDmxDataChanged(uint8_t nPortId, const uint8_t *pData, uint16_t nLength) {
-	bool isChanged = false;
-
-	const uint8_t *src = (uint8_t *) pData;
-	uint8_t *dst = m_OutputPorts[nPortId].data;
-
 	if (nLength != m_OutputPorts[nPortId].nLength) {
 		m_OutputPorts[nPortId].nLength = nLength;
-
-		for (uint32_t i = 0; i < nLength; i++) {
-			*dst++ = *src++;
-		}
-
+		memcpy(m_OutputPorts[nPortId].data, pData, nLength);
 		return true;
 	}
 
-	for (uint32_t i = 0; i < nLength; i++) {
-		if (*dst != *src) {
-			isChanged = true;
-		}
-		*dst++ = *src++;
-	}
-
-	return isChanged;
+	return LightSetData::Copy(m_OutputPorts[nPortId].data, pData, nLength);
 }
 
 bool ArtNetNode::IsMergedDmxDataChanged(uint8_t nPortId, const uint8_t *pData, uint16_t nLength) {
-	bool isChanged = false;
-
 	if (!m_State.IsMergeMode) {
 		m_State.IsMergeMode = true;
 		m_State.IsChanged = true;
@@ -630,26 +636,14 @@ bool ArtNetNode::IsMergedDmxDataChanged(uint8_t nPortId, const uint8_t *pData, u
 
 	m_OutputPorts[nPortId].port.nStatus |= GO_OUTPUT_IS_MERGING;
 
-
 	if (m_OutputPorts[nPortId].mergeMode == ARTNET_MERGE_HTP) {
+		const bool isChanged = LightSetData::MergeHtp(m_OutputPorts[nPortId].data, m_OutputPorts[nPortId].dataA, m_OutputPorts[nPortId].dataB, nLength);
 
 		if (nLength != m_OutputPorts[nPortId].nLength) {
 			m_OutputPorts[nPortId].nLength = nLength;
-			for (uint32_t i = 0; i < nLength; i++) {
-				uint8_t data = MAX(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-				m_OutputPorts[nPortId].data[i] = data;
-			}
 			return true;
 		}
 
-		for (uint32_t i = 0; i < nLength; i++) {
-			uint8_t data = MAX(m_OutputPorts[nPortId].dataA[i], m_OutputPorts[nPortId].dataB[i]);
-			if (data != m_OutputPorts[nPortId].data[i]) {
-				m_OutputPorts[nPortId].data[i] = data;
-				isChanged = true;
-			}
-		}
-
 		return isChanged;
 	} else {
 		return IsDmxDataChanged(nPortId, pData, nLength);
@@ -686,7 +680,7 @@ void ArtNetNode::CheckMergeTimeouts(uint8_t nPortId) {
 }
 
 void ArtNetNode::HandlePoll(void) {
-	const struct TArtPoll *packet = (struct TArtPoll *)&(m_ArtNetPacket.ArtPacket.ArtPoll);
+	const struct TArtPoll *packet = (struct TArtPoll *)&(m_ArtNetPacket.pArtPacket->ArtPoll);
 
 	if (packet->TalkToMe & TTM_SEND_ARTP_ON_CHANGE) {
 		m_State.SendArtPollReplyOnChange = true;
@@ -728,123 +722,124 @@ void ArtNetNode::HandlePoll(void) {
 }
 
 void ArtNetNode::HandleDmx(void) {
-	const struct TArtDmx *packet = (struct TArtDmx *)&(m_ArtNetPacket.ArtPacket.ArtDmx);
+	const struct TArtDmx *packet = (struct TArtDmx *)&(m_ArtNetPacket.pArtPacket->ArtDmx);
 
 	uint32_t data_length = (uint32_t) ((packet->LengthHi << 8) & 0xff00) | (packet->Length);
 	data_length = MIN(data_length, ARTNET_DMX_LENGTH);
 
-	for (uint32_t i = 0; i < (ARTNET_MAX_PORTS * m_nPages); i++) {
+	uint32_t nPortMask = m_PortIndex.Lookup(packet->PortAddress);
 
-		if (m_OutputPorts[i].bIsEnabled && (m_OutputPorts[i].tPortProtocol == PORT_ARTNET_ARTNET) && (packet->PortAddress == m_OutputPorts[i].port.nPortAddress)) {
+	while (nPortMask != 0) {
+		const uint32_t i = __builtin_ctz(nPortMask);
+		nPortMask &= (nPortMask - 1);
 
-			uint32_t ipA = m_OutputPorts[i].ipA;
-			uint32_t ipB = m_OutputPorts[i].ipB;
+		uint32_t ipA = m_OutputPorts[i].ipA;
+		uint32_t ipB = m_OutputPorts[i].ipB;
 
-			bool sendNewData = false;
+		bool sendNewData = false;
 
-			m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus | GO_DATA_IS_BEING_TRANSMITTED;
+		m_OutputPorts[i].port.nStatus = m_OutputPorts[i].port.nStatus | GO_DATA_IS_BEING_TRANSMITTED;
 
-			if (m_State.IsMergeMode) {
-				if (__builtin_expect((!m_State.bDisableMergeTimeout), 1)) {
-					CheckMergeTimeouts(i);
-				}
+		if (m_State.IsMergeMode) {
+			if (__builtin_expect((!m_State.bDisableMergeTimeout), 1)) {
+				CheckMergeTimeouts(i);
 			}
+		}
 
-			if (ipA == 0 && ipB == 0) {
+		if (ipA == 0 && ipB == 0) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("1. first packet recv on this port", ARTNET_DP_LOW);
+			SendDiag("1. first packet recv on this port", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == 0) {
+			m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
+			m_OutputPorts[i].timeA = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
+			sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+		} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == 0) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("2. continued transmission from the same ip (source A)", ARTNET_DP_LOW);
+			SendDiag("2. continued transmission from the same ip (source A)", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA == 0 && ipB == m_ArtNetPacket.IPAddressFrom) {
+			m_OutputPorts[i].timeA = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
+			sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+		} else if (ipA == 0 && ipB == m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("3. continued transmission from the same ip (source B)", ARTNET_DP_LOW);
+			SendDiag("3. continued transmission from the same ip (source B)", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == 0) {
+			m_OutputPorts[i].timeB = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
+			sendNewData = IsDmxDataChanged(i, packet->Data, data_length);
+		} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == 0) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("4. new source, start the merge", ARTNET_DP_LOW);
+			SendDiag("4. new source, start the merge", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipB = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-			} else if (ipA == 0 && ipB != m_ArtNetPacket.IPAddressFrom) {
+			m_OutputPorts[i].ipB = m_ArtNetPacket.IPAddressFrom;
+			m_OutputPorts[i].timeB = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
+			sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
+		} else if (ipA == 0 && ipB != m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("5. new source, start the merge", ARTNET_DP_LOW);
+			SendDiag("5. new source, start the merge", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
+			m_OutputPorts[i].ipA = m_ArtNetPacket.IPAddressFrom;
+			m_OutputPorts[i].timeA = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
+			sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
+		} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("6. continue merge", ARTNET_DP_LOW);
+			SendDiag("6. continue merge", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeA = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
+			m_OutputPorts[i].timeA = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataA, packet->Data, data_length);
+			sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataA, data_length);
+		} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("7. continue merge", ARTNET_DP_LOW);
+			SendDiag("7. continue merge", ARTNET_DP_LOW);
 #endif
-				m_OutputPorts[i].timeB = m_nCurrentPacketTime;
-				memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
-				sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
-			} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
+			m_OutputPorts[i].timeB = m_nCurrentPacketTime;
+			memcpy(&m_OutputPorts[i].dataB, packet->Data, data_length);
+			sendNewData = IsMergedDmxDataChanged(i, m_OutputPorts[i].dataB, data_length);
+		} else if (ipA == m_ArtNetPacket.IPAddressFrom && ipB == m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("8. Source matches both buffers, this shouldn't be happening!", ARTNET_DP_LOW);
+			SendDiag("8. Source matches both buffers, this shouldn't be happening!", ARTNET_DP_LOW);
 #endif
-				return;
-			} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
+			return;
+		} else if (ipA != m_ArtNetPacket.IPAddressFrom && ipB != m_ArtNetPacket.IPAddressFrom) {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("9. More than two sources, discarding data", ARTNET_DP_LOW);
+			SendDiag("9. More than two sources, discarding data", ARTNET_DP_LOW);
 #endif
-				return;
-			} else {
+			return;
+		} else {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("0. No cases matched, this shouldn't happen!", ARTNET_DP_LOW);
+			SendDiag("0. No cases matched, this shouldn't happen!", ARTNET_DP_LOW);
 #endif
-				return;
-			}
+			return;
+		}
 
-			if (sendNewData || m_bDirectUpdate) {
-				if (!m_State.IsSynchronousMode) {
+		if (sendNewData || m_bDirectUpdate) {
+			if (!m_State.IsSynchronousMode) {
 #if defined ( ENABLE_SENDDIAG )
-					SendDiag("Send new data", ARTNET_DP_LOW);
+				SendDiag("Send new data", ARTNET_DP_LOW);
 #endif
-					m_pLightSet->SetData(i, m_OutputPorts[i].data, m_OutputPorts[i].nLength);
+				m_pLightSet->SetData(i, m_OutputPorts[i].data, m_OutputPorts[i].nLength);
 
-					if(!m_IsLightSetRunning[i]) {
-						m_pLightSet->Start(i);
-						m_State.IsChanged |= (!m_IsLightSetRunning[i]);
-						m_IsLightSetRunning[i] = true;
-					}
-				} else {
-#if defined ( ENABLE_SENDDIAG )
-					SendDiag("DMX data pending", ARTNET_DP_LOW);
-#endif
-					m_OutputPorts[i].IsDataPending = sendNewData;
+				if(!m_IsLightSetRunning[i]) {
+					m_pLightSet->Start(i);
+					m_State.IsChanged |= (!m_IsLightSetRunning[i]);
+					m_IsLightSetRunning[i] = true;
 				}
 			} else {
 #if defined ( ENABLE_SENDDIAG )
-				SendDiag("Data not changed", ARTNET_DP_LOW);
+				SendDiag("DMX data pending", ARTNET_DP_LOW);
 #endif
+				m_OutputPorts[i].IsDataPending = sendNewData;
 			}
-
-			m_State.bIsReceivingDmx = true;
+		} else {
+#if defined ( ENABLE_SENDDIAG )
+			SendDiag("Data not changed", ARTNET_DP_LOW);
+#endif
 		}
+
+		m_State.bIsReceivingDmx = true;
 	}
 }
 
@@ -870,7 +865,7 @@ void ArtNetNode::HandleSync(void) {
 }
 
 void ArtNetNode::HandleAddress(void) {
-	const struct TArtAddress *packet = (struct TArtAddress *) &(m_ArtNetPacket.ArtPacket.ArtAddress);
+	const struct TArtAddress *packet = (struct TArtAddress *) &(m_ArtNetPacket.pArtPacket->ArtAddress);
 	uint8_t nPort = 0xFF;
 
 	m_State.reportCode = ARTNET_RCPOWEROK;
@@ -1012,64 +1007,31 @@ void ArtNetNode::SetNetworkDataLossCondition(void) {
 }
 
 void ArtNetNode::GetType(void) {
-	char *data = (char *) &(m_ArtNetPacket.ArtPacket);
+	char *data = (char *) m_ArtNetPacket.pArtPacket;
 
 	if (m_ArtNetPacket.length < ARTNET_MIN_HEADER_SIZE) {
 		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
 		return;
 	}
 
-	if ((data[10] != 0) || (data[11] != (char) ARTNET_PROTOCOL_REVISION)) {
+	if (memcmp(data, "Art-Net\0", 8) != 0) {
 		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
 		return;
 	}
 
-	if (memcmp(data, "Art-Net\0", 8) == 0) {
-		m_ArtNetPacket.OpCode = (TOpCodes) ((uint16_t) (data[9] << 8) + data[8]);
-	} else {
-		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
-	}
-}
-
-void ArtNetNode::Run(void) {
-	const char *packet = (char *) &(m_ArtNetPacket.ArtPacket);
-	uint16_t nForeignPort;
-
-	const int nBytesReceived = Network::Get()->RecvFrom(m_nHandle, (uint8_t *) packet, (uint16_t) sizeof(m_ArtNetPacket.ArtPacket), &m_ArtNetPacket.IPAddressFrom, &nForeignPort);
-
-	m_nCurrentPacketTime = Hardware::Get()->GetTime();
-
-	if (__builtin_expect((nBytesReceived == 0), 1)) {
-		if ((m_State.nNetworkDataLossTimeout != 0) && ((m_nCurrentPacketTime - m_nPreviousPacketTime) >= m_State.nNetworkDataLossTimeout)) {
-			SetNetworkDataLossCondition();
-		}
-
-		if (m_State.SendArtPollReplyOnChange) {
-			bool doSend = m_State.IsChanged;
-			if (m_pArtNet4Handler != 0) {
-				doSend |= m_pArtNet4Handler->IsStatusChanged();
-			}
-			if (doSend) {
-				SendPollRelply(false);
-			}
-		}
-
-		if ((m_nCurrentPacketTime - m_nPreviousPacketTime) >= 1) {
-			if (((m_Node.Status1 & STATUS1_INDICATOR_MASK) == STATUS1_INDICATOR_NORMAL_MODE)) {
-				LedBlink::Get()->SetMode(LEDBLINK_MODE_NORMAL);
-			}
-		}
-
-		if (m_pArtNetDmx != 0) {
-			HandleDmxIn();
-		}
+	m_ArtNetPacket.OpCode = (TOpCodes) ((uint16_t) (data[9] << 8) + data[8]);
 
+	// ArtPollReply has no protocol version, the IP address follows the OpCode
+	if (m_ArtNetPacket.OpCode == OP_POLLREPLY) {
 		return;
 	}
 
-	m_ArtNetPacket.length = nBytesReceived;
-	m_nPreviousPacketTime = m_nCurrentPacketTime;
+	if ((data[10] != 0) || (data[11] != (char) ARTNET_PROTOCOL_REVISION)) {
+		m_ArtNetPacket.OpCode = OP_NOT_DEFINED;
+	}
+}
 
+void ArtNetNode::HandlePacket(void) {
 	GetType();
 
 	if (m_State.IsSynchronousMode) {
@@ -1082,6 +1044,11 @@ void ArtNetNode::Run(void) {
 	case OP_POLL:
 		HandlePoll();
 		break;
+	case OP_POLLREPLY:
+		if ((m_pArtNetDmx != 0) && (m_State.nActiveInputPorts != 0)) {
+			HandlePollReply();
+		}
+		break;
 	case OP_DMX:
 		if (m_pLightSet != 0) {
 			HandleDmx();
@@ -1132,11 +1099,67 @@ void ArtNetNode::Run(void) {
 		//__builtin_unreachable ();
 		break;
 	}
+}
+
+void ArtNetNode::Run(void) {
+	struct TNetworkPacket aPackets[ARTNET_RECV_BATCH];
+
+	const uint32_t nPackets = Network::Get()->RecvMany(m_nHandle, aPackets, ARTNET_RECV_BATCH);
+
+	m_nCurrentPacketTime = Hardware::Get()->GetTime();
+
+	if (__builtin_expect((nPackets == 0), 1)) {
+		if ((m_State.nNetworkDataLossTimeout != 0) && ((m_nCurrentPacketTime - m_nPreviousPacketTime) >= m_State.nNetworkDataLossTimeout)) {
+			SetNetworkDataLossCondition();
+		}
+
+		if (m_State.SendArtPollReplyOnChange) {
+			bool doSend = m_State.IsChanged;
+			if (m_pArtNet4Handler != 0) {
+				doSend |= m_pArtNet4Handler->IsStatusChanged();
+			}
+			if (doSend) {
+				SendPollRelply(false);
+			}
+		}
+
+		if ((m_nCurrentPacketTime - m_nPreviousPacketTime) >= 1) {
+			if (((m_Node.Status1 & STATUS1_INDICATOR_MASK) == STATUS1_INDICATOR_NORMAL_MODE)) {
+				LedBlink::Get()->SetMode(LEDBLINK_MODE_NORMAL);
+			}
+		}
+
+		if (m_pArtNetDmx != 0) {
+			HandleDmxIn();
+		}
+
+		if (m_nDiscoveryPorts != 0) {
+			RunDiscovery();
+		}
+
+		return;
+	}
+
+	m_nPreviousPacketTime = m_nCurrentPacketTime;
+
+	for (uint32_t i = 0; i < nPackets; i++) {
+		m_ArtNetPacket.pArtPacket = (union UArtPacket *) aPackets[i].pData;
+		m_ArtNetPacket.length = aPackets[i].nSize;
+		m_ArtNetPacket.IPAddressFrom = aPackets[i].nFromIp;
+
+		HandlePacket();
+
+		Network::Get()->RecvRelease(m_nHandle);
+	}
 
 	if (m_pArtNetDmx != 0) {
 		HandleDmxIn();
 	}
 
+	if (m_nDiscoveryPorts != 0) {
+		RunDiscovery();
+	}
+
 	if (((m_Node.Status1 & STATUS1_INDICATOR_MASK) == STATUS1_INDICATOR_NORMAL_MODE)) {
 		if (m_State.bIsReceivingDmx) {
 			LedBlink::Get()->SetMode(LEDBLINK_MODE_DATA);
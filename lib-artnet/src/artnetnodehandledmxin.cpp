@@ -28,42 +28,185 @@
 
 #include <stdint.h>
 #include <string.h>
+#include <time.h>
 #include <assert.h>
 
 #include "artnetnode.h"
 #include "artnet.h"
 #include "artnetdmx.h"
 
+#include "hardware.h"
 #include "network.h"
 
 #include "debug.h"
 
-void ArtNetNode::HandleDmxIn(void) {
-	struct TArtDmx  artDmx;
-	uint16_t nLength;
+#define IP2STR(addr) (uint8_t)(addr & 0xFF), (uint8_t)((addr >> 8) & 0xFF), (uint8_t)((addr >> 16) & 0xFF), (uint8_t)((addr >> 24) & 0xFF)
+#define IPSTR "%d.%d.%d.%d"
+
+#define POLLREPLY_MIN_SIZE			207	///< Art-Net 4 : shorter ArtPollReply packets are from older revisions
+#define SUBSCRIBER_TIMEOUT_SECONDS	10	///< A controller sends an ArtPoll every 2.5 - 3 seconds
+
+/**
+ * An ArtPollReply with an output port on the Port-Address of one of our input ports
+ * subscribes that controller to the input port.
+ */
+void ArtNetNode::HandlePollReply(void) {
+	const struct TArtPollReply *packet = (struct TArtPollReply *)&(m_ArtNetPacket.pArtPacket->ArtPollReply);
+
+	if ((m_ArtNetPacket.length < POLLREPLY_MIN_SIZE) || (m_ArtNetPacket.IPAddressFrom == m_Node.IPAddressLocal)) {
+		return;
+	}
+
+	for (uint32_t nPort = 0; nPort < ARTNET_MAX_PORTS; nPort++) {
+		if ((packet->PortTypes[nPort] & ARTNET_ENABLE_OUTPUT) != ARTNET_ENABLE_OUTPUT) {
+			continue;
+		}
+
+		uint16_t nPortAddress = (packet->NetSwitch & 0x7F) << 8;			// Net : Bits 14-8
+		nPortAddress |= (packet->SubSwitch & (uint8_t) 0x0F) << 4;			// Sub-Net : Bits 7-4
+		nPortAddress |= packet->SwOut[nPort] & (uint16_t) 0x0F;				// Universe : Bits 3-0
+
+		for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
+			if (m_InputPorts[i].bIsEnabled && (m_InputPorts[i].port.nPortAddress == nPortAddress)) {
+				AddSubscriber(i, m_ArtNetPacket.IPAddressFrom);
+			}
+		}
+	}
+}
+
+void ArtNetNode::AddSubscriber(uint8_t nPortIndex, uint32_t nIp) {
+	struct TArtNetSubscriber *pSubscribers = m_InputPorts[nPortIndex].subscribers;
+	int32_t nFree = -1;
+
+	for (uint32_t i = 0; i < ARTNET_MAX_SUBSCRIBERS; i++) {
+		if (pSubscribers[i].nIp == nIp) {
+			pSubscribers[i].nTime = m_nCurrentPacketTime;
+			return;
+		}
+
+		if ((nFree < 0) && (pSubscribers[i].nIp == 0)) {
+			nFree = i;
+		}
+	}
+
+	if (nFree < 0) {
+		m_InputPorts[nPortIndex].nOverflowTime = m_nCurrentPacketTime;
+		return;
+	}
+
+	pSubscribers[nFree].nIp = nIp;
+	pSubscribers[nFree].nTime = m_nCurrentPacketTime;
+
+	DEBUG_PRINTF("Port %d, subscriber " IPSTR, (int) nPortIndex, IP2STR(nIp));
+}
+
+/**
+ * Only the slots received are sent, rounded up to an even length.
+ * The ArtDmx is unicast to the subscribers, or sent to m_nDestinationIp when there are none,
+ * or when there are more than \ref ARTNET_MAX_SUBSCRIBERS.
+ */
+void ArtNetNode::SendDmxIn(uint8_t nPortIndex) {
+	struct TArtDmx artDmx;
+	struct TInputPort *pInputPort = &m_InputPorts[nPortIndex];
 
 	memcpy((void *)artDmx.Id, (const char *) NODE_ID, sizeof m_PollReply.Id);
 	artDmx.OpCode = OP_DMX;
 	artDmx.ProtVerHi = 0;
 	artDmx.ProtVerLo = ARTNET_PROTOCOL_REVISION;
+	artDmx.Sequence = ++pInputPort->nSequence;
+
+	if (artDmx.Sequence == 0) {	// 0 disables the sequence check
+		artDmx.Sequence = ++pInputPort->nSequence;
+	}
+
+	artDmx.Physical = nPortIndex;
+	artDmx.PortAddress = pInputPort->port.nPortAddress;
+
+	uint16_t nLength = pInputPort->nLength;
+
+	memcpy(artDmx.Data, pInputPort->data, nLength);
+
+	if ((nLength & 0x1) == 0x1) {
+		artDmx.Data[nLength++] = 0;
+	}
+
+	artDmx.LengthHi = (nLength & 0xFF00) >> 8;
+	artDmx.Length = (nLength & 0xFF);
+
+	const uint16_t nSize = (uint16_t) (sizeof(struct TArtDmx) - ARTNET_DMX_LENGTH + nLength);
+
+	bool bIsUnicast = false;
+
+	if ((pInputPort->nOverflowTime == 0) || ((m_nCurrentPacketTime - pInputPort->nOverflowTime) > (time_t) SUBSCRIBER_TIMEOUT_SECONDS)) {
+		pInputPort->nOverflowTime = 0;
+
+		for (uint32_t i = 0; i < ARTNET_MAX_SUBSCRIBERS; i++) {
+			struct TArtNetSubscriber *pSubscriber = &pInputPort->subscribers[i];
+
+			if (pSubscriber->nIp == 0) {
+				continue;
+			}
+
+			if ((m_nCurrentPacketTime - pSubscriber->nTime) > (time_t) SUBSCRIBER_TIMEOUT_SECONDS) {
+				pSubscriber->nIp = 0;
+				continue;
+			}
+
+			Network::Get()->SendTo(m_nHandle, (const uint8_t *) &(artDmx), nSize, pSubscriber->nIp, (uint16_t) ARTNET_UDP_PORT);
+			bIsUnicast = true;
+		}
+	}
+
+	if (!bIsUnicast) {
+		Network::Get()->SendTo(m_nHandle, (const uint8_t *) &(artDmx), nSize, m_nDestinationIp, (uint16_t) ARTNET_UDP_PORT);
+	}
+}
+
+/**
+ * An input port sends an ArtDmx when the data has changed,
+ * otherwise the latest data is sent again every m_nDmxInRefreshMillis.
+ */
+void ArtNetNode::HandleDmxIn(void) {
+	const uint32_t nMillis = Hardware::Get()->Millis();
 
 	for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
-		if (m_InputPorts[i].bIsEnabled){
-			const uint8_t *pDmxData = m_pArtNetDmx->Handler(i, nLength);
+		struct TInputPort *pInputPort = &m_InputPorts[i];
+
+		if (!pInputPort->bIsEnabled) {
+			continue;
+		}
+
+		uint16_t nLength;
+		const uint8_t *pDmxData = m_pArtNetDmx->Handler(i, nLength);
+
+		const bool bIsRefresh = (pInputPort->nLength != 0) && ((nMillis - pInputPort->nMillis) >= m_nDmxInRefreshMillis);
+
+		if ((pDmxData != 0) && (nLength > 1)) {
+			// nLength includes the start code
+			uint16_t nSlots = nLength - 1;
 
-			if (pDmxData != 0) {
-				artDmx.Sequence = m_InputPorts[i].nSequence++;
-				artDmx.PortAddress = m_InputPorts[i].port.nPortAddress;
-				artDmx.LengthHi = (nLength & 0xFF00) >> 8;
-				artDmx.Length = (nLength & 0xFF);
+			if (nSlots > ARTNET_DMX_LENGTH) {
+				nSlots = ARTNET_DMX_LENGTH;
+			}
 
-				memcpy(artDmx.Data, &pDmxData[1], nLength-1);
+			const bool bIsChanged = (nSlots != pInputPort->nLength) || (memcmp(pInputPort->data, &pDmxData[1], nSlots) != 0);
 
-				m_InputPorts[i].port.nStatus = GI_DATA_RECIEVED;
+			if (!bIsChanged && !bIsRefresh) {
+				continue;
+			}
 
-				Network::Get()->SendTo(m_nHandle, (const uint8_t *) &(artDmx), (uint16_t) sizeof(struct TArtDmx), m_nDestinationIp, (uint16_t) ARTNET_UDP_PORT);
+			if (bIsChanged) {
+				memcpy(pInputPort->data, &pDmxData[1], nSlots);
+				pInputPort->nLength = nSlots;
 			}
+
+			pInputPort->port.nStatus = GI_DATA_RECIEVED;
+		} else if (!bIsRefresh) {
+			continue;
 		}
 
+		pInputPort->nMillis = nMillis;
+
+		SendDmxIn(i);
 	}
 }
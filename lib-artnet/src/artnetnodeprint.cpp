@@ -72,5 +72,6 @@ void ArtNetNode::Print(void) {
 				printf("  Port %c %d:%d:%d\n", (char) ('A' + i), nNet, nSubSwitch, nAddress);
 			}
 		}
+		printf(" Input refresh : %d ms\n", (int) m_nDmxInRefreshMillis);
 	}
 }
@@ -41,31 +41,43 @@ ArtNetRdm::~ArtNetRdm(void) {
 }
 
 void ArtNetNode::HandleTodControl(void) {
-	const struct TArtTodControl *packet = (struct TArtTodControl *) &(m_ArtNetPacket.ArtPacket.ArtTodControl);
+	const struct TArtTodControl *packet = (struct TArtTodControl *) &(m_ArtNetPacket.pArtPacket->ArtTodControl);
 	const uint16_t portAddress = (uint16_t)(packet->Net << 8) | (uint16_t)(packet->Address);
 
 	for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
 		if ((portAddress == m_OutputPorts[i].port.nPortAddress) && m_OutputPorts[i].bIsEnabled) {
 
-			if (m_IsLightSetRunning[i] && (!m_IsRdmResponder)) {
-				m_pLightSet->Stop(i);
-			}
-
-			if (packet->Command == 0x01) {	// AtcFlush
-				m_pArtNetRdm->Full(i);
+			if ((packet->Command == 0x01) && (!m_IsRdmResponder)) {	// AtcFlush
+				// The TOD is sent from RunDiscovery when the discovery has finished
+				m_pArtNetRdm->DiscoveryStart(i, m_IsLightSetRunning[i]);
+				m_nDiscoveryPorts |= (1 << i);
+				continue;
 			}
 
 			SendTod(i);
+		}
+	}
+}
 
-			if (m_IsLightSetRunning[i] && (!m_IsRdmResponder)) {
-				m_pLightSet->Start(i);
-			}
+/*
+ * Discovery runs interleaved with the DMX output and the network processing,
+ * each call advances every active port by at most one RDM transaction step.
+ */
+void ArtNetNode::RunDiscovery(void) {
+	for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
+		if ((m_nDiscoveryPorts & (1 << i)) == 0) {
+			continue;
+		}
+
+		if (!m_pArtNetRdm->DiscoveryRun(i)) {
+			m_nDiscoveryPorts &= ~(1 << i);
+			SendTod(i);
 		}
 	}
 }
 
 void ArtNetNode::HandleTodRequest(void) {
-	const struct TArtTodRequest *packet = (struct TArtTodRequest *) &(m_ArtNetPacket.ArtPacket.ArtTodRequest);
+	const struct TArtTodRequest *packet = (struct TArtTodRequest *) &(m_ArtNetPacket.pArtPacket->ArtTodRequest);
 	const uint16_t portAddress = (uint16_t)(packet->Net << 8) | (uint16_t)(packet->Address[0]);
 
 	for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
@@ -119,12 +131,17 @@ void ArtNetNode::SetRdmHandler(ArtNetRdm *pArtNetTRdm, bool IsResponder) {
 }
 
 void ArtNetNode::HandleRdm(void) {
-	struct TArtRdm *packet = (struct TArtRdm *) &(m_ArtNetPacket.ArtPacket.ArtRdm);
+	struct TArtRdm *packet = (struct TArtRdm *) &(m_ArtNetPacket.pArtPacket->ArtRdm);
 	const uint16_t portAddress = (uint16_t) (packet->Net << 8) | (uint16_t) (packet->Address);
 
 	for (uint32_t i = 0; i < ARTNET_MAX_PORTS; i++) {
 		if ((portAddress == m_OutputPorts[i].port.nPortAddress) && m_OutputPorts[i].bIsEnabled) {
 
+			if ((m_nDiscoveryPorts & (1 << i)) != 0) {
+				// The port is in the middle of a DUB/MUTE exchange, the ArtRdm is dropped. The controller retries after the ArtTodData.
+				continue;
+			}
+
 			if (!m_IsRdmResponder) {
 				if ((m_OutputPorts[i].tPortProtocol == PORT_ARTNET_SACN) && (m_pArtNet4Handler != 0)) {
 					const uint8_t nMask = GO_OUTPUT_IS_MERGING | GO_DATA_IS_BEING_TRANSMITTED | GO_OUTPUT_IS_SACN;
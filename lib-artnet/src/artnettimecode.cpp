@@ -54,7 +54,7 @@ void ArtNetNode::SetTimeCodeHandler(ArtNetTimeCode *pArtNetTimeCode) {
 }
 
 void ArtNetNode::HandleTimeCode(void) {
-	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_ArtNetPacket.ArtPacket.ArtTimeCode);
+	const struct TArtTimeCode *packet = (struct TArtTimeCode *) &(m_ArtNetPacket.pArtPacket->ArtTimeCode);
 
 	m_pArtNetTimeCode->Handler((struct TArtNetTimeCode *) &packet->Frames);
 }
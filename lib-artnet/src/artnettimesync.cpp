@@ -37,7 +37,7 @@ ArtNetTimeSync::~ArtNetTimeSync(void) {
 }
 
 void ArtNetNode::HandleTimeSync(void) {
-	struct TArtTimeSync *packet = (struct TArtTimeSync *) &(m_ArtNetPacket.ArtPacket.ArtTimeSync);
+	struct TArtTimeSync *packet = (struct TArtTimeSync *) &(m_ArtNetPacket.pArtPacket->ArtTimeSync);
 
 	m_pArtNetTimeSync->Handler((struct TArtNetTimeSync *)&packet->tm_sec);
 
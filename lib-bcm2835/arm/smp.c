@@ -31,6 +31,8 @@
 #include <stdbool.h>
 #include "arm/synchronize.h"
 
+#include "bcm2835.h"
+
 static volatile bool core_is_started;		///<
 static start_fn_t start_fn;					///<
 
@@ -50,18 +52,25 @@ void smp_core_main(void) {
  *
  * @param core_number
  * @param start
+ * @return false when the core did not start within SMP_START_TIMEOUT_US
  */
-void smp_start_core(uint32_t core_number, start_fn_t start) {
+bool smp_start_core(uint32_t core_number, start_fn_t start) {
 	if (core_number == 0 || core_number > 3) {
-		return;
+		return false;
 	}
 	start_fn = start;
+	core_is_started = false;
+	dmb();
 	*(uint32_t *) (SMP_CORE_BASE + (core_number * 0x10)) = (uint32_t) _init_core;
 	dmb();
-	core_is_started = false;
+	const uint32_t micros_start = BCM2835_ST->CLO;
 	while (!core_is_started) {
+		if ((BCM2835_ST->CLO - micros_start) > SMP_START_TIMEOUT_US) {
+			return false;
+		}
 		dmb();
 	}
+	return true;
 }
 #endif
 
@@ -377,13 +377,13 @@ typedef struct {
 } BCM2835_EMMC_TypeDef;
 
 #define BCM2835_ST		((BCM2835_ST_TypeDef *)   BCM2835_ST_BASE)			///< Base register address for SYSTEM TIMER
-#define BCM2835_DMA0	((BCM2835_DMA_TypeDef) *) BCM2835_DMA0_BASE)		///< Base register address for DMA Channel 0
-#define BCM2835_DMA1	((BCM2835_DMA_TypeDef) *) BCM2835_DMA1_BASE)		///< Base register address for DMA Channel 1
-#define BCM2835_DMA2	((BCM2835_DMA_TypeDef) *) BCM2835_DMA2_BASE)		///< Base register address for DMA Channel 2
-#define BCM2835_DMA3	((BCM2835_DMA_TypeDef) *) BCM2835_DMA3_BASE)		///< Base register address for DMA Channel 3
-#define BCM2835_DMA4	((BCM2835_DMA_TypeDef) *) BCM2835_DMA4_BASE)		///< Base register address for DMA Channel 4
-#define BCM2835_DMA5	((BCM2835_DMA_TypeDef) *) BCM2835_DMA5_BASE)		///< Base register address for DMA Channel 5
-#define BCM2835_DMA6	((BCM2835_DMA_TypeDef) *) BCM2835_DMA6_BASE)		///< Base register address for DMA Channel 6
+#define BCM2835_DMA0	((BCM2835_DMA_TypeDef *)  BCM2835_DMA0_BASE)		///< Base register address for DMA Channel 0
+#define BCM2835_DMA1	((BCM2835_DMA_TypeDef *)  BCM2835_DMA1_BASE)		///< Base register address for DMA Channel 1
+#define BCM2835_DMA2	((BCM2835_DMA_TypeDef *)  BCM2835_DMA2_BASE)		///< Base register address for DMA Channel 2
+#define BCM2835_DMA3	((BCM2835_DMA_TypeDef *)  BCM2835_DMA3_BASE)		///< Base register address for DMA Channel 3
+#define BCM2835_DMA4	((BCM2835_DMA_TypeDef *)  BCM2835_DMA4_BASE)		///< Base register address for DMA Channel 4
+#define BCM2835_DMA5	((BCM2835_DMA_TypeDef *)  BCM2835_DMA5_BASE)		///< Base register address for DMA Channel 5
+#define BCM2835_DMA6	((BCM2835_DMA_TypeDef *)  BCM2835_DMA6_BASE)		///< Base register address for DMA Channel 6
 #define BCM2835_IRQ		((BCM2835_IRQ_TypeDef *)  BCM2835_IRQ_BASE)			///< Base register address for IRQ
 #define BCM2835_MAILBOX	((BCM2835_MAILBOX_TypeDef *) BCM2835_MAILBOX_BASE)	///< Base register address for MAILBOX
 #define BCM2835_PM_WDOG	((BCM2835_PM_WDOG_TypeDef *) BCM2835_PM_WDOG_BASE)	///< Base register address for WATCHDOG
@@ -58,6 +58,7 @@
 #ifdef __ASSEMBLY__
 #else
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "bcm2835.h"
 #include "bcm2835_gpio.h"
@@ -147,6 +148,9 @@ extern void bcm2835_spi_writenb(const char*, uint32_t);
 extern void bcm2835_spi_write(uint16_t data);
 extern uint8_t bcm2835_spi_transfer(uint8_t);
 
+extern void bcm2835_spi_dma_tx_start(const char*, uint32_t);
+extern bool bcm2835_spi_dma_tx_is_active(void);
+
 #ifdef __cplusplus
 }
 #endif
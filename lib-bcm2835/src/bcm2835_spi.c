@@ -129,6 +129,10 @@ void bcm2835_spi_transfernb(char *tbuf, char *rbuf, const uint32_t len) {
 	uint32_t fifo_writes = 0;
 	uint32_t fifo_reads = 0;
 
+	while (bcm2835_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	dsb();
 	// Clear TX and RX fifos
 	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
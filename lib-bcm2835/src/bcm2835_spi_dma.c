@@ -0,0 +1,187 @@
+/**
+ * @file bcm2835_spi_dma.c
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "bcm2835.h"
+#include "bcm2835_spi.h"
+#include "arm/synchronize.h"
+
+#define SPI_DMA_TX_CHANNEL		4
+#define SPI_DMA_RX_CHANNEL		5
+#define SPI_DMA_TX				BCM2835_DMA4
+#define SPI_DMA_RX				BCM2835_DMA5
+#define SPI_DMA_TX_BUFFER_SIZE	(32 * 1024)
+
+#define DMA_ENABLE				(*(volatile uint32_t *) (BCM2835_DMA0_BASE + 0xFF0))
+
+#define DMA_CS_RESET			(1 << 31)
+#define DMA_CS_WAIT_WRITES		(1 << 28)	///< Wait for outstanding writes
+#define DMA_CS_PANIC_PRIORITY(x)	(((x) & 0xF) << 20)
+#define DMA_CS_PRIORITY(x)		(((x) & 0xF) << 16)
+#define DMA_CS_END				(1 << 1)
+#define DMA_CS_ACTIVE			(1 << 0)
+
+#define DMA_TI_PERMAP(x)		(((x) & 0x1F) << 16)
+#define DMA_TI_SRC_DREQ			(1 << 10)
+#define DMA_TI_SRC_INC			(1 << 8)
+#define DMA_TI_DEST_DREQ		(1 << 6)
+#define DMA_TI_WAIT_RESP		(1 << 3)
+
+#define DREQ_SPI_TX				6
+#define DREQ_SPI_RX				7
+
+#define SPI0_FIFO_BUS_ADDRESS	(GPU_IO_BASE + 0x204000 + BCM2835_SPI0_FIFO)
+#define BUS_ADDRESS(x)			(GPU_MEM_BASE | (uint32_t) (x))
+
+struct dma_control_block {
+	uint32_t ti;
+	uint32_t source_ad;
+	uint32_t dest_ad;
+	uint32_t txfr_len;
+	uint32_t stride;
+	uint32_t nextconbk;
+	uint32_t reserved[2];
+} __attribute__ ((aligned (32)));
+
+/*
+ * INFO The start of the coherent region is used for the mailbox messages, the SPI DMA buffers are in the second half
+ */
+struct coherent_region {
+	struct dma_control_block cb_tx;
+	struct dma_control_block cb_rx;
+	uint32_t rxdummy;
+	uint32_t txbuffer[SPI_DMA_TX_BUFFER_SIZE / 4] __attribute__ ((aligned (32)));
+};
+
+static struct coherent_region *p_coherent_region = (struct coherent_region *) (MEM_COHERENT_REGION + 0x80000);
+
+static volatile bool s_dma_tx_active = false;
+
+/**
+ * @ingroup SPI
+ *
+ * Starts a DMA transfer to the currently selected SPI slave and returns.
+ * The data is copied into the DMA buffer, then the caller can reuse tbuf.
+ * When a previous transfer is still active, this waits for it.
+ * The SPI DMA mode transfers 32-bit words, any other length falls back to \ref bcm2835_spi_writenb.
+ *
+ * @param tbuf Buffer of bytes to send.
+ * @param len Number of bytes in the tbuf buffer, and the number of bytes to send.
+ */
+void bcm2835_spi_dma_tx_start(const char *tbuf, uint32_t len) {
+	assert(tbuf != 0);
+
+	if ((len > SPI_DMA_TX_BUFFER_SIZE) || ((len & 0x3) != 0) || (((uint32_t) tbuf & 0x3) != 0)) {
+		bcm2835_spi_writenb(tbuf, len);
+		return;
+	}
+
+	while (bcm2835_spi_dma_tx_is_active()) {
+		// wait for the previous transfer
+	}
+
+	const uint32_t *src = (const uint32_t *) tbuf;
+	uint32_t *dst = p_coherent_region->txbuffer;
+	uint32_t i;
+
+	for (i = 0; i < (len / 4); i++) {
+		dst[i] = src[i];
+	}
+
+	// TX is written into the SPI FIFO, RX is drained so that the SPI does not stall on a full RX FIFO
+	struct dma_control_block *cb = &p_coherent_region->cb_tx;
+
+	cb->ti = DMA_TI_PERMAP(DREQ_SPI_TX) | DMA_TI_DEST_DREQ | DMA_TI_SRC_INC | DMA_TI_WAIT_RESP;
+	cb->source_ad = BUS_ADDRESS(p_coherent_region->txbuffer);
+	cb->dest_ad = SPI0_FIFO_BUS_ADDRESS;
+	cb->txfr_len = len;
+	cb->stride = 0;
+	cb->nextconbk = 0;
+
+	cb = &p_coherent_region->cb_rx;
+
+	cb->ti = DMA_TI_PERMAP(DREQ_SPI_RX) | DMA_TI_SRC_DREQ | DMA_TI_WAIT_RESP;
+	cb->source_ad = SPI0_FIFO_BUS_ADDRESS;
+	cb->dest_ad = BUS_ADDRESS(&p_coherent_region->rxdummy);
+	cb->txfr_len = len;
+	cb->stride = 0;
+	cb->nextconbk = 0;
+
+	dsb();
+
+	DMA_ENABLE |= (1 << SPI_DMA_TX_CHANNEL) | (1 << SPI_DMA_RX_CHANNEL);
+
+	SPI_DMA_TX->CS = DMA_CS_RESET;
+	SPI_DMA_RX->CS = DMA_CS_RESET;
+
+	// Clear TX and RX fifos
+	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
+
+	BCM2835_SPI0->DLEN = len;
+
+	// Set TA = 1, DMAEN = 1
+	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN, BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN);
+
+	s_dma_tx_active = true;
+
+	SPI_DMA_RX->CONBLK_AD = BUS_ADDRESS(&p_coherent_region->cb_rx);
+	SPI_DMA_TX->CONBLK_AD = BUS_ADDRESS(&p_coherent_region->cb_tx);
+
+	SPI_DMA_RX->CS = DMA_CS_WAIT_WRITES | DMA_CS_PANIC_PRIORITY(8) | DMA_CS_PRIORITY(8) | DMA_CS_END | DMA_CS_ACTIVE;
+	SPI_DMA_TX->CS = DMA_CS_WAIT_WRITES | DMA_CS_PANIC_PRIORITY(8) | DMA_CS_PRIORITY(8) | DMA_CS_END | DMA_CS_ACTIVE;
+
+	dmb();
+}
+
+/**
+ * @ingroup SPI
+ *
+ * @return true while a transfer started with \ref bcm2835_spi_dma_tx_start is active.
+ */
+bool bcm2835_spi_dma_tx_is_active(void) {
+	if (!s_dma_tx_active) {
+		return false;
+	}
+
+	dsb();
+
+	// The last RX word is read when the last byte is shifted out
+	if (((SPI_DMA_RX->CS & DMA_CS_ACTIVE) != 0) || ((BCM2835_SPI0->CS & BCM2835_SPI0_CS_DONE) == 0)) {
+		dmb();
+		return true;
+	}
+
+	// Set TA = 0, DMAEN = 0
+	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, 0, BCM2835_SPI0_CS_TA | BCM2835_SPI0_CS_DMAEN);
+
+	dmb();
+
+	s_dma_tx_active = false;
+	return false;
+}
@@ -31,6 +31,10 @@
 uint8_t bcm2835_spi_transfer(uint8_t data) {
 	uint8_t ret;
 
+	while (bcm2835_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	dsb();
 	// Clear TX and RX fifos
 	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
@@ -39,6 +39,10 @@
  * @param data uint16_t
  */
 void bcm2835_spi_write(const uint16_t data) {
+	while (bcm2835_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	dsb();
 	// Clear TX and RX fifos
 	BCM2835_PERI_SET_BITS(BCM2835_SPI0->CS, BCM2835_SPI0_CS_CLEAR, BCM2835_SPI0_CS_CLEAR);
@@ -131,27 +131,29 @@ inline static void newline(void) {
 	}
 }
 
-inline static void draw_pixel(uint32_t x, uint32_t y, uint32_t color) {
-	volatile uint32_t *address = (volatile uint32_t *)(fb_addr + (x * FB_BYTES_PER_PIXEL) + (y * FB_WIDTH * FB_BYTES_PER_PIXEL));
-	*address = (uint32_t) color;
-}
-
+/*
+ * The glyph is written one row of 8 pixels at the time, with the address
+ * calculated once per row. The pixel color is selected without branches.
+ */
 inline static void draw_char(int c, uint32_t x, uint32_t y, uint32_t fore, uint32_t back) {
-	uint32_t i, j;
-	uint8_t line;
-	unsigned char *p = FONT + (c * (int) FB_CHAR_H);
+	const unsigned char *p = FONT + (c * (int) FB_CHAR_H);
+	volatile uint32_t *address = (volatile uint32_t *)(fb_addr + (x * FB_BYTES_PER_PIXEL) + (y * FB_WIDTH * FB_BYTES_PER_PIXEL));
+	const uint32_t diff = fore ^ back;
+	uint32_t i;
 
 	for (i = 0; i < FB_CHAR_H; i++) {
-		line = (uint8_t) *p++;
-		for (j = x; j < (FB_CHAR_W + x); j++) {
-			if ((line & 0x1) != 0) {
-				draw_pixel(j, y, fore);
-			} else {
-				draw_pixel(j, y, back);
-			}
-			line >>= 1;
-		}
-		y++;
+		const uint32_t line = (uint32_t) *p++;
+
+		address[0] = back ^ (diff & -((line >> 0) & 0x1));
+		address[1] = back ^ (diff & -((line >> 1) & 0x1));
+		address[2] = back ^ (diff & -((line >> 2) & 0x1));
+		address[3] = back ^ (diff & -((line >> 3) & 0x1));
+		address[4] = back ^ (diff & -((line >> 4) & 0x1));
+		address[5] = back ^ (diff & -((line >> 5) & 0x1));
+		address[6] = back ^ (diff & -((line >> 6) & 0x1));
+		address[7] = back ^ (diff & -((line >> 7) & 0x1));
+
+		address += FB_WIDTH;
 	}
 }
 
@@ -42,6 +42,7 @@
 #include "h3_board.h"
 
 #include "irq_timer.h"
+#include "soft_timer.h"
 
 #include "gpio.h"
 #include "dmx.h"
@@ -482,10 +483,10 @@ static void irq_timer0_dmx_receive(uint32_t clo) {
 }
 
 /**
- * Timer 1 interrupt DMX Receiver
+ * Soft timer DMX Receiver, 1 second
  * Statistics
  */
-static void irq_timer1_dmx_receive(uint32_t clo) {
+static void timer_dmx_receive(uint32_t clo) {
 	dmb();
 	dmx_updates_per_seconde = total_statistics.dmx_packets - dmx_packets_previous;
 	dmx_packets_previous = total_statistics.dmx_packets;
@@ -792,10 +793,7 @@ void dmx_init(void) {
 
 	irq_timer_init();
 
-	irq_timer_set(IRQ_TIMER_1, irq_timer1_dmx_receive);
-	H3_TIMER->TMR1_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR1_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD); // 0x3;
+	soft_timer_periodic(timer_dmx_receive, 1000000, 1000);
 
 #if (EXT_UART_NUMBER == 1)
 	gic_fiq_config(H3_UART1_IRQn, 1);
@@ -64,6 +64,7 @@ public:
 #if defined (__linux__) || defined (__CYGWIN__) || defined(__APPLE__)
 #else
 	void Cls(void);
+	void Run(void);
 #endif
 
 #if defined (__linux__) || defined (__CYGWIN__) || defined(__APPLE__)
@@ -85,7 +86,12 @@ private:
 	uint16_t m_nMaxChannels;
 #else
 	bool m_bIsStarted;
+	bool m_bIsDirty;
+	bool m_bRedraw;
+	uint16_t m_nSlotsShadow;
+	uint32_t m_nMillisPrevious;
 	alignas(uint32_t) uint8_t m_Data[512];
+	alignas(uint32_t) uint8_t m_Shadow[512];	///< The values on the screen
 #endif
 };
 
@@ -30,6 +30,8 @@
 #include "dmxmonitor.h"
 #include "console.h"
 
+#include "hardware.h"
+
 #define TOP_ROW			2
 
 #define HEX_COLUMNS		32
@@ -38,6 +40,8 @@
 #define DEC_COLUMNS		24
 #define DEC_ROWS		22
 
+#define REFRESH_MILLIS	(1000 / 25)	///< The screen is updated with 25 fps maximum
+
 enum {
 	DMX_FOOTPRINT = 512,
 	DMX_START_ADDRESS = 1
@@ -46,12 +50,18 @@ enum {
 DMXMonitor::DMXMonitor(void) :
 	m_tFormat(DMX_MONITOR_FORMAT_HEX),
 	m_nSlots(0),
-	m_bIsStarted(false)
+	m_bIsStarted(false),
+	m_bIsDirty(false),
+	m_bRedraw(true),
+	m_nSlotsShadow(DMX_FOOTPRINT),
+	m_nMillisPrevious(0)
 {
 	uint8_t *p = (uint8_t *) m_Data;
+	uint8_t *s = (uint8_t *) m_Shadow;
 
 	for (uint32_t i = 0; i < (uint32_t) (sizeof(m_Data) / sizeof(m_Data[0])); i++) {
 		*p++ = 0;
+		*s++ = 0;
 	}
 }
 
@@ -114,6 +124,7 @@ void DMXMonitor::Start(uint8_t nPort) {
 		}
 	}
 
+	m_bRedraw = true;
 	Update();
 }
 
@@ -138,6 +149,9 @@ void DMXMonitor::Stop(uint8_t nPort) {
 		console_set_cursor(4, i);
 		console_puts("--- --- --- --- --- --- --- ---");
 	}
+
+	m_bRedraw = true;
+	m_nSlotsShadow = DMX_FOOTPRINT;
 }
 
 void DMXMonitor::Cls(void) {
@@ -152,82 +166,108 @@ void DMXMonitor::Cls(void) {
 			console_clear_line(i);
 		}
 	}
+
+	m_bRedraw = true;
+	m_nSlotsShadow = DMX_FOOTPRINT;
 }
 
 void DMXMonitor::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	bool bIsChanged = (m_nSlots != nLength);
+
 	m_nSlots = nLength;
 
 	const uint8_t *src = (const uint8_t *) pData;
 	uint8_t *dst = (uint8_t *) m_Data;
 
 	for (uint32_t i = 0; i < nLength; i++) {
-		*dst++ = *src++;
+		if (*dst != *src) {
+			*dst = *src;
+			bIsChanged = true;
+		}
+		dst++;
+		src++;
+	}
+
+	if (bIsChanged) {
+		m_bIsDirty = true;
+		Run();
+	}
+}
+
+/*
+ * The rendering is decoupled from the packet rate. Only the cells which
+ * differ from the shadow copy are drawn, with 25 screen updates per second maximum.
+ * Run is called from the main loop as well, so the last received frame is shown.
+ */
+void DMXMonitor::Run(void) {
+	if (!m_bIsDirty) {
+		return;
 	}
 
+	const uint32_t nMillis = Hardware::Get()->Millis();
+
+	if ((nMillis - m_nMillisPrevious) < REFRESH_MILLIS) {
+		return;
+	}
+
+	m_nMillisPrevious = nMillis;
+	m_bIsDirty = false;
+
 	Update();
 }
 
 void DMXMonitor::Update(void) {
-	uint32_t row = TOP_ROW;
-	uint32_t i, j;
-	uint8_t *p = (uint8_t *) m_Data;
-	uint16_t slot = 0;
+	uint32_t nColumns, nWidth;
 
 	if (m_tFormat != DMX_MONITOR_FORMAT_DEC) {
-		for (i = 0; (i < HEX_ROWS) && (slot < m_nSlots); i++) {
+		nColumns = HEX_COLUMNS;
+		nWidth = 3;
+	} else {
+		nColumns = DEC_COLUMNS;
+		nWidth = 4;
+	}
 
-			console_set_cursor(4, ++row);
+	const uint32_t nCells = m_nSlots > m_nSlotsShadow ? m_nSlots : m_nSlotsShadow;
+	const uint8_t *p = (const uint8_t *) m_Data;
+	uint8_t *s = (uint8_t *) m_Shadow;
+	uint32_t row = TOP_ROW + 1;
+	uint32_t column = 0;
 
-			for (j = 0; (j < HEX_COLUMNS) && (slot < m_nSlots); j++) {
-				const uint8_t d = *p++;
+	for (uint32_t slot = 0; slot < nCells; slot++) {
+		const uint8_t d = *p++;
 
+		if (slot >= m_nSlots) {
+			// Not in the packet anymore
+			console_set_cursor(4 + column * nWidth, row);
+			console_puts(m_tFormat != DMX_MONITOR_FORMAT_DEC ? "  " : "   ");
+		} else if (m_bRedraw || (slot >= m_nSlotsShadow) || (d != *s)) {
+			console_set_cursor(4 + column * nWidth, row);
+
+			if (m_tFormat != DMX_MONITOR_FORMAT_DEC) {
 				if (d == 0) {
 					console_puts(" 0");
+				} else if (m_tFormat == DMX_MONITOR_FORMAT_HEX) {
+					console_puthex_fg_bg(d, (uint16_t) (d > 92 ? CONSOLE_BLACK : CONSOLE_WHITE), (uint16_t) RGB(d, d, d));
 				} else {
-					if (m_tFormat == DMX_MONITOR_FORMAT_HEX) {
-						console_puthex_fg_bg(d, (uint16_t) (d > 92 ? CONSOLE_BLACK : CONSOLE_WHITE), (uint16_t) RGB(d, d, d));
-					} else {
-						console_putpct_fg_bg(((uint32_t) d * 100) / 255, (uint16_t) (d > 92 ? CONSOLE_BLACK : CONSOLE_WHITE), (uint16_t) RGB(d, d, d));
-					}
+					console_putpct_fg_bg(((uint32_t) d * 100) / 255, (uint16_t) (d > 92 ? CONSOLE_BLACK : CONSOLE_WHITE), (uint16_t) RGB(d, d, d));
 				}
-				console_putc((int) ' ');
-				slot++;
-			}
-
-			for (; j < HEX_COLUMNS; j++) {
-				console_puts("   ");
-			}
-		}
-
-		for (; i < HEX_ROWS; i++) {
-			console_set_cursor(4, ++row);
-			console_puts("                                                                                               ");
-		}
-	} else {
-		for (i = 0; (i < DEC_ROWS) && (slot < m_nSlots); i++) {
-
-			console_set_cursor(4, ++row);
-
-			for (j = 0; (j < DEC_COLUMNS) && (slot < m_nSlots); j++) {
-				const uint8_t d = *p++;
-
+			} else {
 				if (d == 0) {
 					console_puts("  0");
 				} else {
 					console_put3dec_fg_bg(d, (uint16_t) (d > 92 ? CONSOLE_BLACK : CONSOLE_WHITE), (uint16_t) RGB(d, d, d));
 				}
-				console_putc((int) ' ');
-				slot++;
-			}
-
-			for (; j < DEC_COLUMNS; j++) {
-				console_puts("    ");
 			}
 		}
 
-		for (; i < DEC_ROWS; i++) {
-			console_set_cursor(4, ++row);
-			console_puts("                                                                                               ");
+		*s++ = d;
+
+		if (++column == nColumns) {
+			column = 0;
+			row++;
 		}
 	}
+
+	m_nSlotsShadow = m_nSlots;
+	m_bRedraw = false;
 }
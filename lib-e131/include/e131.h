@@ -91,6 +91,13 @@ enum TVectorDMP {
  */
 #define E131_DEFAULT_PORT		5568	///<
 
+/**
+ * Receive queue depth, a burst of universes must fit.
+ * At most E131_RECV_BATCH packets are handled in one Run.
+ */
+#define E131_RECV_QUEUE_DEPTH	32		///<
+#define E131_RECV_BATCH			8		///<
+
 /**
  * Merge is implemented in either LTP or HTP mode
  */
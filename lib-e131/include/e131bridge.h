@@ -35,11 +35,19 @@
 #include "e131dmx.h"
 
 #include "lightset.h"
+#include "universeindex.h"
 
 enum {
 	E131_MAX_UARTS = 4
 };
 
+/**
+ * Sources tracked for each output universe. When the table is full, the source not seen for the longest time is replaced.
+ */
+#if !defined (E131_MAX_SOURCES)
+ #define E131_MAX_SOURCES	4
+#endif
+
 #define UUID_STRING_LENGTH	36
 
 struct TE131BridgeState {
@@ -54,19 +62,17 @@ struct TE131BridgeState {
 	uint32_t SynchronizationTime;
 	uint32_t DiscoveryTime;
 	uint16_t DiscoveryPacketLength;
-	uint16_t nSynchronizationAddressSourceA;
-	uint16_t nSynchronizationAddressSourceB;
 	uint8_t nActiveInputPorts;
 	uint8_t nActiveOutputPorts;
-	uint8_t nPriority;
 };
 
 struct TSource {
 	uint32_t time;
-	uint32_t ip;
-	uint8_t data[E131_DMX_LENGTH];
+	uint16_t length;
+	uint16_t nSynchronizationAddress;
 	uint8_t cid[E131_CID_LENGTH];
 	uint8_t sequenceNumberData;
+	uint8_t data[E131_DMX_LENGTH];
 };
 
 struct TE131OutputPort {
@@ -78,8 +84,9 @@ struct TE131OutputPort {
 	bool bIsEnabled;
 	bool IsTransmitting;
 	bool IsMerging;
-	struct TSource sourceA;
-	struct TSource sourceB;
+	uint8_t nPriority;				///< Priority of the sources in the table
+	uint8_t nSources;				///< Number of valid entries in source[]
+	struct TSource source[E131_MAX_SOURCES];
 };
 
 struct TE131InputPort {
@@ -182,16 +189,24 @@ public:
 	void Print(void);
 
 private:
+	void UpdatePortIndex(void);
+
+	void HandlePacket(void);
 	bool IsValidRoot(void);
 	bool IsValidDataPacket(void);
 
-	void SetNetworkDataLossCondition(bool bSourceA = true, bool bSourceB = true);
+	void SetNetworkDataLossCondition(void);
+	void StopOutput(uint8_t nPortIndex);
 
-	void SetSynchronizationAddress(bool bSourceA, bool bSourceB, uint16_t nSynchronizationAddress);
+	void SetSynchronizationAddress(struct TSource *pSource, uint16_t nSynchronizationAddress);
+	bool IsSynchronizationAddressInUse(uint16_t nSynchronizationAddress) const;
+	void LeaveSynchronizationAddress(uint16_t nSynchronizationAddress);
 
-	void CheckMergeTimeouts(uint8_t nPortIndex);
-	bool IsPriorityTimeOut(uint8_t nPortIndex);
-	bool isIpCidMatch(const struct TSource *);
+	int32_t FindSource(uint8_t nPortIndex) const;
+	uint32_t AddSource(uint8_t nPortIndex);
+	void RemoveSource(uint8_t nPortIndex, uint32_t nSourceIndex);
+	void CheckSourceTimeouts(uint8_t nPortIndex, uint32_t nTimeOutMillis);
+	void UpdateMergeMode(void);
 	bool IsDmxDataChanged(uint8_t nPortIndex, const uint8_t *pData, uint16_t nLength);
 	bool IsMergedDmxDataChanged(uint8_t nPortIndex, const uint8_t *pData, uint16_t nLength);
 
@@ -220,6 +235,7 @@ private:
 
 	struct TE131BridgeState m_State;
 	struct TE131OutputPort m_OutputPort[E131_MAX_PORTS];
+	UniverseIndex m_PortIndex;	///< Universe -> enabled output ports
 	struct TE131InputPort m_InputPort[E131_MAX_UARTS];
 	struct TE131 m_E131;
 
@@ -35,7 +35,6 @@
 #ifndef MIN
  #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
-
 #ifndef MAX
  #define MAX(a, b) ((a) > (b) ? (a) : (b))
 #endif
@@ -44,6 +43,7 @@
 #include "e131uuid.h"
 
 #include "lightset.h"
+#include "lightsetdata.h"
 
 #include "hardware.h"
 #include "network.h"
@@ -80,14 +80,13 @@ E131Bridge::E131Bridge(void) :
 	}
 
 	memset(&m_State, 0, sizeof(struct TE131BridgeState));
-	m_State.nPriority = E131_PRIORITY_LOWEST;
 
 	char aSourceName[E131_SOURCE_NAME_LENGTH];
 	uint8_t nLength;
 	snprintf(aSourceName, E131_SOURCE_NAME_LENGTH, "%s %s", Network::Get()->GetHostName(), Hardware::Get()->GetBoardName(nLength));
 	SetSourceName((const char *)aSourceName);
 
-	m_nHandle = Network::Get()->Begin(E131_DEFAULT_PORT); 	// This must be here (and not in Start) for Mac OS and Linux
+	m_nHandle = Network::Get()->BeginDepth(E131_DEFAULT_PORT, E131_RECV_QUEUE_DEPTH); 	// This must be here (and not in Start) for Mac OS and Linux
 	assert(m_nHandle != -1);								// ToDO Rewrite SetUniverse
 
 	E131Uuid e131UUID;
@@ -152,8 +151,14 @@ const uint8_t *E131Bridge::GetSoftwareVersion(void) {
 void E131Bridge::SetSourceName(const char *pSourceName) {
 	assert(pSourceName != 0);
 
-	strncpy((char *)m_SourceName, pSourceName, E131_SOURCE_NAME_LENGTH);
-	m_SourceName[E131_SOURCE_NAME_LENGTH - 1] = '\0';
+	size_t nLength = strlen(pSourceName);
+
+	if (nLength > E131_SOURCE_NAME_LENGTH - 1) {
+		nLength = E131_SOURCE_NAME_LENGTH - 1;
+	}
+
+	memcpy(m_SourceName, pSourceName, nLength);
+	m_SourceName[nLength] = '\0';
 }
 
 uint32_t E131Bridge::UniverseToMulticastIp(uint16_t nUniverse) const {
@@ -169,42 +174,58 @@ uint32_t E131Bridge::UniverseToMulticastIp(uint16_t nUniverse) const {
 	return nMulticastIp;
 }
 
-void E131Bridge::SetSynchronizationAddress(bool bSourceA, bool bSourceB, uint16_t nSynchronizationAddress) {
+void E131Bridge::SetSynchronizationAddress(struct TSource *pSource, uint16_t nSynchronizationAddress) {
 	DEBUG_ENTRY
-	DEBUG_PRINTF("bSourceA=%d, bSourceB=%d, nSynchronizationAddress=%d", bSourceA, bSourceB, nSynchronizationAddress);
+	DEBUG_PRINTF("nSynchronizationAddress=%d", nSynchronizationAddress);
 
+	assert(pSource != 0);
 	assert(nSynchronizationAddress != 0);
 
-	uint16_t *pSynchronizationAddressSource;
+	const uint16_t nSynchronizationAddressPrevious = pSource->nSynchronizationAddress;
 
-	if (bSourceA) {
-		pSynchronizationAddressSource = &m_State.nSynchronizationAddressSourceA;
-	} else if (bSourceB) {
-		pSynchronizationAddressSource = &m_State.nSynchronizationAddressSourceB;
-	} else {
-		DEBUG_EXIT
-		return; // Just make the compiler happy
-	}
-
-	if (*pSynchronizationAddressSource == 0) {
-		*pSynchronizationAddressSource = nSynchronizationAddress;
-		DEBUG_PUTS("SynchronizationAddressSource == 0");
-	} else if (*pSynchronizationAddressSource != nSynchronizationAddress) {
-		// E131_MAX_PORTS forces to check all ports
-		LeaveUniverse(E131_MAX_PORTS, *pSynchronizationAddressSource);
-		*pSynchronizationAddressSource = nSynchronizationAddress;
-		DEBUG_PUTS("SynchronizationAddressSource != nSynchronizationAddress");
-	} else {
+	if (nSynchronizationAddressPrevious == nSynchronizationAddress) {
 		DEBUG_PUTS("Already received SynchronizationAddress");
 		DEBUG_EXIT
 		return;
 	}
 
-	Network::Get()->JoinGroup(m_nHandle, UniverseToMulticastIp(nSynchronizationAddress));
+	const bool bIsJoined = IsSynchronizationAddressInUse(nSynchronizationAddress);
+
+	pSource->nSynchronizationAddress = nSynchronizationAddress;
+
+	LeaveSynchronizationAddress(nSynchronizationAddressPrevious);
+
+	if (!bIsJoined) {
+		Network::Get()->JoinGroup(m_nHandle, UniverseToMulticastIp(nSynchronizationAddress));
+	}
 
 	DEBUG_EXIT
 }
 
+bool E131Bridge::IsSynchronizationAddressInUse(uint16_t nSynchronizationAddress) const {
+	for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
+		for (uint32_t nSource = 0; nSource < m_OutputPort[i].nSources; nSource++) {
+			if (m_OutputPort[i].source[nSource].nSynchronizationAddress == nSynchronizationAddress) {
+				return true;
+			}
+		}
+	}
+
+	return false;
+}
+
+/**
+ * Leave the synchronization universe when no source uses it anymore.
+ * Called after a source has stopped using nSynchronizationAddress.
+ */
+void E131Bridge::LeaveSynchronizationAddress(uint16_t nSynchronizationAddress) {
+	if ((nSynchronizationAddress != 0) && !IsSynchronizationAddressInUse(nSynchronizationAddress)) {
+		// E131_MAX_PORTS forces to check all ports
+		LeaveUniverse(E131_MAX_PORTS, nSynchronizationAddress);
+		DEBUG_PRINTF("Left SynchronizationAddress %d", nSynchronizationAddress);
+	}
+}
+
 void E131Bridge::LeaveUniverse(uint8_t nPortIndex, uint16_t nUniverse) {
 	DEBUG_ENTRY
 	DEBUG_PRINTF("nPortIndex=%d, nUniverse=%d", nPortIndex, nUniverse);
@@ -254,6 +275,7 @@ void E131Bridge::SetUniverse(uint8_t nPortIndex, TE131PortDir dir, uint16_t nUni
 			m_OutputPort[nPortIndex].bIsEnabled = false;
 			m_State.nActiveOutputPorts = m_State.nActiveOutputPorts - 1;
 			LeaveUniverse(nPortIndex, nUniverse);
+			UpdatePortIndex();
 		}
 		if (m_InputPort[nPortIndex].bIsEnabled) {
 			m_InputPort[nPortIndex].bIsEnabled = false;
@@ -279,6 +301,18 @@ void E131Bridge::SetUniverse(uint8_t nPortIndex, TE131PortDir dir, uint16_t nUni
 	Network::Get()->JoinGroup(m_nHandle, UniverseToMulticastIp(nUniverse));
 
 	m_OutputPort[nPortIndex].nUniverse = nUniverse;
+
+	UpdatePortIndex();
+}
+
+void E131Bridge::UpdatePortIndex(void) {
+	m_PortIndex.Clear();
+
+	for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
+		if (m_OutputPort[i].bIsEnabled) {
+			m_PortIndex.Add(m_OutputPort[i].nUniverse, i);
+		}
+	}
 }
 
 bool E131Bridge::GetUniverse(uint8_t nPortIndex, uint16_t &nUniverse, TE131PortDir tDir) const {
@@ -313,61 +347,40 @@ bool E131Bridge::IsDmxDataChanged(uint8_t nPortIndex, const uint8_t *pData, uint
 	assert(nPortIndex < E131_MAX_PORTS);
 	assert(pData != 0);
 
-	bool isChanged = false;
-
-	uint8_t *src = (uint8_t *)pData;
-	uint8_t *dst = (uint8_t *)m_OutputPort[nPortIndex].data;
-
 	if (nLength != m_OutputPort[nPortIndex].length) {
 		m_OutputPort[nPortIndex].length = nLength;
-		for (unsigned i = 0 ; i < E131_DMX_LENGTH; i++) {
-			*dst++ = *src++;
-		}
+		memcpy(m_OutputPort[nPortIndex].data, pData, E131_DMX_LENGTH);
 		return true;
 	}
 
-	for (unsigned i = 0; i < E131_DMX_LENGTH; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
-		}
-		dst++;
-		src++;
-	}
-
-	return isChanged;
+	return LightSetData::Copy(m_OutputPort[nPortIndex].data, pData, E131_DMX_LENGTH);
 }
 
 bool E131Bridge::IsMergedDmxDataChanged(uint8_t nPortIndex, const uint8_t *pData, uint16_t nLength) {
 	assert(nPortIndex < E131_MAX_PORTS);
 	assert(pData != 0);
 
-	bool isChanged = false;
+	struct TE131OutputPort *pPort = &m_OutputPort[nPortIndex];
 
-	if (!m_State.IsMergeMode) {
-		m_State.IsMergeMode = true;
-		m_State.IsChanged = true;
+	if (!pPort->IsMerging) {
+		pPort->IsMerging = true;
+		UpdateMergeMode();
 	}
 
-	m_OutputPort[nPortIndex].IsMerging = true;
-
-	if (m_OutputPort[nPortIndex].mergeMode == E131_MERGE_HTP) {
+	if (pPort->mergeMode == E131_MERGE_HTP) {
+		const uint8_t *pSourceData[E131_MAX_SOURCES];
+		uint16_t nMergeLength = 0;
 
-		if (nLength != m_OutputPort[nPortIndex].length) {
-			m_OutputPort[nPortIndex].length = nLength;
-			for (unsigned i = 0; i < nLength; i++) {
-				uint8_t data = MAX(m_OutputPort[nPortIndex].sourceA.data[i], m_OutputPort[nPortIndex].sourceB.data[i]);
-				m_OutputPort[nPortIndex].data[i] = data;
-			}
-			return true;
+		for (uint32_t nSource = 0; nSource < pPort->nSources; nSource++) {
+			pSourceData[nSource] = pPort->source[nSource].data;
+			nMergeLength = MAX(nMergeLength, pPort->source[nSource].length);
 		}
 
-		for (unsigned i = 0; i < nLength; i++) {
-			uint8_t data = MAX(m_OutputPort[nPortIndex].sourceA.data[i], m_OutputPort[nPortIndex].sourceB.data[i]);
-			if (data != m_OutputPort[nPortIndex].data[i]) {
-				m_OutputPort[nPortIndex].data[i] = data;
-				isChanged = true;
-			}
+		const bool isChanged = LightSetData::MergeHtp(pPort->data, pSourceData, pPort->nSources, nMergeLength);
+
+		if (nMergeLength != pPort->length) {
+			pPort->length = nMergeLength;
+			return true;
 		}
 
 		return isChanged;
@@ -376,115 +389,148 @@ bool E131Bridge::IsMergedDmxDataChanged(uint8_t nPortIndex, const uint8_t *pData
 	}
 }
 
-void E131Bridge::CheckMergeTimeouts(uint8_t nPortIndex) {
-	assert(nPortIndex < E131_MAX_PORTS);
-
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort[nPortIndex].sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort[nPortIndex].sourceB.time;
-
-	if (timeOutA > (uint32_t) (E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort[nPortIndex].sourceA.ip = 0;
-		memset(m_OutputPort[nPortIndex].sourceA.cid, 0, E131_CID_LENGTH);
-		m_OutputPort[nPortIndex].IsMerging = false;
-	}
-
-	if (timeOutB > (uint32_t) (E131_MERGE_TIMEOUT_SECONDS * 1000)) {
-		m_OutputPort[nPortIndex].sourceB.ip = 0;
-		memset(m_OutputPort[nPortIndex].sourceB.cid, 0, E131_CID_LENGTH);
-		m_OutputPort[nPortIndex].IsMerging = false;
-	}
-
+void E131Bridge::UpdateMergeMode(void) {
 	bool bIsMerging = false;
 
 	for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
 		bIsMerging |= m_OutputPort[i].IsMerging;
 	}
 
-	if (!bIsMerging) {
+	if (bIsMerging != m_State.IsMergeMode) {
+		m_State.IsMergeMode = bIsMerging;
 		m_State.IsChanged = true;
-		m_State.IsMergeMode = false;
 	}
-
 }
 
-bool E131Bridge::IsPriorityTimeOut(uint8_t nPortIndex) {
+/**
+ * The source table is indexed by the CID of the received packet.
+ * @return index in source[], -1 when the CID is not in the table
+ */
+int32_t E131Bridge::FindSource(uint8_t nPortIndex) const {
 	assert(nPortIndex < E131_MAX_PORTS);
 
-	const uint32_t timeOutA = m_nCurrentPacketMillis - m_OutputPort[nPortIndex].sourceA.time;
-	const uint32_t timeOutB = m_nCurrentPacketMillis - m_OutputPort[nPortIndex].sourceB.time;
+	const struct TE131OutputPort *pPort = &m_OutputPort[nPortIndex];
+	const uint8_t *pCid = m_E131.E131Packet->Data.RootLayer.Cid;
 
-	if ( (m_OutputPort[nPortIndex].sourceA.ip != 0) && (m_OutputPort[nPortIndex].sourceB.ip != 0) ) {
-		if ( (timeOutA < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) || (timeOutB < (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) ) {
-			return false;
-		} else {
-			return true;
-		}
-	} else if ( (m_OutputPort[nPortIndex].sourceA.ip != 0) && (m_OutputPort[nPortIndex].sourceB.ip == 0) ) {
-		if (timeOutA > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
-		}
-	} else if ( (m_OutputPort[nPortIndex].sourceA.ip == 0) && (m_OutputPort[nPortIndex].sourceB.ip != 0) ) {
-		if (timeOutB > (uint32_t)(E131_PRIORITY_TIMEOUT_SECONDS * 1000)) {
-			return true;
+	for (uint32_t nSource = 0; nSource < pPort->nSources; nSource++) {
+		if (memcmp(pPort->source[nSource].cid, pCid, E131_CID_LENGTH) == 0) {
+			return (int32_t) nSource;
 		}
 	}
 
-	return false;
+	return -1;
 }
 
-bool E131Bridge::isIpCidMatch(const struct TSource *source) {
-	if (source->ip != m_E131.IPAddressFrom) {
-		return false;
+uint32_t E131Bridge::AddSource(uint8_t nPortIndex) {
+	assert(nPortIndex < E131_MAX_PORTS);
+
+	struct TE131OutputPort *pPort = &m_OutputPort[nPortIndex];
+	uint32_t nSourceIndex;
+	bool bIsReplaced = false;
+
+	if (pPort->nSources < E131_MAX_SOURCES) {
+		nSourceIndex = pPort->nSources++;
+	} else {
+		bIsReplaced = true;
+
+		// The table is full, replace the source not seen for the longest time
+		nSourceIndex = 0;
+
+		for (uint32_t nSource = 1; nSource < E131_MAX_SOURCES; nSource++) {
+			if ((m_nCurrentPacketMillis - pPort->source[nSource].time) > (m_nCurrentPacketMillis - pPort->source[nSourceIndex].time)) {
+				nSourceIndex = nSource;
+			}
+		}
+
+		DEBUG_PRINTF("nPortIndex=%d, replacing source %d", nPortIndex, nSourceIndex);
 	}
 
-	if (memcmp(source->cid, m_E131.E131Packet.Raw.RootLayer.Cid, E131_CID_LENGTH) != 0) {
-		return false;
+	struct TSource *pSource = &pPort->source[nSourceIndex];
+	const uint16_t nSynchronizationAddressPrevious = pSource->nSynchronizationAddress;
+
+	memcpy(pSource->cid, m_E131.E131Packet->Data.RootLayer.Cid, E131_CID_LENGTH);
+	memset(pSource->data, 0, E131_DMX_LENGTH);
+	pSource->sequenceNumberData = m_E131.E131Packet->Data.FrameLayer.SequenceNumber;
+	pSource->nSynchronizationAddress = 0;
+
+	// Only a replaced source can have joined a synchronization universe
+	if (bIsReplaced) {
+		LeaveSynchronizationAddress(nSynchronizationAddressPrevious);
 	}
 
-	return true;
+	return nSourceIndex;
 }
 
-void E131Bridge::HandleDmx(void) {
-	const uint8_t *p = &m_E131.E131Packet.Data.DMPLayer.PropertyValues[1];
-	const uint16_t slots = __builtin_bswap16(m_E131.E131Packet.Data.DMPLayer.PropertyValueCount) - (uint16_t) 1;
+void E131Bridge::RemoveSource(uint8_t nPortIndex, uint32_t nSourceIndex) {
+	assert(nPortIndex < E131_MAX_PORTS);
 
-	for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
-		if (!m_OutputPort[i].bIsEnabled) {
-			continue;
-		}
+	struct TE131OutputPort *pPort = &m_OutputPort[nPortIndex];
 
-		// Frame layer
-		// 8.2 Association of Multicast Addresses and Universe
-		// Note: The identity of the universe shall be determined by the universe number in the
-		// packet and not assumed from the multicast address.
-		if (m_E131.E131Packet.Data.FrameLayer.Universe != __builtin_bswap16(m_OutputPort[i].nUniverse)) {
-			continue;
+	assert(nSourceIndex < pPort->nSources);
+
+	const uint16_t nSynchronizationAddress = pPort->source[nSourceIndex].nSynchronizationAddress;
+
+	pPort->nSources--;
+
+	if (nSourceIndex != pPort->nSources) {
+		memcpy(&pPort->source[nSourceIndex], &pPort->source[pPort->nSources], sizeof(struct TSource));
+	}
+
+	LeaveSynchronizationAddress(nSynchronizationAddress);
+
+	if ((pPort->nSources <= 1) && pPort->IsMerging) {
+		pPort->IsMerging = false;
+		UpdateMergeMode();
+	}
+}
+
+void E131Bridge::CheckSourceTimeouts(uint8_t nPortIndex, uint32_t nTimeOutMillis) {
+	assert(nPortIndex < E131_MAX_PORTS);
+
+	struct TE131OutputPort *pPort = &m_OutputPort[nPortIndex];
+	uint32_t nSource = 0;
+
+	while (nSource < pPort->nSources) {
+		if ((m_nCurrentPacketMillis - pPort->source[nSource].time) > nTimeOutMillis) {
+			DEBUG_PRINTF("nPortIndex=%d, source %d timed out", nPortIndex, nSource);
+			RemoveSource(nPortIndex, nSource);
+		} else {
+			nSource++;
 		}
+	}
+}
+
+void E131Bridge::HandleDmx(void) {
+	const uint8_t *p = &m_E131.E131Packet->Data.DMPLayer.PropertyValues[1];
+	const uint16_t slots = __builtin_bswap16(m_E131.E131Packet->Data.DMPLayer.PropertyValueCount) - (uint16_t) 1;
+	const uint8_t nPriority = m_E131.E131Packet->Data.FrameLayer.Priority;
 
-		struct TSource *pSourceA = &m_OutputPort[i].sourceA;
-		struct TSource *pSourceB = &m_OutputPort[i].sourceB;
+	// Frame layer
+	// 8.2 Association of Multicast Addresses and Universe
+	// Note: The identity of the universe shall be determined by the universe number in the
+	// packet and not assumed from the multicast address.
+	uint32_t nPortMask = m_PortIndex.Lookup(__builtin_bswap16(m_E131.E131Packet->Data.FrameLayer.Universe));
 
-		const uint32_t ipA = pSourceA->ip;
-		const uint32_t ipB = pSourceB->ip;
+	while (nPortMask != 0) {
+		const uint32_t i = __builtin_ctz(nPortMask);
+		nPortMask &= (nPortMask - 1);
 
-		const bool isSourceA = isIpCidMatch(pSourceA);
-		const bool isSourceB = isIpCidMatch(pSourceB);
+		struct TE131OutputPort *pPort = &m_OutputPort[i];
 
-		bool sendNewData = false;
+		if (pPort->IsMerging && __builtin_expect((!m_State.bDisableMergeTimeout), 1)) {
+			CheckSourceTimeouts(i, (uint32_t) (E131_MERGE_TIMEOUT_SECONDS * 1000));
+		}
+
+		int32_t nSourceIndex = FindSource(i);
 
 		// 6.9.2 Sequence Numbering
 		// Having first received a packet with sequence number A, a second packet with sequence number B
 		// arrives. If, using signed 8-bit binary arithmetic, B – A is less than or equal to 0, but greater than -20 then
 		// the packet containing sequence number B shall be deemed out of sequence and discarded
-		if (isSourceA) {
-			const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceA->sequenceNumberData);
-			pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
-				continue;
-			}
-		} else if (isSourceB) {
-			const int8_t diff = (int8_t) (m_E131.E131Packet.Data.FrameLayer.SequenceNumber - pSourceB->sequenceNumberData);
-			pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
+		if (nSourceIndex >= 0) {
+			struct TSource *pSource = &pPort->source[nSourceIndex];
+			const int8_t diff = (int8_t) (m_E131.E131Packet->Data.FrameLayer.SequenceNumber - pSource->sequenceNumberData);
+			pSource->sequenceNumberData = m_E131.E131Packet->Data.FrameLayer.SequenceNumber;
 			if ((diff <= (int8_t) 0) && (diff > (int8_t) -20)) {
 				continue;
 			}
@@ -492,106 +538,72 @@ void E131Bridge::HandleDmx(void) {
 
 		// This bit, when set to 1, indicates that the data in this packet is intended for use in visualization or media
 		// server preview applications and shall not be used to generate live output.
-		if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_PREVIEW_DATA) != 0) {
+		if ((m_E131.E131Packet->Data.FrameLayer.Options & E131_OPTIONS_MASK_PREVIEW_DATA) != 0) {
 			continue;
 		}
 
 		// Upon receipt of a packet containing this bit set to a value of 1, receiver shall enter network data loss condition.
 		// Any property values in these packets shall be ignored.
-		if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0) {
-			if (isSourceA || isSourceB) {
-				SetNetworkDataLossCondition(isSourceA, isSourceB);
+		if ((m_E131.E131Packet->Data.FrameLayer.Options & E131_OPTIONS_MASK_STREAM_TERMINATED) != 0) {
+			if (nSourceIndex >= 0) {
+				RemoveSource(i, nSourceIndex);
+
+				if (pPort->nSources == 0) {
+					StopOutput(i);
+				}
 			}
 			continue;
 		}
 
-		if (m_State.IsMergeMode) {
-			if (__builtin_expect((!m_State.bDisableMergeTimeout), 1)) {
-				CheckMergeTimeouts(i);
+		// 6.2.3 E1.31 Data Packet: Priority
+		// The priority is arbitrated for each universe. Only the sources with the highest priority are in the table.
+		if (pPort->nSources != 0) {
+			if (nPriority < pPort->nPriority) {
+				if ((nSourceIndex < 0) || (pPort->nSources != 1)) {
+					if (nSourceIndex >= 0) {
+						RemoveSource(i, nSourceIndex);
+						nSourceIndex = -1;
+					}
+
+					CheckSourceTimeouts(i, (uint32_t) (E131_PRIORITY_TIMEOUT_SECONDS * 1000));
+
+					if (pPort->nSources != 0) {
+						continue;
+					}
+				}
+			} else if (nPriority > pPort->nPriority) {
+				if (nSourceIndex > 0) {
+					memcpy(&pPort->source[0], &pPort->source[nSourceIndex], sizeof(struct TSource));
+					nSourceIndex = 0;
+				}
+
+				pPort->nSources = (nSourceIndex == 0) ? 1 : 0;
+
+				if (pPort->IsMerging) {
+					pPort->IsMerging = false;
+					UpdateMergeMode();
+				}
 			}
 		}
 
-		if (m_E131.E131Packet.Data.FrameLayer.Priority < m_State.nPriority ){
-			if (!IsPriorityTimeOut(i)) {
-				continue;
-			}
-			m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-		} else if (m_E131.E131Packet.Data.FrameLayer.Priority > m_State.nPriority) {
-			m_OutputPort[i].sourceA.ip = 0;
-			m_OutputPort[i].sourceB.ip = 0;
-			m_State.IsMergeMode = false;
-			m_State.nPriority = m_E131.E131Packet.Data.FrameLayer.Priority;
-		}
-
-		if ((ipA == 0) && (ipB == 0)) {
-			//printf("1. First package from Source\n");
-			pSourceA->ip = m_E131.IPAddressFrom;
-			pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			memcpy(pSourceA->cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-			pSourceA->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceA->data, (const void *)p, slots);
-			sendNewData = IsDmxDataChanged(i, p, slots);
+		pPort->nPriority = nPriority;
 
-		} else if (isSourceA && (ipB == 0)) {
-			//printf("2. Continue package from SourceA\n");
-			pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			pSourceA->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceA->data, (const void *)p, slots);
-			sendNewData = IsDmxDataChanged(i, p, slots);
+		if (nSourceIndex < 0) {
+			nSourceIndex = AddSource(i);
+		}
 
-		} else if ((ipA == 0) && isSourceB) {
-			//printf("3. Continue package from SourceB\n");
-			pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			pSourceB->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceB->data, (const void *)p, slots);
-			sendNewData = IsDmxDataChanged(i, p, slots);
+		struct TSource *pSource = &pPort->source[nSourceIndex];
 
-		} else if (!isSourceA && (ipB == 0)) {
-			//printf("4. New ip, start merging\n");
-			pSourceB->ip = m_E131.IPAddressFrom;
-			pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			memcpy(pSourceB->cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-			pSourceB->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceB->data, (const void *)p, slots);
-			sendNewData = IsMergedDmxDataChanged(i, pSourceB->data, slots);
-
-		} else if ((ipA == 0) && !isSourceB) {
-			//printf("5. New ip, start merging\n");
-			pSourceA->ip = m_E131.IPAddressFrom;
-			pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			memcpy(pSourceA->cid, m_E131.E131Packet.Data.RootLayer.Cid, 16);
-			pSourceA->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceA->data, (const void *)p, slots);
-			sendNewData = IsMergedDmxDataChanged(i, pSourceA->data, slots);
-
-		} else if (isSourceA && !isSourceB) {
-			//printf("6. Continue merging\n");
-			pSourceA->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			pSourceA->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceA->data, (const void *)p, slots);
-			sendNewData = IsMergedDmxDataChanged(i, pSourceA->data, slots);
-
-		} else if (!isSourceA && isSourceB) {
-			//printf("7. Continue merging\n");
-			pSourceB->sequenceNumberData = m_E131.E131Packet.Data.FrameLayer.SequenceNumber;
-			pSourceB->time = m_nCurrentPacketMillis;
-			memcpy((void *)pSourceB->data, (const void *)p, slots);
-			sendNewData = IsMergedDmxDataChanged(i, pSourceB->data, slots);
-
-		} else if (isSourceA && isSourceB) {
-			printf("8. Source matches both buffers, this shouldn't be happening!\n");
-			assert(0);
-			return;
+		pSource->time = m_nCurrentPacketMillis;
+		pSource->length = slots;
+		memcpy(pSource->data, p, slots);
 
-		} else if (!isSourceA && !isSourceB) {
-			printf("9. More than two sources, discarding data\n");
-			assert(0);
-			return;
+		bool sendNewData;
 
+		if (pPort->nSources == 1) {
+			sendNewData = IsDmxDataChanged(i, p, slots);
 		} else {
-			printf("0. No cases matched, this shouldn't happen!\n");
-			assert(0);
-			return;
+			sendNewData = IsMergedDmxDataChanged(i, p, slots);
 		}
 
 		// This bit indicates whether to lock or revert to an unsynchronized state when synchronization is lost
@@ -600,18 +612,14 @@ void E131Bridge::HandleDmx(void) {
 		// new packets until synchronization resumes. When set to 1, once synchronization has been lost,
 		// components that had been operating in a synchronized state need not wait for a new
 		// E1.31 Synchronization Packet in order to update to the next E1.31 Data Packet.
-		if ((m_E131.E131Packet.Data.FrameLayer.Options & E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION) == 0) {
+		if ((m_E131.E131Packet->Data.FrameLayer.Options & E131_OPTIONS_MASK_FORCE_SYNCHRONIZATION) == 0) {
 			// 6.3.3.1 Synchronization Address Usage in an E1.31 Synchronization Packet
 			// An E1.31 Synchronization Packet is sent to synchronize the E1.31 data on a specific universe number.
 			// A Synchronization Address of 0 is thus meaningless, and shall not be transmitted.
 			// Receivers shall ignore E1.31 Synchronization Packets containing a Synchronization Address of 0.
-			if (m_E131.E131Packet.Data.FrameLayer.SynchronizationAddress != 0) {
+			if (m_E131.E131Packet->Data.FrameLayer.SynchronizationAddress != 0) {
 				if (!m_State.IsForcedSynchronized) {
-					if (!(isSourceA || isSourceB)) {
-						SetSynchronizationAddress((pSourceA->ip != 0), (pSourceB->ip != 0), (uint16_t) __builtin_bswap16(m_E131.E131Packet.Data.FrameLayer.SynchronizationAddress));
-					} else {
-						SetSynchronizationAddress(isSourceA, isSourceB, (uint16_t) __builtin_bswap16(m_E131.E131Packet.Data.FrameLayer.SynchronizationAddress));
-					}
+					SetSynchronizationAddress(pSource, (uint16_t) __builtin_bswap16(m_E131.E131Packet->Data.FrameLayer.SynchronizationAddress));
 					m_State.IsForcedSynchronized = true;
 					m_State.IsSynchronized = true;
 				}
@@ -623,15 +631,15 @@ void E131Bridge::HandleDmx(void) {
 		if (sendNewData || m_bDirectUpdate) {
 			if (!m_State.IsSynchronized) {
 
-				m_pLightSet->SetData(i, m_OutputPort[i].data, m_OutputPort[i].length);
+				m_pLightSet->SetData(i, pPort->data, pPort->length);
 
-				if (!m_OutputPort[i].IsTransmitting) {
+				if (!pPort->IsTransmitting) {
 					m_pLightSet->Start(i);
-					m_State.IsChanged |= (!m_OutputPort[i].IsTransmitting);
-					m_OutputPort[i].IsTransmitting = true;
+					m_State.IsChanged |= (!pPort->IsTransmitting);
+					pPort->IsTransmitting = true;
 				}
 			} else {
-				m_OutputPort[i].IsDataPending = sendNewData;
+				pPort->IsDataPending = sendNewData;
 			}
 
 		}
@@ -648,9 +656,9 @@ void E131Bridge::HandleSynchronization(void) {
 	// NOTE: There is no multicast addresses (To Ip) available
 	// We just check if SynchronizationAddress is published by a Source
 
-	const uint16_t nSynchronizationAddress = __builtin_bswap16(m_E131.E131Packet.Synchronization.FrameLayer.UniverseNumber);
+	const uint16_t nSynchronizationAddress = __builtin_bswap16(m_E131.E131Packet->Synchronization.FrameLayer.UniverseNumber);
 
-	if ((nSynchronizationAddress != m_State.nSynchronizationAddressSourceA) && (nSynchronizationAddress != m_State.nSynchronizationAddressSourceB)) {
+	if (!IsSynchronizationAddressInUse(nSynchronizationAddress)) {
 		DEBUG_PUTS("");
 		return;
 	}
@@ -672,57 +680,36 @@ void E131Bridge::HandleSynchronization(void) {
 	}
 }
 
-void E131Bridge::SetNetworkDataLossCondition(bool bSourceA, bool bSourceB) {
-	DEBUG_ENTRY
-	DEBUG_PRINTF("%d %d", bSourceA, bSourceB);
-
-	m_State.IsChanged = true;
+void E131Bridge::StopOutput(uint8_t nPortIndex) {
+	assert(nPortIndex < E131_MAX_PORTS);
 
-	if (bSourceA && bSourceB) {
-		m_State.IsNetworkDataLoss = true;
-		m_State.IsMergeMode = false;
-		m_State.IsSynchronized = false;
-		m_State.IsForcedSynchronized = false;
-		m_State.nPriority = E131_PRIORITY_LOWEST;
-
-		for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
-			if (m_OutputPort[i].IsTransmitting) {
-				m_pLightSet->Stop(i);
-				m_OutputPort[i].sourceA.ip = 0;
-				memset(m_OutputPort[i].sourceA.cid, 0, E131_CID_LENGTH);
-				m_OutputPort[i].sourceB.ip = 0;
-				memset(m_OutputPort[i].sourceB.cid, 0, E131_CID_LENGTH);
-				m_OutputPort[i].length = 0;
-				m_OutputPort[i].IsDataPending = false;
-				m_OutputPort[i].IsTransmitting = false;
-				m_OutputPort[i].IsMerging = false;
-			}
-		}
+	if (m_OutputPort[nPortIndex].IsTransmitting) {
+		m_pLightSet->Stop(nPortIndex);
+		m_OutputPort[nPortIndex].length = 0;
+		m_OutputPort[nPortIndex].IsDataPending = false;
+		m_OutputPort[nPortIndex].IsTransmitting = false;
+		m_State.IsChanged = true;
+	}
+}
 
-	} else {
-		for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
-			if (m_OutputPort[i].IsTransmitting) {
+void E131Bridge::SetNetworkDataLossCondition(void) {
+	DEBUG_ENTRY
 
-				if ((bSourceA) && (m_OutputPort[i].sourceA.ip != 0)) {
-					m_OutputPort[i].sourceA.ip = 0;
-					memset(m_OutputPort[i].sourceA.cid, 0, E131_CID_LENGTH);
-					m_OutputPort[i].IsMerging = false;
-				}
+	m_State.IsChanged = true;
+	m_State.IsNetworkDataLoss = true;
+	m_State.IsMergeMode = false;
+	m_State.IsSynchronized = false;
+	m_State.IsForcedSynchronized = false;
 
-				if ((bSourceB) && (m_OutputPort[i].sourceB.ip != 0)) {
-					m_OutputPort[i].sourceB.ip = 0;
-					memset(m_OutputPort[i].sourceB.cid, 0, E131_CID_LENGTH);
-					m_OutputPort[i].IsMerging = false;
-				}
+	for (uint32_t i = 0; i < E131_MAX_PORTS; i++) {
+		StopOutput(i);
 
-				if (!m_State.IsMergeMode) {
-					m_pLightSet->Stop(i);
-					m_OutputPort[i].length = 0;
-					m_OutputPort[i].IsDataPending = false;
-					m_OutputPort[i].IsTransmitting = false;
-				}
-			}
+		while (m_OutputPort[i].nSources != 0) {
+			m_OutputPort[i].nSources--;
+			LeaveSynchronizationAddress(m_OutputPort[i].source[m_OutputPort[i].nSources].nSynchronizationAddress);
 		}
+
+		m_OutputPort[i].IsMerging = false;
 	}
 
 	DEBUG_EXIT
@@ -771,12 +758,12 @@ void E131Bridge::Clear(uint8_t nPortIndex) {
 bool E131Bridge::IsValidRoot(void) {
 	// 5 E1.31 use of the ACN Root Layer Protocol
 	// Receivers shall discard the packet if the ACN Packet Identifier is not valid.
-	if (memcmp(m_E131.E131Packet.Raw.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, 12) != 0) {
+	if (memcmp(m_E131.E131Packet->Raw.RootLayer.ACNPacketIdentifier, ACN_PACKET_IDENTIFIER, 12) != 0) {
 		return false;
 	}
 	
-	if (m_E131.E131Packet.Raw.RootLayer.Vector != __builtin_bswap32(E131_VECTOR_ROOT_DATA)
-			 && (m_E131.E131Packet.Raw.RootLayer.Vector != __builtin_bswap32(E131_VECTOR_ROOT_EXTENDED)) ) {
+	if (m_E131.E131Packet->Raw.RootLayer.Vector != __builtin_bswap32(E131_VECTOR_ROOT_DATA)
+			 && (m_E131.E131Packet->Raw.RootLayer.Vector != __builtin_bswap32(E131_VECTOR_ROOT_EXTENDED)) ) {
 		return false;
 	}
 
@@ -788,40 +775,69 @@ bool E131Bridge::IsValidDataPacket(void) {
 
 	// The DMP Layer's Vector shall be set to 0x02, which indicates a DMP Set Property message by
 	// transmitters. Receivers shall discard the packet if the received value is not 0x02.
-	if (m_E131.E131Packet.Data.DMPLayer.Vector != (uint8_t)E131_VECTOR_DMP_SET_PROPERTY) {
+	if (m_E131.E131Packet->Data.DMPLayer.Vector != (uint8_t)E131_VECTOR_DMP_SET_PROPERTY) {
 		return false;
 	}
 
 	// Transmitters shall set the DMP Layer's Address Type and Data Type to 0xa1. Receivers shall discard the
 	// packet if the received value is not 0xa1.
-	if (m_E131.E131Packet.Data.DMPLayer.Type != (uint8_t)0xa1) {
+	if (m_E131.E131Packet->Data.DMPLayer.Type != (uint8_t)0xa1) {
 		return false;
 	}
 
 	// Transmitters shall set the DMP Layer's First Property Address to 0x0000. Receivers shall discard the
 	// packet if the received value is not 0x0000.
-	if (m_E131.E131Packet.Data.DMPLayer.FirstAddressProperty != __builtin_bswap16((uint16_t)0x0000)) {
+	if (m_E131.E131Packet->Data.DMPLayer.FirstAddressProperty != __builtin_bswap16((uint16_t)0x0000)) {
 		return false;
 	}
 
 	// Transmitters shall set the DMP Layer's Address Increment to 0x0001. Receivers shall discard the packet if
 	// the received value is not 0x0001.
-	if (m_E131.E131Packet.Data.DMPLayer.AddressIncrement != __builtin_bswap16((uint16_t)0x0001)) {
+	if (m_E131.E131Packet->Data.DMPLayer.AddressIncrement != __builtin_bswap16((uint16_t)0x0001)) {
 		return false;
 	}
 
 	return true;
 }
 
+void E131Bridge::HandlePacket(void) {
+	if (!IsValidRoot()) {
+		return;
+	}
+
+	m_State.IsNetworkDataLoss = false;
+	m_nPreviousPacketMillis = m_nCurrentPacketMillis;
+
+	if (m_State.IsSynchronized && !m_State.IsForcedSynchronized) {
+		if ((m_nCurrentPacketMillis - m_State.SynchronizationTime) >= (uint32_t) (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
+			m_State.IsSynchronized = false;
+		}
+	}
+
+	const uint32_t nRootVector = __builtin_bswap32(m_E131.E131Packet->Raw.RootLayer.Vector);
+
+	if (nRootVector == E131_VECTOR_ROOT_DATA) {
+		if (IsValidDataPacket()) {
+			HandleDmx();
+		}
+	} else if (nRootVector == E131_VECTOR_ROOT_EXTENDED) {
+		const uint32_t nFramingVector = __builtin_bswap32(m_E131.E131Packet->Raw.FrameLayer.Vector);
+			if (nFramingVector == E131_VECTOR_EXTENDED_SYNCHRONIZATION) {
+			HandleSynchronization();
+		}
+	} else {
+		DEBUG_PRINTF("Not supported Root Vector : 0x%x", nRootVector);
+	}
+}
+
 void E131Bridge::Run(void) {
-	const char *packet = (char *) &(m_E131.E131Packet);
-	uint16_t nForeignPort;
+	struct TNetworkPacket aPackets[E131_RECV_BATCH];
 
-	const int nBytesReceived = Network::Get()->RecvFrom(m_nHandle, (uint8_t *)packet, (const uint16_t)sizeof(m_E131.E131Packet), &m_E131.IPAddressFrom, &nForeignPort) ;
+	const uint32_t nPackets = Network::Get()->RecvMany(m_nHandle, aPackets, E131_RECV_BATCH);
 
 	m_nCurrentPacketMillis = Hardware::Get()->Millis();
 
-	if (__builtin_expect((nBytesReceived == 0), 1)) {
+	if (__builtin_expect((nPackets == 0), 1)) {
 		if (m_State.nActiveOutputPorts != 0) {
 			if (!m_State.bDisableNetworkDataLossTimeout && ((m_nCurrentPacketMillis - m_nPreviousPacketMillis) >= (uint32_t)(E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000))) {
 				if (!m_State.IsNetworkDataLoss) {
@@ -845,35 +861,16 @@ void E131Bridge::Run(void) {
 		return;
 	}
 
-	if (!IsValidRoot()) {
-		return;
-	}
-
-	m_State.IsNetworkDataLoss = false;
-	m_nPreviousPacketMillis = m_nCurrentPacketMillis;
-
-	if (m_State.IsSynchronized && !m_State.IsForcedSynchronized) {
-		if ((m_nCurrentPacketMillis - m_State.SynchronizationTime) >= (uint32_t) (E131_NETWORK_DATA_LOSS_TIMEOUT_SECONDS * 1000)) {
-			m_State.IsSynchronized = false;
-		}
-	}
+	for (uint32_t i = 0; i < nPackets; i++) {
+		m_E131.E131Packet = (union UE131Packet *) aPackets[i].pData;
+		m_E131.length = aPackets[i].nSize;
+		m_E131.IPAddressFrom = aPackets[i].nFromIp;
 
-	const uint32_t nRootVector = __builtin_bswap32(m_E131.E131Packet.Raw.RootLayer.Vector);
+		HandlePacket();
 
-	if (nRootVector == E131_VECTOR_ROOT_DATA) {
-		if (IsValidDataPacket()) {
-			HandleDmx();
-		}
-	} else if (nRootVector == E131_VECTOR_ROOT_EXTENDED) {
-		const uint32_t nFramingVector = __builtin_bswap32(m_E131.E131Packet.Raw.FrameLayer.Vector);
-			if (nFramingVector == E131_VECTOR_EXTENDED_SYNCHRONIZATION) {
-			HandleSynchronization();
-		}
-	} else {
-		DEBUG_PRINTF("Not supported Root Vector : 0x%x", nRootVector);
+		Network::Get()->RecvRelease(m_nHandle);
 	}
 
-
 	if (m_pE131DmxIn != 0) {
 		HandleDmxIn();
 		SendDiscoveryPacket();
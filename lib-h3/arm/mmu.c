@@ -125,7 +125,7 @@ uint32_t *mmu_get_page_table(void) {
 	return (uint32_t *) &page_table;
 }
 
-void mmu_enable(void) {
+static void mmu_setup_page_table(void) {
 	uint32_t entry;
 	const uint32_t dram_size = h3_get_dram_size(); // This is already in MEGABYTE
 
@@ -160,7 +160,12 @@ void mmu_enable(void) {
 
 	clean_data_cache();
 	dmb();
+}
 
+/*
+ * Load TTBR0 with the page table and enable the MMU and the caches on the calling core
+ */
+static void mmu_enable_core(void) {
 	uint32_t auxctrl;
 	asm volatile ("mrc p15, 0, %0, c1, c0,  1" : "=r" (auxctrl));
 	auxctrl |= ARM_AUX_CONTROL_SMP;
@@ -196,3 +201,17 @@ void mmu_enable(void) {
 	control |= MMU_MODE;
 	asm volatile ("mcr p15, 0, %0, c1, c0,  0" : : "r" (control) : "memory");
 }
+
+void mmu_enable(void) {
+	mmu_setup_page_table();
+	mmu_enable_core();
+}
+
+#if defined (ARM_ALLOW_MULTI_CORE)
+/**
+ * Called from _init_core in vectors.S. The page table is shared, it is built once by core 0 in \ref mmu_enable.
+ */
+void mmu_enable_secondary(void) {
+	mmu_enable_core();
+}
+#endif
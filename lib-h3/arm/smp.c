@@ -0,0 +1,213 @@
+/**
+ * @file smp.c
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <assert.h>
+
+#include "arm/smp.h"
+
+#if defined (ARM_ALLOW_MULTI_CORE)
+#include "arm/synchronize.h"
+#include "arm/gic.h"
+#include "arm/spsc.h"
+
+#include "h3.h"
+#include "h3_cpu.h"
+
+#define GICC_CTL_ENABLE_GRP0	(1 << 0)
+#define GICC_CTL_ENABLE_GRP1	(1 << 1)
+
+#define GICC_IA_SPURIOUS		1023
+
+struct smp_work {
+	smp_work_fn_t fn;
+	void *arg;
+};
+
+/*
+ * One run queue for each secondary core. There is a single producer for each queue.
+ */
+struct smp_run_queue {
+	struct spsc_queue queue;
+	void *entries[SMP_RUN_QUEUE_SIZE];
+	struct smp_work work[SMP_RUN_QUEUE_SIZE];
+};
+
+static struct smp_run_queue s_run_queue[H3_CPU_COUNT];
+
+static volatile bool core_is_started;		///<
+static start_fn_t start_fn;					///<
+
+
+/*
+ * The CPU interface is banked, each core enables its own.
+ * Interrupts stay masked in the CPSR, a pending SGI wakes up the core from WFI.
+ */
+static void gic_cpuif_init(void) {
+	H3_GIC_DIST->ISENABLE[0] = (1 << SMP_IPI_WAKEUP);
+	H3_GIC_CPUIF->PM = 0xFF;
+	H3_GIC_CPUIF->CTL = GICC_CTL_ENABLE_GRP0 | GICC_CTL_ENABLE_GRP1;
+}
+
+static void ipi_acknowledge(void) {
+	for (;;) {
+		const uint32_t ia = H3_GIC_CPUIF->IA;
+
+		if ((ia & 0x3FF) == GICC_IA_SPURIOUS) {
+			return;
+		}
+
+		H3_GIC_CPUIF->EOI = ia;
+	}
+}
+
+/**
+ * Called from _init_core in vectors.S
+ */
+void smp_core_main(void) {
+	start_fn_t temp_fn = start_fn;
+
+	gic_cpuif_init();
+
+	dmb();
+	core_is_started = true;
+	temp_fn();
+	for (;;)
+		;
+}
+
+/**
+ *
+ * @param core_number
+ * @param start
+ * @return false when the core did not start within SMP_START_TIMEOUT_US, the caller must then run single core
+ */
+bool smp_start_core(uint32_t core_number, start_fn_t start) {
+	if (core_number == 0 || core_number >= H3_CPU_COUNT) {
+		return false;
+	}
+
+	struct smp_run_queue *rq = &s_run_queue[core_number];
+	spsc_init(&rq->queue, rq->entries, SMP_RUN_QUEUE_SIZE);
+
+	start_fn = start;
+	core_is_started = false;
+	clean_data_cache();
+	dmb();
+
+	h3_cpu_on((h3_cpu_t) core_number, (uint32_t) _init_core);
+
+	const uint32_t micros_start = H3_TIMER->AVS_CNT1;
+
+	while (!core_is_started) {
+		if ((H3_TIMER->AVS_CNT1 - micros_start) > SMP_START_TIMEOUT_US) {
+			return false;
+		}
+		dmb();
+	}
+
+	return true;
+}
+
+/**
+ *
+ * @param core_number
+ * @param ipi
+ */
+void smp_send_ipi(uint32_t core_number, uint32_t ipi) {
+	assert(core_number < H3_CPU_COUNT);
+	assert(ipi < 16);
+
+	dsb();
+	H3_GIC_DIST->SGI = (1 << (16 + core_number)) | ipi;
+}
+
+/**
+ * Queue fn(arg) on a core running \\ref smp_run_queue. Only one core may queue work for a given core.
+ *
+ * @param core_number
+ * @param fn
+ * @param arg
+ * @return false when the run queue is full
+ */
+bool smp_queue_work(uint32_t core_number, smp_work_fn_t fn, void *arg) {
+	assert(core_number != 0);
+	assert(core_number < H3_CPU_COUNT);
+	assert(fn != 0);
+
+	struct smp_run_queue *rq = &s_run_queue[core_number];
+
+	if (spsc_is_full(&rq->queue)) {
+		return false;
+	}
+
+	struct smp_work *work = &rq->work[rq->queue.head & (SMP_RUN_QUEUE_SIZE - 1)];
+	work->fn = fn;
+	work->arg = arg;
+
+	spsc_push(&rq->queue, work);
+
+	smp_send_ipi(core_number, SMP_IPI_WAKEUP);
+
+	return true;
+}
+
+/**
+ * Start function for a core which runs the work queued with \\ref smp_queue_work. Does not return.
+ */
+void smp_run_queue(void) {
+	struct smp_run_queue *rq = &s_run_queue[smp_get_core_number()];
+
+	for (;;) {
+		ipi_acknowledge();
+
+		const struct smp_work *work;
+
+		while ((work = (const struct smp_work *) spsc_peek(&rq->queue)) != 0) {
+			// The slot can be reused by smp_queue_work once it is released
+			const smp_work_fn_t fn = work->fn;
+			void *arg = work->arg;
+
+			spsc_release(&rq->queue);
+
+			fn(arg);
+		}
+
+		asm volatile ("wfi");
+	}
+}
+#endif
+
+/**
+ *
+ * @return
+ */
+uint32_t smp_get_core_number(void) {
+	uint32_t core_number;
+	asm volatile ("mrc p15, 0, %0, c0, c0, 5" : "=r" (core_number));
+	return (core_number & SMP_CORE_MASK);
+}
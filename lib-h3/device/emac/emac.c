@@ -51,17 +51,26 @@
 	#define CTL0_SPEED_MASK		0b11
 
 #define TX_CTL0_TX_EN				(1 << 31)
+#define TX_CTL1_TX_MD				(1 << 1)	///< Store and forward, needed for the checksum insertion
 #define TX_CTL1_TX_DMA_EN			(1 << 30)
 
+#define TX_DESC_CIC_FULL			(3 << 27)	///< Insert the IPv4 header and the TCP/UDP/ICMP checksum
+
 #define RX_CTL0_RX_EN				(1 << 31)
 #define RX_CTL1_RX_DMA_EN			(1 << 30)
+#define RX_CTL1_RX_DMA_START		(1 << 31)
 
 #define RX_FRM_FLT_RX_ALL_MULTICAST	(1 << 16)
 
+#define ADDR_HIGH_ENABLE			(1 << 31)	///< ADDR[1..7] only
+#define ADDR_FILTERS				7			///< ADDR[0] is the station address
+
+#define MAC_ADDR_LEN				6
+
 #define	ARM_DMA_ALIGN	64
 
 #define CONFIG_TX_DESCR_NUM	32
-#define CONFIG_RX_DESCR_NUM	32
+#define CONFIG_RX_DESCR_NUM	128 /* Shared receive pool for the UDP sockets, the coherent region is shared at 1/2 MB */
 #define CONFIG_ETH_BUFSIZE	2048 /* Note must be dma aligned */
 /*
  * The datasheet says that each descriptor can transfers up to 4096 bytes
@@ -70,6 +79,17 @@
  */
 #define CONFIG_ETH_RXSIZE	2044 /* Note must fit in ETH_BUFSIZE */
 
+/*
+ * Receive buffers lent to the UDP layer (zero-copy receive).
+ * A few descriptors are always kept for the DMA.
+ */
+#define CONFIG_RX_HELD_MAX	(CONFIG_RX_DESCR_NUM - 8)
+/*
+ * A lent buffer this close ahead of the receive position is taken back,
+ * before the DMA wraps onto it and stops.
+ */
+#define CONFIG_RX_GUARD		16
+
 #define TX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_TX_DESCR_NUM)
 #define RX_TOTAL_BUFSIZE	(CONFIG_ETH_BUFSIZE * CONFIG_RX_DESCR_NUM)
 
@@ -83,16 +103,23 @@ struct emac_dma_desc {
 } __aligned(ARM_DMA_ALIGN);
 
 struct coherent_region {
-	struct emac_dma_desc rx_chain[CONFIG_TX_DESCR_NUM];
-	struct emac_dma_desc tx_chain[CONFIG_RX_DESCR_NUM];
+	struct emac_dma_desc rx_chain[CONFIG_RX_DESCR_NUM];
+	struct emac_dma_desc tx_chain[CONFIG_TX_DESCR_NUM];
 	char rxbuffer[RX_TOTAL_BUFSIZE] __aligned(ARM_DMA_ALIGN);
 	char txbuffer[TX_TOTAL_BUFSIZE] __aligned(ARM_DMA_ALIGN);
 	uint32_t rx_currdescnum;
 	uint32_t tx_currdescnum;
 };
 
+/* The coherent region above 1/2 MB is used by the other DMA drivers */
+_Static_assert(sizeof(struct coherent_region) <= (MEGABYTE / 2), "The EMAC rings must fit in 1/2 MB");
+
 static struct coherent_region *p_coherent_region = 0;
 
+static bool s_rx_held[CONFIG_RX_DESCR_NUM];
+static uint32_t s_rx_held_count;
+static bool s_rx_hold_current;
+
 #define H3_EPHY_DEFAULT_VALUE	0x00058000
 #define H3_EPHY_DEFAULT_MASK	0xFFFF8000
 #define H3_EPHY_ADDR_SHIFT		20
@@ -142,6 +169,40 @@ void _write_hwaddr(uint8_t *mac_id) {
 	H3_EMAC->ADDR[0].LOW = macid_lo;
 }
 
+/**
+ * Program the multicast filter.
+ * Up to 7 addresses are matched exactly, above that all multicast frames are received (as dwmac-sun8i does).
+ * The 64 bin hash table is not used, its CRC bit order and word order are not verified on hardware.
+ *
+ * @param mac_addresses count * MAC_ADDR_LEN bytes, 0 receives all multicast frames
+ * @param count
+ */
+void emac_set_multicast_filter(const uint8_t *mac_addresses, uint32_t count) {
+	uint32_t i;
+
+	for (i = 1; i <= ADDR_FILTERS; i++) {
+		H3_EMAC->ADDR[i].HIGH = 0;
+		H3_EMAC->ADDR[i].LOW = 0;
+	}
+
+	H3_EMAC->RX_HASH0 = 0;
+	H3_EMAC->RX_HASH1 = 0;
+
+	if ((mac_addresses == 0) || (count > ADDR_FILTERS)) {
+		H3_EMAC->RX_FRM_FLT = RX_FRM_FLT_RX_ALL_MULTICAST;
+		return;
+	}
+
+	for (i = 0; i < count; i++) {
+		const uint8_t *mac_id = &mac_addresses[i * MAC_ADDR_LEN];
+
+		H3_EMAC->ADDR[1 + i].HIGH = ADDR_HIGH_ENABLE | mac_id[4] | (mac_id[5] << 8);
+		H3_EMAC->ADDR[1 + i].LOW = mac_id[0] | (mac_id[1] << 8) | (mac_id[2] << 16) | (mac_id[3] << 24);
+	}
+
+	H3_EMAC->RX_FRM_FLT = 0;
+}
+
 void _set_syscon_ephy(void) {
 	/* H3 based SoC's that has an Internal 100MBit PHY
 	 * needs to be configured and powered up before use
@@ -223,6 +284,13 @@ static void _rx_descs_init(void) {
 
 	H3_EMAC->RX_DMA_DESC = (uintptr_t)&desc_table_p[0];
 	p_coherent_region->rx_currdescnum = 0;
+
+	for (idx = 0; idx < CONFIG_RX_DESCR_NUM; idx++) {
+		s_rx_held[idx] = false;
+	}
+
+	s_rx_held_count = 0;
+	s_rx_hold_current = false;
 }
 
 static void _tx_descs_init(void) {
@@ -251,6 +319,11 @@ int emac_eth_recv(uint8_t **packetp) {
 	struct emac_dma_desc *desc_p = &p_coherent_region->rx_chain[desc_num];
 	int length;
 
+	/* All the buffers up to here are still lent out */
+	if (__builtin_expect(s_rx_held[desc_num], 0)) {
+		return -1;
+	}
+
 	status = desc_p->status;
 
 	/* Check for DMA own bit */
@@ -278,17 +351,22 @@ int emac_eth_recv(uint8_t **packetp) {
 	return -1;
 }
 
-void emac_eth_send(void *packet, int len) {
+static void _eth_send(const void *header, uint32_t header_len, const void *payload, uint32_t payload_len, uint32_t st) {
 	uint32_t value;
 	uint32_t desc_num = p_coherent_region->tx_currdescnum;
 	struct emac_dma_desc *desc_p = &p_coherent_region->tx_chain[desc_num];
-	uintptr_t data_start = (uintptr_t) desc_p->buf_addr;
+	uint8_t *data_start = (uint8_t *) desc_p->buf_addr;
+	const uint32_t len = header_len + payload_len;
 
-	desc_p->st = len;
+	desc_p->st = len | st;
 	/* Mandatory undocumented bit */
 	desc_p->st |= (1 << 24);
 
-	memcpy((void *) data_start, packet, len);
+	memcpy(data_start, header, header_len);
+
+	if (payload_len != 0) {
+		memcpy(&data_start[header_len], payload, payload_len);
+	}
 
 	debug_dump((void *) data_start, (uint16_t) len);
 
@@ -314,12 +392,82 @@ void emac_eth_send(void *packet, int len) {
 	H3_EMAC->TX_CTL1 = value;
 }
 
+void emac_eth_send(void *packet, int len) {
+	_eth_send(packet, (uint32_t) len, 0, 0, 0);
+}
+
+/*
+ * Gather send for IPv4 frames : the header and the payload are copied straight into the DMA buffer.
+ * The EMAC inserts the IPv4 header checksum and the UDP checksum, both must be 0.
+ */
+void emac_eth_send_gather(const void *header, uint32_t header_len, const void *payload, uint32_t payload_len) {
+	_eth_send(header, header_len, payload, payload_len, TX_DESC_CIC_FULL);
+}
+
+/*
+ * Keep the current receive buffer when emac_free_pkt is called.
+ * It is given back to the DMA with emac_eth_release.
+ */
+int emac_eth_hold(void) {
+	if (s_rx_held_count >= CONFIG_RX_HELD_MAX) {
+		return -1;
+	}
+
+	s_rx_hold_current = true;
+
+	return 0;
+}
+
+static uint32_t _rx_desc_num(const uint8_t *packet) {
+	return ((uintptr_t) packet - (uintptr_t) &p_coherent_region->rxbuffer[0]) / CONFIG_ETH_BUFSIZE;
+}
+
+void emac_eth_release(const uint8_t *packet) {
+	const uint32_t desc_num = _rx_desc_num(packet);
+	struct emac_dma_desc *desc_p = &p_coherent_region->rx_chain[desc_num];
+
+	assert(desc_num < CONFIG_RX_DESCR_NUM);
+	assert(s_rx_held[desc_num]);
+
+	s_rx_held[desc_num] = false;
+	s_rx_held_count--;
+
+	desc_p->status |= (1 << 31);
+
+	/* The DMA is suspended when it did run into a lent buffer */
+	H3_EMAC->RX_CTL1 |= RX_CTL1_RX_DMA_START;
+}
+
+/*
+ * The receive DMA stops at a lent buffer, and with it all receive, ARP and ICMP included.
+ * True when the buffer of packet is less than CONFIG_RX_GUARD descriptors ahead of the receive position.
+ */
+bool emac_eth_is_overtaken(const uint8_t *packet) {
+	const uint32_t desc_num = _rx_desc_num(packet);
+
+	assert(desc_num < CONFIG_RX_DESCR_NUM);
+
+	uint32_t distance = desc_num + CONFIG_RX_DESCR_NUM - p_coherent_region->rx_currdescnum;
+
+	if (distance >= CONFIG_RX_DESCR_NUM) {
+		distance -= CONFIG_RX_DESCR_NUM;
+	}
+
+	return distance < CONFIG_RX_GUARD;
+}
+
 void emac_free_pkt(void) {
 	uint32_t desc_num = p_coherent_region->rx_currdescnum;
 	struct emac_dma_desc *desc_p = &p_coherent_region->rx_chain[desc_num];
 
-	/* Make the current descriptor valid again */
-	desc_p->status |= (1 << 31);
+	if (s_rx_hold_current) {
+		s_rx_hold_current = false;
+		s_rx_held[desc_num] = true;
+		s_rx_held_count++;
+	} else {
+		/* Make the current descriptor valid again */
+		desc_p->status |= (1 << 31);
+	}
 
 	/* Move to next desc and wrap-around condition. */
 	if (++desc_num >= CONFIG_RX_DESCR_NUM) {
@@ -418,7 +566,7 @@ void emac_start(bool reset_emac) {
 	H3_EMAC->RX_CTL1 = value;
 
 	value = H3_EMAC->TX_CTL1;
-	value |= TX_CTL1_TX_DMA_EN;
+	value |= TX_CTL1_TX_MD | TX_CTL1_TX_DMA_EN;
 	H3_EMAC->TX_CTL1 = value;
 
 	value = H3_EMAC->RX_CTL0;
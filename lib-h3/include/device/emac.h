@@ -36,6 +36,7 @@ extern "C" {
 extern void emac_init(void);
 extern void emac_start(bool reset_emac);
 extern void emac_shutdown(void);
+extern void emac_set_multicast_filter(const uint8_t *, uint32_t);
 
 #ifdef __cplusplus
 }
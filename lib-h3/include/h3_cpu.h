@@ -41,6 +41,7 @@ typedef enum h3_cpu {
 extern "C" {
 #endif
 
+extern void h3_cpu_on(h3_cpu_t, uint32_t);
 extern void h3_cpu_off(h3_cpu_t);
 
 extern void h3_cpu_set_clock(uint64_t);
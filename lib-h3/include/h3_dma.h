@@ -37,7 +37,9 @@ enum H3_DMA_DRQDST {
 	DRQDST_UART1TX = 7,
 	DRQDST_UART2TX = 8,
 	DRQDST_UART3TX = 9,
-	DRQDST_AUDIO_CODEC = 15
+	DRQDST_AUDIO_CODEC = 15,
+	DRQDST_SPI0TX = 23,
+	DRQDST_SPI1TX = 24
 };
 
 	#define DMA_IRQ_EN_MASK			(0x07)
@@ -43,6 +43,23 @@ struct ip_info {
 
 #define IP_BROADCAST	((uint32_t) 0xFFFFFFFF)
 
+#define UDP_RECV_DEPTH_DEFAULT	4
+
+struct udp_stats {
+	uint32_t rx;				///< Packets queued
+	uint32_t dropped;			///< Queue full or no receive buffer available
+	uint32_t high_water_mark;	///< Maximum number of packets queued
+	uint32_t depth;				///< Queue depth set at bind time
+};
+
+struct igmp_stats {
+	uint32_t rx;				///< Multicast frames passed by the EMAC filter
+	uint32_t dropped;			///< Multicast frames dropped in software, the group is not joined
+	uint32_t groups;			///< Joined groups
+	uint32_t filter_entries;	///< MAC addresses programmed in the EMAC filter
+	bool hash_filter;			///< false : exact match, true : hash table
+};
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -54,12 +71,19 @@ extern void net_set_ip(uint32_t);
 extern void net_set_default_ip(struct ip_info *);
 //
 extern int udp_bind(uint16_t);
+extern int udp_bind_depth(uint16_t, uint32_t);
 extern int udp_unbind(uint16_t);
 extern uint16_t udp_recv(uint8_t, uint8_t *, uint16_t, uint32_t *, uint16_t *);
+extern uint16_t udp_recv_borrow(uint8_t, const uint8_t **, uint32_t *, uint16_t *);
+extern uint16_t udp_recv_peek(uint8_t, uint32_t, const uint8_t **, uint32_t *, uint16_t *);
+extern void udp_recv_release(uint8_t);
+extern void udp_get_stats(uint8_t, struct udp_stats *);
 extern int udp_send(uint8_t, const uint8_t *, uint16_t, uint32_t, uint16_t);
 //
 extern int igmp_join(uint32_t);
 extern int igmp_leave(uint32_t);
+extern void igmp_set_multicast_filter(bool);
+extern void igmp_get_stats(struct igmp_stats *);
 
 #ifdef __cplusplus
 }
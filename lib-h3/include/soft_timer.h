@@ -0,0 +1,83 @@
+/**
+ * @file soft_timer.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef SOFT_TIMER_H_
+#define SOFT_TIMER_H_
+
+#include <stdint.h>
+
+/*
+ * Software timers, multiplexed on H3 Timer 1.
+ * Timer 0 is left for the DMX break and mark-after-break timing.
+ */
+
+#if !defined (SOFT_TIMER_MAX)
+ #define SOFT_TIMER_MAX	8
+#endif
+
+typedef void (*thunk_soft_timer_t)(const uint32_t);	///< Called in IRQ context, with the AVS counter (us)
+
+struct soft_timer_stats {
+	uint32_t count;		///< Number of expiries
+	uint32_t late_max;	///< Maximum latency after the deadline (us)
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+extern void soft_timer_init(void);
+
+/**
+ * A timer may fire up to slack_us after its deadline, so that
+ * timers with overlapping windows share one interrupt.
+ * Return the timer id, or -1 when all timers are in use.
+ * A one-shot timer is released when it expires.
+ */
+extern int32_t soft_timer_oneshot(thunk_soft_timer_t func, uint32_t delay_us, uint32_t slack_us);
+extern int32_t soft_timer_periodic(thunk_soft_timer_t func, uint32_t period_us, uint32_t slack_us);
+/**
+ * A periodic timer firing rate times per second, without accumulated rounding error.
+ */
+extern int32_t soft_timer_rate(thunk_soft_timer_t func, uint32_t rate, uint32_t slack_us);
+
+/**
+ * Restart a periodic timer from now. With rate != 0 it gets the new rate.
+ */
+extern void soft_timer_restart(int32_t id, uint32_t rate);
+/**
+ * Stop keeps the timer id, cancel releases it.
+ */
+extern void soft_timer_stop(int32_t id);
+extern void soft_timer_cancel(int32_t id);
+
+extern void soft_timer_get_stats(int32_t id, struct soft_timer_stats *stats);
+extern void soft_timer_print(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SOFT_TIMER_H_ */
@@ -24,6 +24,7 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <assert.h>
 
@@ -35,13 +36,47 @@
 #endif
 
 extern void arp_send_request(uint32_t ip);
-extern void net_handle(void);
+extern void emac_eth_send_gather(const void *, uint32_t, const void *, uint32_t);
 
-#define MAX_RECORDS	32
+#define MAX_RECORDS			32
+#define HASH_SIZE			32	///< Power of 2
+
+#define MAX_PENDING			16	///< Frames waiting for an ARP reply, shared by all destinations
+#define MAX_PENDING_PER_IP	4
+
+/*
+ * The timer runs every 1/10 second
+ */
+#define ARP_TTL_TICKS		(10 * 60 * 10)	///< 10 minutes
+#define ARP_RETRY_TICKS		10				///< 1 second
+#define ARP_MAX_RETRIES		3
+
+#define NO_ENTRY			(-1)
+
+typedef enum arp_state {
+	ARP_STATE_FREE = 0,
+	ARP_STATE_PENDING,		///< Request sent, no MAC address yet
+	ARP_STATE_VALID,
+	ARP_STATE_REFRESH		///< TTL expired, the MAC address is used until the retries are done
+} _arp_state;
 
 struct t_arp_record {
 	uint32_t ip;
+	uint32_t ticks;			///< Last reply, or last request sent when PENDING / REFRESH
+	uint32_t ticks_used;	///< Last lookup, for the LRU eviction
 	uint8_t mac_address[ETH_ADDR_LEN];
+	uint8_t state;
+	uint8_t retries;
+	int8_t next;			///< Hash chain
+	int8_t pending_head;	///< Queued frames, FIFO
+	int8_t pending_tail;
+	uint8_t pending_count;
+} ALIGNED;
+
+struct t_arp_pending {
+	int8_t next;
+	uint16_t length;
+	uint8_t frame[sizeof(struct t_udp)] ALIGNED;
 } ALIGNED;
 
 typedef union pcast32 {
@@ -50,7 +85,11 @@ typedef union pcast32 {
 } _pcast32;
 
 static struct t_arp_record s_arp_records[MAX_RECORDS] ALIGNED;
-static uint16_t s_entry_current;
+static int8_t s_hash[HASH_SIZE];
+static struct t_arp_pending s_pending[MAX_PENDING] ALIGNED;
+static int8_t s_pending_free;
+static uint32_t s_pending_dropped;
+static uint32_t s_ticks;
 static uint8_t s_multicast_mac[ETH_ADDR_LEN] = {0x01, 0x00, 0x5E}; // Fixed part
 
 #ifndef NDEBUG
@@ -58,16 +97,115 @@ static uint8_t s_multicast_mac[ETH_ADDR_LEN] = {0x01, 0x00, 0x5E}; // Fixed part
  static volatile uint32_t s_ticker ;
 #endif
 
-void arp_cache_init(void) {
-	uint16_t i;
+static inline uint32_t _hash(uint32_t ip) {
+	return (ip ^ (ip >> 8) ^ (ip >> 16) ^ (ip >> 24)) & (HASH_SIZE - 1);
+}
+
+static int32_t _find(uint32_t ip) {
+	int32_t i = s_hash[_hash(ip)];
+
+	while (i != NO_ENTRY) {
+		if (s_arp_records[i].ip == ip) {
+			return i;
+		}
+		i = s_arp_records[i].next;
+	}
+
+	return NO_ENTRY;
+}
+
+static void _pending_free(struct t_arp_record *p_record) {
+	while (p_record->pending_head != NO_ENTRY) {
+		const int8_t i = p_record->pending_head;
+
+		p_record->pending_head = s_pending[i].next;
+		s_pending[i].next = s_pending_free;
+		s_pending_free = i;
+		s_pending_dropped++;
+	}
+
+	p_record->pending_tail = NO_ENTRY;
+	p_record->pending_count = 0;
+}
+
+static void _remove(int32_t index) {
+	struct t_arp_record *p_record = &s_arp_records[index];
+	int8_t *p = &s_hash[_hash(p_record->ip)];
+
+	while (*p != NO_ENTRY) {
+		if (*p == index) {
+			*p = p_record->next;
+			break;
+		}
+		p = &s_arp_records[*p].next;
+	}
+
+	_pending_free(p_record);
 
-	s_entry_current = 0;
+	p_record->ip = 0;
+	p_record->state = ARP_STATE_FREE;
+}
+
+/*
+ * A free record, or else the least recently used one.
+ */
+static int32_t _insert(uint32_t ip) {
+	int32_t index = NO_ENTRY;
+	int32_t i;
 
 	for (i = 0; i < MAX_RECORDS; i++) {
-		s_arp_records[i].ip = 0;
-		memset(s_arp_records[i].mac_address, 0, ETH_ADDR_LEN);
+		if (s_arp_records[i].state == ARP_STATE_FREE) {
+			index = i;
+			break;
+		}
+
+		if ((index == NO_ENTRY) || ((s_ticks - s_arp_records[i].ticks_used) > (s_ticks - s_arp_records[index].ticks_used))) {
+			index = i;
+		}
+	}
+
+	if (s_arp_records[index].state != ARP_STATE_FREE) {
+		DEBUG_PRINTF("Evict " IPSTR, IP2STR(s_arp_records[index].ip));
+		_remove(index);
 	}
 
+	struct t_arp_record *p_record = &s_arp_records[index];
+	const uint32_t hash = _hash(ip);
+
+	p_record->ip = ip;
+	p_record->ticks = s_ticks;
+	p_record->ticks_used = s_ticks;
+	p_record->retries = 0;
+	p_record->pending_head = NO_ENTRY;
+	p_record->pending_tail = NO_ENTRY;
+	p_record->pending_count = 0;
+	p_record->next = s_hash[hash];
+	s_hash[hash] = index;
+
+	return index;
+}
+
+void arp_cache_init(void) {
+	uint32_t i;
+
+	for (i = 0; i < MAX_RECORDS; i++) {
+		memset(&s_arp_records[i], 0, sizeof(struct t_arp_record));
+		s_arp_records[i].next = NO_ENTRY;
+		s_arp_records[i].pending_head = NO_ENTRY;
+		s_arp_records[i].pending_tail = NO_ENTRY;
+	}
+
+	for (i = 0; i < HASH_SIZE; i++) {
+		s_hash[i] = NO_ENTRY;
+	}
+
+	for (i = 0; i < MAX_PENDING; i++) {
+		s_pending[i].next = (i + 1 < MAX_PENDING) ? (int8_t) (i + 1) : NO_ENTRY;
+	}
+
+	s_pending_free = 0;
+	s_pending_dropped = 0;
+
 #ifndef NDEBUG
 	s_ticker = TICKER_COUNT;
 #endif
@@ -75,27 +213,44 @@ void arp_cache_init(void) {
 
 void arp_cache_update(uint8_t *mac_address, uint32_t ip) {
 	DEBUG2_ENTRY
-	uint16_t i;
 
-	if (s_entry_current == MAX_RECORDS) {
-		assert(0);
-		return;
-	}
+	int32_t index = _find(ip);
 
-	for (i = 0; i < s_entry_current; i++) {
-		if (s_arp_records[i].ip == ip) {
-			return;
-		}
+	if (index == NO_ENTRY) {
+		index = _insert(ip);
 	}
 
-	memcpy(s_arp_records[s_entry_current].mac_address, mac_address, ETH_ADDR_LEN);
-	s_arp_records[s_entry_current].ip = ip;
+	struct t_arp_record *p_record = &s_arp_records[index];
+
+	memcpy(p_record->mac_address, mac_address, ETH_ADDR_LEN);
+	p_record->state = ARP_STATE_VALID;
+	p_record->ticks = s_ticks;
+	p_record->retries = 0;
 
-	s_entry_current++;
+	// Send the frames which were waiting for this reply
+	while (p_record->pending_head != NO_ENTRY) {
+		const int8_t i = p_record->pending_head;
+		struct t_arp_pending *p_pending = &s_pending[i];
+
+		memcpy(p_pending->frame, mac_address, ETH_ADDR_LEN);
+		emac_eth_send_gather(p_pending->frame, p_pending->length, 0, 0);
+
+		p_record->pending_head = p_pending->next;
+		p_pending->next = s_pending_free;
+		s_pending_free = i;
+	}
+
+	p_record->pending_tail = NO_ENTRY;
+	p_record->pending_count = 0;
 
 	DEBUG2_EXIT
 }
 
+/**
+ * Non blocking. On a miss an ARP request is sent, the frame can be queued with \ref arp_cache_queue.
+ *
+ * @return ip when the MAC address is known, else 0
+ */
 uint32_t arp_cache_lookup(uint32_t ip, uint8_t *mac_address) {
 	DEBUG2_ENTRY
 
@@ -112,67 +267,145 @@ uint32_t arp_cache_lookup(uint32_t ip, uint8_t *mac_address) {
 		return ip;
 	}
 
-	DEBUG_PRINTF(IPSTR " " MACSTR, IP2STR(ip), MAC2STR(mac_address));
+	const int32_t index = _find(ip);
 
-	uint16_t i;
+	if (__builtin_expect((index != NO_ENTRY), 1)) {
+		struct t_arp_record *p_record = &s_arp_records[index];
 
-	for (i = 0; i < MAX_RECORDS; i++) {
-		if (s_arp_records[i].ip == ip) {
-			memcpy(mac_address, s_arp_records[i].mac_address, ETH_ADDR_LEN);
+		if (p_record->state != ARP_STATE_PENDING) {
+			memcpy(mac_address, p_record->mac_address, ETH_ADDR_LEN);
+			p_record->ticks_used = s_ticks;
+			DEBUG2_EXIT
 			return ip;
 		}
 
-		if (s_arp_records[i].ip == 0) {
-			break;
-		}
+		DEBUG2_EXIT
+		return 0;
 	}
 
-	uint16_t current_entry = s_entry_current;
-	int32_t timeout;
-	int8_t retries = 3;
+	DEBUG_PRINTF(IPSTR, IP2STR(ip));
 
-	while (retries--) {
-		arp_send_request(ip);
+	s_arp_records[_insert(ip)].state = ARP_STATE_PENDING;
+	arp_send_request(ip);
 
-		timeout = 0xFFFF;
+	DEBUG2_EXIT
+	return 0;
+}
 
-		while ((timeout-- > 0) && (current_entry == s_entry_current)) {
-			net_handle();
-		}
+/**
+ * Keep a copy of the UDP frame (header and payload) until the ARP reply for ip arrives.
+ * When the queue for ip is full, the oldest frame is replaced.
+ *
+ * @return 0 when queued, -1 when there is no free queue entry
+ */
+int arp_cache_queue(uint32_t ip, const void *header, uint32_t header_length, const void *payload, uint32_t payload_length) {
+	const int32_t index = _find(ip);
 
-		if (current_entry != s_entry_current) {
-			memcpy(mac_address, s_arp_records[current_entry].mac_address, ETH_ADDR_LEN);
-			DEBUG_PRINTF("timeout=%x", timeout);
-			return ip;
-		}
+	assert((header_length + payload_length) <= sizeof(struct t_udp));
 
-		DEBUG_PRINTF("i=%d, timeout=%d, current_entry=%d, s_entry_current=%d", i, timeout, current_entry, s_entry_current);
+	if ((index == NO_ENTRY) || (s_arp_records[index].state != ARP_STATE_PENDING)) {
+		return -1;
 	}
 
-	DEBUG2_EXIT
+	struct t_arp_record *p_record = &s_arp_records[index];
+	int8_t i;
+
+	if ((p_record->pending_count == MAX_PENDING_PER_IP) || ((s_pending_free == NO_ENTRY) && (p_record->pending_count != 0))) {
+		i = p_record->pending_head;
+		p_record->pending_head = s_pending[i].next;
+		p_record->pending_count--;
+		s_pending_dropped++;
+	} else if (s_pending_free != NO_ENTRY) {
+		i = s_pending_free;
+		s_pending_free = s_pending[i].next;
+	} else {
+		s_pending_dropped++;
+		return -1;
+	}
+
+	struct t_arp_pending *p_pending = &s_pending[i];
+
+	memcpy(p_pending->frame, header, header_length);
+	memcpy(&p_pending->frame[header_length], payload, payload_length);
+	p_pending->length = (uint16_t) (header_length + payload_length);
+	p_pending->next = NO_ENTRY;
+
+	if (p_record->pending_head == NO_ENTRY) {
+		p_record->pending_head = i;
+	} else {
+		s_pending[p_record->pending_tail].next = i;
+	}
+
+	p_record->pending_tail = i;
+	p_record->pending_count++;
+
 	return 0;
 }
 
 void arp_cache_dump(void) {
 #ifndef NDEBUG
-	uint16_t i;
+	uint32_t i;
 
-	printf("ARP Cache size=%d\n", s_entry_current);
+	printf("ARP Cache, dropped=%d\n", s_pending_dropped);
 
-	for (i = 0; i < s_entry_current; i++) {
-		printf("%02d " IPSTR " " MACSTR "\n", i, IP2STR(s_arp_records[i].ip),MAC2STR(s_arp_records[i].mac_address));
+	for (i = 0; i < MAX_RECORDS; i++) {
+		if (s_arp_records[i].state != ARP_STATE_FREE) {
+			printf("%02d " IPSTR " " MACSTR " %d %d\n", i, IP2STR(s_arp_records[i].ip), MAC2STR(s_arp_records[i].mac_address), s_arp_records[i].state, s_arp_records[i].pending_count);
+		}
 	}
 #endif
 }
 
-#ifndef NDEBUG
+/**
+ * Called every 1/10 second.
+ * Retries pending requests, refreshes the entries in use when the TTL expires and removes the others.
+ */
 void arp_cache_timer(void) {
+	uint32_t i;
+
+	s_ticks++;
+
+	for (i = 0; i < MAX_RECORDS; i++) {
+		struct t_arp_record *p_record = &s_arp_records[i];
+		const uint32_t age = s_ticks - p_record->ticks;
+
+		switch (p_record->state) {
+		case ARP_STATE_VALID:
+			if (age >= ARP_TTL_TICKS) {
+				if ((s_ticks - p_record->ticks_used) < ARP_TTL_TICKS) {
+					p_record->state = ARP_STATE_REFRESH;
+					p_record->ticks = s_ticks;
+					p_record->retries = 0;
+					arp_send_request(p_record->ip);
+				} else {
+					_remove(i);
+				}
+			}
+			break;
+		case ARP_STATE_PENDING:
+		case ARP_STATE_REFRESH:
+			if (age >= ARP_RETRY_TICKS) {
+				if (p_record->retries < ARP_MAX_RETRIES) {
+					p_record->retries++;
+					p_record->ticks = s_ticks;
+					arp_send_request(p_record->ip);
+				} else {
+					DEBUG_PRINTF("No reply " IPSTR, IP2STR(p_record->ip));
+					_remove(i);
+				}
+			}
+			break;
+		default:
+			break;
+		}
+	}
+
+#ifndef NDEBUG
 	s_ticker--;
 
 	if (s_ticker == 0) {
 		s_ticker = TICKER_COUNT;
 		arp_cache_dump();
 	}
-}
 #endif
-
+}
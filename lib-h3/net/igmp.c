@@ -38,9 +38,12 @@
 
 extern uint16_t net_chksum(void *, uint32_t);
 extern void emac_eth_send(void *, int);
+extern void emac_set_multicast_filter(const uint8_t *, uint32_t);
 
 #define MAX_JOINS_ALLOWED	(4 + (4 * 4))
 
+#define IGMP_ALL_HOSTS		0x010000e0	///< 224.0.0.1
+
 typedef enum s_state {
 	NON_MEMBER = 0,
 	DELAYING_MEMBER,
@@ -64,6 +67,59 @@ static uint8_t s_multicast_mac[ETH_ADDR_LEN] ALIGNED;
 static struct t_group_info s_groups[MAX_JOINS_ALLOWED] ALIGNED;
 static uint32_t s_joins_allowed_index;
 static uint16_t s_id ALIGNED;
+static uint8_t s_filter[(1 + MAX_JOINS_ALLOWED) * ETH_ADDR_LEN] ALIGNED;
+static bool s_filter_enabled = true;
+static struct igmp_stats s_stats;
+
+static void _multicast_mac(uint32_t group_address, uint8_t *mac_address) {
+	_pcast32 multicast_ip;
+
+	multicast_ip.u32 = group_address;
+
+	mac_address[0] = 0x01;
+	mac_address[1] = 0x00;
+	mac_address[2] = 0x5E;
+	mac_address[3] = multicast_ip.u8[1] & 0x7F;
+	mac_address[4] = multicast_ip.u8[2];
+	mac_address[5] = multicast_ip.u8[3];
+}
+
+/*
+ * The EMAC filter passes the all-hosts group (IGMP queries) and the joined groups.
+ * Groups which map to the same MAC address are added once.
+ */
+static void _update_filter(void) {
+	uint32_t count = 0;
+	uint32_t i, j;
+
+	_multicast_mac(IGMP_ALL_HOSTS, &s_filter[0]);
+	count++;
+
+	for (i = 0; i < s_joins_allowed_index; i++) {
+		if (s_groups[i].state == NON_MEMBER) {
+			continue;
+		}
+
+		uint8_t *mac_address = &s_filter[count * ETH_ADDR_LEN];
+
+		_multicast_mac(s_groups[i].group_address, mac_address);
+
+		for (j = 0; j < count; j++) {
+			if (memcmp(&s_filter[j * ETH_ADDR_LEN], mac_address, ETH_ADDR_LEN) == 0) {
+				break;
+			}
+		}
+
+		if (j == count) {
+			count++;
+		}
+	}
+
+	s_stats.groups = count - 1;
+	s_stats.filter_entries = count;
+
+	emac_set_multicast_filter(s_filter_enabled ? s_filter : 0, count);
+}
 
 void igmp_set_ip(const struct ip_info  *p_ip_info) {
 	_pcast32 src;
@@ -84,6 +140,9 @@ void igmp_init(uint8_t *mac_address, const struct ip_info  *p_ip_info) {
 	s_joins_allowed_index = 0;
 	s_id = 0;
 
+	memset(&s_stats, 0, sizeof(struct igmp_stats));
+	_update_filter();
+
 	igmp_set_ip(p_ip_info);
 
 	s_multicast_mac[0] = 0x01;
@@ -272,6 +331,7 @@ int igmp_join(uint32_t group_address) {
 
 	s_joins_allowed_index++;
 
+	_update_filter();
 	_send_report(group_address);
 
 	return current_index;
@@ -296,7 +356,46 @@ int igmp_leave(uint32_t group_address) {
 	s_groups[i].state = NON_MEMBER;
 	s_groups[i].timer = 0;
 
+	_update_filter();
+
 	return 0;
 }
 
+/**
+ * Software exact match for the multicast frames which passed the EMAC filter.
+ * The hash filter passes all groups that share a bin with a joined group.
+ */
+bool igmp_accept(uint32_t group_address) {
+	uint32_t i;
+
+	s_stats.rx++;
+
+	if (group_address == IGMP_ALL_HOSTS) {
+		return true;
+	}
+
+	for (i = 0; i < s_joins_allowed_index; i++) {
+		if (s_groups[i].group_address == group_address) {
+			return true;
+		}
+	}
+
+	s_stats.dropped++;
+
+	return false;
+}
+
+/**
+ * When disabled, the EMAC receives all multicast frames. Used for comparing the counters.
+ */
+void igmp_set_multicast_filter(bool enable) {
+	s_filter_enabled = enable;
+	_update_filter();
+}
+
+void igmp_get_stats(struct igmp_stats *p_stats) {
+	s_stats.hash_filter = s_filter_enabled && (s_stats.filter_entries > 7);
+	memcpy(p_stats, &s_stats, sizeof(struct igmp_stats));
+}
+
 // <---
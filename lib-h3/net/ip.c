@@ -24,6 +24,8 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
 
 #include "net/net.h"
 
@@ -41,6 +43,7 @@ extern void udp_handle(struct t_udp *);
 extern void igmp_init(const uint8_t *, const struct ip_info  *);
 extern void igmp_set_ip(const struct ip_info  *);
 extern void igmp_handle(struct t_igmp *);
+extern bool igmp_accept(uint32_t);
 
 extern void icmp_init(const uint8_t *, const struct ip_info  *);
 extern void icmp_set_ip(const struct ip_info  *);
@@ -68,6 +71,15 @@ void ip_handle(struct t_ip4 *p_ip4) {
 		return;
 	}
 
+	if ((p_ip4->ip4.dst[0] & 0xF0) == 0xE0) {
+		uint32_t group_address;
+		memcpy(&group_address, p_ip4->ip4.dst, IPv4_ADDR_LEN);
+
+		if (!igmp_accept(group_address)) {
+			return;
+		}
+	}
+
 #if defined(DO_NET_CHKSUM)
 	uint16_t chksum;
 	// Really needed, doesn't do EMAC this job?
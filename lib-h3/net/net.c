@@ -34,6 +34,8 @@
 extern int emac_eth_recv(uint8_t **);
 extern void emac_free_pkt(void);
 
+extern void udp_reclaim(void);
+
 extern void net_timers_init(void);
 extern void net_timers_run(void);
 
@@ -110,6 +112,7 @@ void net_handle(void) {
 		}
 
 		emac_free_pkt();
+		udp_reclaim();
 	}
 
 	net_timers_run();
@@ -139,6 +139,13 @@ struct t_udp_packet {
 	uint8_t data[FRAME_BUFFER_SIZE];
 }PACKED;
 
+struct t_udp_packet_header {
+	uint16_t source_port;
+	uint16_t destination_port;
+	uint16_t len;
+	uint16_t checksum;
+}PACKED;
+
 struct t_igmp_packet {
 	uint8_t type;
 	uint8_t max_resp_time;
@@ -170,6 +177,12 @@ struct t_udp {
 	struct t_udp_packet udp;
 }PACKED;
 
+struct t_udp_header {
+	struct ether_packet ether;
+	struct t_ip4_packet ip4;
+	struct t_udp_packet_header udp;
+}PACKED;
+
 struct t_igmp {
 	struct ether_packet ether;
 	struct t_ip4_packet ip4;
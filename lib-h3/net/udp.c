@@ -47,16 +47,18 @@
  #define MIN(a, b) ((a) < (b) ? (a) : (b))
 #endif
 
-extern void emac_eth_send(void *, int);
+extern void emac_eth_send_gather(const void *, uint32_t, const void *, uint32_t);
+extern int emac_eth_hold(void);
+extern void emac_eth_release(const uint8_t *);
+extern bool emac_eth_is_overtaken(const uint8_t *);
 extern uint32_t arp_cache_lookup(uint32_t, uint8_t *);
-extern uint16_t net_chksum(void *, uint32_t);
+extern int arp_cache_queue(uint32_t, const void *, uint32_t, const void *, uint32_t);
 
 #define MAX_PORTS_ALLOWED	8
-#define MAX_ENTRIES			(1 << 2) // Must always be a power of 2
-#define MAX_ENTRIES_MASK	(MAX_ENTRIES - 1)
+#define MAX_POOL_ENTRIES	128	///< Queue entries shared by all bound ports
 
 struct queue_entry {
-	uint8_t data[FRAME_BUFFER_SIZE];
+	const uint8_t *data;	///< UDP payload, in the EMAC receive buffer
 	uint32_t from_ip;
 	uint16_t from_port;
 	uint16_t size;
@@ -65,7 +67,10 @@ struct queue_entry {
 struct queue {
 	uint32_t queue_head;
 	uint32_t queue_tail;
-	struct queue_entry entries[MAX_ENTRIES] ALIGNED;
+	uint32_t queue_count;
+	uint32_t queue_depth;
+	struct queue_entry *entries;	///< Slice of s_pool
+	struct udp_stats stats;
 }ALIGNED;
 
 typedef union pcast32 {
@@ -76,15 +81,24 @@ typedef union pcast32 {
 static uint32_t s_ports_allowed[MAX_PORTS_ALLOWED];
 static uint32_t s_ports_used_index;
 static struct queue s_recv_queue[MAX_PORTS_ALLOWED] ALIGNED;
-static struct t_udp s_send_packet ALIGNED;
+static struct queue_entry s_pool[MAX_POOL_ENTRIES] ALIGNED;
+static uint32_t s_pool_used;
+static struct t_udp_header s_send_template ALIGNED;
+static struct t_udp_header s_send_header[MAX_PORTS_ALLOWED] ALIGNED;	///< Header template for each bound port
 static uint16_t s_id ALIGNED;
 static uint32_t broadcast_mask;
 
 void udp_set_ip(const struct ip_info *p_ip_info) {
 	_pcast32 src;
+	uint32_t i;
 
 	src.u32 = p_ip_info->ip.addr;
-	memcpy(s_send_packet.ip4.src, src.u8, IPv4_ADDR_LEN);
+	memcpy(s_send_template.ip4.src, src.u8, IPv4_ADDR_LEN);
+
+	for (i = 0; i < MAX_PORTS_ALLOWED; i++) {
+		memcpy(s_send_header[i].ip4.src, src.u8, IPv4_ADDR_LEN);
+	}
+
 	broadcast_mask = ~(p_ip_info->netmask.addr);
 }
 
@@ -93,31 +107,36 @@ void udp_init(const uint8_t *mac_address, const struct ip_info  *p_ip_info) {
 
 	for (i = 0; i < MAX_PORTS_ALLOWED; i++) {
 		s_ports_allowed[i] = 0;
-		s_recv_queue[i].queue_head = 0;
-		s_recv_queue[i].queue_tail = 0;
+		memset(&s_recv_queue[i], 0, sizeof(struct queue));
 	}
 
 	s_ports_used_index = 0;
+	s_pool_used = 0;
 	s_id = 0;
 
 	// Ethernet
-	memcpy(s_send_packet.ether.src, mac_address, ETH_ADDR_LEN);
-	s_send_packet.ether.type = __builtin_bswap16(ETHER_TYPE_IPv4);
+	memcpy(s_send_template.ether.src, mac_address, ETH_ADDR_LEN);
+	s_send_template.ether.type = __builtin_bswap16(ETHER_TYPE_IPv4);
 	// IPv4
-	s_send_packet.ip4.ver_ihl = 0x45;
-	s_send_packet.ip4.tos = 0;
-	s_send_packet.ip4.flags_froff = __builtin_bswap16(IPv4_FLAG_DF);
-	s_send_packet.ip4.ttl = 64;
-	s_send_packet.ip4.proto = IPv4_PROTO_UDP;
-	udp_set_ip(p_ip_info);
+	s_send_template.ip4.ver_ihl = 0x45;
+	s_send_template.ip4.tos = 0;
+	s_send_template.ip4.flags_froff = __builtin_bswap16(IPv4_FLAG_DF);
+	s_send_template.ip4.ttl = 64;
+	s_send_template.ip4.proto = IPv4_PROTO_UDP;
+	s_send_template.ip4.chksum = 0;	// Inserted by the EMAC
 	// UDP
-	s_send_packet.udp.checksum = 0;
+	s_send_template.udp.checksum = 0;	// Inserted by the EMAC
+
+	for (i = 0; i < MAX_PORTS_ALLOWED; i++) {
+		memcpy(&s_send_header[i], &s_send_template, sizeof(struct t_udp_header));
+	}
+
+	udp_set_ip(p_ip_info);
 }
 
 void udp_handle(struct t_udp *p_udp) {
 	uint32_t port_index;
 	_pcast32 src;
-	uint32_t i;
 
 	const uint16_t dest_port = __builtin_bswap16(p_udp->udp.destination_port);
 
@@ -140,45 +159,112 @@ void udp_handle(struct t_udp *p_udp) {
 		return;
 	}
 
-	const uint32_t entry = s_recv_queue[port_index].queue_tail;
-	struct queue_entry *p_queue_entry = &s_recv_queue[port_index].entries[entry];
+	struct queue *p_queue = &s_recv_queue[port_index];
+
+	if (__builtin_expect((p_queue->queue_count == p_queue->queue_depth), 0)) {
+		// Queue is full, the new packet is dropped. Queued packets are never overwritten.
+		p_queue->stats.dropped++;
+		return;
+	}
+
+	if (__builtin_expect((emac_eth_hold() != 0), 0)) {
+		DEBUG_PUTS("No receive buffers available");
+		p_queue->stats.dropped++;
+		return;
+	}
+
+	struct queue_entry *p_queue_entry = &p_queue->entries[p_queue->queue_head];
 
 	const uint32_t data_length = __builtin_bswap16(p_udp->udp.len) - UDP_HEADER_SIZE;
 
 	// debug_dump(p_udp->udp.data, data_length);
 
-	i = MIN(FRAME_BUFFER_SIZE, data_length);
-
-	h3_memcpy(p_queue_entry->data, p_udp->udp.data, i);
+	p_queue_entry->data = p_udp->udp.data;
 
 	memcpy(src.u8, p_udp->ip4.src, IPv4_ADDR_LEN);
 	p_queue_entry->from_ip = src.u32;
 	p_queue_entry->from_port = __builtin_bswap16(p_udp->udp.source_port);
-	p_queue_entry->size = i;
+	p_queue_entry->size = MIN(FRAME_BUFFER_SIZE, data_length);
+
+	if (++p_queue->queue_head == p_queue->queue_depth) {
+		p_queue->queue_head = 0;
+	}
+
+	p_queue->queue_count++;
+	p_queue->stats.rx++;
+
+	if (p_queue->queue_count > p_queue->stats.high_water_mark) {
+		p_queue->stats.high_water_mark = p_queue->queue_count;
+	}
+}
+
+static void _queue_release_tail(struct queue *p_queue) {
+	emac_eth_release(p_queue->entries[p_queue->queue_tail].data);
+
+	if (++p_queue->queue_tail == p_queue->queue_depth) {
+		p_queue->queue_tail = 0;
+	}
+
+	p_queue->queue_count--;
+}
+
+/*
+ * A queue that is not drained keeps its packets in the EMAC receive ring.
+ * The oldest lent buffer is always the tail of a queue. It is dropped before
+ * the ring wraps onto it, so a slow consumer cannot stop the receive.
+ */
+void udp_reclaim(void) {
+	uint32_t i;
+
+	for (i = 0; i < s_ports_used_index; i++) {
+		struct queue *p_queue = &s_recv_queue[i];
 
-	s_recv_queue[port_index].queue_head = (s_recv_queue[port_index].queue_head + 1) & MAX_ENTRIES_MASK;
+		while ((p_queue->queue_count != 0) && emac_eth_is_overtaken(p_queue->entries[p_queue->queue_tail].data)) {
+			_queue_release_tail(p_queue);
+			p_queue->stats.dropped++;
+		}
+	}
 }
 
 // -->
 
 int udp_bind(uint16_t local_port) {
+	return udp_bind_depth(local_port, UDP_RECV_DEPTH_DEFAULT);
+}
+
+int udp_bind_depth(uint16_t local_port, uint32_t depth) {
 	uint32_t i;
 
+	for (i = 0; i < s_ports_used_index; i++) {
+		if (s_ports_allowed[i] == local_port) {
+			return i;
+		}
+	}
+
 	if (s_ports_used_index == MAX_PORTS_ALLOWED) {
 		DEBUG_PUTS("s_ports_used_index == MAX_PORTS_ALLOWED");
 		return -1;
 	}
 
-	for (i = 0; i < s_ports_used_index; i++) {
-		if (s_ports_allowed[i] == local_port) {
-			return i;
-		}
+	if ((depth == 0) || (s_pool_used + depth > MAX_POOL_ENTRIES)) {
+		DEBUG_PRINTF("depth=%d, s_pool_used=%d", depth, s_pool_used);
+		return -1;
 	}
 
 	const int current_index = s_ports_used_index;
+	struct queue *p_queue = &s_recv_queue[current_index];
 
+	memset(p_queue, 0, sizeof(struct queue));
+	p_queue->queue_depth = depth;
+	p_queue->entries = &s_pool[s_pool_used];
+	p_queue->stats.depth = depth;
+
+	s_pool_used += depth;
 	s_ports_allowed[s_ports_used_index++] = local_port;
 
+	memcpy(&s_send_header[current_index], &s_send_template, sizeof(struct t_udp_header));
+	s_send_header[current_index].udp.source_port = __builtin_bswap16(local_port);
+
 	return current_index;
 }
 
@@ -192,9 +278,16 @@ int udp_unbind(uint16_t local_port) {
 	DEBUG_PRINTF("s_ports_allowed[s_ports_allowed_index - 1]=%d", s_ports_allowed[s_ports_used_index - 1]);
 
 	if ((s_ports_allowed[s_ports_used_index - 1]) == local_port) {
+		struct queue *p_queue = &s_recv_queue[s_ports_used_index - 1];
+
+		while (p_queue->queue_count != 0) {
+			_queue_release_tail(p_queue);
+		}
+
+		s_pool_used -= p_queue->queue_depth;
+		p_queue->queue_depth = 0;
+
 		s_ports_allowed[s_ports_used_index - 1] = 0;
-		s_recv_queue[s_ports_used_index - 1].queue_head = 0;
-		s_recv_queue[s_ports_used_index - 1].queue_tail = 0;
 		s_ports_used_index--;
 		return 0;
 	}
@@ -203,27 +296,76 @@ int udp_unbind(uint16_t local_port) {
 }
 
 uint16_t udp_recv(uint8_t idx, uint8_t *packet, uint16_t size, uint32_t *from_ip, uint16_t *from_port) {
+	const uint8_t *data;
+
+	const uint16_t length = udp_recv_borrow(idx, &data, from_ip, from_port);
+
+	if (length == 0) {
+		return 0;
+	}
+
+	const uint16_t i = MIN(size, length);
+
+	h3_memcpy(packet, data, i);
+
+	udp_recv_release(idx);
+
+	return i;
+}
+
+/*
+ * Zero-copy receive. The returned packet points into the EMAC receive buffer.
+ * It is valid until udp_recv_release is called for the same idx, and must be
+ * released before net_handle runs again, see udp_reclaim.
+ */
+uint16_t udp_recv_borrow(uint8_t idx, const uint8_t **packet, uint32_t *from_ip, uint16_t *from_port) {
+	return udp_recv_peek(idx, 0, packet, from_ip, from_port);
+}
+
+/*
+ * As udp_recv_borrow, for the n-th queued packet. Used for batch receive,
+ * the packets are released in order with udp_recv_release.
+ */
+uint16_t udp_recv_peek(uint8_t idx, uint32_t n, const uint8_t **packet, uint32_t *from_ip, uint16_t *from_port) {
 	assert(idx < MAX_PORTS_ALLOWED);
 
-	if (s_recv_queue[idx].queue_head == s_recv_queue[idx].queue_tail) {
+	const struct queue *p_queue = &s_recv_queue[idx];
+
+	if (n >= p_queue->queue_count) {
 		return 0;
 	}
 
-	const uint8_t entry = s_recv_queue[idx].queue_tail;
-	struct queue_entry *p_queue_entry = &s_recv_queue[idx].entries[entry];
+	uint32_t entry = p_queue->queue_tail + n;
 
-	const uint16_t i = MIN(size, p_queue_entry->size);
+	if (entry >= p_queue->queue_depth) {
+		entry -= p_queue->queue_depth;
+	}
 
-	h3_memcpy(packet, p_queue_entry->data, i);
+	const struct queue_entry *p_queue_entry = &p_queue->entries[entry];
 
+	*packet = p_queue_entry->data;
 	*from_ip = p_queue_entry->from_ip;
 	*from_port = p_queue_entry->from_port;
 
-	s_recv_queue[idx].queue_tail = (s_recv_queue[idx].queue_tail + 1) & MAX_ENTRIES_MASK;
+	DEBUG_PRINTF("%d " IPSTR, p_queue_entry->size, IP2STR(*from_ip));
+
+	return p_queue_entry->size;
+}
 
-	DEBUG_PRINTF("%d " IPSTR, i, IP2STR(*from_ip));
+void udp_recv_release(uint8_t idx) {
+	assert(idx < MAX_PORTS_ALLOWED);
 
-	return i;
+	if (s_recv_queue[idx].queue_count == 0) {
+		return;
+	}
+
+	_queue_release_tail(&s_recv_queue[idx]);
+}
+
+void udp_get_stats(uint8_t idx, struct udp_stats *p_stats) {
+	assert(idx < MAX_PORTS_ALLOWED);
+
+	memcpy(p_stats, &s_recv_queue[idx].stats, sizeof(struct udp_stats));
 }
 
 int udp_send(uint8_t idx, const uint8_t *packet, uint16_t size, uint32_t to_ip, uint16_t remote_port) {
@@ -238,41 +380,44 @@ int udp_send(uint8_t idx, const uint8_t *packet, uint16_t size, uint32_t to_ip,
 
 	DEBUG_PRINTF("%d %p " IPSTR, size, to_ip, IP2STR(to_ip));
 
+	struct t_udp_header *p_header = &s_send_header[idx];
+	const uint16_t length = MIN(FRAME_BUFFER_SIZE, size);
+	bool is_resolved = true;
+
 	if (to_ip == IPv4_BROADCAST) {
-		memset(s_send_packet.ether.dst, 0xFF, ETH_ADDR_LEN);
-		memset(s_send_packet.ip4.dst, 0xFF, IPv4_ADDR_LEN);
+		memset(p_header->ether.dst, 0xFF, ETH_ADDR_LEN);
+		memset(p_header->ip4.dst, 0xFF, IPv4_ADDR_LEN);
 	} else if ((to_ip & broadcast_mask) == broadcast_mask) {
-		memset(s_send_packet.ether.dst, 0xFF, ETH_ADDR_LEN);
+		memset(p_header->ether.dst, 0xFF, ETH_ADDR_LEN);
 		dst.u32 = to_ip;
-		memcpy(s_send_packet.ip4.dst, dst.u8, IPv4_ADDR_LEN);
+		memcpy(p_header->ip4.dst, dst.u8, IPv4_ADDR_LEN);
 	} else {
-		if (to_ip == arp_cache_lookup(to_ip, s_send_packet.ether.dst)) {
-			dst.u32 = to_ip;
-			memcpy(s_send_packet.ip4.dst, dst.u8, IPv4_ADDR_LEN);
-		} else {
-			DEBUG_PUTS("ARP lookup failed");
-			return -2;
-		}
+		is_resolved = (to_ip == arp_cache_lookup(to_ip, p_header->ether.dst));
+		dst.u32 = to_ip;
+		memcpy(p_header->ip4.dst, dst.u8, IPv4_ADDR_LEN);
 	}
 
 	//IPv4
-	s_send_packet.ip4.id = s_id;
-	s_send_packet.ip4.len = __builtin_bswap16(size + IPv4_UDP_HEADERS_SIZE);
-	s_send_packet.ip4.chksum = 0;
-	s_send_packet.ip4.chksum = net_chksum((void *) &s_send_packet.ip4, (uint32_t) sizeof(s_send_packet.ip4));
+	p_header->ip4.id = s_id;
+	p_header->ip4.len = __builtin_bswap16(length + IPv4_UDP_HEADERS_SIZE);
 
 	//UDP
-	s_send_packet.udp.source_port = __builtin_bswap16(s_ports_allowed[idx]);
-	s_send_packet.udp.destination_port = __builtin_bswap16(remote_port);
-	s_send_packet.udp.len = __builtin_bswap16(size + UDP_HEADER_SIZE);
-
-	h3_memcpy(s_send_packet.udp.data, packet, MIN(FRAME_BUFFER_SIZE, size));
+	p_header->udp.destination_port = __builtin_bswap16(remote_port);
+	p_header->udp.len = __builtin_bswap16(length + UDP_HEADER_SIZE);
 
-	// debug_dump((void *) &s_send_packet, size + UDP_PACKET_HEADERS_SIZE);
+	s_id++;
 
-	emac_eth_send((void *) &s_send_packet, size + UDP_PACKET_HEADERS_SIZE);
+	if (__builtin_expect((!is_resolved), 0)) {
+		// Sent when the ARP reply arrives
+		if (arp_cache_queue(to_ip, p_header, sizeof(struct t_udp_header), packet, length) != 0) {
+			DEBUG_PUTS("ARP queue full");
+			return -2;
+		}
+		return 0;
+	}
 
-	s_id++;
+	// The payload is copied once, straight into the EMAC DMA buffer
+	emac_eth_send_gather(p_header, sizeof(struct t_udp_header), packet, length);
 
 	return 0;
 }
@@ -48,6 +48,58 @@
 	#define CPU_CLK_SRC_MASK	0x03
 	#define CPU_CLK_SRC_SHIFT	16
 
+#define CPUCFG_CPU_RST_CTRL(cpu)	(*(volatile uint32_t *) (H3_CPUCFG_BASE + (((cpu) + 1) * 0x40)))
+	#define CPU_RST_CTRL_CORE_RESET		(1 << 0)
+	#define CPU_RST_CTRL_RESET			(1 << 1)
+#define CPUCFG_GEN_CTRL				(*(volatile uint32_t *) (H3_CPUCFG_BASE + 0x184))
+#define CPUCFG_PRIVATE0				(*(volatile uint32_t *) (H3_CPUCFG_BASE + 0x1A4))	// Soft entry address
+#define CPUCFG_DBG_CTL1				(*(volatile uint32_t *) (H3_CPUCFG_BASE + 0x1E4))
+
+static volatile uint32_t *_pwr_clamp(uint32_t cpu) {
+	return &H3_PRCM->CPU1_PWR_CLAMP + (cpu - 1);
+}
+
+/*
+ * Based on sun8i_smp_boot_secondary (Linux arch/arm/mach-sunxi/platsmp.c)
+ */
+void h3_cpu_on(h3_cpu_t cpuid, uint32_t start_address) {
+	assert(H3_CPU0 != cpuid);
+	assert(cpuid < H3_CPU_COUNT);
+
+	const uint32_t cpu = cpuid & (H3_CPU_COUNT - 1); // Count is always power of 2
+	uint32_t i;
+
+	// Set the soft entry address
+	CPUCFG_PRIVATE0 = start_address;
+
+	// Assert the CPU core in reset
+	CPUCFG_CPU_RST_CTRL(cpu) = 0;
+
+	// Cancel the L1 reset
+	CPUCFG_GEN_CTRL &= ~(1 << cpu);
+
+	// Disable external debug access
+	CPUCFG_DBG_CTL1 &= ~(1 << cpu);
+
+	// Release the power clamp
+	for (i = 0; i <= 8; i++) {
+		*_pwr_clamp(cpu) = 0xFF >> i;
+	}
+
+	udelay(10000);
+
+	// Clear the power-off gating
+	H3_PRCM->CPU_PWROFF &= ~(1 << cpu);
+
+	udelay(1000);
+
+	// Deassert the CPU core reset
+	CPUCFG_CPU_RST_CTRL(cpu) = CPU_RST_CTRL_RESET | CPU_RST_CTRL_CORE_RESET;
+
+	// Enable back the external debug access
+	CPUCFG_DBG_CTL1 |= (1 << cpu);
+}
+
 void h3_cpu_off(h3_cpu_t cpuid) {
 	assert(H3_CPU0 != cpuid);
 	assert(cpuid < H3_CPU_COUNT);
@@ -34,9 +34,12 @@
 #include "h3_gpio.h"
 #include "h3_spi.h"
 #include "h3_ccu.h"
+#include "h3_dma.h"
 
 #include "h3_board.h"
 
+#include "arm/synchronize.h"
+
 #include "h3_spi_internal.h"
 
 #define ALT_FUNCTION_CS		(EXT_SPI_NUMBER == 0 ? (H3_PC3_SELECT_SPI0_CS) : (H3_PA13_SELECT_SPI1_CS))
@@ -44,8 +47,26 @@
 #define ALT_FUNCTION_MOSI	(EXT_SPI_NUMBER == 0 ? (H3_PC1_SELECT_SPI0_MISO) : (H3_PA15_SELECT_SPI1_MOSI))
 #define ALT_FUNCTION_MISO	(EXT_SPI_NUMBER == 0 ? (H3_PC0_SELECT_SPI0_MOSI) : (H3_PA16_SELECT_SPI1_MISO))
 
+#define SPI_DMA_CHANNEL			5
+#define SPI_DMA_CHL				H3_DMA_CHL5
+#define SPI_DMA_DRQDST			(EXT_SPI_NUMBER == 0 ? (DRQDST_SPI0TX) : (DRQDST_SPI1TX))
+#define SPI_DMA_TX_TRIG_LEVEL	(SPI_FIFO_SIZE / 2)
+#define SPI_DMA_TX_BUFFER_SIZE	(32 * 1024)
+
+/*
+ * INFO The first half of the coherent region is used by the EMAC, the start of the second half by lib-dmx (dmx_multi),
+ * the codec and WS28xxMulti. The SPI DMA buffer is in the last quarter.
+ */
+struct coherent_region {
+	struct sunxi_dma_lli lli;
+	uint8_t txbuffer[4 + SPI_DMA_TX_BUFFER_SIZE] __attribute__ ((aligned (64)));	// [3] is the WS28xx mode leading byte
+};
+
+static struct coherent_region *p_coherent_region = (struct coherent_region *)(H3_MEM_COHERENT_REGION + MEGABYTE/2 + MEGABYTE/4);
+
 static bool s_ws28xx_mode = false;
 static uint32_t s_current_speed_hz = 0; // This forces an update
+static volatile bool s_dma_tx_active = false;
 
 struct spi_status {
 	bool		transfer_active;
@@ -275,6 +296,9 @@ void h3_spi_begin(void) {
 
 	EXT_SPI->IE = 0; // Disable interrupts
 
+	H3_CCU->BUS_SOFT_RESET0 |= CCU_BUS_SOFT_RESET0_DMA;
+	H3_CCU->BUS_CLK_GATING0 |= CCU_BUS_CLK_GATING0_DMA;
+
 #ifndef NDEBUG
 	const uint64_t pll_frequency = h3_ccu_get_pll_rate(CCU_PLL_PERIPH0);
 	printf("pll_frequency=%ld\n", (long int) pll_frequency);
@@ -300,6 +324,10 @@ void h3_spi_begin(void) {
 }
 
 void h3_spi_end(void) {
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	uint32_t value;
 
 	value = EXT_SPI->GC;
@@ -382,6 +410,10 @@ void h3_spi_setChipSelectPolarity(uint8_t chip_select, uint8_t polarity) {
 }
 
 void h3_spi_transfernb(char *tx_buffer, /*@null@*/char *rx_buffer, uint32_t data_length) {
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	s_spi_status.rxbuf = (uint8_t *)rx_buffer;
 	s_spi_status.rxcnt = 0;
 	s_spi_status.txbuf = (uint8_t *)tx_buffer;
@@ -416,6 +448,10 @@ void h3_spi_transfern(char *buffer, uint32_t data_length) {
 void h3_spi_writenb(const char *tx_buffer, uint32_t data_length) {
 	assert(tx_buffer != 0);
 
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	EXT_SPI->GC &= ~(GC_TP_EN);	// ignore RXFIFO
 
 	_clear_fifos();
@@ -473,6 +509,10 @@ void h3_spi_writenb(const char *tx_buffer, uint32_t data_length) {
 }
 
 void h3_spi_write(uint16_t data) {
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	EXT_SPI->GC &= ~(GC_TP_EN);	// ignore RXFIFO
 
 	_clear_fifos();
@@ -501,6 +541,10 @@ void h3_spi_write(uint16_t data) {
 uint8_t h3_spi_transfer(uint8_t data) {
 	uint8_t ret;
 
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the DMA to finish
+	}
+
 	_clear_fifos();
 
 	EXT_SPI->MBC = 1;
@@ -526,3 +570,82 @@ uint8_t h3_spi_transfer(uint8_t data) {
 
 	return ret;
 }
+
+/*
+ * Non-blocking. The data is copied into the DMA buffer, then the caller can reuse tx_buffer.
+ * When a previous transfer is still active, this waits for it.
+ */
+void h3_spi_dma_tx_start(const char *tx_buffer, uint32_t data_length) {
+	assert(tx_buffer != 0);
+
+	if (data_length > SPI_DMA_TX_BUFFER_SIZE) {
+		h3_spi_writenb(tx_buffer, data_length);
+		return;
+	}
+
+	while (h3_spi_dma_tx_is_active()) {
+		// wait for the previous transfer
+	}
+
+	// The data starts word aligned, so the copy can be done with words
+	uint8_t *src = &p_coherent_region->txbuffer[4];
+	uint32_t length = data_length;
+
+	h3_memcpy(src, tx_buffer, data_length);
+
+	if (s_ws28xx_mode) {
+		src--;
+		*src = (uint8_t) 0x00;
+		length++;
+	}
+
+	EXT_SPI->GC &= ~(GC_TP_EN);	// ignore RXFIFO
+
+	_clear_fifos();
+
+	EXT_SPI->MBC = length;
+	EXT_SPI->MTC = length;
+	EXT_SPI->BCC = length;
+
+	EXT_SPI->IS = EXT_SPI->IS;
+	EXT_SPI->IE = IE_TC;
+	EXT_SPI->FC = FC_TX_DRQEN | (SPI_DMA_TX_TRIG_LEVEL << 16);
+
+	struct sunxi_dma_lli *lli = &p_coherent_region->lli;
+
+	lli->cfg = DMA_CHAN_CFG_DST_IO_MODE | DMA_CHAN_CFG_SRC_LINEAR_MODE
+			| DMA_CHAN_CFG_SRC_DRQ(DRQSRC_SDRAM) | DMA_CHAN_CFG_SRC_WIDTH(0) | DMA_CHAN_CFG_SRC_BURST(0)
+			| DMA_CHAN_CFG_DST_DRQ(SPI_DMA_DRQDST) | DMA_CHAN_CFG_DST_WIDTH(0) | DMA_CHAN_CFG_DST_BURST(0);
+	lli->src = (uint32_t) src;
+	lli->dst = (uint32_t) &EXT_SPI->TX;
+	lli->len = length;
+	lli->para = DMA_NORMAL_WAIT;
+	lli->p_lli_next = DMA_LLI_LAST_ITEM;
+
+	dmb();
+
+	s_dma_tx_active = true;
+
+	SPI_DMA_CHL->DESC_ADDR = (uint32_t) lli;
+	SPI_DMA_CHL->EN = DMA_CHAN_ENABLE_START;
+
+	EXT_SPI->TC |= TC_XCH;
+}
+
+bool h3_spi_dma_tx_is_active(void) {
+	if (!s_dma_tx_active) {
+		return false;
+	}
+
+	// The DMA is done when the last byte is in the TX FIFO, the transfer is done when the FIFO is shifted out
+	if (((H3_DMA->STA & (1 << SPI_DMA_CHANNEL)) != 0) || ((EXT_SPI->IS & IS_TC) != IS_TC)) {
+		return true;
+	}
+
+	EXT_SPI->FC &= ~FC_TX_DRQEN;
+	EXT_SPI->IS = EXT_SPI->IS;
+	EXT_SPI->IE = 0;
+
+	s_dma_tx_active = false;
+	return false;
+}
@@ -0,0 +1,329 @@
+/**
+ * @file soft_timer.c
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#include "soft_timer.h"
+#include "irq_timer.h"
+
+#include "arm/arm.h"
+#include "arm/synchronize.h"
+
+#include "h3.h"
+#include "h3_timer.h"
+
+/*
+ * The number of timers is small, so the timers are kept in an array
+ * and the next hardware interrupt is found with a linear scan.
+ * The interrupt is set at the earliest (deadline + slack). All timers
+ * with a deadline before that moment expire in the same interrupt.
+ */
+
+#define TIMER1_TICKS_PER_US	12			///< 24MHz clock source, 2 pre-scale
+#define TIMER1_MAX_US		(1U << 24)	///< Fits in TMR1_INTV
+
+struct soft_timer {
+	thunk_soft_timer_t func;
+	uint32_t deadline;
+	uint32_t period;		///< 0 for a one-shot timer
+	uint32_t slack;
+	uint32_t rate;			///< With a rate, period is 1000000 / rate
+	uint32_t remainder;		///< 1000000 % rate
+	uint32_t accumulator;
+	struct soft_timer_stats stats;
+	bool is_active;
+};
+
+static struct soft_timer s_timers[SOFT_TIMER_MAX];
+static bool s_is_init = false;
+
+static inline uint32_t now_us(void) {
+	return H3_TIMER->AVS_CNT1;
+}
+
+/*
+ * The API can be used from a timer function, which runs with the IRQ disabled.
+ */
+static inline uint32_t irq_save(void) {
+	uint32_t cpsr;
+	asm volatile ("mrs %0, cpsr" : "=r" (cpsr) :: "memory");
+	__disable_irq();
+	return cpsr;
+}
+
+static inline void irq_restore(uint32_t cpsr) {
+	asm volatile ("msr cpsr_c, %0" :: "r" (cpsr) : "memory");
+}
+
+static void timer1_program(uint32_t now) {
+	bool is_found = false;
+	uint32_t next = 0;
+	uint32_t i;
+
+	for (i = 0; i < SOFT_TIMER_MAX; i++) {
+		const struct soft_timer *p = &s_timers[i];
+
+		if (p->is_active) {
+			const uint32_t latest = p->deadline + p->slack;
+
+			if (!is_found || ((int32_t) (latest - next) < 0)) {
+				next = latest;
+				is_found = true;
+			}
+		}
+	}
+
+	H3_TIMER->TMR1_CTRL &= ~TIMER_CTRL_EN_START;
+
+	if (!is_found) {
+		return;
+	}
+
+	int32_t delta = (int32_t) (next - now);
+
+	if (delta < 1) {
+		delta = 1;
+	} else if ((uint32_t) delta > TIMER1_MAX_US) {
+		delta = TIMER1_MAX_US;
+	}
+
+	H3_TIMER->TMR1_INTV = (uint32_t) delta * TIMER1_TICKS_PER_US;
+	H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+}
+
+static void advance(struct soft_timer *p, uint32_t now) {
+	p->deadline += p->period;
+
+	if (p->rate != 0) {
+		p->accumulator += p->remainder;
+
+		if (p->accumulator >= p->rate) {
+			p->accumulator -= p->rate;
+			p->deadline++;
+		}
+	}
+
+	// More than a period behind, then skip the missed expiries
+	if ((int32_t) (now - p->deadline) > (int32_t) p->period) {
+		p->deadline = now + p->period;
+	}
+}
+
+static void irq_timer1_soft_timer_handler(__attribute__((unused)) uint32_t clo) {
+	const uint32_t now = now_us();
+	uint32_t i;
+
+	dmb();
+
+	for (i = 0; i < SOFT_TIMER_MAX; i++) {
+		struct soft_timer *p = &s_timers[i];
+
+		if (p->is_active && ((int32_t) (now - p->deadline) >= 0)) {
+			const thunk_soft_timer_t func = p->func;
+			const uint32_t late = now - p->deadline;
+
+			if (late > p->stats.late_max) {
+				p->stats.late_max = late;
+			}
+
+			p->stats.count++;
+
+			if (p->period != 0) {
+				advance(p, now);
+			} else {
+				// A one-shot timer is released
+				p->is_active = false;
+				p->func = NULL;
+			}
+
+			func(now);
+		}
+	}
+
+	timer1_program(now_us());
+
+	dmb();
+}
+
+void soft_timer_init(void) {
+	if (s_is_init) {
+		return;
+	}
+
+	s_is_init = true;
+
+	irq_timer_init();
+
+	irq_timer_set(IRQ_TIMER_1, (thunk_irq_timer_t) irq_timer1_soft_timer_handler);
+	H3_TIMER->TMR1_CTRL &= ~TIMER_CTRL_EN_START;
+	H3_TIMER->TMR1_CTRL |= TIMER_CTRL_SINGLE_MODE;
+}
+
+static int32_t add(thunk_soft_timer_t func, uint32_t delay, uint32_t period, uint32_t rate, uint32_t slack) {
+	int32_t id;
+
+	soft_timer_init();
+
+	const uint32_t cpsr = irq_save();
+
+	for (id = 0; id < SOFT_TIMER_MAX; id++) {
+		if (s_timers[id].func == NULL) {
+			break;
+		}
+	}
+
+	if (id == SOFT_TIMER_MAX) {
+		irq_restore(cpsr);
+		return -1;
+	}
+
+	struct soft_timer *p = &s_timers[id];
+
+	p->func = func;
+	p->period = period;
+	p->slack = slack;
+	p->rate = rate;
+	p->remainder = rate == 0 ? 0 : 1000000 % rate;
+	p->accumulator = 0;
+	p->stats.count = 0;
+	p->stats.late_max = 0;
+
+	const uint32_t now = now_us();
+
+	p->deadline = now + delay;
+	p->is_active = true;
+
+	timer1_program(now);
+
+	irq_restore(cpsr);
+
+	return id;
+}
+
+int32_t soft_timer_oneshot(thunk_soft_timer_t func, uint32_t delay_us, uint32_t slack_us) {
+	return add(func, delay_us, 0, 0, slack_us);
+}
+
+int32_t soft_timer_periodic(thunk_soft_timer_t func, uint32_t period_us, uint32_t slack_us) {
+	if (period_us == 0) {
+		return -1;
+	}
+
+	return add(func, period_us, period_us, 0, slack_us);
+}
+
+int32_t soft_timer_rate(thunk_soft_timer_t func, uint32_t rate, uint32_t slack_us) {
+	if (rate == 0) {
+		return -1;
+	}
+
+	return add(func, 1000000 / rate, 1000000 / rate, rate, slack_us);
+}
+
+void soft_timer_restart(int32_t id, uint32_t rate) {
+	if ((id < 0) || (id >= SOFT_TIMER_MAX)) {
+		return;
+	}
+
+	struct soft_timer *p = &s_timers[id];
+
+	const uint32_t cpsr = irq_save();
+
+	if ((p->func == NULL) || ((p->period == 0) && (rate == 0))) {
+		irq_restore(cpsr);
+		return;
+	}
+
+	if (rate != 0) {
+		p->period = 1000000 / rate;
+		p->rate = rate;
+		p->remainder = 1000000 % rate;
+	}
+
+	p->accumulator = 0;
+
+	const uint32_t now = now_us();
+
+	p->deadline = now + p->period;
+	p->is_active = true;
+
+	timer1_program(now);
+
+	irq_restore(cpsr);
+}
+
+void soft_timer_stop(int32_t id) {
+	if ((id < 0) || (id >= SOFT_TIMER_MAX)) {
+		return;
+	}
+
+	const uint32_t cpsr = irq_save();
+
+	s_timers[id].is_active = false;
+
+	timer1_program(now_us());
+
+	irq_restore(cpsr);
+}
+
+void soft_timer_cancel(int32_t id) {
+	if ((id < 0) || (id >= SOFT_TIMER_MAX)) {
+		return;
+	}
+
+	const uint32_t cpsr = irq_save();
+
+	s_timers[id].is_active = false;
+	s_timers[id].func = NULL;
+
+	timer1_program(now_us());
+
+	irq_restore(cpsr);
+}
+
+void soft_timer_get_stats(int32_t id, struct soft_timer_stats *stats) {
+	if ((id < 0) || (id >= SOFT_TIMER_MAX)) {
+		return;
+	}
+
+	const uint32_t cpsr = irq_save();
+	*stats = s_timers[id].stats;
+	irq_restore(cpsr);
+}
+
+void soft_timer_print(void) {
+	uint32_t i;
+
+	for (i = 0; i < SOFT_TIMER_MAX; i++) {
+		const struct soft_timer *p = &s_timers[i];
+
+		if (p->func != NULL) {
+			printf("Timer %d: %s %u us, count %u, late max %u us\n", (int) i, p->period == 0 ? "one-shot" : "period", (unsigned) p->period, (unsigned) p->stats.count, (unsigned) p->stats.late_max);
+		}
+	}
+}
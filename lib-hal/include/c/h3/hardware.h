@@ -38,6 +38,8 @@ extern "C" {
 
 extern int32_t hardware_get_mac_address(/*@out@*/uint8_t *mac_address);
 
+extern int hardware_led_get(void);
+
 inline static uint32_t hardware_micros(void) {
 	return h3_hs_timer_lo_us();
 }
@@ -93,7 +93,15 @@ void hardware_led_init(void) {
 #endif
 }
 
+static int led_state;
+
+int hardware_led_get(void) {
+	return led_state;
+}
+
 void hardware_led_set(int state) {
+	led_state = state;
+
 #if defined(ORANGE_PI_ONE)
 	if (state == 0) {
 		h3_gpio_clr(H3_BOARD_STATUS_LED);
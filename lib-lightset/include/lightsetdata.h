@@ -0,0 +1,56 @@
+/**
+ * @file lightsetdata.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef LIGHTSETDATA_H_
+#define LIGHTSETDATA_H_
+
+#include <stdint.h>
+
+/**
+ * Compare-and-copy and merge kernels for the DMX receive paths.
+ * The bulk of the data is handled 16 (AVX2 : 32) bytes at a time, NEON on ARMv7, SSE2/AVX2 on x86.
+ */
+class LightSetData {
+public:
+	/**
+	 * Copies nLength bytes from pSrc into pDst.
+	 * @return true when at least one byte in pDst was different
+	 */
+	static bool Copy(uint8_t *pDst, const uint8_t *pSrc, uint32_t nLength);
+
+	/**
+	 * Highest Takes Precedence : pDst[i] = MAX(pDataA[i], pDataB[i])
+	 * @return true when at least one byte in pDst was different
+	 */
+	static bool MergeHtp(uint8_t *pDst, const uint8_t *pDataA, const uint8_t *pDataB, uint32_t nLength);
+
+	/**
+	 * Highest Takes Precedence over nSources buffers : pDst[i] = MAX(ppData[0][i], .., ppData[nSources - 1][i])
+	 * @return true when at least one byte in pDst was different
+	 */
+	static bool MergeHtp(uint8_t *pDst, const uint8_t * const *ppData, uint32_t nSources, uint32_t nLength);
+};
+
+#endif /* LIGHTSETDATA_H_ */
@@ -0,0 +1,73 @@
+/**
+ * @file universeindex.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef UNIVERSEINDEX_H_
+#define UNIVERSEINDEX_H_
+
+#include <stdint.h>
+
+#define UNIVERSE_INDEX_SIZE		64	///< Must be a power of 2, at least twice UNIVERSE_INDEX_MAX_PORTS
+#define UNIVERSE_INDEX_MAX_PORTS	32	///< Ports are kept in a bit mask
+
+/**
+ * Open-addressed index from a universe (Art-Net Port-Address or sACN universe) to the output ports.
+ * One universe can feed several ports. The index is rebuilt when the port configuration changes.
+ */
+class UniverseIndex {
+public:
+	UniverseIndex(void);
+
+	void Clear(void);
+	void Add(uint16_t nUniverse, uint32_t nPortIndex);
+
+	/**
+	 * @return the bit mask of the ports for nUniverse, bit 0 is port index 0
+	 */
+	uint32_t Lookup(uint16_t nUniverse) const {
+		uint32_t nSlot = Hash(nUniverse);
+
+		while (m_Entries[nSlot].nPortMask != 0) {
+			if (m_Entries[nSlot].nUniverse == nUniverse) {
+				return m_Entries[nSlot].nPortMask;
+			}
+			nSlot = (nSlot + 1) & (UNIVERSE_INDEX_SIZE - 1);
+		}
+
+		return 0;
+	}
+
+private:
+	static uint32_t Hash(uint16_t nUniverse) {
+		return ((uint32_t) nUniverse * 0x9E3779B1) >> (32 - __builtin_ctz(UNIVERSE_INDEX_SIZE));
+	}
+
+private:
+	struct TEntry {
+		uint32_t nPortMask;	///< 0 is an empty slot
+		uint16_t nUniverse;
+	} m_Entries[UNIVERSE_INDEX_SIZE];
+};
+
+#endif /* UNIVERSEINDEX_H_ */
@@ -0,0 +1,169 @@
+/**
+ * @file lightsetdata.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "lightsetdata.h"
+
+/*
+ * The builds are -nostdinc, so arm_neon.h / emmintrin.h are not available.
+ * The GCC generic vectors are lowered to NEON (-mfpu=neon-vfpv4), SSE2 or AVX2.
+ * On ARMv6 (RPi 1) the word loop is used.
+ */
+#if defined (__AVX2__)
+ #define VECTOR_SIZE	32
+#elif defined (__ARM_NEON) || defined (__ARM_NEON__) || defined (__SSE2__)
+ #define VECTOR_SIZE	16
+#endif
+
+#if defined (VECTOR_SIZE)
+typedef uint8_t vu8 __attribute__ ((vector_size (VECTOR_SIZE)));
+typedef uint64_t vu64 __attribute__ ((vector_size (VECTOR_SIZE)));
+
+static inline vu8 load(const uint8_t *p) {
+	vu8 v;
+	__builtin_memcpy(&v, p, sizeof(vu8));
+	return v;
+}
+
+static inline void store(uint8_t *p, vu8 v) {
+	__builtin_memcpy(p, &v, sizeof(vu8));
+}
+
+static inline bool is_zero(vu8 v) {
+	const vu64 w = (vu64) v;
+	uint64_t n = 0;
+
+	for (uint32_t i = 0; i < (sizeof(vu64) / sizeof(uint64_t)); i++) {
+		n |= w[i];
+	}
+
+	return n == 0;
+}
+#endif
+
+bool LightSetData::Copy(uint8_t *pDst, const uint8_t *pSrc, uint32_t nLength) {
+	uint32_t i = 0;
+	uint32_t nDiff = 0;
+
+#if defined (VECTOR_SIZE)
+	vu8 vDiff = { 0 };
+
+	for (; (i + VECTOR_SIZE) <= nLength; i += VECTOR_SIZE) {
+		const vu8 vSrc = load(&pSrc[i]);
+		vDiff |= (vSrc ^ load(&pDst[i]));
+		store(&pDst[i], vSrc);
+	}
+
+	nDiff = is_zero(vDiff) ? 0 : 1;
+#else
+	for (; (i + 4) <= nLength; i += 4) {
+		uint32_t nSrc, nDst;
+		__builtin_memcpy(&nSrc, &pSrc[i], sizeof(uint32_t));
+		__builtin_memcpy(&nDst, &pDst[i], sizeof(uint32_t));
+		nDiff |= (nSrc ^ nDst);
+		__builtin_memcpy(&pDst[i], &nSrc, sizeof(uint32_t));
+	}
+#endif
+
+	for (; i < nLength; i++) {
+		nDiff |= (uint32_t) (pSrc[i] ^ pDst[i]);
+		pDst[i] = pSrc[i];
+	}
+
+	return nDiff != 0;
+}
+
+bool LightSetData::MergeHtp(uint8_t *pDst, const uint8_t *pDataA, const uint8_t *pDataB, uint32_t nLength) {
+	uint32_t i = 0;
+	uint32_t nDiff = 0;
+
+#if defined (VECTOR_SIZE)
+	vu8 vDiff = { 0 };
+
+	for (; (i + VECTOR_SIZE) <= nLength; i += VECTOR_SIZE) {
+		const vu8 vA = load(&pDataA[i]);
+		const vu8 vB = load(&pDataB[i]);
+		const vu8 vMax = (vA > vB) ? vA : vB;	// vmax.u8 / pmaxub
+		vDiff |= (vMax ^ load(&pDst[i]));
+		store(&pDst[i], vMax);
+	}
+
+	nDiff = is_zero(vDiff) ? 0 : 1;
+#endif
+
+	for (; i < nLength; i++) {
+		const uint8_t nData = pDataA[i] > pDataB[i] ? pDataA[i] : pDataB[i];
+		nDiff |= (uint32_t) (nData ^ pDst[i]);
+		pDst[i] = nData;
+	}
+
+	return nDiff != 0;
+}
+
+bool LightSetData::MergeHtp(uint8_t *pDst, const uint8_t * const *ppData, uint32_t nSources, uint32_t nLength) {
+	if (nSources == 0) {
+		return false;
+	}
+
+	if (nSources == 1) {
+		return Copy(pDst, ppData[0], nLength);
+	}
+
+	uint32_t i = 0;
+	uint32_t nDiff = 0;
+
+#if defined (VECTOR_SIZE)
+	vu8 vDiff = { 0 };
+
+	for (; (i + VECTOR_SIZE) <= nLength; i += VECTOR_SIZE) {
+		vu8 vMax = load(&ppData[0][i]);
+
+		for (uint32_t nSource = 1; nSource < nSources; nSource++) {
+			const vu8 v = load(&ppData[nSource][i]);
+			vMax = (v > vMax) ? v : vMax;
+		}
+
+		vDiff |= (vMax ^ load(&pDst[i]));
+		store(&pDst[i], vMax);
+	}
+
+	nDiff = is_zero(vDiff) ? 0 : 1;
+#endif
+
+	for (; i < nLength; i++) {
+		uint8_t nData = ppData[0][i];
+
+		for (uint32_t nSource = 1; nSource < nSources; nSource++) {
+			nData = ppData[nSource][i] > nData ? ppData[nSource][i] : nData;
+		}
+
+		nDiff |= (uint32_t) (nData ^ pDst[i]);
+		pDst[i] = nData;
+	}
+
+	return nDiff != 0;
+}
@@ -0,0 +1,63 @@
+/**
+ * @file universeindex.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <assert.h>
+
+#include "universeindex.h"
+
+UniverseIndex::UniverseIndex(void) {
+	Clear();
+}
+
+void UniverseIndex::Clear(void) {
+	for (uint32_t i = 0; i < UNIVERSE_INDEX_SIZE; i++) {
+		m_Entries[i].nPortMask = 0;
+		m_Entries[i].nUniverse = 0;
+	}
+}
+
+void UniverseIndex::Add(uint16_t nUniverse, uint32_t nPortIndex) {
+	assert(nPortIndex < UNIVERSE_INDEX_MAX_PORTS);
+
+	uint32_t nSlot = Hash(nUniverse);
+
+	for (uint32_t i = 0; i < UNIVERSE_INDEX_SIZE; i++) {
+		if (m_Entries[nSlot].nPortMask == 0) {
+			m_Entries[nSlot].nUniverse = nUniverse;
+			m_Entries[nSlot].nPortMask = (uint32_t) 1 << nPortIndex;
+			return;
+		}
+
+		if (m_Entries[nSlot].nUniverse == nUniverse) {
+			m_Entries[nSlot].nPortMask |= (uint32_t) 1 << nPortIndex;
+			return;
+		}
+
+		nSlot = (nSlot + 1) & (UNIVERSE_INDEX_SIZE - 1);
+	}
+
+	assert(0);
+}
@@ -45,6 +45,9 @@ public:
 
 	void Handler(const struct TArtNetTimeCode *);
 
+private:
+	void Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked);
+
 private:
 	struct TLtcDisabledOutputs *m_ptLtcDisabledOutputs;
 	TTimecodeTypes m_tTimeCodeTypePrevious;
@@ -66,8 +66,8 @@ private:
 	alignas(uint32_t) struct TLtcTimeCode *m_pStopLtcTimeCode;
 	uint8_t m_nFps;
 	char m_aTimeCode[TC_CODE_MAX_LENGTH];
-	uint32_t m_nTimer0Interval;
-	uint32_t m_nMidiQuarterFrameUs12;
+	int32_t m_nTimerFrame;
+	int32_t m_nTimerMidi;
 	uint32_t nMidiQuarterFramePiece;
 	uint32_t m_nButtons;
 	int m_nHandle;
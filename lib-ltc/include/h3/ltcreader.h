@@ -27,6 +27,8 @@
 #define H3_LTC_READER_H_
 
 #include "artnetnode.h"
+#include "ltc.h"
+#include "midi.h"
 
 class LtcReader {
 public:
@@ -36,10 +38,15 @@ public:
 	void Start(void);
 	void Run(void);
 
+private:
+	void Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked);
+
 private:
 	ArtNetNode *m_pNode;
 	alignas(uint32_t) struct TLtcDisabledOutputs *m_ptLtcDisabledOutputs;
+	alignas(uint32_t) struct _midi_send_tc m_tMidiTimeCode;
 	uint8_t m_tTimeCodeTypePrevious;
+	char m_aTimeCode[TC_CODE_MAX_LENGTH];
 };
 
 #endif /* H3_LTC_READER_H_ */
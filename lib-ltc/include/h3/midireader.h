@@ -41,7 +41,7 @@ public:
 private:
 	void HandleMtc(void);
 	void HandleMtcQf(void);
-	void Update(void);
+	void Update(const struct TLtcTimeCode *pTimeCode);
 
 private:
 	ArtNetNode *m_pNode;
@@ -47,7 +47,7 @@ public:
 private:
 	void HandleMtc(const struct _midi_message *ptMidiMessage);
 	void HandleMtcQf(const struct _midi_message *ptMidiMessage);
-	void Update(const struct _midi_message *ptMidiMessage);
+	void Update(const struct TLtcTimeCode *pTimeCode);
 
 private:
 	ArtNetNode *m_pNode;
@@ -44,12 +44,14 @@ public:
 
 	void Handler(const struct TTCNetTimeCode *pTimeCode);
 
+private:
+	void Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked);
+
 private:
 	ArtNetNode *m_pNode;
 	alignas(uint32_t) struct TLtcDisabledOutputs *m_ptLtcDisabledOutputs;
 	alignas(uint32_t) struct _midi_send_tc m_tMidiTimeCode;
 	uint32_t m_nMidiQuarterFramePiece;
-	uint32_t m_nTimeCodePrevious;
 	TTimecodeTypes m_tTimeCodeTypePrevious;
 	char m_aTimeCode[TC_CODE_MAX_LENGTH];
 };
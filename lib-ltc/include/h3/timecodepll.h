@@ -0,0 +1,113 @@
+/**
+ * @file timecodepll.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#ifndef H3_TIMECODEPLL_H_
+#define H3_TIMECODEPLL_H_
+
+#include <stdint.h>
+
+#include "ltc.h"
+
+#define TIMECODE_PLL_FREEWHEEL_FRAMES_DEFAULT	25
+
+/*
+ * Clock recovery for the timecode readers.
+ * The incoming frames discipline a frame clock (phase and period).
+ * The outputs are driven by that clock, one frame at the time, with
+ * the MIDI quarter frames at exactly a quarter of the recovered period.
+ * When the input stops, the clock freewheels for a number of frames.
+ * When the input repeats the same frame, the source is paused and the clock holds.
+ */
+
+class TimeCodePll {
+public:
+	TimeCodePll(void);
+	~TimeCodePll(void);
+
+	void Start(void);
+	void Stop(void);
+
+	void SetFreewheelFrames(uint8_t nFreewheelFrames) {
+		m_nFreewheelFrames = nFreewheelFrames;
+	}
+
+	/**
+	 * nTimeUs is the AVS counter at the moment the frame was received.
+	 */
+	void Input(const struct TLtcTimeCode *pTimeCode, uint32_t nTimeUs);
+	void Input(const struct TLtcTimeCode *pTimeCode);
+
+	/**
+	 * Main loop. Return true, once, for each frame of the recovered clock.
+	 * bRelocked is true when the output jumped, instead of counting.
+	 */
+	bool GetTimeCode(struct TLtcTimeCode *pTimeCode, bool &bRelocked);
+	/**
+	 * Main loop. Return true, once, for each quarter frame of the recovered clock.
+	 */
+	bool IsMidiQuarterFrame(void);
+
+	bool IsLocked(void) const {
+		return m_bLocked;
+	}
+
+	void Print(void);
+
+	static TimeCodePll* Get(void) {
+		return s_pThis;
+	}
+
+	// Timer function (IRQ)
+	void Tick(uint32_t nNowUs);
+
+private:
+	void Lock(const struct TLtcTimeCode *pTimeCode, uint32_t nTimeUs);
+	void Next(struct TLtcTimeCode *pTimeCode) const;
+	void Schedule(uint32_t nNowUs);
+
+private:
+	struct TLtcTimeCode m_tTimeCode;
+	struct TLtcTimeCode m_tInput;
+	uint32_t m_nInputUs;			///< First arrival of m_tInput
+	uint32_t m_nFrameUs;			///< Start of the current output frame
+	uint32_t m_nFraction;			///< 1/256 us
+	uint32_t m_nPeriod;				///< 1/256 us
+	uint32_t m_nPeriodNominal;		///< 1/256 us
+	uint32_t m_nQuarter;
+	uint32_t m_nFramesMissed;
+	int32_t m_nTimer;
+	int32_t m_nPhaseError;			///< Last phase error (us)
+	uint32_t m_nRelocks;
+	uint8_t m_nFreewheelFrames;
+	volatile bool m_bLocked;
+	volatile bool m_bHold;
+	volatile bool m_bTimeCodeAvailable;
+	volatile bool m_bRelocked;
+	volatile bool m_bMidiQuarterFrame;
+
+	static TimeCodePll *s_pThis;
+};
+
+#endif /* H3_TIMECODEPLL_H_ */
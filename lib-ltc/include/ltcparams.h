@@ -79,6 +79,7 @@ struct TLtcParams {
 	uint8_t nStopMinute;
 	uint8_t nStopHour;
 	uint8_t nEnableOsc;
+	uint8_t nFreewheelFrames;
 };
 
 enum TLtcParamsMask {
@@ -102,7 +103,8 @@ enum TLtcParamsMask {
 	LTC_PARAMS_MASK_STOP_SECOND = (1 << 17),
 	LTC_PARAMS_MASK_STOP_MINUTE = (1 << 18),
 	LTC_PARAMS_MASK_STOP_HOUR = (1 << 19),
-	LTC_PARAMS_MASK_ENABLE_OSC = (1 << 20)
+	LTC_PARAMS_MASK_ENABLE_OSC = (1 << 20),
+	LTC_PARAMS_MASK_FREEWHEEL_FRAMES = (1 << 21)
 };
 
 class LtcParamsStore {
@@ -179,6 +181,10 @@ public:
 		return (m_tLtcParams.nEnableOsc == 1);
 	}
 
+	uint8_t GetFreewheelFrames(void) {
+		return m_tLtcParams.nFreewheelFrames;
+	}
+
 	void StartTimeCodeCopyTo(TLtcTimeCode *ptStartTimeCode);
 	void StopTimeCodeCopyTo(TLtcTimeCode *ptStopTimeCode);
 
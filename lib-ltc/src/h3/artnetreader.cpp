@@ -29,14 +29,10 @@
 
 #include "h3/artnetreader.h"
 #include "ltc.h"
-#include "timecodeconst.h"
 
 #include "c/led.h"
 
-#include "arm/synchronize.h"
-#include "h3_hs_timer.h"
-#include "h3_timer.h"
-#include "irq_timer.h"
+#include "h3/timecodepll.h"
 
 // Input
 #include "artnettimecode.h"
@@ -50,22 +46,6 @@
 #include "h3/ltcsender.h"
 #include "ntpserver.h"
 
-// IRQ Timer0
-static volatile uint32_t nUpdatesPerSecond = 0;
-static volatile uint32_t nUpdatesPrevious = 0;
-static volatile uint32_t nUpdates = 0;
-// IRQ Timer1
-static volatile bool IsMidiQuarterFrameMessage = false;
-
-static void irq_timer0_update_handler(uint32_t clo) {
-	nUpdatesPerSecond = nUpdates - nUpdatesPrevious;
-	nUpdatesPrevious = nUpdates;
-}
-
-static void irq_timer1_midi_handler(uint32_t clo) {
-	IsMidiQuarterFrameMessage = true;
-}
-
 ArtNetReader::ArtNetReader(struct TLtcDisabledOutputs *pLtcDisabledOutputs) :
 	m_ptLtcDisabledOutputs(pLtcDisabledOutputs),
 	m_tTimeCodeTypePrevious(TC_TYPE_INVALID),
@@ -82,68 +62,58 @@ ArtNetReader::~ArtNetReader(void) {
 }
 
 void ArtNetReader::Start(void) {
-	irq_timer_init();
-
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_update_handler);
-	H3_TIMER->TMR0_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
-
-	if (!m_ptLtcDisabledOutputs->bMidi) {
-		irq_timer_set(IRQ_TIMER_1, (thunk_irq_timer_t) irq_timer1_midi_handler);
-		H3_TIMER->TMR1_CTRL &= ~TIMER_CTRL_SINGLE_MODE;
-	}
+	TimeCodePll::Get()->Start();
 
 	led_set_ticks_per_second(1000000 / 1);
 }
 
 void ArtNetReader::Stop(void) {
-	irq_timer_set(IRQ_TIMER_0, 0);
-	irq_timer_set(IRQ_TIMER_1, 0);
+	TimeCodePll::Get()->Stop();
 }
 
 void ArtNetReader::Handler(const struct TArtNetTimeCode *ArtNetTimeCode) {
-	char *pTimeCodeType;
+	// The outputs are driven by the recovered clock, see Run
+	TimeCodePll::Get()->Input((const struct TLtcTimeCode *) ArtNetTimeCode);
+}
 
-	nUpdates++;
+void ArtNetReader::Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked) {
+	char *pTimeCodeType;
 
 	if (!m_ptLtcDisabledOutputs->bLtc) {
-		LtcSender::Get()->SetTimeCode((const struct TLtcTimeCode *)ArtNetTimeCode);
+		LtcSender::Get()->SetTimeCode(pTimeCode);
 	}
 
 	if (!m_ptLtcDisabledOutputs->bRtpMidi) {
-		RtpMidi::Get()->SendTimeCode((const struct _midi_send_tc *)ArtNetTimeCode);
+		RtpMidi::Get()->SendTimeCode((const struct _midi_send_tc *) pTimeCode);
 	}
 
 	if (!m_ptLtcDisabledOutputs->bNtp) {
-		NtpServer::Get()->SetTimeCode((const struct TLtcTimeCode *)ArtNetTimeCode);
+		NtpServer::Get()->SetTimeCode(pTimeCode);
 	}
 
-	memcpy(&m_tMidiTimeCode, ArtNetTimeCode, sizeof (struct _midi_send_tc ));
-
-	if ((m_tTimeCodeTypePrevious != (TTimecodeTypes )ArtNetTimeCode->Type)) {
-		m_tTimeCodeTypePrevious = (TTimecodeTypes) ArtNetTimeCode->Type;
+	memcpy(&m_tMidiTimeCode, pTimeCode, sizeof (struct _midi_send_tc ));
 
+	if (bRelocked) {
 		if (!m_ptLtcDisabledOutputs->bMidi) {
 			Midi::Get()->SendTimeCode(&m_tMidiTimeCode);
 		}
 
-		H3_TIMER->TMR1_INTV = TimeCodeConst::TMR_INTV[(int) ArtNetTimeCode->Type] / 4;
-		H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
-
 		m_nMidiQuarterFramePiece = 0;
+	}
+
+	if ((m_tTimeCodeTypePrevious != (TTimecodeTypes) pTimeCode->nType)) {
+		m_tTimeCodeTypePrevious = (TTimecodeTypes) pTimeCode->nType;
 
-		pTimeCodeType = (char *) Ltc::GetType((TTimecodeTypes) ArtNetTimeCode->Type);
+		pTimeCodeType = (char *) Ltc::GetType((TTimecodeTypes) pTimeCode->nType);
 
 		if (!m_ptLtcDisabledOutputs->bDisplay) {
 			Display::Get()->TextLine(2, pTimeCodeType, TC_TYPE_MAX_LENGTH);
 		}
 
-		LtcLeds::Get()->Show((TTimecodeTypes) ArtNetTimeCode->Type);
-
+		LtcLeds::Get()->Show((TTimecodeTypes) pTimeCode->nType);
 	}
 
-	Ltc::ItoaBase10((const struct TLtcTimeCode *) ArtNetTimeCode, m_aTimeCode);
+	Ltc::ItoaBase10(pTimeCode, m_aTimeCode);
 
 	if (!m_ptLtcDisabledOutputs->bDisplay) {
 		Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
@@ -154,11 +124,15 @@ void ArtNetReader::Handler(const struct TArtNetTimeCode *ArtNetTimeCode) {
 }
 
 void ArtNetReader::Run(void) {
-	dmb();
-	if (nUpdatesPerSecond >= 24) {
-		dmb();
-		if (__builtin_expect((IsMidiQuarterFrameMessage), 0)) {
-			IsMidiQuarterFrameMessage = false;
+	struct TLtcTimeCode tTimeCode;
+	bool bRelocked;
+
+	if (TimeCodePll::Get()->GetTimeCode(&tTimeCode, bRelocked)) {
+		Update(&tTimeCode, bRelocked);
+	}
+
+	if (TimeCodePll::Get()->IsLocked()) {
+		if (TimeCodePll::Get()->IsMidiQuarterFrame() && (!m_ptLtcDisabledOutputs->bMidi)) {
 			Midi::Get()->SendQf(&m_tMidiTimeCode, m_nMidiQuarterFramePiece);
 		}
 		led_set_ticks_per_second(1000000 / 3);
@@ -45,7 +45,7 @@
 
 #include "h3_hs_timer.h"
 #include "h3_timer.h"
-#include "irq_timer.h"
+#include "soft_timer.h"
 
 // Buttons
 #include "h3_board.h"
@@ -85,16 +85,16 @@ enum tUdpPort {
 	UDP_PORT = 0x5443
 };
 
-// IRQ Timer0
+// Soft timer, frame rate
 static volatile bool bTimeCodeAvailable;
 static ArtNetNode* s_pNode;
 static struct TLtcDisabledOutputs* s_ptLtcDisabledOutputs;
-// IRQ Timer1
+// Soft timer, MIDI quarter frame
 static volatile bool IsMidiQuarterFrameMessage;
 
 static struct TLtcTimeCode s_tLtcTimeCode;
 
-static void irq_timer0_handler(uint32_t clo) {
+static void timer_frame_handler(uint32_t clo) {
 	if (!s_ptLtcDisabledOutputs->bLtc) {
 		LtcSender::Get()->SetTimeCode((const struct TLtcTimeCode *) &s_tLtcTimeCode, false);
 	}
@@ -102,7 +102,7 @@ static void irq_timer0_handler(uint32_t clo) {
 	bTimeCodeAvailable = true;
 }
 
-static void irq_timer1_midi_handler(uint32_t clo) {
+static void timer_midi_handler(uint32_t clo) {
 	IsMidiQuarterFrameMessage = true;
 }
 
@@ -112,8 +112,8 @@ LtcGenerator::LtcGenerator(ArtNetNode* pNode, const struct TLtcTimeCode* pStartL
 	m_pStartLtcTimeCode((struct TLtcTimeCode *)pStartLtcTimeCode),
 	m_pStopLtcTimeCode((struct TLtcTimeCode *)pStopLtcTimeCode),
 	m_nFps(0),
-	m_nTimer0Interval(0),
-	m_nMidiQuarterFrameUs12(0),
+	m_nTimerFrame(-1),
+	m_nTimerMidi(-1),
 	nMidiQuarterFramePiece(0),
 	m_nButtons(0),
 	m_nHandle(-1),
@@ -142,8 +142,6 @@ LtcGenerator::LtcGenerator(ArtNetNode* pNode, const struct TLtcTimeCode* pStartL
 	m_aTimeCode[8] = '.';
 
 	m_nFps = TimeCodeConst::FPS[(int) pStartLtcTimeCode->nType];
-	m_nTimer0Interval = TimeCodeConst::TMR_INTV[(int) pStartLtcTimeCode->nType];
-	m_nMidiQuarterFrameUs12 = m_nTimer0Interval / 4;
 
 	if (m_pStartLtcTimeCode->nFrames >= m_nFps) {
 		m_pStartLtcTimeCode->nFrames = m_nFps - 1;
@@ -186,12 +184,8 @@ void LtcGenerator::Start(void) {
 	assert(m_nHandle != -1);
 
 	// Generator
-	irq_timer_init();
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_handler);
-
-	H3_TIMER->TMR0_INTV = m_nTimer0Interval;
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+	m_nTimerFrame = soft_timer_rate(timer_frame_handler, m_nFps, 0);
+	assert(m_nTimerFrame >= 0);
 
 	if (!s_ptLtcDisabledOutputs->bLtc) {
 		LtcSender::Get()->SetTimeCode((const struct TLtcTimeCode *) &s_tLtcTimeCode, false);
@@ -206,13 +200,10 @@ void LtcGenerator::Start(void) {
 	}
 
 	if (!s_ptLtcDisabledOutputs->bMidi) {
-		irq_timer_set(IRQ_TIMER_1, (thunk_irq_timer_t) irq_timer1_midi_handler);
-
 		Midi::Get()->SendTimeCode((const struct _midi_send_tc *)&s_tLtcTimeCode);
 
-		H3_TIMER->TMR1_INTV = m_nMidiQuarterFrameUs12;
-		H3_TIMER->TMR1_CTRL &= ~TIMER_CTRL_SINGLE_MODE;
-		H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+		m_nTimerMidi = soft_timer_rate(timer_midi_handler, m_nFps * 4, 0);
+		assert(m_nTimerMidi >= 0);
 
 		nMidiQuarterFramePiece = 0;
 	}
@@ -232,12 +223,11 @@ void LtcGenerator::Stop(void) {
 	DEBUG_ENTRY
 
 	__disable_irq();
-	irq_timer_set(IRQ_TIMER_0, 0);
-
+	soft_timer_cancel(m_nTimerFrame);
+	m_nTimerFrame = -1;
 
-	if (!s_ptLtcDisabledOutputs->bMidi) {
-		irq_timer_set(IRQ_TIMER_1, 0);
-	}
+	soft_timer_cancel(m_nTimerMidi);
+	m_nTimerMidi = -1;
 
 	m_nHandle = Network::Get()->End(UDP_PORT);
 
@@ -258,8 +248,7 @@ void LtcGenerator::ActionStart(void) {
 	if (!s_ptLtcDisabledOutputs->bMidi) {
 		Midi::Get()->SendTimeCode((struct _midi_send_tc *) &s_tLtcTimeCode);
 
-		H3_TIMER->TMR1_INTV = m_nMidiQuarterFrameUs12;
-		H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+		soft_timer_restart(m_nTimerMidi, 0);
 
 		nMidiQuarterFramePiece = 0;
 	}
@@ -42,7 +42,9 @@
 #include "h3_timer.h"
 #include "h3_hs_timer.h"
 
-#include "irq_timer.h"
+#include "soft_timer.h"
+
+#include "h3/timecodepll.h"
 
 #include "arm/arm.h"
 #include "arm/synchronize.h"
@@ -74,15 +76,14 @@
 #define END_SYNC_POSITION	77
 #define END_SMPTE_POSITION	80
 
-static volatile char aTimeCode[TC_CODE_MAX_LENGTH] ALIGNED;
-
 static volatile uint32_t nUpdatesPerSecond = 0;
 static volatile uint32_t nUpdatesPrevious = 0;
 static volatile uint32_t nUpdates = 0;
 
-static volatile bool IsMidiQuarterFrameMessage = false;
 static uint32_t nMidiQuarterFramePiece = 0;
 
+static int32_t s_nTimerUpdate = -1;
+
 static volatile uint32_t nFiqUsPrevious = 0;
 static volatile uint32_t nFiqUsCurrent = 0;
 
@@ -98,6 +99,7 @@ static volatile uint8_t aTimeCodeBits[8] ALIGNED;
 static volatile bool bIsDropFrameFlagSet = false;
 
 static volatile bool bTimeCodeAvailable = false;
+static volatile uint32_t nTimeCodeUs = 0;	///< AVS counter at the end of the frame
 static volatile struct _midi_send_tc s_tMidiTimeCode = { 0, 0, 0, 0, MIDI_TC_TYPE_EBU };
 
 static void __attribute__((interrupt("FIQ"))) fiq_handler(void) {
@@ -167,17 +169,9 @@ static void __attribute__((interrupt("FIQ"))) fiq_handler(void) {
 			s_tMidiTimeCode.nMinutes = (10 * (aTimeCodeBits[5] & 0x07)) + (aTimeCodeBits[4] & 0x0F);
 			s_tMidiTimeCode.nHours   = (10 * (aTimeCodeBits[7] & 0x03)) + (aTimeCodeBits[6] & 0x0F);
 
-			aTimeCode[10] = (aTimeCodeBits[0] & 0x0F) + '0';	// frames
-			aTimeCode[9]  = (aTimeCodeBits[1] & 0x03) + '0';	// 10's of frames
-			aTimeCode[7]  = (aTimeCodeBits[2] & 0x0F) + '0';	// seconds
-			aTimeCode[6]  = (aTimeCodeBits[3] & 0x07) + '0';	// 10's of seconds
-			aTimeCode[4]  = (aTimeCodeBits[4] & 0x0F) + '0';	// minutes
-			aTimeCode[3]  = (aTimeCodeBits[5] & 0x07) + '0';	// 10's of minutes
-			aTimeCode[1]  = (aTimeCodeBits[6] & 0x0F) + '0';	// hours
-			aTimeCode[0]  = (aTimeCodeBits[7] & 0x03) + '0';	// 10's of hours
-
 			bIsDropFrameFlagSet = (aTimeCodeBits[1] & (1 << 2));
 
+			nTimeCodeUs = H3_TIMER->AVS_CNT1;
 			bTimeCodeAvailable = true;
 		}
 	}
@@ -187,25 +181,21 @@ static void __attribute__((interrupt("FIQ"))) fiq_handler(void) {
 	dmb();
 }
 
-static void irq_timer0_update_handler(uint32_t clo) {
+static void timer_update_handler(uint32_t clo) {
 	dmb();
 	nUpdatesPerSecond = nUpdates - nUpdatesPrevious;
 	nUpdatesPrevious = nUpdates;
 }
 
-static void irq_timer1_midi_handler(uint32_t clo) {
-	IsMidiQuarterFrameMessage = true;
-}
-
 LtcReader::LtcReader(ArtNetNode *pNode, struct TLtcDisabledOutputs *pLtcDisabledOutputs):
 	m_pNode(pNode),
 	m_ptLtcDisabledOutputs(pLtcDisabledOutputs),
 	m_tTimeCodeTypePrevious(TC_TYPE_INVALID)
 {
-	memset((void *)&aTimeCode, ' ', sizeof(aTimeCode) / sizeof(aTimeCode[0]));
-	aTimeCode[2] = ':';
-	aTimeCode[5] = ':';
-	aTimeCode[8] = '.';
+	memset(&m_aTimeCode, ' ', sizeof(m_aTimeCode) / sizeof(m_aTimeCode[0]));
+	m_aTimeCode[2] = ':';
+	m_aTimeCode[5] = ':';
+	m_aTimeCode[8] = '.';
 }
 
 LtcReader::~LtcReader(void) {
@@ -223,133 +213,122 @@ void LtcReader::Start(void) {
 	H3_PIO_PA_INT->STA = (1 << GPIO_EXT_26);
 	H3_PIO_PA_INT->DEB = 1;
 
-	irq_timer_init();
+	s_nTimerUpdate = soft_timer_periodic(timer_update_handler, 1000000, 1000);
+	assert(s_nTimerUpdate >= 0);
 
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_update_handler);
-	H3_TIMER->TMR0_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
-
-	irq_timer_set(IRQ_TIMER_1, (thunk_irq_timer_t) irq_timer1_midi_handler);
-	H3_TIMER->TMR1_CTRL &= ~TIMER_CTRL_SINGLE_MODE;
+	TimeCodePll::Get()->Start();
 
 	__enable_fiq();
 }
 
 void LtcReader::Run(void) {
 	uint8_t TimeCodeType;
-	char *pTimeCodeType;
-#ifndef NDEBUG
-	char aLimitWarning[16] ALIGNED;
-	uint32_t nLimitUs;
-	uint32_t nNowUs =  0;
-#endif
 
 	dmb();
 	if (bTimeCodeAvailable) {
 		dmb();
 		bTimeCodeAvailable = false;
 
-#ifndef NDEBUG
-		nNowUs =  h3_hs_timer_lo_us();
-#endif
 		TimeCodeType = TC_TYPE_UNKNOWN;
 
 		dmb();
 		if (bIsDropFrameFlagSet) {
 			TimeCodeType = TC_TYPE_DF;
-#ifndef NDEBUG
-			nLimitUs = (uint32_t) ((double) 1000000 / (double) 30);
-#endif
 		} else {
 			if (nUpdatesPerSecond == 24) {
 				TimeCodeType = TC_TYPE_FILM;
-#ifndef NDEBUG
-				nLimitUs = (uint32_t) ((double) 1000000 / (double) 24);
-#endif
 			} else if (nUpdatesPerSecond == 25) {
 				TimeCodeType = TC_TYPE_EBU;
-#ifndef NDEBUG
-				nLimitUs = (uint32_t) ((double) 1000000 / (double) 25);
-#endif
 			} else if (nUpdatesPerSecond == 30) {
-#ifndef NDEBUG
-				nLimitUs = (uint32_t) ((double) 1000000 / (double) 30);
-#endif
 				TimeCodeType = TC_TYPE_SMPTE;
 			}
 		}
 
-		s_tMidiTimeCode.nType = (_midi_timecode_type)TimeCodeType;
-
 		struct TLtcTimeCode tLtcTimeCode;
 
 		tLtcTimeCode.nFrames = s_tMidiTimeCode.nFrames;
 		tLtcTimeCode.nSeconds = s_tMidiTimeCode.nSeconds;
 		tLtcTimeCode.nMinutes = s_tMidiTimeCode.nMinutes;
 		tLtcTimeCode.nHours = s_tMidiTimeCode.nHours;
-		tLtcTimeCode.nType = (uint8_t) s_tMidiTimeCode.nType;
+		tLtcTimeCode.nType = TimeCodeType;
 
-		if (!m_ptLtcDisabledOutputs->bArtNet) {
-			m_pNode->SendTimeCode((const struct TArtNetTimeCode*) &tLtcTimeCode);
-		}
+		// The outputs are driven by the recovered clock
+		TimeCodePll::Get()->Input(&tLtcTimeCode, nTimeCodeUs);
+	}
 
-		if (!m_ptLtcDisabledOutputs->bRtpMidi) {
-			RtpMidi::Get()->SendTimeCode((const struct _midi_send_tc *)&s_tMidiTimeCode);
-		}
+	struct TLtcTimeCode tTimeCode;
+	bool bRelocked;
+
+	if (TimeCodePll::Get()->GetTimeCode(&tTimeCode, bRelocked)) {
+		Update(&tTimeCode, bRelocked);
+	}
 
-		if (!m_ptLtcDisabledOutputs->bNtp) {
-			NtpServer::Get()->SetTimeCode((const struct TLtcTimeCode *)&tLtcTimeCode);
+	if (TimeCodePll::Get()->IsLocked()) {
+		if (TimeCodePll::Get()->IsMidiQuarterFrame()) {
+			Midi::Get()->SendQf((const struct _midi_send_tc*) &m_tMidiTimeCode, nMidiQuarterFramePiece);
 		}
+		led_set_ticks_per_second(1000000 / 3);
+	} else {
+		led_set_ticks_per_second(1000000 / 1);
+	}
+}
 
-		if (m_tTimeCodeTypePrevious != TimeCodeType) {
-			m_tTimeCodeTypePrevious = TimeCodeType;
+void LtcReader::Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked) {
+	char *pTimeCodeType;
+#ifndef NDEBUG
+	char aLimitWarning[16] ALIGNED;
+	const uint32_t nNowUs = h3_hs_timer_lo_us();
+	const uint32_t nLimitUs = pTimeCode->nType < TC_TYPE_UNKNOWN ? 1000000 / TimeCodeConst::FPS[pTimeCode->nType] : 0;
+#endif
 
-			Midi::Get()->SendTimeCode((const struct _midi_send_tc *) &s_tMidiTimeCode);
+	memcpy(&m_tMidiTimeCode, pTimeCode, sizeof(struct _midi_send_tc));
 
-			H3_TIMER->TMR1_INTV = TimeCodeConst::TMR_INTV[(int) TimeCodeType] / 4;
-			H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+	if (!m_ptLtcDisabledOutputs->bArtNet) {
+		m_pNode->SendTimeCode((const struct TArtNetTimeCode*) pTimeCode);
+	}
 
-			nMidiQuarterFramePiece = 0;
+	if (!m_ptLtcDisabledOutputs->bRtpMidi) {
+		RtpMidi::Get()->SendTimeCode(&m_tMidiTimeCode);
+	}
 
-			pTimeCodeType = (char *) Ltc::GetType((TTimecodeTypes) TimeCodeType);
+	if (!m_ptLtcDisabledOutputs->bNtp) {
+		NtpServer::Get()->SetTimeCode(pTimeCode);
+	}
 
-			if (!m_ptLtcDisabledOutputs->bDisplay) {
-				Display::Get()->TextLine(2, pTimeCodeType, TC_TYPE_MAX_LENGTH);
-			}
-			LtcLeds::Get()->Show((TTimecodeTypes) TimeCodeType);
-		}
+	if (bRelocked || (m_tTimeCodeTypePrevious != pTimeCode->nType)) {
+		Midi::Get()->SendTimeCode(&m_tMidiTimeCode);
+		nMidiQuarterFramePiece = 0;
+	}
+
+	if (m_tTimeCodeTypePrevious != pTimeCode->nType) {
+		m_tTimeCodeTypePrevious = pTimeCode->nType;
+
+		pTimeCodeType = (char *) Ltc::GetType((TTimecodeTypes) pTimeCode->nType);
 
 		if (!m_ptLtcDisabledOutputs->bDisplay) {
-			Display::Get()->TextLine(1, (const char *) aTimeCode, TC_CODE_MAX_LENGTH);
-		}
-		if (!m_ptLtcDisabledOutputs->bMax7219) {
-			DisplayMax7219::Get()->Show((const char *) aTimeCode);
+			Display::Get()->TextLine(2, pTimeCodeType, TC_TYPE_MAX_LENGTH);
 		}
+		LtcLeds::Get()->Show((TTimecodeTypes) pTimeCode->nType);
+	}
 
-#ifndef NDEBUG
-		const uint32_t delta_us = h3_hs_timer_lo_us() - nNowUs;
+	Ltc::ItoaBase10(pTimeCode, m_aTimeCode);
 
-		if (nLimitUs == 0) {
-			sprintf(aLimitWarning, "%.2d:-----:%.5d", (int) nUpdatesPerSecond, (int) delta_us);
-			console_status(CONSOLE_CYAN, aLimitWarning);
-		} else {
-			sprintf(aLimitWarning, "%.2d:%.5d:%.5d", (int) nUpdatesPerSecond, (int) nLimitUs, (int) delta_us);
-			console_status(delta_us < nLimitUs ? CONSOLE_YELLOW : CONSOLE_RED, aLimitWarning);
-		}
-#endif
+	if (!m_ptLtcDisabledOutputs->bDisplay) {
+		Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
+	}
+	if (!m_ptLtcDisabledOutputs->bMax7219) {
+		DisplayMax7219::Get()->Show((const char *) m_aTimeCode);
 	}
 
-	dmb();
-	if ((nUpdatesPerSecond >= 24) && (nUpdatesPerSecond <= 30)) {
-		dmb();
-		if (__builtin_expect((IsMidiQuarterFrameMessage), 0)) {
-			dmb();
-			IsMidiQuarterFrameMessage = false;
-			Midi::Get()->SendQf((const struct _midi_send_tc*)&s_tMidiTimeCode, nMidiQuarterFramePiece);
-		}
-		led_set_ticks_per_second(1000000 / 3);
+#ifndef NDEBUG
+	const uint32_t delta_us = h3_hs_timer_lo_us() - nNowUs;
+
+	if (nLimitUs == 0) {
+		sprintf(aLimitWarning, "%.2d:-----:%.5d", (int) nUpdatesPerSecond, (int) delta_us);
+		console_status(CONSOLE_CYAN, aLimitWarning);
 	} else {
-		led_set_ticks_per_second(1000000 / 1);
+		sprintf(aLimitWarning, "%.2d:%.5d:%.5d", (int) nUpdatesPerSecond, (int) nLimitUs, (int) delta_us);
+		console_status(delta_us < nLimitUs ? CONSOLE_YELLOW : CONSOLE_RED, aLimitWarning);
 	}
+#endif
 }
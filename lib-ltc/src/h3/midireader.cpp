@@ -36,7 +36,9 @@
 #include "arm/synchronize.h"
 #include "h3_hs_timer.h"
 #include "h3_timer.h"
-#include "irq_timer.h"
+#include "soft_timer.h"
+
+#include "h3/timecodepll.h"
 
 // Input
 #include "midi.h"
@@ -53,27 +55,16 @@
  #define ALIGNED __attribute__ ((aligned (4)))
 #endif
 
-// IRQ Timer0
+// Soft timer, 1 second
 static volatile uint32_t nUpdatesPerSecond = 0;
 static volatile uint32_t nUpdatesPrevious = 0;
 static volatile uint32_t nUpdates = 0;
 
 static uint8_t qf[8] ALIGNED = { 0, 0, 0, 0, 0, 0, 0, 0 };	///<
 
-inline static void itoa_base10(uint32_t arg, char *buf) {
-	char *n = buf;
-
-	if (arg == 0) {
-		*n++ = '0';
-		*n = '0';
-		return;
-	}
-
-	*n++ = (char) ('0' + (arg / 10));
-	*n = (char) ('0' + (arg % 10));
-}
+static int32_t s_nTimerUpdate = -1;
 
-static void irq_timer0_update_handler(uint32_t clo) {
+static void timer_update_handler(uint32_t clo) {
 	dmb();
 	nUpdatesPerSecond = nUpdates - nUpdatesPrevious;
 	nUpdatesPrevious = nUpdates;
@@ -97,12 +88,10 @@ MidiReader::~MidiReader(void) {
 }
 
 void MidiReader::Start(void) {
-	irq_timer_init();
+	s_nTimerUpdate = soft_timer_periodic(timer_update_handler, 1000000, 1000);
+	assert(s_nTimerUpdate >= 0);
 
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_update_handler);
-	H3_TIMER->TMR0_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+	TimeCodePll::Get()->Start();
 
 	midi_active_set_sense(false); //TODO We do nothing with sense data, yet
 	midi_init(MIDI_DIRECTION_INPUT);
@@ -136,8 +125,15 @@ void MidiReader::Run(void) {
 		nUpdates++;
 	}
 
+	struct TLtcTimeCode tTimeCode;
+	bool bRelocked;
+
+	if (TimeCodePll::Get()->GetTimeCode(&tTimeCode, bRelocked)) {
+		Update(&tTimeCode);
+	}
+
 	dmb();
-	if (nUpdatesPerSecond >= 24)  {
+	if ((nUpdatesPerSecond >= 24) || TimeCodePll::Get()->IsLocked())  {
 		led_set_ticks_per_second(1000000 / 3);
 	} else {
 		led_set_ticks_per_second(1000000 / 1);
@@ -150,18 +146,13 @@ void MidiReader::HandleMtc(void) {
 
 	m_nTimeCodeType = (_midi_timecode_type) (pSystemExclusive[5] >> 5);
 
-	itoa_base10((pSystemExclusive[5] & 0x1F), (char *) &m_aTimeCode[0]);
-	itoa_base10(pSystemExclusive[6], (char *) &m_aTimeCode[3]);
-	itoa_base10(pSystemExclusive[7], (char *) &m_aTimeCode[6]);
-	itoa_base10(pSystemExclusive[8], (char *) &m_aTimeCode[9]);
-
 	m_MidiTimeCode.nHours = pSystemExclusive[5] & 0x1F;
 	m_MidiTimeCode.nMinutes = pSystemExclusive[6];
 	m_MidiTimeCode.nSeconds = pSystemExclusive[7];
 	m_MidiTimeCode.nFrames = pSystemExclusive[8];
 	m_MidiTimeCode.nType = m_nTimeCodeType;
 
-	Update();
+	TimeCodePll::Get()->Input((const struct TLtcTimeCode *) &m_MidiTimeCode);
 }
 
 void MidiReader::HandleMtcQf(void) {
@@ -181,45 +172,43 @@ void MidiReader::HandleMtcQf(void) {
 	}
 
 	if ((m_bDirection && (nPart == 7)) || (!m_bDirection && (nPart == 0))) {
-		itoa_base10(qf[6] | ((qf[7] & 0x1) << 4), (char*) &m_aTimeCode[0]);
-		itoa_base10(qf[4] | (qf[5] << 4), (char*) &m_aTimeCode[3]);
-		itoa_base10(qf[2] | (qf[3] << 4), (char*) &m_aTimeCode[6]);
-		itoa_base10(qf[0] | (qf[1] << 4), (char*) &m_aTimeCode[9]);
-
 		m_MidiTimeCode.nHours = qf[6] | ((qf[7] & 0x1) << 4);
 		m_MidiTimeCode.nMinutes = qf[4] | (qf[5] << 4);
 		m_MidiTimeCode.nSeconds = qf[2] | (qf[3] << 4);
 		m_MidiTimeCode.nFrames = qf[0] | (qf[1] << 4);
 		m_MidiTimeCode.nType = m_nTimeCodeType;
 
-		Update();
+		// A full frame every 2 frames, the PLL interpolates the frame in between
+		TimeCodePll::Get()->Input((const struct TLtcTimeCode *) &m_MidiTimeCode);
 	}
 
 	m_nPartPrevious = nPart;
 }
 
-void MidiReader::Update(void) {
+void MidiReader::Update(const struct TLtcTimeCode *pTimeCode) {
 	if (!m_ptLtcDisabledOutputs->bArtNet) {
-		m_pNode->SendTimeCode((const struct TArtNetTimeCode *) &m_MidiTimeCode);
+		m_pNode->SendTimeCode((const struct TArtNetTimeCode *) pTimeCode);
 	}
 
 	if (!m_ptLtcDisabledOutputs->bRtpMidi) {
-		RtpMidi::Get()->SendTimeCode(&m_MidiTimeCode);
+		RtpMidi::Get()->SendTimeCode((const struct _midi_send_tc *) pTimeCode);
 	}
 
 	if (!m_ptLtcDisabledOutputs->bNtp) {
-		NtpServer::Get()->SetTimeCode((const struct TLtcTimeCode *) &m_MidiTimeCode);
+		NtpServer::Get()->SetTimeCode(pTimeCode);
 	}
 
-	if (m_nTimeCodeType != m_nTimeCodeTypePrevious) {
-		m_nTimeCodeTypePrevious = m_nTimeCodeType;
+	if (pTimeCode->nType != m_nTimeCodeTypePrevious) {
+		m_nTimeCodeTypePrevious = (_midi_timecode_type) pTimeCode->nType;
 
 		if (!m_ptLtcDisabledOutputs->bDisplay) {
-			Display::Get()->TextLine(2, (char *) Ltc::GetType((TTimecodeTypes) m_nTimeCodeType), TC_TYPE_MAX_LENGTH);
+			Display::Get()->TextLine(2, (char *) Ltc::GetType((TTimecodeTypes) pTimeCode->nType), TC_TYPE_MAX_LENGTH);
 		}
-		LtcLeds::Get()->Show((TTimecodeTypes) m_nTimeCodeType);
+		LtcLeds::Get()->Show((TTimecodeTypes) pTimeCode->nType);
 	}
 
+	Ltc::ItoaBase10(pTimeCode, m_aTimeCode);
+
 	if (!m_ptLtcDisabledOutputs->bDisplay) {
 		Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
 	}
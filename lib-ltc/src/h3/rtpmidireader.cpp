@@ -34,7 +34,9 @@
 #include "arm/synchronize.h"
 #include "h3_hs_timer.h"
 #include "h3_timer.h"
-#include "irq_timer.h"
+#include "soft_timer.h"
+
+#include "h3/timecodepll.h"
 
 // Output
 #include "ltcleds.h"
@@ -45,31 +47,20 @@
 #include "h3/ltcsender.h"
 #include "ntpserver.h"
 
-// IRQ Timer0
+// Soft timer, 1 second
 static volatile uint32_t nUpdatesPerSecond = 0;
 static volatile uint32_t nUpdatesPrevious = 0;
 static volatile uint32_t nUpdates = 0;
 
 static uint8_t qf[8] __attribute__ ((aligned (4))) = { 0, 0, 0, 0, 0, 0, 0, 0 };
 
-static void irq_timer0_update_handler(uint32_t clo) {
+static int32_t s_nTimerUpdate = -1;
+
+static void timer_update_handler(uint32_t clo) {
 	nUpdatesPerSecond = nUpdates - nUpdatesPrevious;
 	nUpdatesPrevious = nUpdates;
 }
 
-inline static void itoa_base10(uint32_t arg, char *buf) {
-	char *n = buf;
-
-	if (arg == 0) {
-		*n++ = '0';
-		*n = '0';
-		return;
-	}
-
-	*n++ = (char) ('0' + (arg / 10));
-	*n = (char) ('0' + (arg % 10));
-}
-
 RtpMidiHandler::~RtpMidiHandler(void) {
 
 }
@@ -96,18 +87,19 @@ RtpMidiReader::~RtpMidiReader(void) {
 }
 
 void RtpMidiReader::Start(void) {
-	irq_timer_init();
+	s_nTimerUpdate = soft_timer_periodic(timer_update_handler, 1000000, 1000);
+	assert(s_nTimerUpdate >= 0);
 
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_update_handler);
-	H3_TIMER->TMR0_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+	TimeCodePll::Get()->Start();
 
 	led_set_ticks_per_second(1000000 / 1);
 }
 
 void RtpMidiReader::Stop(void) {
-	irq_timer_set(IRQ_TIMER_0, 0);
+	soft_timer_cancel(s_nTimerUpdate);
+	s_nTimerUpdate = -1;
+
+	TimeCodePll::Get()->Stop();
 }
 
 void RtpMidiReader::MidiMessage(const struct _midi_message *ptMidiMessage) {
@@ -131,8 +123,15 @@ void RtpMidiReader::MidiMessage(const struct _midi_message *ptMidiMessage) {
 }
 
 void RtpMidiReader::Run(void) {
+	struct TLtcTimeCode tTimeCode;
+	bool bRelocked;
+
+	if (TimeCodePll::Get()->GetTimeCode(&tTimeCode, bRelocked)) {
+		Update(&tTimeCode);
+	}
+
 	dmb();
-	if (nUpdatesPerSecond >= 24)  {
+	if ((nUpdatesPerSecond >= 24) || TimeCodePll::Get()->IsLocked())  {
 		led_set_ticks_per_second(1000000 / 3);
 	} else {
 		m_nTimeCodeTypePrevious = MIDI_TC_TYPE_UNKNOWN;
@@ -146,10 +145,9 @@ void RtpMidiReader::HandleMtc(const struct _midi_message *ptMidiMessage) {
 
 	m_nTimeCodeType = (_midi_timecode_type) (pSystemExclusive[5] >> 5);
 
-	itoa_base10((pSystemExclusive[5] & 0x1F), (char *) &m_aTimeCode[0]);
-	itoa_base10(pSystemExclusive[6], (char *) &m_aTimeCode[3]);
-	itoa_base10(pSystemExclusive[7], (char *) &m_aTimeCode[6]);
-	itoa_base10(pSystemExclusive[8], (char *) &m_aTimeCode[9]);
+	if (!m_ptLtcDisabledOutputs->bMidi) {
+		midi_send_raw(ptMidiMessage->system_exclusive, ptMidiMessage->bytes_count);
+	}
 
 	m_tLtcTimeCode.nFrames = pSystemExclusive[8];
 	m_tLtcTimeCode.nSeconds = pSystemExclusive[7];
@@ -157,7 +155,7 @@ void RtpMidiReader::HandleMtc(const struct _midi_message *ptMidiMessage) {
 	m_tLtcTimeCode.nHours = pSystemExclusive[5] & 0x1F;
 	m_tLtcTimeCode.nType = m_nTimeCodeType;
 
-	Update(ptMidiMessage);
+	TimeCodePll::Get()->Input(&m_tLtcTimeCode);
 }
 
 void RtpMidiReader::HandleMtcQf(const struct _midi_message *ptMidiMessage) {
@@ -178,47 +176,39 @@ void RtpMidiReader::HandleMtcQf(const struct _midi_message *ptMidiMessage) {
 	}
 
 	if ( (m_bDirection && (nPart == 7)) || (!m_bDirection && (nPart == 0)) ) {
-		itoa_base10(qf[6] | ((qf[7] & 0x1) << 4), (char *) &m_aTimeCode[0]);
-		itoa_base10(qf[4] | (qf[5] << 4), (char *) &m_aTimeCode[3]);
-		itoa_base10(qf[2] | (qf[3] << 4), (char *) &m_aTimeCode[6]);
-		itoa_base10(qf[0] | (qf[1] << 4), (char *) &m_aTimeCode[9]);
-
 		m_tLtcTimeCode.nFrames = qf[0] | (qf[1] << 4);
 		m_tLtcTimeCode.nSeconds = qf[2] | (qf[3] << 4);
 		m_tLtcTimeCode.nMinutes = qf[4] | (qf[5] << 4);
 		m_tLtcTimeCode.nHours = qf[6] | ((qf[7] & 0x1) << 4);
 		m_tLtcTimeCode.nType = m_nTimeCodeType;
 
-		Update(ptMidiMessage);
+		// A full frame every 2 frames, the PLL interpolates the frame in between
+		TimeCodePll::Get()->Input(&m_tLtcTimeCode);
 	}
 
 	m_nPartPrevious = nPart;
 }
 
-void RtpMidiReader::Update(const struct _midi_message *ptMidiMessage) {
+void RtpMidiReader::Update(const struct TLtcTimeCode *pTimeCode) {
 	if (!m_ptLtcDisabledOutputs->bArtNet) {
-		m_pNode->SendTimeCode((struct TArtNetTimeCode *) &m_tLtcTimeCode);
-	}
-
-	if (!m_ptLtcDisabledOutputs->bMidi) {
-		if (ptMidiMessage->type == MIDI_TYPES_SYSTEM_EXCLUSIVE) {
-			midi_send_raw(ptMidiMessage->system_exclusive, ptMidiMessage->bytes_count);
-		}
+		m_pNode->SendTimeCode((const struct TArtNetTimeCode *) pTimeCode);
 	}
 
 	if (!m_ptLtcDisabledOutputs->bNtp) {
-		NtpServer::Get()->SetTimeCode((const struct TLtcTimeCode *) &m_tLtcTimeCode);
+		NtpServer::Get()->SetTimeCode(pTimeCode);
 	}
 
-	if (m_nTimeCodeType != m_nTimeCodeTypePrevious) {
-		m_nTimeCodeTypePrevious = m_nTimeCodeType;
+	if (pTimeCode->nType != m_nTimeCodeTypePrevious) {
+		m_nTimeCodeTypePrevious = (_midi_timecode_type) pTimeCode->nType;
 
 		if (!m_ptLtcDisabledOutputs->bDisplay) {
-			Display::Get()->TextLine(2, (char *) Ltc::GetType((TTimecodeTypes) m_nTimeCodeType), TC_TYPE_MAX_LENGTH);
+			Display::Get()->TextLine(2, (char *) Ltc::GetType((TTimecodeTypes) pTimeCode->nType), TC_TYPE_MAX_LENGTH);
 		}
-		LtcLeds::Get()->Show((TTimecodeTypes) m_nTimeCodeType);
+		LtcLeds::Get()->Show((TTimecodeTypes) pTimeCode->nType);
 	}
 
+	Ltc::ItoaBase10(pTimeCode, m_aTimeCode);
+
 	if (!m_ptLtcDisabledOutputs->bDisplay) {
 		Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
 	}
@@ -28,14 +28,10 @@
 #include <assert.h>
 
 #include "h3/tcnetreader.h"
-#include "timecodeconst.h"
 
 #include "c/led.h"
 
-#include "arm/synchronize.h"
-#include "h3_hs_timer.h"
-#include "h3_timer.h"
-#include "irq_timer.h"
+#include "h3/timecodepll.h"
 
 // Output
 #include "ltcleds.h"
@@ -47,27 +43,10 @@
 #include "h3/ltcsender.h"
 #include "ntpserver.h"
 
-// IRQ Timer0
-static volatile uint32_t nUpdatesPerSecond = 0;
-static volatile uint32_t nUpdatesPrevious = 0;
-static volatile uint32_t nUpdates = 0;
-// IRQ Timer1
-static volatile bool IsMidiQuarterFrameMessage = false;
-
-static void irq_timer0_update_handler(uint32_t clo) {
-	nUpdatesPerSecond = nUpdates - nUpdatesPrevious;
-	nUpdatesPrevious = nUpdates;
-}
-
-static void irq_timer1_midi_handler(uint32_t clo) {
-	IsMidiQuarterFrameMessage = true;
-}
-
 TCNetReader::TCNetReader(ArtNetNode* pNode, struct TLtcDisabledOutputs *pLtcDisabledOutputs) :
 	m_pNode(pNode),
 	m_ptLtcDisabledOutputs(pLtcDisabledOutputs),
 	m_nMidiQuarterFramePiece(0),
-	m_nTimeCodePrevious(0xFF),
 	m_tTimeCodeTypePrevious(TC_TYPE_INVALID)
 {
 	memset(&m_aTimeCode, ' ', sizeof(m_aTimeCode) / sizeof(m_aTimeCode[0]));
@@ -81,65 +60,51 @@ TCNetReader::~TCNetReader(void) {
 }
 
 void TCNetReader::Start(void) {
-	irq_timer_init();
-
-	irq_timer_set(IRQ_TIMER_0, (thunk_irq_timer_t) irq_timer0_update_handler);
-	H3_TIMER->TMR0_INTV = 0xB71B00; // 1 second
-	H3_TIMER->TMR0_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	H3_TIMER->TMR0_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
-
-	if (!m_ptLtcDisabledOutputs->bMidi) {
-		irq_timer_set(IRQ_TIMER_1, (thunk_irq_timer_t) irq_timer1_midi_handler);
-		H3_TIMER->TMR1_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-	}
+	TimeCodePll::Get()->Start();
 
 	led_set_ticks_per_second(1000000 / 1);
 }
 
 void TCNetReader::Stop(void) {
-	irq_timer_set(IRQ_TIMER_0, 0);
-	irq_timer_set(IRQ_TIMER_1, 0);
+	TimeCodePll::Get()->Stop();
 }
 
 void TCNetReader::Handler(const struct TTCNetTimeCode* pTimeCode) {
-	char *pTimeCodeType;
+	// Repeated frames are filtered by the PLL. The outputs are driven by the recovered clock, see Run
+	TimeCodePll::Get()->Input((const struct TLtcTimeCode *) pTimeCode);
+}
 
-	nUpdates++;
+void TCNetReader::Update(const struct TLtcTimeCode *pTimeCode, bool bRelocked) {
+	char *pTimeCodeType;
 
 	memcpy(&m_tMidiTimeCode, pTimeCode, sizeof(struct _midi_send_tc));
 
-	assert(((uint32_t )pTimeCode & 0x3) == 0); // Check if we can do 4-byte compare
-	const uint32_t *p = (uint32_t *)pTimeCode;
-
-	if (m_nTimeCodePrevious != *p) {
-		if (!m_ptLtcDisabledOutputs->bLtc) {
-			LtcSender::Get()->SetTimeCode((const struct TLtcTimeCode *) pTimeCode);
-		}
-
-		if (!m_ptLtcDisabledOutputs->bArtNet) {
-			m_pNode->SendTimeCode((const struct TArtNetTimeCode *) pTimeCode);
-		}
+	if (!m_ptLtcDisabledOutputs->bLtc) {
+		LtcSender::Get()->SetTimeCode(pTimeCode);
+	}
 
-		if (!m_ptLtcDisabledOutputs->bRtpMidi) {
-			RtpMidi::Get()->SendTimeCode(&m_tMidiTimeCode);
-		}
+	if (!m_ptLtcDisabledOutputs->bArtNet) {
+		m_pNode->SendTimeCode((const struct TArtNetTimeCode *) pTimeCode);
+	}
 
-		if (!m_ptLtcDisabledOutputs->bNtp) {
-			NtpServer::Get()->SetTimeCode((const struct TLtcTimeCode *) pTimeCode);
-		}
+	if (!m_ptLtcDisabledOutputs->bRtpMidi) {
+		RtpMidi::Get()->SendTimeCode(&m_tMidiTimeCode);
 	}
 
-	if ((m_tTimeCodeTypePrevious != (TTimecodeTypes) pTimeCode->nType)) {
-		m_tTimeCodeTypePrevious = (TTimecodeTypes) pTimeCode->nType;
+	if (!m_ptLtcDisabledOutputs->bNtp) {
+		NtpServer::Get()->SetTimeCode(pTimeCode);
+	}
 
+	if (bRelocked) {
 		if (!m_ptLtcDisabledOutputs->bMidi) {
 			Midi::Get()->SendTimeCode((struct _midi_send_tc *) &m_tMidiTimeCode);
 		}
 
-		H3_TIMER->TMR1_INTV = TimeCodeConst::TMR_INTV[(int) pTimeCode->nType] / 4;
-		H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
-
 		m_nMidiQuarterFramePiece = 0;
+	}
+
+	if ((m_tTimeCodeTypePrevious != (TTimecodeTypes) pTimeCode->nType)) {
+		m_tTimeCodeTypePrevious = (TTimecodeTypes) pTimeCode->nType;
 
 		pTimeCodeType = (char *) Ltc::GetType((TTimecodeTypes) pTimeCode->nType);
 
@@ -150,32 +115,31 @@ void TCNetReader::Handler(const struct TTCNetTimeCode* pTimeCode) {
 		LtcLeds::Get()->Show((TTimecodeTypes) pTimeCode->nType);
 	}
 
-	if (m_nTimeCodePrevious != *p) {
-		m_nTimeCodePrevious = *p;
+	Ltc::ItoaBase10(pTimeCode, m_aTimeCode);
 
-		Ltc::ItoaBase10((const struct TLtcTimeCode *) pTimeCode, m_aTimeCode);
-
-		if (!m_ptLtcDisabledOutputs->bDisplay) {
-			Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
-		}
-		if (!m_ptLtcDisabledOutputs->bMax7219) {
-			DisplayMax7219::Get()->Show((const char *) m_aTimeCode);
-		}
+	if (!m_ptLtcDisabledOutputs->bDisplay) {
+		Display::Get()->TextLine(1, (const char *) m_aTimeCode, TC_CODE_MAX_LENGTH);
+	}
+	if (!m_ptLtcDisabledOutputs->bMax7219) {
+		DisplayMax7219::Get()->Show((const char *) m_aTimeCode);
 	}
 }
 
 void TCNetReader::Run(void) {
-	dmb();
-	if (nUpdatesPerSecond >= 24) {
-		dmb();
-		if (__builtin_expect((IsMidiQuarterFrameMessage), 0)) {
-			dmb();
-			IsMidiQuarterFrameMessage = false;
+	struct TLtcTimeCode tTimeCode;
+	bool bRelocked;
+
+	if (TimeCodePll::Get()->GetTimeCode(&tTimeCode, bRelocked)) {
+		Update(&tTimeCode, bRelocked);
+	}
+
+	if (TimeCodePll::Get()->IsLocked()) {
+		if (TimeCodePll::Get()->IsMidiQuarterFrame() && (!m_ptLtcDisabledOutputs->bMidi)) {
 			Midi::Get()->SendQf(&m_tMidiTimeCode, m_nMidiQuarterFramePiece);
 		}
 		led_set_ticks_per_second(1000000 / 3);
 	} else {
-		m_nTimeCodePrevious = TC_TYPE_INVALID;
+		m_tTimeCodeTypePrevious = TC_TYPE_INVALID;
 		DisplayMax7219::Get()->ShowSysTime();
 		led_set_ticks_per_second(1000000 / 1);
 	}
@@ -0,0 +1,372 @@
+/**
+ * @file timecodepll.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+#include <stdint.h>
+#include <string.h>
+#include <stdio.h>
+#include <assert.h>
+
+#include "h3/timecodepll.h"
+#include "ltc.h"
+#include "timecodeconst.h"
+
+#include "h3.h"
+#include "soft_timer.h"
+
+#include "arm/arm.h"
+#include "arm/synchronize.h"
+
+/*
+ * The period is kept in 1/256 us.
+ * DF is 29.97 fps, FPS[TC_TYPE_DF] is the frame count per second.
+ */
+static const uint32_t s_aPeriodNominal[4] = {
+		(256 * 1000000U) / 24,
+		(256 * 1000000U) / 25,
+		(256 * 1000000ULL * 1001) / 30000,
+		(256 * 1000000U) / 30 };
+
+/*
+ * PI loop filter, with a phase gain of 1/8 and a frequency gain of 1/128.
+ * The recovered clock lags the input with a quarter frame, so that the jitter
+ * of the input does not reorder the input frames and the output frames.
+ */
+#define PHASE_GAIN_SHIFT		3
+#define PERIOD_GAIN				2		///< 256/128
+#define PERIOD_RANGE_SHIFT		5		///< +/- 3%
+
+TimeCodePll *TimeCodePll::s_pThis = 0;
+
+static void timer_pll_handler(uint32_t clo) {
+	TimeCodePll::Get()->Tick(clo);
+}
+
+static inline uint32_t now_us(void) {
+	return H3_TIMER->AVS_CNT1;
+}
+
+static inline bool is_equal(const struct TLtcTimeCode *pA, const struct TLtcTimeCode *pB) {
+	return (pA->nFrames == pB->nFrames) && (pA->nSeconds == pB->nSeconds) && (pA->nMinutes == pB->nMinutes) && (pA->nHours == pB->nHours);
+}
+
+TimeCodePll::TimeCodePll(void) :
+	m_nInputUs(0),
+	m_nFrameUs(0),
+	m_nFraction(0),
+	m_nPeriod(s_aPeriodNominal[TC_TYPE_EBU]),
+	m_nPeriodNominal(s_aPeriodNominal[TC_TYPE_EBU]),
+	m_nQuarter(0),
+	m_nFramesMissed(0),
+	m_nTimer(-1),
+	m_nPhaseError(0),
+	m_nRelocks(0),
+	m_nFreewheelFrames(TIMECODE_PLL_FREEWHEEL_FRAMES_DEFAULT),
+	m_bLocked(false),
+	m_bHold(false),
+	m_bTimeCodeAvailable(false),
+	m_bRelocked(false),
+	m_bMidiQuarterFrame(false)
+{
+	s_pThis = this;
+
+	memset(&m_tTimeCode, 0, sizeof(struct TLtcTimeCode));
+	m_tTimeCode.nType = TC_TYPE_INVALID;
+	memset(&m_tInput, 0, sizeof(struct TLtcTimeCode));
+	m_tInput.nType = TC_TYPE_INVALID;
+}
+
+TimeCodePll::~TimeCodePll(void) {
+	Stop();
+}
+
+void TimeCodePll::Start(void) {
+	__disable_irq();
+
+	m_bLocked = false;
+	m_bTimeCodeAvailable = false;
+	m_bMidiQuarterFrame = false;
+	m_tTimeCode.nType = TC_TYPE_INVALID;
+
+	__enable_irq();
+}
+
+void TimeCodePll::Stop(void) {
+	__disable_irq();
+
+	soft_timer_cancel(m_nTimer);
+	m_nTimer = -1;
+	m_bLocked = false;
+
+	__enable_irq();
+}
+
+void TimeCodePll::Next(struct TLtcTimeCode *pTimeCode) const {
+	assert(pTimeCode->nType < TC_TYPE_UNKNOWN);
+
+	pTimeCode->nFrames++;
+
+	if (pTimeCode->nFrames == TimeCodeConst::FPS[pTimeCode->nType]) {
+		pTimeCode->nFrames = 0;
+
+		pTimeCode->nSeconds++;
+		if (pTimeCode->nSeconds == 60) {
+			pTimeCode->nSeconds = 0;
+
+			pTimeCode->nMinutes++;
+			if (pTimeCode->nMinutes == 60) {
+				pTimeCode->nMinutes = 0;
+
+				pTimeCode->nHours++;
+				if (pTimeCode->nHours == 24) {
+					pTimeCode->nHours = 0;
+				}
+			}
+
+			// Drop frame: frames 0 and 1 are skipped, except for every tenth minute
+			if ((pTimeCode->nType == TC_TYPE_DF) && ((pTimeCode->nMinutes % 10) != 0)) {
+				pTimeCode->nFrames = 2;
+			}
+		}
+	}
+}
+
+void TimeCodePll::Schedule(uint32_t nNowUs) {
+	// The deadline of the next quarter frame, from the start of the current frame
+	const uint32_t nOffset = ((m_nFraction << 2) + ((m_nQuarter + 1) * m_nPeriod)) >> 10;
+	const int32_t nDelay = (int32_t) ((m_nFrameUs + nOffset) - nNowUs);
+
+	m_nTimer = soft_timer_oneshot(timer_pll_handler, nDelay < 1 ? 1 : (uint32_t) nDelay, 0);
+	assert(m_nTimer >= 0);
+}
+
+void TimeCodePll::Lock(const struct TLtcTimeCode *pTimeCode, uint32_t nTimeUs) {
+	soft_timer_cancel(m_nTimer);
+	m_nTimer = -1;
+
+	// A jump within the same type keeps the recovered period
+	if (!m_bLocked || (m_tTimeCode.nType != pTimeCode->nType)) {
+		m_nPeriodNominal = s_aPeriodNominal[pTimeCode->nType];
+		m_nPeriod = m_nPeriodNominal;
+	}
+
+	memcpy(&m_tTimeCode, pTimeCode, sizeof(struct TLtcTimeCode));
+	memcpy(&m_tInput, pTimeCode, sizeof(struct TLtcTimeCode));
+	m_nInputUs = nTimeUs;
+
+	m_nFrameUs = nTimeUs + (m_nPeriod >> 10);
+	m_nFraction = 0;
+	m_nQuarter = 0;
+	m_nFramesMissed = 0;
+	m_nPhaseError = 0;
+	m_nRelocks++;
+
+	m_bLocked = true;
+	m_bHold = false;
+	m_bTimeCodeAvailable = true;
+	m_bRelocked = true;
+	m_bMidiQuarterFrame = false;
+
+	Schedule(now_us());
+}
+
+void TimeCodePll::Input(const struct TLtcTimeCode *pTimeCode) {
+	Input(pTimeCode, now_us());
+}
+
+void TimeCodePll::Input(const struct TLtcTimeCode *pTimeCode, uint32_t nTimeUs) {
+	assert(pTimeCode != 0);
+
+	__disable_irq();
+
+	if (pTimeCode->nType >= TC_TYPE_UNKNOWN) {
+		// There is no nominal frame rate, the frame is passed through
+		soft_timer_cancel(m_nTimer);
+		m_nTimer = -1;
+
+		memcpy(&m_tTimeCode, pTimeCode, sizeof(struct TLtcTimeCode));
+
+		m_bRelocked = m_bLocked;
+		m_bLocked = false;
+		m_bTimeCodeAvailable = true;
+
+		__enable_irq();
+		return;
+	}
+
+	if (!m_bLocked || (m_tTimeCode.nType != pTimeCode->nType)) {
+		Lock(pTimeCode, nTimeUs);
+		__enable_irq();
+		return;
+	}
+
+	if (is_equal(pTimeCode, &m_tInput)) {
+		// Only the first arrival of a frame is used
+		m_nFramesMissed = 0;
+
+		if (!m_bHold && ((nTimeUs - m_nInputUs) > ((m_nPeriod + (m_nPeriod >> 1)) >> 8))) {
+			// The source is paused, the output holds the input frame
+			memcpy(&m_tTimeCode, pTimeCode, sizeof(struct TLtcTimeCode));
+			m_bHold = true;
+			m_bTimeCodeAvailable = true;
+		}
+
+		__enable_irq();
+		return;
+	}
+
+	if (m_bHold) {
+		// The source is running again
+		Lock(pTimeCode, nTimeUs);
+		__enable_irq();
+		return;
+	}
+
+	memcpy(&m_tInput, pTimeCode, sizeof(struct TLtcTimeCode));
+	m_nInputUs = nTimeUs;
+
+	// The input is expected a quarter frame before the start of the output frame
+	int32_t nError = (int32_t) ((nTimeUs + (m_nPeriod >> 10)) - m_nFrameUs);
+
+	if (!is_equal(pTimeCode, &m_tTimeCode)) {
+		struct TLtcTimeCode tNext;
+
+		memcpy(&tNext, &m_tTimeCode, sizeof(struct TLtcTimeCode));
+		Next(&tNext);
+
+		if (!is_equal(pTimeCode, &tNext)) {
+			Lock(pTimeCode, nTimeUs);
+			__enable_irq();
+			return;
+		}
+
+		nError -= (int32_t) ((m_nPeriod + m_nFraction) >> 8);
+	}
+
+	if ((nError > (int32_t) (m_nPeriod >> 9)) || (nError < -(int32_t) (m_nPeriod >> 9))) {
+		// More than half a frame off
+		Lock(pTimeCode, nTimeUs);
+		__enable_irq();
+		return;
+	}
+
+	m_nPhaseError = nError;
+	m_nFrameUs += nError / (1 << PHASE_GAIN_SHIFT);
+	m_nPeriod += nError * PERIOD_GAIN;
+
+	const uint32_t nRange = m_nPeriodNominal >> PERIOD_RANGE_SHIFT;
+
+	if (m_nPeriod > (m_nPeriodNominal + nRange)) {
+		m_nPeriod = m_nPeriodNominal + nRange;
+	} else if (m_nPeriod < (m_nPeriodNominal - nRange)) {
+		m_nPeriod = m_nPeriodNominal - nRange;
+	}
+
+	m_nFramesMissed = 0;
+
+	soft_timer_cancel(m_nTimer);
+	Schedule(now_us());
+
+	__enable_irq();
+}
+
+void TimeCodePll::Tick(uint32_t nNowUs) {
+	// The one-shot timer is released
+	m_nTimer = -1;
+
+	if (!m_bLocked) {
+		return;
+	}
+
+	m_nQuarter++;
+
+	if (m_nQuarter == 4) {
+		m_nQuarter = 0;
+
+		if (m_nFramesMissed > m_nFreewheelFrames) {
+			m_bLocked = false;
+			return;
+		}
+
+		m_nFramesMissed++;
+
+		const uint32_t nPeriod = m_nPeriod + m_nFraction;
+
+		m_nFrameUs += nPeriod >> 8;
+		m_nFraction = nPeriod & 0xFF;
+
+		if (!m_bHold) {
+			Next(&m_tTimeCode);
+			m_bTimeCodeAvailable = true;
+		}
+	}
+
+	if (!m_bHold) {
+		m_bMidiQuarterFrame = true;
+	}
+
+	Schedule(nNowUs);
+
+	dmb();
+}
+
+bool TimeCodePll::GetTimeCode(struct TLtcTimeCode *pTimeCode, bool &bRelocked) {
+	assert(pTimeCode != 0);
+
+	dmb();
+	if (!m_bTimeCodeAvailable) {
+		return false;
+	}
+
+	__disable_irq();
+
+	memcpy(pTimeCode, &m_tTimeCode, sizeof(struct TLtcTimeCode));
+	bRelocked = m_bRelocked;
+
+	m_bTimeCodeAvailable = false;
+	m_bRelocked = false;
+
+	__enable_irq();
+
+	return true;
+}
+
+bool TimeCodePll::IsMidiQuarterFrame(void) {
+	dmb();
+	if (__builtin_expect((m_bMidiQuarterFrame), 0)) {
+		m_bMidiQuarterFrame = false;
+		return true;
+	}
+
+	return false;
+}
+
+void TimeCodePll::Print(void) {
+	printf("Timecode PLL\n");
+	printf(" Freewheel : %d frames\n", (int) m_nFreewheelFrames);
+	printf(" Locked    : %s%s\n", m_bLocked ? "Yes" : "No", m_bHold ? " [Hold]" : "");
+	printf(" Period    : %d.%.3d us\n", (int) (m_nPeriod >> 8), (int) (((m_nPeriod & 0xFF) * 1000) >> 8));
+	printf(" Phase     : %d us\n", (int) m_nPhaseError);
+	printf(" Relocks   : %d\n", (int) m_nRelocks);
+}
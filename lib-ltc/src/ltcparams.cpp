@@ -54,6 +54,7 @@ LtcParams::LtcParams(LtcParamsStore* pLtcParamsStore): m_pLTcParamsStore(pLtcPar
 	m_tLtcParams.nStopSecond = 59;
 	m_tLtcParams.nStopMinute = 29;
 	m_tLtcParams.nStopHour = 23;
+	m_tLtcParams.nFreewheelFrames = 25;
 }
 
 LtcParams::~LtcParams(void) {
@@ -339,6 +340,12 @@ void LtcParams::callbackFunction(const char* pLine) {
 			m_tLtcParams.nEnableOsc = 0;
 			m_tLtcParams.nSetList &= ~LTC_PARAMS_MASK_ENABLE_OSC;
 		}
+		return;
+	}
+
+	if (Sscan::Uint8(pLine, LtcParamsConst::FREEWHEEL_FRAMES, &value8) == SSCAN_OK) {
+		m_tLtcParams.nFreewheelFrames = value8;
+		m_tLtcParams.nSetList |= LTC_PARAMS_MASK_FREEWHEEL_FRAMES;
 	}
 
 }
@@ -458,6 +465,10 @@ void LtcParams::Dump(void) {
 	if (isMaskSet(LTC_PARAMS_MASK_ENABLE_OSC)) {
 		printf(" OSC is enabled\n");
 	}
+
+	if (isMaskSet(LTC_PARAMS_MASK_FREEWHEEL_FRAMES)) {
+		printf(" %s=%d\n", LtcParamsConst::FREEWHEEL_FRAMES, m_tLtcParams.nFreewheelFrames);
+	}
 #endif
 }
 
@@ -56,3 +56,4 @@ alignas(uint32_t) const char LtcParamsConst::STOP_HOUR[] = "stop_hour";
 alignas(uint32_t) const char LtcParamsConst::SET_DATE[] = "set_date";
 #endif
 alignas(uint32_t) const char LtcParamsConst::OSC_ENABLE[] = "osc_enable";
+alignas(uint32_t) const char LtcParamsConst::FREEWHEEL_FRAMES[] = "freewheel_frames";
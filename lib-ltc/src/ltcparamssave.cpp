@@ -84,6 +84,7 @@ bool LtcParams::Builder(const struct TLtcParams *ptLtcParams, uint8_t *pBuffer,
 #endif
 
 	isAdded &= builder.Add(LtcParamsConst::OSC_ENABLE, (uint32_t) m_tLtcParams.nEnableOsc, isMaskSet(LTC_PARAMS_MASK_ENABLE_OSC));
+	isAdded &= builder.Add(LtcParamsConst::FREEWHEEL_FRAMES, (uint32_t) m_tLtcParams.nFreewheelFrames, isMaskSet(LTC_PARAMS_MASK_FREEWHEEL_FRAMES));
 
 
 	nSize = builder.GetSize();
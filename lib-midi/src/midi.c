@@ -51,6 +51,7 @@
  #include "h3_gpio.h"
  #include "h3_timer.h"
  #include "h3_hs_timer.h"
+ #include "soft_timer.h"
 
  #include "uart.h"
 #else
@@ -583,7 +584,7 @@ void __attribute__((interrupt("FIQ"))) fiq_midi_in_handler(void) {
 	dmb();
 }
 
-static void irq_timer1_sense_handler(uint32_t clo) {
+static void timer_sense_handler(uint32_t clo) {
 	dmb();
 	if (midi_active_sense_state == MIDI_ACTIVE_SENSE_ENABLED) {
 		midi_active_sense_timeout++;
@@ -673,11 +674,7 @@ void midi_init(_midi_direction dir) {
 		midi_rx_buffer_index_tail = 0;
 
 		if (midi_active_sense) {
-			irq_timer_init();
-			irq_timer_set(IRQ_TIMER_1, irq_timer1_sense_handler);
-			H3_TIMER->TMR1_INTV = 12000; // 1 ms
-			H3_TIMER->TMR1_CTRL &= ~(TIMER_CTRL_SINGLE_MODE);
-			H3_TIMER->TMR1_CTRL |= (TIMER_CTRL_EN_START | TIMER_CTRL_RELOAD);
+			soft_timer_periodic(timer_sense_handler, 1000, 100); // 1 ms
 		}
 
 		reset_input();
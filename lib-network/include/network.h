@@ -36,7 +36,9 @@
 enum TNetwork {
 	NETWORK_IP_SIZE = 4,
 	NETWORK_MAC_SIZE = 6,
-	NETWORK_HOSTNAME_SIZE = 48
+	NETWORK_HOSTNAME_SIZE = 48,
+	NETWORK_RECV_BUFFER_SIZE = 2048,
+	NETWORK_RECV_BATCH_MAX = 16
 };
 
 #ifndef IP2STR
@@ -54,6 +56,20 @@ enum TNetwork {
  #define MACSTR "%.2x:%.2x:%.2x:%.2x:%.2x:%.2x"
 #endif
 
+struct TNetworkPacket {
+	const uint8_t *pData;	///< Lent from the network receive buffer
+	uint32_t nFromIp;		///<
+	uint16_t nFromPort;		///<
+	uint16_t nSize;			///<
+};
+
+struct TNetworkRecvStats {
+	uint32_t nReceived;			///< Packets queued
+	uint32_t nDropped;			///< Queue full or no receive buffer available
+	uint32_t nHighWaterMark;	///< Maximum number of packets queued
+	uint32_t nDepth;			///< Receive queue depth
+};
+
 class Network {
 public:
 	Network(void);
@@ -64,6 +80,12 @@ public:
 	virtual int32_t Begin(uint16_t nPort)=0;
 	virtual int32_t End(uint16_t nPort)=0;
 
+	/**
+	 * As Begin, with a receive queue of nRecvQueueDepth packets.
+	 * The default implementation ignores the depth.
+	 */
+	virtual int32_t BeginDepth(uint16_t nPort, uint32_t nRecvQueueDepth);
+
 	virtual void MacAddressCopyTo(uint8_t *pMacAddress)=0;
 
 	virtual void JoinGroup(uint32_t nHandle, uint32_t nIp)=0;
@@ -72,6 +94,26 @@ public:
 	virtual uint16_t RecvFrom(uint32_t nHandle, uint8_t *pPacket, uint16_t nSize, uint32_t *pFromIp, uint16_t *pFromPort)=0;
 	virtual void SendTo(uint32_t nHandle, const uint8_t *pPacket, uint16_t nSize, uint32_t nToIp, uint16_t nRemotePort)=0;
 
+	/**
+	 * Zero-copy receive, the packet is lent from the network receive buffer.
+	 * It is valid until RecvRelease is called for the same handle.
+	 * The default implementation copies into an internal buffer.
+	 */
+	virtual uint16_t RecvBorrow(uint32_t nHandle, const uint8_t **ppPacket, uint32_t *pFromIp, uint16_t *pFromPort);
+	virtual void RecvRelease(uint32_t nHandle);
+
+	/**
+	 * Batch receive, returns at most nMaxPackets queued packets without blocking.
+	 * The packets are lent as with RecvBorrow, RecvRelease is called once for each packet, in order.
+	 * The default implementation returns at most 1 packet.
+	 */
+	virtual uint32_t RecvMany(uint32_t nHandle, struct TNetworkPacket *pPackets, uint32_t nMaxPackets);
+
+	/**
+	 * Returns false when the statistics are not supported.
+	 */
+	virtual bool GetRecvStats(uint32_t nHandle, struct TNetworkRecvStats *pStats);
+
 	virtual void SetIp(uint32_t nIp)=0;
 	uint32_t GetIp(void) {
 		return m_nLocalIp;
@@ -156,6 +198,7 @@ protected:
 private:
 	uint32_t m_nQueuedLocalIp;
 	uint32_t m_nQueuedNetmask;
+	uint8_t *m_pRecvBuffer;
 
 	static Network *s_pThis;
 };
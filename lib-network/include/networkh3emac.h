@@ -44,6 +44,8 @@ public:
 	int32_t Begin(uint16_t nPort);
 	int32_t End(uint16_t nPort);
 
+	int32_t BeginDepth(uint16_t nPort, uint32_t nRecvQueueDepth);
+
 	void MacAddressCopyTo(uint8_t *pMacAddress);
 
 	void JoinGroup(uint32_t nHandle, uint32_t nIp);
@@ -52,6 +54,29 @@ public:
 	uint16_t RecvFrom(uint32_t nHandle, uint8_t *pPacket, uint16_t nSize, uint32_t *pFromIp, uint16_t *pFromPort);
 	void SendTo(uint32_t nHandle, const uint8_t *pPacket, uint16_t nSize, uint32_t nToIp, uint16_t nRemotePort);
 
+	uint16_t RecvBorrow(uint32_t nHandle, const uint8_t **ppPacket, uint32_t *pFromIp, uint16_t *pFromPort) {
+		return udp_recv_borrow(nHandle, ppPacket, pFromIp, pFromPort);
+	}
+	void RecvRelease(uint32_t nHandle) {
+		udp_recv_release(nHandle);
+	}
+
+	uint32_t RecvMany(uint32_t nHandle, struct TNetworkPacket *pPackets, uint32_t nMaxPackets) {
+		uint32_t i;
+
+		for (i = 0; i < nMaxPackets; i++) {
+			pPackets[i].nSize = udp_recv_peek(nHandle, i, &pPackets[i].pData, &pPackets[i].nFromIp, &pPackets[i].nFromPort);
+
+			if (pPackets[i].nSize == 0) {
+				break;
+			}
+		}
+
+		return i;
+	}
+
+	bool GetRecvStats(uint32_t nHandle, struct TNetworkRecvStats *pStats);
+
 	void SetIp(uint32_t nIp);
 	void SetNetmask(uint32_t nNetmask);
 
@@ -52,6 +52,10 @@ public:
 	uint16_t RecvFrom(uint32_t nHandle, uint8_t *pPacket, uint16_t nSize, uint32_t *pFromIp, uint16_t *pFromPort);
 	void SendTo(uint32_t nHandle, const uint8_t *pPacket, uint16_t nSize, uint32_t nToIp, uint16_t nRemotePort);
 
+#if defined(__linux__)
+	uint32_t RecvMany(uint32_t nHandle, struct TNetworkPacket *pPackets, uint32_t nMaxPackets);
+#endif
+
 private:
 	bool IsDhclient(const char *pIfName);
 	int IfGetByAddress(const char *pIp, char *pName, size_t nLength);
@@ -59,6 +63,8 @@ private:
 #if defined(__APPLE__)
 	bool OSxGetMacaddress(const char *pIfName, uint8_t *pMacAddress);
 #endif
+
+	uint8_t *m_pRecvBatchBuffer;
 };
 
 #endif /* NETWORKLINUX_H_ */
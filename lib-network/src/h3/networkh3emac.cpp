@@ -126,6 +126,17 @@ int32_t NetworkH3emac::Begin(uint16_t nPort) {
 	DEBUG_EXIT
 }
 
+int32_t NetworkH3emac::BeginDepth(uint16_t nPort, uint32_t nRecvQueueDepth) {
+	DEBUG_ENTRY
+
+	const int32_t nIdx = udp_bind_depth(nPort, nRecvQueueDepth);
+
+	assert(nIdx != -1);
+
+	DEBUG_EXIT
+	return nIdx;
+}
+
 int32_t NetworkH3emac::End(uint16_t nPort) {
 	DEBUG_ENTRY
 
@@ -138,6 +149,19 @@ int32_t NetworkH3emac::End(uint16_t nPort) {
 	DEBUG_EXIT
 }
 
+bool NetworkH3emac::GetRecvStats(uint32_t nHandle, struct TNetworkRecvStats *pStats) {
+	struct udp_stats stats;
+
+	udp_get_stats(nHandle, &stats);
+
+	pStats->nReceived = stats.rx;
+	pStats->nDropped = stats.dropped;
+	pStats->nHighWaterMark = stats.high_water_mark;
+	pStats->nDepth = stats.depth;
+
+	return true;
+}
+
 void NetworkH3emac::MacAddressCopyTo(uint8_t* pMacAddress) {
 	DEBUG_ENTRY
 
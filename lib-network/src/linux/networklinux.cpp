@@ -28,6 +28,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <arpa/inet.h>
+#include <sys/socket.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <net/if.h>
@@ -39,6 +40,8 @@
 
 #include "debug.h"
 
+#define RECV_BATCH_BUFFER_SIZE	4096	///< The largest receive buffer of a consumer, OscServer
+
 /**
  * BEGIN - needed H3 code compatibility
  */
@@ -51,10 +54,14 @@ static int snHandles[MAX_PORTS_ALLOWED];
  * END
  */
 
-NetworkLinux::NetworkLinux(void) {
+NetworkLinux::NetworkLinux(void): m_pRecvBatchBuffer(0) {
 }
 
 NetworkLinux::~NetworkLinux(void) {
+	if (m_pRecvBatchBuffer != 0) {
+		delete[] m_pRecvBatchBuffer;
+		m_pRecvBatchBuffer = 0;
+	}
 }
 
 int NetworkLinux::Init(const char *s) {
@@ -78,7 +85,8 @@ int NetworkLinux::Init(const char *s) {
 
 	if (IfGetByAddress(s, m_aIfName, sizeof(m_aIfName)) == 0) {
 	} else {
-		strncpy(m_aIfName, s, IFNAMSIZ);
+		strncpy(m_aIfName, s, IFNAMSIZ - 1);
+		m_aIfName[IFNAMSIZ - 1] = '\0';
 	}
 
 	DEBUG_PRINTF("m_aIfName=%s", m_aIfName);
@@ -313,6 +321,63 @@ uint16_t NetworkLinux::RecvFrom(uint32_t nHandle, uint8_t* pPacket, uint16_t nSi
 	return recv_len;
 }
 
+#if defined(__linux__)
+uint32_t NetworkLinux::RecvMany(uint32_t nHandle, struct TNetworkPacket *pPackets, uint32_t nMaxPackets) {
+	assert(pPackets != NULL);
+
+	struct mmsghdr msgs[NETWORK_RECV_BATCH_MAX];
+	struct iovec iovecs[NETWORK_RECV_BATCH_MAX];
+	struct sockaddr_in addrs[NETWORK_RECV_BATCH_MAX];
+
+	if (nMaxPackets > NETWORK_RECV_BATCH_MAX) {
+		nMaxPackets = NETWORK_RECV_BATCH_MAX;
+	}
+
+	if (m_pRecvBatchBuffer == 0) {
+		m_pRecvBatchBuffer = new uint8_t[NETWORK_RECV_BATCH_MAX * RECV_BATCH_BUFFER_SIZE];
+		assert(m_pRecvBatchBuffer != 0);
+	}
+
+	memset(msgs, 0, nMaxPackets * sizeof(struct mmsghdr));
+
+	for (uint32_t i = 0; i < nMaxPackets; i++) {
+		iovecs[i].iov_base = &m_pRecvBatchBuffer[i * RECV_BATCH_BUFFER_SIZE];
+		iovecs[i].iov_len = RECV_BATCH_BUFFER_SIZE;
+		msgs[i].msg_hdr.msg_iov = &iovecs[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_name = &addrs[i];
+		msgs[i].msg_hdr.msg_namelen = sizeof(struct sockaddr_in);
+	}
+
+	const int nPackets = recvmmsg(nHandle, msgs, nMaxPackets, MSG_DONTWAIT, NULL);
+
+	if (nPackets == -1) {
+		if ((errno != EAGAIN) && (errno != EWOULDBLOCK)) {
+			perror("recvmmsg");
+		}
+		return 0;
+	}
+
+	uint32_t nReceived = 0;
+
+	for (int i = 0; i < nPackets; i++) {
+		// A truncated packet is dropped, it is never handed over incomplete
+		if ((msgs[i].msg_hdr.msg_flags & MSG_TRUNC) != 0) {
+			DEBUG_PRINTF("Packet truncated, dropped (%d bytes)", RECV_BATCH_BUFFER_SIZE);
+			continue;
+		}
+
+		pPackets[nReceived].pData = &m_pRecvBatchBuffer[i * RECV_BATCH_BUFFER_SIZE];
+		pPackets[nReceived].nFromIp = addrs[i].sin_addr.s_addr;
+		pPackets[nReceived].nFromPort = ntohs(addrs[i].sin_port);
+		pPackets[nReceived].nSize = (uint16_t) msgs[i].msg_len;
+		nReceived++;
+	}
+
+	return nReceived;
+}
+#endif
+
 void NetworkLinux::SendTo(uint32_t nHandle, const uint8_t* pPacket, uint16_t nSize, uint32_t nToIp, uint16_t nRemotePort) {
 	struct sockaddr_in si_other;
 	int slen = sizeof(si_other);
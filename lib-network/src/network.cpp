@@ -25,6 +25,8 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <string.h>
+#include <assert.h>
 
 #include "network.h"
 
@@ -43,7 +45,8 @@ Network::Network(void) :
 	m_pNetworkDisplay(0),
 	m_pNetworkStore(0),
 	m_nQueuedLocalIp(0),
-	m_nQueuedNetmask(0)
+	m_nQueuedNetmask(0),
+	m_pRecvBuffer(0)
 {
 	s_pThis = this;
 
@@ -53,6 +56,11 @@ Network::Network(void) :
 }
 
 Network::~Network(void) {
+	if (m_pRecvBuffer != 0) {
+		delete[] m_pRecvBuffer;
+		m_pRecvBuffer = 0;
+	}
+
 	s_pThis = 0;
 }
 
@@ -78,3 +86,36 @@ bool Network::SetStaticIp(bool bQueueing, uint32_t nLocalIp, uint32_t nNetmask)
 
 	return false;
 }
+
+uint16_t Network::RecvBorrow(uint32_t nHandle, const uint8_t **ppPacket, uint32_t *pFromIp, uint16_t *pFromPort) {
+	if (__builtin_expect((m_pRecvBuffer == 0), 0)) {
+		m_pRecvBuffer = new uint8_t[NETWORK_RECV_BUFFER_SIZE];
+		assert(m_pRecvBuffer != 0);
+	}
+
+	*ppPacket = m_pRecvBuffer;
+
+	return RecvFrom(nHandle, m_pRecvBuffer, NETWORK_RECV_BUFFER_SIZE, pFromIp, pFromPort);
+}
+
+void Network::RecvRelease(uint32_t nHandle) {
+}
+
+uint32_t Network::RecvMany(uint32_t nHandle, struct TNetworkPacket *pPackets, uint32_t nMaxPackets) {
+	if (nMaxPackets == 0) {
+		return 0;
+	}
+
+	pPackets[0].nSize = RecvBorrow(nHandle, &pPackets[0].pData, &pPackets[0].nFromIp, &pPackets[0].nFromPort);
+
+	return (pPackets[0].nSize == 0) ? 0 : 1;
+}
+
+int32_t Network::BeginDepth(uint16_t nPort, uint32_t nRecvQueueDepth) {
+	return Begin(nPort);
+}
+
+bool Network::GetRecvStats(uint32_t nHandle, struct TNetworkRecvStats *pStats) {
+	memset(pStats, 0, sizeof(struct TNetworkRecvStats));
+	return false;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file oscbundle.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef OSCBUNDLE_H_
+#define OSCBUNDLE_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#include "osc.h"
+
+#define OSCBUNDLE_HEADER_SIZE	16	///< "#bundle\0" followed by the time tag
+#define OSCBUNDLE_NTP_UNIX_OFFSET	2208988800U	///< Seconds from 1900 (NTP/OSC) to 1970 (Unix)
+
+/**
+ * Iterates the elements of an OSC bundle in place.
+ * An element is either an OSC message or a nested bundle.
+ *
+ * Time tags : a bundle is due when its time tag is 1 (immediately) or not later than
+ * the current time, with the one second resolution of the system clock.
+ * OscServer handles a due bundle at once. A bundle due within OSCSERVER_BUNDLE_DELAY_MAX
+ * seconds is kept (one at a time) and handled from Run() when due. Other bundles are dropped,
+ * this includes all bundles with an absolute time tag when the system clock is not set.
+ * A nested bundle that is not yet due when its enclosing bundle is handled is dropped.
+ */
+class OSCBundle {
+public:
+	OSCBundle(const uint8_t *pOscBundle, uint32_t nLength);
+	~OSCBundle(void);
+
+	bool IsValid(void) const {
+		return m_bIsValid;
+	}
+
+	const osc_timetag& GetTimeTag(void) const {
+		return m_TimeTag;
+	}
+
+	/**
+	 * @return false when there are no more elements or the next element is malformed
+	 */
+	bool GetNext(const uint8_t *&pElement, uint32_t &nElementLength);
+
+public:
+	static bool IsBundle(const uint8_t *pData, uint32_t nLength);
+
+	/**
+	 * @param nNtpSeconds the current time, seconds since Jan 1st 1900
+	 * @return the seconds until the time tag is due, 0 when it is due
+	 */
+	static uint32_t GetDelay(const osc_timetag &tTimeTag, uint32_t nNtpSeconds);
+
+private:
+	const uint8_t *m_pOscBundle;
+	uint32_t m_nLength;
+	uint32_t m_nOffset;
+	osc_timetag m_TimeTag;
+	bool m_bIsValid;
+};
+
+#endif /* OSCBUNDLE_H_ */
@@ -0,0 +1,81 @@
+/**
+ * @file oscsimplemessage.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef OSCSIMPLEMESSAGE_H_
+#define OSCSIMPLEMESSAGE_H_
+
+#include <stdint.h>
+
+#include "osc.h"
+#include "oscblob.h"
+
+#define OSCSIMPLEMESSAGE_ARGS_CACHE	16	///< Argument offsets kept, further arguments are located by walking the type tags
+
+/**
+ * Parses an OSC message in place. Nothing is copied or allocated,
+ * the receive buffer must stay valid while the message is used.
+ */
+class OSCSimpleMessage {
+public:
+	OSCSimpleMessage(const uint8_t *pOscMessage, uint32_t nLength);
+	~OSCSimpleMessage(void);
+
+	bool IsValid(void) const {
+		return m_nResult == 0;
+	}
+
+	int GetResult(void) const {
+		return m_nResult;
+	}
+
+	const char *GetPath(void) const {
+		return (const char *) m_pOscMessage;
+	}
+
+	int GetArgc(void) const {
+		return (int) m_nArgc;
+	}
+
+	osc_type GetType(unsigned nArg) const;
+
+	float GetFloat(unsigned nArg) const;
+	int GetInt(unsigned nArg) const;
+	const char *GetString(unsigned nArg) const;
+	OSCBlob GetBlob(unsigned nArg) const;
+
+private:
+	const uint8_t *GetArg(unsigned nArg) const;
+
+private:
+	const uint8_t *m_pOscMessage;
+	const char *m_pTypes;
+	const uint8_t *m_pArgs;
+	uint32_t m_nArgc;
+	int m_nResult;
+	uint16_t m_aArgOffset[OSCSIMPLEMESSAGE_ARGS_CACHE];
+};
+
+#endif /* OSCSIMPLEMESSAGE_H_ */
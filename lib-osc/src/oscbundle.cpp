@@ -0,0 +1,99 @@
+/**
+ * @file oscbundle.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "oscbundle.h"
+#include "osc.h"
+
+static const char s_aBundle[8] = { '#', 'b', 'u', 'n', 'd', 'l', 'e', '\0' };
+
+static uint32_t get_uint32(const uint8_t *p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+OSCBundle::OSCBundle(const uint8_t *pOscBundle, uint32_t nLength) :
+	m_pOscBundle(pOscBundle),
+	m_nLength(nLength),
+	m_nOffset(OSCBUNDLE_HEADER_SIZE),
+	m_bIsValid(false)
+{
+	assert(pOscBundle != 0);
+
+	m_TimeTag.sec = 0;
+	m_TimeTag.frac = 1;	// Immediately
+
+	if (!IsBundle(pOscBundle, nLength)) {
+		return;
+	}
+
+	m_TimeTag.sec = get_uint32(&pOscBundle[8]);
+	m_TimeTag.frac = get_uint32(&pOscBundle[12]);
+
+	m_bIsValid = true;
+}
+
+OSCBundle::~OSCBundle(void) {
+}
+
+bool OSCBundle::IsBundle(const uint8_t *pData, uint32_t nLength) {
+	return (nLength >= OSCBUNDLE_HEADER_SIZE) && (memcmp(pData, s_aBundle, sizeof(s_aBundle)) == 0);
+}
+
+uint32_t OSCBundle::GetDelay(const osc_timetag &tTimeTag, uint32_t nNtpSeconds) {
+	if ((tTimeTag.sec == 0) && (tTimeTag.frac == 1)) {
+		return 0;
+	}
+
+	// Wraps at the NTP era boundary (2036)
+	const int32_t nDelay = (int32_t) (tTimeTag.sec - nNtpSeconds);
+
+	return nDelay > 0 ? (uint32_t) nDelay : 0;
+}
+
+bool OSCBundle::GetNext(const uint8_t *&pElement, uint32_t &nElementLength) {
+	if (!m_bIsValid || ((m_nOffset + 4) > m_nLength)) {
+		return false;
+	}
+
+	const uint32_t nSize = get_uint32(&m_pOscBundle[m_nOffset]);
+
+	// The size of a bundle element is always a multiple of 4
+	if (((nSize & 0x3) != 0) || (nSize > (m_nLength - m_nOffset - 4))) {
+		m_bIsValid = false;
+		return false;
+	}
+
+	pElement = &m_pOscBundle[m_nOffset + 4];
+	nElementLength = nSize;
+
+	m_nOffset += 4 + nSize;
+
+	return true;
+}
@@ -0,0 +1,240 @@
+/**
+ * @file oscsimplemessage.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "oscsimplemessage.h"
+#include "oscmessage.h"
+#include "oscstring.h"
+#include "oscblob.h"
+#include "osc.h"
+
+typedef union pcast32 {
+	int32_t i;
+	float f;
+	uint32_t nl;
+} osc_pcast32;
+
+static uint32_t get_uint32(const uint8_t *p) {
+	return ((uint32_t) p[0] << 24) | ((uint32_t) p[1] << 16) | ((uint32_t) p[2] << 8) | (uint32_t) p[3];
+}
+
+/*
+ * Returns the size of the argument, or a negative _osc_message_deserialise
+ */
+static int arg_validate(osc_type type, const uint8_t *pData, uint32_t nSize) {
+	switch (type) {
+	case OSC_TRUE:
+	case OSC_FALSE:
+	case OSC_NIL:
+	case OSC_INFINITUM:
+		return 0;
+	case OSC_INT32:
+	case OSC_FLOAT:
+	case OSC_MIDI:
+	case OSC_CHAR:
+		return nSize >= 4 ? 4 : -OSC_INVALID_SIZE;
+	case OSC_INT64:
+	case OSC_TIMETAG:
+	case OSC_DOUBLE:
+		return nSize >= 8 ? 8 : -OSC_INVALID_SIZE;
+	case OSC_STRING:
+	case OSC_SYMBOL:
+		return (int) OSCString::Validate((void *) pData, nSize);
+	case OSC_BLOB:
+		if (nSize < 4) {
+			return -OSC_INVALID_SIZE;
+		}
+		return (int) OSCBlob::Validate((void *) pData, nSize);
+	default:
+		return -OSC_INVALID_TYPE;
+	}
+
+	return -OSC_INTERNAL_ERROR;
+}
+
+/*
+ * Only used on validated arguments
+ */
+static uint32_t arg_size(osc_type type, const uint8_t *pData) {
+	switch (type) {
+	case OSC_INT32:
+	case OSC_FLOAT:
+	case OSC_MIDI:
+	case OSC_CHAR:
+		return 4;
+	case OSC_INT64:
+	case OSC_TIMETAG:
+	case OSC_DOUBLE:
+		return 8;
+	case OSC_STRING:
+	case OSC_SYMBOL:
+		return OSCString::Size((const char *) pData);
+	case OSC_BLOB:
+		return 4 * ((4 + get_uint32(pData) + 3) / 4);
+	default:
+		return 0;
+	}
+
+	return 0;
+}
+
+OSCSimpleMessage::OSCSimpleMessage(const uint8_t *pOscMessage, uint32_t nLength) :
+	m_pOscMessage(pOscMessage),
+	m_pTypes(0),
+	m_pArgs(0),
+	m_nArgc(0),
+	m_nResult(OSC_INTERNAL_ERROR)
+{
+	assert(pOscMessage != 0);
+
+	int nLen = (int) OSCString::Validate((void *) pOscMessage, nLength);
+
+	if (nLen < 0) {
+		m_nResult = OSC_INVALID_PATH;
+		return;
+	}
+
+	uint32_t nRemain = nLength - (uint32_t) nLen;
+
+	if (nRemain == 0) {
+		m_nResult = OSC_NO_TYPE_TAG;
+		return;
+	}
+
+	const char *pTypes = (const char *) pOscMessage + nLen;
+
+	nLen = (int) OSCString::Validate((void *) pTypes, nRemain);
+
+	if (nLen < 0) {
+		m_nResult = OSC_INVALID_TYPE;
+		return;
+	}
+
+	if (pTypes[0] != ',') {
+		m_nResult = OSC_INVALID_TYPE_TAG;
+		return;
+	}
+
+	nRemain -= (uint32_t) nLen;
+
+	m_pTypes = &pTypes[1];
+	m_pArgs = (const uint8_t *) pTypes + nLen;
+
+	uint32_t nOffset = 0;
+
+	for (; m_pTypes[m_nArgc] != '\0'; m_nArgc++) {
+		nLen = arg_validate((osc_type) m_pTypes[m_nArgc], &m_pArgs[nOffset], nRemain);
+
+		if (nLen < 0) {
+			m_nResult = OSC_INVALID_ARGUMENT;
+			return;
+		}
+
+		if (m_nArgc < OSCSIMPLEMESSAGE_ARGS_CACHE) {
+			m_aArgOffset[m_nArgc] = (uint16_t) nOffset;
+		}
+
+		nOffset += (uint32_t) nLen;
+		nRemain -= (uint32_t) nLen;
+	}
+
+	if (nRemain != 0) {
+		m_nResult = OSC_INVALID_SIZE;
+		return;
+	}
+
+	m_nResult = OSC_OK;
+}
+
+OSCSimpleMessage::~OSCSimpleMessage(void) {
+}
+
+const uint8_t *OSCSimpleMessage::GetArg(unsigned nArg) const {
+	if (nArg < OSCSIMPLEMESSAGE_ARGS_CACHE) {
+		return &m_pArgs[m_aArgOffset[nArg]];
+	}
+
+	const uint8_t *p = &m_pArgs[m_aArgOffset[OSCSIMPLEMESSAGE_ARGS_CACHE - 1]];
+
+	for (unsigned i = OSCSIMPLEMESSAGE_ARGS_CACHE - 1; i < nArg; i++) {
+		p += arg_size((osc_type) m_pTypes[i], p);
+	}
+
+	return p;
+}
+
+osc_type OSCSimpleMessage::GetType(unsigned nArg) const {
+	if ((m_nResult != OSC_OK) || (nArg >= m_nArgc)) {
+		return OSC_UNKNOWN;
+	}
+
+	return (osc_type) m_pTypes[nArg];
+}
+
+float OSCSimpleMessage::GetFloat(unsigned nArg) const {
+	if (GetType(nArg) != OSC_FLOAT) {
+		return 0;
+	}
+
+	osc_pcast32 val32;
+	val32.nl = get_uint32(GetArg(nArg));
+
+	return val32.f;
+}
+
+int OSCSimpleMessage::GetInt(unsigned nArg) const {
+	if (GetType(nArg) != OSC_INT32) {
+		return 0;
+	}
+
+	osc_pcast32 val32;
+	val32.nl = get_uint32(GetArg(nArg));
+
+	return val32.i;
+}
+
+const char *OSCSimpleMessage::GetString(unsigned nArg) const {
+	const osc_type type = GetType(nArg);
+
+	if ((type != OSC_STRING) && (type != OSC_SYMBOL)) {
+		return 0;
+	}
+
+	return (const char *) GetArg(nArg);
+}
+
+OSCBlob OSCSimpleMessage::GetBlob(unsigned nArg) const {
+	if (GetType(nArg) != OSC_BLOB) {
+		return OSCBlob(0, 0);
+	}
+
+	const uint8_t *p = GetArg(nArg);
+
+	return OSCBlob((const char *) p + 4, (int) get_uint32(p));
+}
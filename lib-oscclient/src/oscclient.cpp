@@ -31,6 +31,7 @@
 
 #include "oscclient.h"
 #include "oscsend.h"
+#include "oscsimplemessage.h"
 #include "osc.h"
 
 #include "hardware.h"
@@ -243,7 +244,7 @@ bool OscClient::HandleLedMessage(void) {
 		return false;
 	}
 
-	OSCMessage Msg((char *) m_pBuffer, m_nBytesReceived);
+	OSCSimpleMessage Msg((const uint8_t *) m_pBuffer, (uint32_t) m_nBytesReceived);
 
 	const int nArgc = Msg.GetArgc();
 
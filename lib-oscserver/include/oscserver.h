@@ -29,6 +29,7 @@
 #include <stdint.h>
 
 #include "oscserverhandler.h"
+#include "oscserverdispatch.h"
 #include "lightset.h"
 
 #define OSCSERVER_DEFAULT_PORT_INCOMING	8000
@@ -77,7 +78,13 @@ public:
 	int Run(void);
 
 private:
+	int HandlePacket(const uint8_t *pBuffer, int nBytesReceived, uint32_t nRemoteIp);
+	void HandleBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nRemoteIp, uint32_t nDepth);
+	void HandleDueBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nRemoteIp);
+	void SetData(uint16_t nLength);
 	int GetChannel(const char *p);
+	void Compile(void);
+	uint8_t MatchPatterns(const char *pAddress, uint16_t &nChannel);
 	bool IsDmxDataChanged(const uint8_t *pData, uint16_t nStartChannel, uint16_t nLength);
 
 private:
@@ -87,10 +94,17 @@ private:
 	bool m_bPartialTransmission;
 	bool m_bEnableNoChangeUpdate;
 	uint16_t m_nLastChannel;
+	bool m_bIsBundle;
+	uint16_t m_nBundleLength;
+	uint8_t *m_pBundlePending;
+	uint32_t m_nBundlePendingLength;	///< 0 when there is no bundle waiting for its time tag
+	uint32_t m_nBundlePendingRemoteIp;
 	char m_aPath[OSCSERVER_PATH_LENGTH_MAX];
 	char m_aPathSecond[OSCSERVER_PATH_LENGTH_MAX];
 	char m_aPathInfo[OSCSERVER_PATH_LENGTH_MAX];
 	char m_aPathBlackOut[OSCSERVER_PATH_LENGTH_MAX];
+	OscServerDispatch m_Dispatch;
+	bool m_bIsDispatch;		///< false when a path has pattern characters, then the paths are matched one by one
 	OscServerHandler *m_pOscServerHandler;
 	LightSet *m_pLightSet;
 	uint8_t *m_pBuffer;
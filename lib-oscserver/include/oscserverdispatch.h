@@ -0,0 +1,74 @@
+/**
+ * @file oscserverdispatch.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef OSCSERVERDISPATCH_H_
+#define OSCSERVERDISPATCH_H_
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#if !defined (OSCSERVERDISPATCH_NODES)
+ #define OSCSERVERDISPATCH_NODES	528	///< The four paths of OSCSERVER_PATH_LENGTH_MAX, "/ping" and the channel separator
+#endif
+
+/**
+ * A trie of the configured OSC addresses, built once when a path is set.
+ * Match() resolves the handler, and for a channel leaf "<path>/<n>" also
+ * the channel, in a single pass over the incoming address.
+ * An exact address has priority over a channel leaf. Handler 0 means no match.
+ */
+class OscServerDispatch {
+public:
+	OscServerDispatch(void);
+	~OscServerDispatch(void);
+
+	void Clear(void);
+
+	/**
+	 * @return false when the path contains pattern characters or the trie is full
+	 */
+	bool Add(const char *pPath, uint8_t nHandler);
+	bool AddChannel(const char *pPath, uint8_t nHandler);
+
+	uint8_t Match(const char *pAddress, uint16_t &nChannel) const;
+
+private:
+	uint32_t Insert(const char *pPath, uint32_t nNode);
+
+private:
+	struct TNode {
+		uint16_t nChild;
+		uint16_t nSibling;
+		char c;
+		uint8_t nHandler;
+		uint8_t nChannelHandler;
+	};
+
+	struct TNode m_aNodes[OSCSERVERDISPATCH_NODES];
+	uint32_t m_nNodes;
+};
+
+#endif /* OSCSERVERDISPATCH_H_ */
@@ -30,11 +30,13 @@
 
 #include "oscserver.h"
 #include "osc.h"
-#include "oscmessage.h"
+#include "oscsimplemessage.h"
+#include "oscbundle.h"
 #include "oscsend.h"
 #include "oscblob.h"
 
 #include "lightset.h"
+#include "lightsetdata.h"
 #include "network.h"
 
 #include "hardware.h"
@@ -42,6 +44,9 @@
 #include "debug.h"
 
 #define OSCSERVER_MAX_BUFFER 				4096
+#define OSCSERVER_RECV_BATCH				4	///< Packets handled in one Run
+#define OSCSERVER_BUNDLE_DEPTH_MAX			4	///< Nested bundles followed
+#define OSCSERVER_BUNDLE_DELAY_MAX			10	///< Seconds a bundle is kept until its time tag is due
 
 #define OSCSERVER_DEFAULT_PATH_PRIMARY		"/dmx1"
 #define OSCSERVER_DEFAULT_PATH_SECONDARY	OSCSERVER_DEFAULT_PATH_PRIMARY"/*"
@@ -50,6 +55,15 @@
 
 #define SOFTWARE_VERSION "1.0"
 
+enum TOscServerHandler {
+	OSCSERVER_HANDLER_NONE,
+	OSCSERVER_HANDLER_PING,
+	OSCSERVER_HANDLER_INFO,
+	OSCSERVER_HANDLER_BLACKOUT,
+	OSCSERVER_HANDLER_DMX,
+	OSCSERVER_HANDLER_DMX_CHANNEL
+};
+
 enum {
 	DMX_UNIVERSE = 512,
 	DMX_MAX_VALUE = 255
@@ -62,6 +76,11 @@ OscServer::OscServer(void):
 	m_bPartialTransmission(false),
 	m_bEnableNoChangeUpdate(false),
 	m_nLastChannel(0),
+	m_bIsBundle(false),
+	m_nBundleLength(0),
+	m_nBundlePendingLength(0),
+	m_nBundlePendingRemoteIp(0),
+	m_bIsDispatch(false),
 	m_pOscServerHandler(0),
 	m_pLightSet(0)
 {
@@ -77,6 +96,8 @@ OscServer::OscServer(void):
 	memset(m_aPathBlackOut, 0, sizeof(m_aPathBlackOut));
 	strcpy(m_aPathBlackOut, OSCSERVER_DEFAULT_PATH_BLACKOUT);
 
+	Compile();
+
 	m_pBuffer = new uint8_t[OSCSERVER_MAX_BUFFER];
 	assert(m_pBuffer != 0);
 
@@ -90,6 +111,9 @@ OscServer::OscServer(void):
 	m_pOsc  = new uint8_t[DMX_UNIVERSE];
 	assert(m_pOsc != 0);
 
+	m_pBundlePending = new uint8_t[OSCSERVER_MAX_BUFFER];
+	assert(m_pBundlePending != 0);
+
 	snprintf(m_Os, sizeof(m_Os), "[V%s] %s", SOFTWARE_VERSION, __DATE__);
 
 	uint8_t nHwTextLength;
@@ -114,6 +138,9 @@ OscServer::~OscServer(void) {
 
 	delete[] m_pOsc;
 	m_pOsc = 0;
+
+	delete[] m_pBundlePending;
+	m_pBundlePending = 0;
 }
 
 void OscServer::Start(void) {
@@ -178,6 +205,8 @@ void OscServer::SetPath(const char* pPath) {
 		m_aPathSecond[length] = '\0';
 	}
 
+	Compile();
+
 	DEBUG_PUTS(m_aPath);
 	DEBUG_PUTS(m_aPathSecond);
 }
@@ -197,6 +226,8 @@ void OscServer::SetPathInfo(const char* pPathInfo) {
 		}
 	}
 
+	Compile();
+
 	DEBUG_PUTS(m_aPathInfo);
 }
 
@@ -215,6 +246,8 @@ void OscServer::SetPathBlackOut(const char* pPathBlackOut) {
 		}
 	}
 
+	Compile();
+
 	DEBUG_PUTS(m_aPathBlackOut);
 }
 
@@ -255,45 +288,163 @@ int OscServer::GetChannel(const char* p) {
 	return nChannel;
 }
 
+/*
+ * The order of adding is the order of the sequential matching in MatchPatterns.
+ */
+void OscServer::Compile(void) {
+	m_Dispatch.Clear();
+
+	m_bIsDispatch = m_Dispatch.Add("/ping", OSCSERVER_HANDLER_PING)
+			&& m_Dispatch.Add(m_aPathInfo, OSCSERVER_HANDLER_INFO)
+			&& m_Dispatch.Add(m_aPathBlackOut, OSCSERVER_HANDLER_BLACKOUT)
+			&& m_Dispatch.Add(m_aPath, OSCSERVER_HANDLER_DMX)
+			&& m_Dispatch.AddChannel(m_aPath, OSCSERVER_HANDLER_DMX_CHANNEL);
+
+	DEBUG_PRINTF("m_bIsDispatch=%d", (int) m_bIsDispatch);
+}
+
+uint8_t OscServer::MatchPatterns(const char *pAddress, uint16_t &nChannel) {
+	if (OSC::isMatch(pAddress, "/ping")) {
+		return OSCSERVER_HANDLER_PING;
+	}
+
+	if (OSC::isMatch(pAddress, m_aPathInfo)) {
+		return OSCSERVER_HANDLER_INFO;
+	}
+
+	if (OSC::isMatch(pAddress, m_aPathBlackOut)) {
+		return OSCSERVER_HANDLER_BLACKOUT;
+	}
+
+	if (OSC::isMatch(pAddress, m_aPath)) {
+		return OSCSERVER_HANDLER_DMX;
+	}
+
+	if (OSC::isMatch(pAddress, m_aPathSecond)) {
+		nChannel = (uint16_t) GetChannel(pAddress);
+		return OSCSERVER_HANDLER_DMX_CHANNEL;
+	}
+
+	return OSCSERVER_HANDLER_NONE;
+}
+
 bool OscServer::IsDmxDataChanged(const uint8_t* pData, uint16_t nStartChannel, uint16_t nLength) {
 	assert(pData != 0);
 	assert(nLength <= DMX_UNIVERSE);
+	assert((nStartChannel - 1 + nLength) <= DMX_UNIVERSE);
 
-	bool isChanged = false;
+	return LightSetData::Copy(&m_pData[nStartChannel - 1], pData, nLength);
+}
 
-	const uint8_t *src = pData;
-	uint8_t *dst = (uint8_t *) &m_pData[--nStartChannel];
+static uint32_t ntp_seconds(void) {
+	return (uint32_t) Hardware::Get()->GetTime() + OSCBUNDLE_NTP_UNIX_OFFSET;
+}
 
-	uint16_t nEnd = nStartChannel + nLength;
+int OscServer::Run(void) {
+	struct TNetworkPacket aPackets[OSCSERVER_RECV_BATCH];
+	int nResult = 0;
 
-	assert(nEnd <= DMX_UNIVERSE);
+	if (m_nBundlePendingLength != 0) {
+		const OSCBundle Pending(m_pBundlePending, m_nBundlePendingLength);
 
-	for (uint32_t i = nStartChannel; i < nEnd; i++) {
-		if (*dst != *src) {
-			*dst = *src;
-			isChanged = true;
+		if (OSCBundle::GetDelay(Pending.GetTimeTag(), ntp_seconds()) == 0) {
+			HandleDueBundle(m_pBundlePending, m_nBundlePendingLength, m_nBundlePendingRemoteIp);
+			m_nBundlePendingLength = 0;
 		}
-		dst++;
-		src++;
 	}
 
-	return isChanged;
+	const uint32_t nPackets = Network::Get()->RecvMany(m_nHandle, aPackets, OSCSERVER_RECV_BATCH);
+
+	for (uint32_t i = 0; i < nPackets; i++) {
+		const int nBytesReceived = aPackets[i].nSize < OSCSERVER_MAX_BUFFER ? aPackets[i].nSize : OSCSERVER_MAX_BUFFER;
+		const uint32_t nRemoteIp = aPackets[i].nFromIp;
+
+		memcpy(m_pBuffer, aPackets[i].pData, nBytesReceived);
+
+		Network::Get()->RecvRelease(m_nHandle);
+
+		if (OSCBundle::IsBundle(m_pBuffer, (uint32_t) nBytesReceived)) {
+			const OSCBundle Bundle(m_pBuffer, (uint32_t) nBytesReceived);
+			const uint32_t nDelay = OSCBundle::GetDelay(Bundle.GetTimeTag(), ntp_seconds());
+
+			if (nDelay == 0) {
+				HandleDueBundle(m_pBuffer, (uint32_t) nBytesReceived, nRemoteIp);
+			} else if ((nDelay <= OSCSERVER_BUNDLE_DELAY_MAX) && (m_nBundlePendingLength == 0)) {
+				memcpy(m_pBundlePending, m_pBuffer, nBytesReceived);
+				m_nBundlePendingLength = (uint32_t) nBytesReceived;
+				m_nBundlePendingRemoteIp = nRemoteIp;
+			} else {
+				DEBUG_PRINTF("#bundle dropped, due in %u seconds", nDelay);
+			}
+
+			nResult = nBytesReceived;
+		} else {
+			nResult = HandlePacket(m_pBuffer, nBytesReceived, nRemoteIp);
+		}
+	}
+
+	return nResult;
 }
 
-int OscServer::Run(void) {
-	uint32_t nRemoteIp;
-	uint16_t nRemotePort;
+void OscServer::HandleDueBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nRemoteIp) {
+	m_bIsBundle = true;
+	m_nBundleLength = 0;
+
+	HandleBundle(pBuffer, nLength, nRemoteIp, 0);
+
+	m_bIsBundle = false;
+
+	// All the channel updates of a bundle are output at once
+	if (m_nBundleLength != 0) {
+		m_pLightSet->SetData(0, m_pData, m_nBundleLength);
+	}
+}
+
+/*
+ * The bundle is due, see oscbundle.h for the time tag handling.
+ */
+void OscServer::HandleBundle(const uint8_t *pBuffer, uint32_t nLength, uint32_t nRemoteIp, uint32_t nDepth) {
+	OSCBundle Bundle(pBuffer, nLength);
+	const uint8_t *pElement;
+	uint32_t nElementLength;
+
+	DEBUG_PRINTF("#bundle %u.%u", Bundle.GetTimeTag().sec, Bundle.GetTimeTag().frac);
 
-	const int nBytesReceived = Network::Get()->RecvFrom(m_nHandle, m_pBuffer, OSCSERVER_MAX_BUFFER, &nRemoteIp, &nRemotePort);
+	while (Bundle.GetNext(pElement, nElementLength)) {
+		if (OSCBundle::IsBundle(pElement, nElementLength)) {
+			const OSCBundle Nested(pElement, nElementLength);
 
-	if (nBytesReceived == 0) {
-		return 0;
+			if ((nDepth < OSCSERVER_BUNDLE_DEPTH_MAX) && (OSCBundle::GetDelay(Nested.GetTimeTag(), ntp_seconds()) == 0)) {
+				HandleBundle(pElement, nElementLength, nRemoteIp, nDepth + 1);
+			}
+		} else if (nElementLength != 0) {
+			HandlePacket(pElement, (int) nElementLength, nRemoteIp);
+		}
+	}
+}
+
+void OscServer::SetData(uint16_t nLength) {
+	if (m_bIsBundle) {
+		m_nBundleLength = nLength > m_nBundleLength ? nLength : m_nBundleLength;
+		return;
+	}
+
+	m_pLightSet->SetData(0, m_pData, nLength);
+}
+
+int OscServer::HandlePacket(const uint8_t *pBuffer, int nBytesReceived, uint32_t nRemoteIp) {
+	uint16_t nChannel = 0;
+
+	if (OSC::GetPath((void *) pBuffer, nBytesReceived) == 0) {
+		return -1;
 	}
 
-	if (OSC::isMatch((const char*) m_pBuffer, "/ping")) {
+	const uint8_t nHandler = m_bIsDispatch ? m_Dispatch.Match((const char*) pBuffer, nChannel) : MatchPatterns((const char*) pBuffer, nChannel);
+
+	if (nHandler == OSCSERVER_HANDLER_PING) {
 		DEBUG_PUTS("ping received");
 		OSCSend MsgSend(m_nHandle, nRemoteIp, m_nPortOutgoing, "/pong", 0);
-	} else if (OSC::isMatch((const char*) m_pBuffer, m_aPathInfo)) {
+	} else if (nHandler == OSCSERVER_HANDLER_INFO) {
 		OSCSend MsgSendInfo(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/os", "s", m_Os);
 		OSCSend MsgSendModel(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/model", "s", m_pModel);
 		OSCSend MsgSendSoc(m_nHandle, nRemoteIp, m_nPortOutgoing, "/info/soc", "s", m_pSoC);
@@ -301,8 +452,8 @@ int OscServer::Run(void) {
 		if (m_pOscServerHandler != 0) {
 			m_pOscServerHandler->Info(m_nHandle, nRemoteIp, m_nPortOutgoing);
 		}
-	} else if (OSC::isMatch((const char*) m_pBuffer, m_aPathBlackOut)) {
-		OSCMessage Msg(m_pBuffer, nBytesReceived);
+	} else if (nHandler == OSCSERVER_HANDLER_BLACKOUT) {
+		OSCSimpleMessage Msg(pBuffer, (uint32_t) nBytesReceived);
 		const bool bBlackout = (unsigned) Msg.GetFloat(0) == 1;
 
 		if (bBlackout) {
@@ -319,13 +470,18 @@ int OscServer::Run(void) {
 	} else {
 		bool bIsDmxDataChanged = false;
 
-		OSCMessage Msg((char *) m_pBuffer, nBytesReceived);
+		OSCSimpleMessage Msg(pBuffer, (uint32_t) nBytesReceived);
 
-		debug_dump(m_pBuffer, nBytesReceived);
+		debug_dump((void *) pBuffer, nBytesReceived);
 
-		DEBUG_PRINTF("[%d] path : %s", nBytesReceived, OSC::GetPath((char*) m_pBuffer, nBytesReceived));
+		DEBUG_PRINTF("[%d] path : %s", nBytesReceived, OSC::GetPath((void *) pBuffer, nBytesReceived));
 
-		if (OSC::isMatch((const char*) m_pBuffer, m_aPath)) {
+		if (!Msg.IsValid()) {
+			DEBUG_PRINTF("Invalid OSC message [%d]", Msg.GetResult());
+			return -1;
+		}
+
+		if (nHandler == OSCSERVER_HANDLER_DMX) {
 			const int nArgc = Msg.GetArgc();
 
 			if ((nArgc == 1) && (Msg.GetType(0) == OSC_BLOB)) {
@@ -341,10 +497,10 @@ int OscServer::Run(void) {
 
 					if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
 						if ((!m_bPartialTransmission) || (size == DMX_UNIVERSE)) {
-							m_pLightSet->SetData(0, m_pData, DMX_UNIVERSE);
+							SetData(DMX_UNIVERSE);
 						} else {
 							m_nLastChannel = size > m_nLastChannel ? size : m_nLastChannel;
-							m_pLightSet->SetData(0, m_pData, m_nLastChannel);
+							SetData(m_nLastChannel);
 						}
 					}
 				} else {
@@ -352,7 +508,7 @@ int OscServer::Run(void) {
 					return -1;
 				}
 			} else if ((nArgc == 2) && (Msg.GetType(0) == OSC_INT32)) {
-				uint16_t nChannel = (uint16_t) (1 + Msg.GetInt(0));
+				nChannel = (uint16_t) (1 + Msg.GetInt(0));
 
 				if ((nChannel < 1) || (nChannel > DMX_UNIVERSE)) {
 					DEBUG_PRINTF("Invalid channel [%d]", nChannel);
@@ -377,19 +533,17 @@ int OscServer::Run(void) {
 
 				if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
 					if (!m_bPartialTransmission) {
-						m_pLightSet->SetData(0, m_pData, DMX_UNIVERSE);
+						SetData(DMX_UNIVERSE);
 					} else {
 						m_nLastChannel = nChannel > m_nLastChannel ? nChannel : m_nLastChannel;
-						m_pLightSet->SetData(0, m_pData, m_nLastChannel);
+						SetData(m_nLastChannel);
 					}
 				}
 			}
-		} else if (OSC::isMatch((const char*) m_pBuffer, m_aPathSecond)) {
+		} else if (nHandler == OSCSERVER_HANDLER_DMX_CHANNEL) {
 			const int nArgc = Msg.GetArgc();
 
 			if (nArgc == 1) { // /path/N 'i' or 'f'
-				const uint16_t nChannel = GetChannel((const char*) m_pBuffer);
-
 				if (nChannel >= 1 && nChannel <= DMX_UNIVERSE) {
 					uint8_t nData;
 
@@ -409,10 +563,10 @@ int OscServer::Run(void) {
 
 					if (bIsDmxDataChanged || m_bEnableNoChangeUpdate) {
 						if (!m_bPartialTransmission) {
-							m_pLightSet->SetData(0, m_pData, DMX_UNIVERSE);
+							SetData(DMX_UNIVERSE);
 						} else {
 							m_nLastChannel = nChannel > m_nLastChannel ? nChannel : m_nLastChannel;
-							m_pLightSet->SetData(0, m_pData, m_nLastChannel);
+							SetData(m_nLastChannel);
 						}
 					}
 				} else {
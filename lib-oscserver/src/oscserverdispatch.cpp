@@ -0,0 +1,177 @@
+/**
+ * @file oscserverdispatch.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <assert.h>
+
+#include "oscserverdispatch.h"
+
+#define CHANNEL_DIGITS_MAX	3
+
+OscServerDispatch::OscServerDispatch(void) {
+	Clear();
+}
+
+OscServerDispatch::~OscServerDispatch(void) {
+}
+
+void OscServerDispatch::Clear(void) {
+	memset(&m_aNodes[0], 0, sizeof(m_aNodes[0]));
+	m_nNodes = 1; // The root, the empty address
+}
+
+/*
+ * Node 0 is the root, so 0 is also used as 'no child' and 'no sibling'.
+ * Returns OSCSERVERDISPATCH_NODES when the trie is full.
+ */
+uint32_t OscServerDispatch::Insert(const char *pPath, uint32_t nNode) {
+	for (const char *p = pPath; *p != '\0'; p++) {
+		uint32_t nChild = m_aNodes[nNode].nChild;
+
+		while ((nChild != 0) && (m_aNodes[nChild].c != *p)) {
+			nChild = m_aNodes[nChild].nSibling;
+		}
+
+		if (nChild == 0) {
+			if (m_nNodes == OSCSERVERDISPATCH_NODES) {
+				return OSCSERVERDISPATCH_NODES;
+			}
+
+			nChild = m_nNodes++;
+
+			m_aNodes[nChild].nChild = 0;
+			m_aNodes[nChild].nSibling = m_aNodes[nNode].nChild;
+			m_aNodes[nChild].c = *p;
+			m_aNodes[nChild].nHandler = 0;
+			m_aNodes[nChild].nChannelHandler = 0;
+
+			m_aNodes[nNode].nChild = (uint16_t) nChild;
+		}
+
+		nNode = nChild;
+	}
+
+	return nNode;
+}
+
+bool OscServerDispatch::Add(const char *pPath, uint8_t nHandler) {
+	assert(pPath != 0);
+	assert(nHandler != 0);
+
+	if (strpbrk(pPath, "*?[]{}") != 0) {
+		return false;
+	}
+
+	const uint32_t nNode = Insert(pPath, 0);
+
+	if (nNode == OSCSERVERDISPATCH_NODES) {
+		return false;
+	}
+
+	// The first one added wins, as with the sequential matching
+	if (m_aNodes[nNode].nHandler == 0) {
+		m_aNodes[nNode].nHandler = nHandler;
+	}
+
+	return true;
+}
+
+bool OscServerDispatch::AddChannel(const char *pPath, uint8_t nHandler) {
+	assert(pPath != 0);
+	assert(nHandler != 0);
+
+	if (strpbrk(pPath, "*?[]{}") != 0) {
+		return false;
+	}
+
+	uint32_t nNode = Insert(pPath, 0);
+
+	if (nNode != OSCSERVERDISPATCH_NODES) {
+		nNode = Insert("/", nNode);
+	}
+
+	if (nNode == OSCSERVERDISPATCH_NODES) {
+		return false;
+	}
+
+	m_aNodes[nNode].nChannelHandler = nHandler;
+
+	return true;
+}
+
+uint8_t OscServerDispatch::Match(const char *pAddress, uint16_t &nChannel) const {
+	assert(pAddress != 0);
+
+	const char *p = pAddress;
+	uint32_t nNode = 0;
+	uint8_t nChannelHandler = 0;
+	uint32_t nChannelValue = 0;
+
+	for (;;) {
+		if (m_aNodes[nNode].nChannelHandler != 0) {
+			const char *s = p;
+			uint32_t nValue = 0;
+
+			while ((*s >= '0') && (*s <= '9') && ((s - p) <= CHANNEL_DIGITS_MAX)) {
+				nValue = nValue * 10 + (uint32_t) (*s - '0');
+				s++;
+			}
+
+			if ((*s == '\0') && (s != p) && ((s - p) <= CHANNEL_DIGITS_MAX)) {
+				nChannelHandler = m_aNodes[nNode].nChannelHandler;
+				nChannelValue = nValue;
+			}
+		}
+
+		if (*p == '\0') {
+			if (m_aNodes[nNode].nHandler != 0) {
+				return m_aNodes[nNode].nHandler;
+			}
+			break;
+		}
+
+		uint32_t nChild = m_aNodes[nNode].nChild;
+
+		while ((nChild != 0) && (m_aNodes[nChild].c != *p)) {
+			nChild = m_aNodes[nChild].nSibling;
+		}
+
+		if (nChild == 0) {
+			break;
+		}
+
+		nNode = nChild;
+		p++;
+	}
+
+	if (nChannelHandler != 0) {
+		nChannel = (uint16_t) nChannelValue;
+	}
+
+	return nChannelHandler;
+}
@@ -39,6 +39,9 @@ public:
 
 	void HandleData(const uint8_t* pRdmDataIn, uint8_t *pRdmDataOut);
 
+	// FindPid is a binary search, both PID tables must be sorted on pid
+	static bool IsPidTablesSorted(void);
+
 private:
 	void Handlers(bool bIsBroadcast, uint8_t nCommandClass, uint16_t nParamId, uint8_t nParamDataLength, uint16_t nSubDevice);
 
@@ -55,6 +58,14 @@ private:
 	static const pid_definition PID_DEFINITIONS[];
 	static const pid_definition PID_DEFINITIONS_SUB_DEVICES[];
 
+	static uint8_t s_SupportedParameters[];
+	static uint8_t s_SupportedParametersSubDevices[];
+	static uint8_t s_nSupportedParametersLength;
+	static uint8_t s_nSupportedParametersSubDevicesLength;
+
+	const pid_definition *FindPid(uint16_t nParamId);
+	static uint8_t SupportedParameters(bool bSubDevices, uint8_t *pParams);
+
 	// Get
 	void GetQueuedMessage(uint16_t nSubDevice);
 	void GetSupportedParameters(uint16_t nSubDevice);
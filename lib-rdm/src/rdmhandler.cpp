@@ -75,6 +75,13 @@ RDMHandler::RDMHandler(bool bIsRdm):
 	m_pRdmDataIn(0),
 	m_pRdmDataOut(0)
 {
+	assert(IsPidTablesSorted());
+
+	// The SUPPORTED_PARAMETERS payloads are fixed, they are built once
+	if (s_nSupportedParametersLength == 0) {
+		s_nSupportedParametersLength = SupportedParameters(false, s_SupportedParameters);
+		s_nSupportedParametersSubDevicesLength = SupportedParameters(true, s_SupportedParametersSubDevices);
+	}
 }
 
 RDMHandler::~RDMHandler(void) {
@@ -159,6 +166,9 @@ void RDMHandler::RespondMessageNack(uint16_t nReason) {
 	CreateRespondMessage(E120_RESPONSE_TYPE_NACK_REASON, nReason);
 }
 
+/*
+ * The tables must be sorted on pid, the lookup is a binary search.
+ */
 const RDMHandler::pid_definition RDMHandler::PID_DEFINITIONS[] {
 //  {E120_QUEUED_MESSAGE,              	&RDMHandler::GetQueuedMessage,           	0,                   				1, true , false},
 	{E120_SUPPORTED_PARAMETERS,        	&RDMHandler::GetSupportedParameters,      	0,             						0, false, true , false},
@@ -183,10 +193,6 @@ const RDMHandler::pid_definition RDMHandler::PID_DEFINITIONS[] {
 	{E120_RECORD_SENSORS,			   	0,											&RDMHandler::SetRecordSensors,	 	0, true , true , false},
 	{E120_DEVICE_HOURS,                	&RDMHandler::GetDeviceHours,    	      	&RDMHandler::SetDeviceHours,       	0, true , true , false},
 	{E120_REAL_TIME_CLOCK,		       	&RDMHandler::GetRealTimeClock,  			&RDMHandler::SetRealTimeClock,    	0, true , true , false},
-	{E120_IDENTIFY_DEVICE,		       	&RDMHandler::GetIdentifyDevice,		    	&RDMHandler::SetIdentifyDevice,    	0, false, true , true },
-	{E120_RESET_DEVICE,			    	0,                                			&RDMHandler::SetResetDevice,       	0, true , true , true },
-	{E120_POWER_STATE,					&RDMHandler::GetPowerState,					&RDMHandler::SetPowerState,			0, true , true , false},
-	{E137_1_IDENTIFY_MODE,			   	&RDMHandler::GetIdentifyMode,				&RDMHandler::SetIdentifyMode,		0, true , true , false},
 	{E137_2_LIST_INTERFACES,			&RDMHandler::GetInterfaceList,				0,									0, false, false, true },
 	{E137_2_INTERFACE_LABEL,			&RDMHandler::GetInterfaceName,				0,									4, false, false, true },
 	{E137_2_INTERFACE_HARDWARE_ADDRESS_TYPE1,&RDMHandler::GetHardwareAddress,		0,									4, false, false, true },
@@ -198,7 +204,11 @@ const RDMHandler::pid_definition RDMHandler::PID_DEFINITIONS[] {
 	{E137_2_IPV4_DEFAULT_ROUTE, 		&RDMHandler::GetDefaultRoute,				0,									0, false, false, true },
 	{E137_2_DNS_IPV4_NAME_SERVER,		&RDMHandler::GetNameServers,				0,									1, false, false, true },
 	{E137_2_DNS_HOSTNAME,               &RDMHandler::GetHostName,                   &RDMHandler::SetHostName,           0, false, false, true },
-	{E137_2_DNS_DOMAIN_NAME,			&RDMHandler::GetDomainName,					0,									0, false, false, true }
+	{E137_2_DNS_DOMAIN_NAME,			&RDMHandler::GetDomainName,					0,									0, false, false, true },
+	{E120_IDENTIFY_DEVICE,		       	&RDMHandler::GetIdentifyDevice,		    	&RDMHandler::SetIdentifyDevice,    	0, false, true , true },
+	{E120_RESET_DEVICE,			    	0,                                			&RDMHandler::SetResetDevice,       	0, true , true , true },
+	{E120_POWER_STATE,					&RDMHandler::GetPowerState,					&RDMHandler::SetPowerState,			0, true , true , false},
+	{E137_1_IDENTIFY_MODE,			   	&RDMHandler::GetIdentifyMode,				&RDMHandler::SetIdentifyMode,		0, true , true , false}
 };
 
 const RDMHandler::pid_definition RDMHandler::PID_DEFINITIONS_SUB_DEVICES[] {
@@ -212,6 +222,11 @@ const RDMHandler::pid_definition RDMHandler::PID_DEFINITIONS_SUB_DEVICES[] {
 	{E120_IDENTIFY_DEVICE,		       &RDMHandler::GetIdentifyDevice,		    	&RDMHandler::SetIdentifyDevice,		0, true, true ,  false}
 };
 
+uint8_t RDMHandler::s_SupportedParameters[2 * (sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]))];
+uint8_t RDMHandler::s_SupportedParametersSubDevices[2 * (sizeof(PID_DEFINITIONS_SUB_DEVICES) / sizeof(PID_DEFINITIONS_SUB_DEVICES[0]))];
+uint8_t RDMHandler::s_nSupportedParametersLength = 0;
+uint8_t RDMHandler::s_nSupportedParametersSubDevicesLength = 0;
+
 /**
  *
  * @param pRdmDataIn RDM with no Start Code
@@ -352,9 +367,7 @@ void RDMHandler::HandleData(const uint8_t* pRdmDataIn, uint8_t *pRdmDataOut) {
 void RDMHandler::Handlers(bool bIsBroadcast, uint8_t nCommandClass, uint16_t nParamId, uint8_t nParamDataLength, uint16_t nSubDevice) {
 	DEBUG1_ENTRY
 
-	pid_definition const *pid_handler = 0;
-	bool bRDM;
-	bool bRDMNet;
+	pid_definition const *pid_handler;
 
 	if (nCommandClass != E120_GET_COMMAND && nCommandClass != E120_SET_COMMAND) {
 		RespondMessageNack(E120_NR_UNSUPPORTED_COMMAND_CLASS);
@@ -368,13 +381,7 @@ void RDMHandler::Handlers(bool bIsBroadcast, uint8_t nCommandClass, uint16_t nPa
 		return;
 	}
 
-	for (uint32_t i = 0; i < sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]); ++i) {
-		if (PID_DEFINITIONS[i].pid == nParamId) {
-			pid_handler = &PID_DEFINITIONS[i];
-			bRDM = PID_DEFINITIONS[i].bRDM;
-			bRDMNet = PID_DEFINITIONS[i].bRDMNet;
-		}
-	}
+	pid_handler = FindPid(nParamId);
 
 	if (!pid_handler) {
 		RespondMessageNack(E120_NR_UNKNOWN_PID);
@@ -382,6 +389,9 @@ void RDMHandler::Handlers(bool bIsBroadcast, uint8_t nCommandClass, uint16_t nPa
 		return;
 	}
 
+	const bool bRDM = pid_handler->bRDM;
+	const bool bRDMNet = pid_handler->bRDMNet;
+
 	if (m_bIsRDM) {
 		if (!bRDM) {
 			RespondMessageNack(E120_NR_UNKNOWN_PID);
@@ -439,39 +449,77 @@ void RDMHandler::GetQueuedMessage(/*@unused@*/uint16_t nSubDevice) {
 	RespondMessageAck();
 }
 
-void RDMHandler::GetSupportedParameters(uint16_t nSubDevice) {
-	uint8_t nSupportedParams = 0;
-	pid_definition *pPidDefinitions;
-	uint32_t nTableSize = 0;
+const RDMHandler::pid_definition *RDMHandler::FindPid(uint16_t nParamId) {
+	uint32_t nLow = 0;
+	uint32_t nHigh = sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]);
 
-	if (nSubDevice != 0) {
-		pPidDefinitions = (pid_definition *)&PID_DEFINITIONS_SUB_DEVICES[0];
-		nTableSize = (int) (sizeof(PID_DEFINITIONS_SUB_DEVICES) / sizeof(PID_DEFINITIONS_SUB_DEVICES[0]));
-	} else {
-		pPidDefinitions = (pid_definition *)&PID_DEFINITIONS[0];
-		nTableSize = (int) (sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]));
+	while (nLow < nHigh) {
+		const uint32_t nMiddle = (nLow + nHigh) / 2;
+
+		if (PID_DEFINITIONS[nMiddle].pid < nParamId) {
+			nLow = nMiddle + 1;
+		} else {
+			nHigh = nMiddle;
+		}
 	}
 
-	for (uint32_t i = 0; i < nTableSize; i++) {
-		if (pPidDefinitions[i].bIncludeInSupportedParams) {
-			nSupportedParams++;
+	if ((nLow < sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0])) && (PID_DEFINITIONS[nLow].pid == nParamId)) {
+		return &PID_DEFINITIONS[nLow];
+	}
+
+	return 0;
+}
+
+bool RDMHandler::IsPidTablesSorted(void) {
+	for (uint32_t i = 1; i < sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]); i++) {
+		if (PID_DEFINITIONS[i - 1].pid >= PID_DEFINITIONS[i].pid) {
+			return false;
 		}
 	}
 
-	struct TRdmMessage *pRdmDataOut = (struct TRdmMessage *)m_pRdmDataOut;
+	for (uint32_t i = 1; i < sizeof(PID_DEFINITIONS_SUB_DEVICES) / sizeof(PID_DEFINITIONS_SUB_DEVICES[0]); i++) {
+		if (PID_DEFINITIONS_SUB_DEVICES[i - 1].pid >= PID_DEFINITIONS_SUB_DEVICES[i].pid) {
+			return false;
+		}
+	}
 
-	pRdmDataOut->param_data_length = (2 * nSupportedParams);
+	return true;
+}
 
+uint8_t RDMHandler::SupportedParameters(bool bSubDevices, uint8_t *pParams) {
+	const pid_definition *pPidDefinitions;
+	uint32_t nTableSize;
 	uint32_t j = 0;
 
+	if (bSubDevices) {
+		pPidDefinitions = PID_DEFINITIONS_SUB_DEVICES;
+		nTableSize = sizeof(PID_DEFINITIONS_SUB_DEVICES) / sizeof(PID_DEFINITIONS_SUB_DEVICES[0]);
+	} else {
+		pPidDefinitions = PID_DEFINITIONS;
+		nTableSize = sizeof(PID_DEFINITIONS) / sizeof(PID_DEFINITIONS[0]);
+	}
+
 	for (uint32_t i = 0; i < nTableSize; i++) {
 		if (pPidDefinitions[i].bIncludeInSupportedParams) {
-			pRdmDataOut->param_data[j + j] = (uint8_t) (pPidDefinitions[i].pid >> 8);
-			pRdmDataOut->param_data[j + j + 1] = (uint8_t) pPidDefinitions[i].pid;
-			j++;
+			pParams[j++] = (uint8_t) (pPidDefinitions[i].pid >> 8);
+			pParams[j++] = (uint8_t) pPidDefinitions[i].pid;
 		}
 	}
 
+	return (uint8_t) j;
+}
+
+void RDMHandler::GetSupportedParameters(uint16_t nSubDevice) {
+	struct TRdmMessage *pRdmDataOut = (struct TRdmMessage *)m_pRdmDataOut;
+
+	if (nSubDevice != 0) {
+		pRdmDataOut->param_data_length = s_nSupportedParametersSubDevicesLength;
+		memcpy(pRdmDataOut->param_data, s_SupportedParametersSubDevices, s_nSupportedParametersSubDevicesLength);
+	} else {
+		pRdmDataOut->param_data_length = s_nSupportedParametersLength;
+		memcpy(pRdmDataOut->param_data, s_SupportedParameters, s_nSupportedParametersLength);
+	}
+
 	RespondMessageAck();
 }
 
@@ -24,6 +24,9 @@ public:
 	void Copy(uint8_t nPort, uint8_t *pTod);
 	const uint8_t *Handler(uint8_t nPort, const uint8_t *pRdmData);
 
+	void DiscoveryStart(uint8_t nPort, bool bInterleaveDmx);
+	bool DiscoveryRun(uint8_t nPort);
+
 	void DumpTod(uint8_t nPort = 0);
 
 private:
@@ -34,6 +34,30 @@
 #include "rdmmessage.h"
 #include "rdmtod.h"
 
+#define RDM_DISCOVERY_STACK_SIZE		(48 + 1)	///< One range per bit of the 48-bit UID, plus the initial range
+
+#if !defined (RDM_DISCOVERY_DMX_INTERVAL)
+ #define RDM_DISCOVERY_DMX_INTERVAL		25000		///< us of discovery before the line is handed back to DMX output
+#endif
+#if !defined (RDM_DISCOVERY_DMX_HOLD)
+ #define RDM_DISCOVERY_DMX_HOLD			25000		///< us of DMX output, at least one full frame at the default refresh rate
+#endif
+
+enum TRdmDiscoveryState {
+	RDM_DISCOVERY_STATE_IDLE,
+	RDM_DISCOVERY_STATE_UNMUTE,
+	RDM_DISCOVERY_STATE_UNMUTE_WAIT,
+	RDM_DISCOVERY_STATE_DUB,
+	RDM_DISCOVERY_STATE_DUB_WAIT,
+	RDM_DISCOVERY_STATE_MUTE_WAIT,
+	RDM_DISCOVERY_STATE_DMX
+};
+
+struct TRdmDiscoveryRange {
+	uint64_t nLowerBound;
+	uint64_t nUpperBound;
+};
+
 class RDMDiscovery: public RDMTod {
 public:
 	RDMDiscovery(uint8_t nPort = 0);
@@ -44,9 +68,32 @@ public:
 
 	void Full(void);
 
+	/**
+	 * Non-blocking discovery. Start() resets the TOD, each call to Run() does at most
+	 * one RDM transaction step and returns false when discovery has finished.
+	 * With bInterleaveDmx the line is handed back to DMX output between transactions.
+	 */
+	void Start(bool bInterleaveDmx = false);
+	bool Run(void);
+
+	bool IsRunning(void) {
+		return m_tState != RDM_DISCOVERY_STATE_IDLE;
+	}
+
 private:
-	bool FindDevices(uint64_t, uint64_t);
-	bool QuickFind(const uint8_t *);
+	void SendDiscUniqueBranch(void);
+	void SendMute(const uint8_t *);
+	void SetDmxOutput(void);
+	bool IsDmxPending(TRdmDiscoveryState tNextState);
+	void SetNextState(TRdmDiscoveryState tNextState);
+	bool IsTimeOut(uint32_t nTimeOut);
+	void Finish(void);
+
+	bool Push(uint64_t, uint64_t);
+	void Split(void);
+	void Pop(void) {
+		m_nStackPointer--;
+	}
 
 	bool IsValidDiscoveryResponse(const uint8_t *, uint8_t *);
 
@@ -61,6 +108,16 @@ private:
 	RDMMessage m_UnMute;
 	RDMMessage m_Mute;
 	RDMMessage m_DiscUniqueBranch;
+	TRdmDiscoveryState m_tState;
+	TRdmDiscoveryState m_tDmxNextState;
+	bool m_bInterleaveDmx;
+	bool m_bQuickFind;
+	uint8_t m_nUnMuteCount;
+	uint8_t m_MuteUid[RDM_UID_SIZE];
+	uint32_t m_nStackPointer;
+	uint32_t m_nMicros;
+	uint32_t m_nDmxMicros;
+	struct TRdmDiscoveryRange m_Stack[RDM_DISCOVERY_STACK_SIZE];
 };
 
 #endif /* RDMDISCOVERY_H_ */
@@ -76,6 +76,20 @@ void ArtNetRdmController::Full(uint8_t nPort) {
 	m_Discovery[nPort]->Full();
 }
 
+void ArtNetRdmController::DiscoveryStart(uint8_t nPort, bool bInterleaveDmx) {
+	assert(nPort < DMX_MAX_UARTS);
+
+	DEBUG_PRINTF("nPort=%d, bInterleaveDmx=%d", nPort, (int) bInterleaveDmx);
+
+	m_Discovery[nPort]->Start(bInterleaveDmx);
+}
+
+bool ArtNetRdmController::DiscoveryRun(uint8_t nPort) {
+	assert(nPort < DMX_MAX_UARTS);
+
+	return m_Discovery[nPort]->Run();
+}
+
 const uint8_t ArtNetRdmController::GetUidCount(uint8_t nPort) {
 	assert(nPort < DMX_MAX_UARTS);
 
@@ -26,6 +26,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <string.h>
+#include <assert.h>
 #ifndef NDEBUG
 #include <stdio.h>
 #endif
@@ -34,11 +35,9 @@
 #include "rdm_e120.h"
 #include "rdmdiscovery.h"
 
-#include "hardware.h"
+#include "dmx.h"
 
-extern "C" {
- void udelay(uint32_t us);
-}
+#include "hardware.h"
 
 static uint8_t pdl[2][RDM_UID_SIZE];
 
@@ -49,9 +48,21 @@ typedef union cast {
 
 static _cast uuid_cast;
 
-#define RECEIVE_TIME_OUT (2800*100) //TODO #define
-
-RDMDiscovery::RDMDiscovery(uint8_t nPort) : m_nPort(nPort) {
+#define RECEIVE_TIME_OUT	2800	///< us, E1.20 lost response time-out
+#define UNMUTE_TIME_OUT		100000	///< us between the DISC_UN_MUTE broadcasts
+#define UNMUTE_COUNT		3
+
+RDMDiscovery::RDMDiscovery(uint8_t nPort) :
+	m_nPort(nPort),
+	m_tState(RDM_DISCOVERY_STATE_IDLE),
+	m_tDmxNextState(RDM_DISCOVERY_STATE_IDLE),
+	m_bInterleaveDmx(false),
+	m_bQuickFind(false),
+	m_nUnMuteCount(0),
+	m_nStackPointer(0),
+	m_nMicros(0),
+	m_nDmxMicros(0)
+{
 	m_UnMute.SetDstUid(UID_ALL);
 	m_UnMute.SetCc(E120_DISCOVERY_COMMAND);
 	m_UnMute.SetPid(E120_DISC_UN_MUTE);
@@ -80,97 +91,252 @@ const char *RDMDiscovery::GetUid(void) {
 }
 
 void RDMDiscovery::Full(void) {
-	struct TRdmMessage *response;
+	Start();
+
+	while (Run()) {
+		Hardware::Get()->WatchdogFeed();
+	}
+}
 
+void RDMDiscovery::Start(bool bInterleaveDmx) {
 	Reset();
 
-	m_UnMute.Send(m_nPort);
-	m_UnMute.ReceiveTimeOut(m_nPort, 2800);
+	m_bInterleaveDmx = bInterleaveDmx;
+	m_nUnMuteCount = 0;
+	m_nStackPointer = 0;
 
-	Hardware::Get()->WatchdogFeed();
-	udelay(100000);
+	Push(0x000000000000, 0xfffffffffffe);
 
-	m_UnMute.Send(m_nPort);
-	m_UnMute.ReceiveTimeOut(m_nPort, 2800);
+	m_nDmxMicros = Hardware::Get()->Micros();
+	m_tState = RDM_DISCOVERY_STATE_UNMUTE;
+}
 
-	Hardware::Get()->WatchdogFeed();
-	udelay(100000);
+/*
+ * The binary search of the UID space is done with an explicit stack of ranges,
+ * the top of the stack is the range under test. Each call does at most one send,
+ * the response windows are polled.
+ */
+bool RDMDiscovery::Run(void) {
+	const uint8_t *pResponse;
+	uint8_t uid[RDM_UID_SIZE];
 
-	m_UnMute.Send(m_nPort);
-	response = (struct TRdmMessage *) m_Mute.ReceiveTimeOut(m_nPort, RECEIVE_TIME_OUT);
+	switch (m_tState) {
+	case RDM_DISCOVERY_STATE_IDLE:
+		return false;
+		break;
+	case RDM_DISCOVERY_STATE_DMX:
+		if (IsTimeOut(RDM_DISCOVERY_DMX_HOLD)) {
+			m_nDmxMicros = Hardware::Get()->Micros();
+			m_tState = m_tDmxNextState;
+		}
+		break;
+	case RDM_DISCOVERY_STATE_UNMUTE:
+		if (IsDmxPending(RDM_DISCOVERY_STATE_UNMUTE)) {
+			break;
+		}
 
-	if (response != 0) {
-		FindDevices(ConvertUid((const uint8_t *)response->source_uid), ConvertUid((const uint8_t *)response->source_uid));
-	}
+		while (0 != RDMMessage::Receive(m_nPort)) {
+			// Discard late responses
+		}
 
-	FindDevices(0x000000000000, 0xfffffffffffe);
+		m_UnMute.Send(m_nPort);
+		m_nUnMuteCount++;
 
-	Dump();
-}
+		// No responses to a broadcast, the line can carry DMX while waiting
+		if (m_bInterleaveDmx) {
+			SetDmxOutput();
+		}
 
-bool RDMDiscovery::FindDevices(uint64_t LowerBound, uint64_t UpperBound) {
-	struct TRdmMessage *response;
-	uint8_t uid[RDM_UID_SIZE];
-	bool bDeviceFound = false;
-	uint64_t MidPosition;
+		m_nMicros = Hardware::Get()->Micros();
+		m_tState = RDM_DISCOVERY_STATE_UNMUTE_WAIT;
+		break;
+	case RDM_DISCOVERY_STATE_UNMUTE_WAIT:
+		if (IsTimeOut(UNMUTE_TIME_OUT)) {
+			m_nDmxMicros = Hardware::Get()->Micros();
+			m_tState = (m_nUnMuteCount < UNMUTE_COUNT) ? RDM_DISCOVERY_STATE_UNMUTE : RDM_DISCOVERY_STATE_DUB;
+		}
+		break;
+	case RDM_DISCOVERY_STATE_DUB:
+		if (m_nStackPointer == 0) {
+			Finish();
+			return false;
+		}
 
-	Hardware::Get()->WatchdogFeed();
+		if (IsDmxPending(RDM_DISCOVERY_STATE_DUB)) {
+			break;
+		}
+
+		Hardware::Get()->WatchdogFeed();
+
+		if (m_Stack[m_nStackPointer - 1].nLowerBound == m_Stack[m_nStackPointer - 1].nUpperBound) {
+			m_bQuickFind = false;
+			SendMute(ConvertUid(m_Stack[m_nStackPointer - 1].nLowerBound));
+			m_tState = RDM_DISCOVERY_STATE_MUTE_WAIT;
+		} else {
+			SendDiscUniqueBranch();
+			m_tState = RDM_DISCOVERY_STATE_DUB_WAIT;
+		}
+		break;
+	case RDM_DISCOVERY_STATE_DUB_WAIT:
+		if ((pResponse = RDMMessage::Receive(m_nPort)) != 0) {
+			if (IsValidDiscoveryResponse(pResponse, uid)) {
+				// Quick find : a single responder, mute it and repeat the same branch
+				m_bQuickFind = true;
+				SendMute(uid);
+				m_tState = RDM_DISCOVERY_STATE_MUTE_WAIT;
+			} else {
+				// Collision
+				Split();
+				SetNextState(RDM_DISCOVERY_STATE_DUB);
+			}
+		} else if (IsTimeOut(RECEIVE_TIME_OUT)) {
+			// Nobody left in this branch
+			Pop();
+			SetNextState(RDM_DISCOVERY_STATE_DUB);
+		}
+		break;
+	case RDM_DISCOVERY_STATE_MUTE_WAIT: {
+		bool bIsMuted = false;
+
+		if ((pResponse = RDMMessage::Receive(m_nPort)) != 0) {
+			const struct TRdmMessage *p = (const struct TRdmMessage *) pResponse;
+
+			if ((p->command_class == E120_DISCOVERY_COMMAND_RESPONSE) && (memcmp(m_MuteUid, p->source_uid, RDM_UID_SIZE) == 0)) {
+				AddUid(m_MuteUid);
+				bIsMuted = true;
+			}
+		} else if (!IsTimeOut(RECEIVE_TIME_OUT)) {
+			break;
+		}
+
+		if (!m_bQuickFind) {
+			Pop();
+		} else if (!bIsMuted) {
+			// The device did not mute, it would answer the same branch again
+			Split();
+		}
+
+		SetNextState(RDM_DISCOVERY_STATE_DUB);
+	}
+		break;
+	default:
+		break;
+	}
+
+	return true;
+}
+
+void RDMDiscovery::SendDiscUniqueBranch(void) {
+	const struct TRdmDiscoveryRange *pRange = &m_Stack[m_nStackPointer - 1];
 
 #ifndef NDEBUG
 	printf("FindDevices : ");
-	PrintUid(LowerBound);
+	PrintUid(pRange->nLowerBound);
 	printf(" - ");
-	PrintUid(UpperBound);
+	PrintUid(pRange->nUpperBound);
 	printf("\n");
 #endif
 
-	if (LowerBound == UpperBound) {
-		memcpy(uid, ConvertUid(LowerBound), RDM_UID_SIZE);
+	while (0 != RDMMessage::Receive(m_nPort)) {
+		// Discard late responses
+	}
 
-		m_Mute.SetDstUid(uid);
-		m_Mute.Send(m_nPort);
+	memcpy(pdl[0], ConvertUid(pRange->nLowerBound), RDM_UID_SIZE);
+	memcpy(pdl[1], ConvertUid(pRange->nUpperBound), RDM_UID_SIZE);
 
-		response = (struct TRdmMessage *) m_Mute.ReceiveTimeOut(m_nPort, RECEIVE_TIME_OUT);
+	m_DiscUniqueBranch.SetPd((const uint8_t *)pdl, 2* RDM_UID_SIZE);
+	m_DiscUniqueBranch.Send(m_nPort);
 
-		if (response != 0) {
-			if ((response->command_class == E120_DISCOVERY_COMMAND_RESPONSE) && (memcmp(uid, response->source_uid, RDM_UID_SIZE) == 0)) {
-				AddUid(uid);
-			}
-		} else {
-			return true;
-		}
-	} else {
-		memcpy(pdl[0], ConvertUid(LowerBound), RDM_UID_SIZE);
-		memcpy(pdl[1], ConvertUid(UpperBound), RDM_UID_SIZE);
+	m_nMicros = Hardware::Get()->Micros();
+}
 
-		m_DiscUniqueBranch.SetPd((const uint8_t *)pdl, 2* RDM_UID_SIZE);
-		m_DiscUniqueBranch.Send(m_nPort);
+void RDMDiscovery::SendMute(const uint8_t *uid) {
+	memcpy(m_MuteUid, uid, RDM_UID_SIZE);
 
-		response = (struct TRdmMessage *) m_DiscUniqueBranch.ReceiveTimeOut(m_nPort, RECEIVE_TIME_OUT);
+#ifndef NDEBUG
+	printf("Mute : ");
+	PrintUid(m_MuteUid);
+	printf("\n");
+#endif
 
-		if (response != 0) {
-			bDeviceFound = true;
+	while (0 != RDMMessage::Receive(m_nPort)) {
+		// Discard late responses
+	}
 
-			if (IsValidDiscoveryResponse((const uint8_t *)response, uid)) {
-				bDeviceFound = QuickFind(uid);
-			}
+	m_Mute.SetDstUid(m_MuteUid);
+	m_Mute.Send(m_nPort);
 
-			if (bDeviceFound) {
-				MidPosition = ((LowerBound & (0x0000800000000000 - 1)) + (UpperBound & (0x0000800000000000 - 1))) / 2
-						+ (UpperBound & (0x0000800000000000) ? 0x0000400000000000 : 0 )
-						+ (LowerBound & (0x0000800000000000) ? 0x0000400000000000 : 0 );
+	m_nMicros = Hardware::Get()->Micros();
+}
 
-				bDeviceFound = FindDevices(LowerBound, MidPosition);
-				bDeviceFound |= FindDevices(MidPosition + 1, UpperBound);
+void RDMDiscovery::SetDmxOutput(void) {
+#if defined (H3)
+	DmxSet::Get()->SetPortDirection(m_nPort, DMXRDM_PORT_DIRECTION_OUTP, true);
+#else
+	dmx_set_port_direction(DMX_PORT_DIRECTION_OUTP, true);
+#endif
+}
 
-				if (bDeviceFound) {
-					return true;
-				}
-			}
-		}
+bool RDMDiscovery::IsDmxPending(TRdmDiscoveryState tNextState) {
+	if (!m_bInterleaveDmx || ((Hardware::Get()->Micros() - m_nDmxMicros) < RDM_DISCOVERY_DMX_INTERVAL)) {
+		return false;
+	}
+
+	SetDmxOutput();
+
+	m_nMicros = Hardware::Get()->Micros();
+	m_tDmxNextState = tNextState;
+	m_tState = RDM_DISCOVERY_STATE_DMX;
+
+	return true;
+}
+
+/*
+ * A transaction has completed, the line is free for DMX output when it is due.
+ */
+void RDMDiscovery::SetNextState(TRdmDiscoveryState tNextState) {
+	if (!IsDmxPending(tNextState)) {
+		m_tState = tNextState;
 	}
+}
+
+bool RDMDiscovery::IsTimeOut(uint32_t nTimeOut) {
+	return (Hardware::Get()->Micros() - m_nMicros) >= nTimeOut;
+}
+
+void RDMDiscovery::Finish(void) {
+	if (m_bInterleaveDmx) {
+		SetDmxOutput();
+	}
+
+	m_tState = RDM_DISCOVERY_STATE_IDLE;
+
+	Dump();
+}
+
+bool RDMDiscovery::Push(uint64_t nLowerBound, uint64_t nUpperBound) {
+	if (m_nStackPointer == RDM_DISCOVERY_STACK_SIZE) {
+		assert(0);
+		return false;
+	}
+
+	m_Stack[m_nStackPointer].nLowerBound = nLowerBound;
+	m_Stack[m_nStackPointer].nUpperBound = nUpperBound;
+	m_nStackPointer++;
 
-	return false;
+	return true;
+}
+
+void RDMDiscovery::Split(void) {
+	const uint64_t nLowerBound = m_Stack[m_nStackPointer - 1].nLowerBound;
+	const uint64_t nUpperBound = m_Stack[m_nStackPointer - 1].nUpperBound;
+	const uint64_t nMidPosition = (nLowerBound + nUpperBound) / 2;
+
+	Pop();
+
+	// The lower half is on top, it is searched first
+	Push(nMidPosition + 1, nUpperBound);
+	Push(nLowerBound, nMidPosition);
 }
 
 const uint8_t *RDMDiscovery::ConvertUid(const uint64_t uid) {
@@ -233,43 +399,3 @@ bool RDMDiscovery::IsValidDiscoveryResponse(const uint8_t *response, uint8_t *ui
 
 	return bIsValid;
 }
-
-bool RDMDiscovery::QuickFind(const uint8_t *uid) {
-	uint8_t *response;
-	struct TRdmMessage *p;
-	uint8_t r_uid[RDM_UID_SIZE];
-
-	Hardware::Get()->WatchdogFeed();
-
-#ifndef NDEBUG
-	printf("QuickFind : ");
-	PrintUid((uint8_t *)uid);
-	printf("\n");
-#endif
-
-	m_Mute.SetDstUid(uid);
-	m_Mute.Send(m_nPort);
-
-	response = (uint8_t *) m_Mute.ReceiveTimeOut(m_nPort, RECEIVE_TIME_OUT);
-
-	if (response != 0) {
-		p = (struct TRdmMessage *) response;
-		if ((p->command_class == E120_DISCOVERY_COMMAND_RESPONSE) && (memcmp(uid, p->source_uid, RDM_UID_SIZE) == 0)) {
-			AddUid(uid);
-		}
-	}
-
-	Hardware::Get()->WatchdogFeed();
-
-	m_DiscUniqueBranch.Send(m_nPort);
-
-	response = (uint8_t *) m_DiscUniqueBranch.ReceiveTimeOut(m_nPort, RECEIVE_TIME_OUT);
-
-	if ((response != 0) && (IsValidDiscoveryResponse(response, r_uid))) {
-		QuickFind(r_uid);
-	} else {
-		return true;
-	}
-
-	return false;
-}
@@ -108,6 +108,7 @@ public:
 	int Run(void);
 
 private:
+	int HandleRequest(void);
 	uint32_t GetIndex(const void *p);
 
 	void HandleReboot(void);
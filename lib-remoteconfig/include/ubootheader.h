@@ -13,6 +13,12 @@ public:
 		return m_bIsValid;
 	}
 
+	/**
+	 * The header fields, the header CRC, the data size and the data CRC.
+	 * @param nFileSize bytes received, the header is followed by the image data
+	 */
+	bool IsImageValid(uint32_t nFileSize);
+
 	void Dump(void);
 
 private:
@@ -166,6 +166,7 @@ static const TStore sMap[TXT_FILE_LAST] ALIGNED = 				 { STORE_RCONFIG, STORE_NE
 
 #define UDP_PORT			0x2905
 #define UDP_BUFFER_SIZE		768
+#define UDP_RECV_BATCH		4	///< Requests handled in one Run
 #define UDP_DATA_MIN_SIZE	MIN(MIN(MIN(MIN(REQUEST_REBOOT_LENGTH, REQUEST_LIST_LENGTH),REQUEST_GET_LENGTH),REQUEST_UPTIME_LENGTH),SET_DISPLAY_LENGTH)
 
 RemoteConfig::RemoteConfig(TRemoteConfig tRemoteConfig, TRemoteConfigMode tRemoteConfigMode, uint8_t nOutputs):
@@ -236,7 +237,11 @@ void RemoteConfig::SetDisable(bool bDisable) {
 void RemoteConfig::SetDisplayName(const char *pDisplayName) {
 	DEBUG_ENTRY
 
-	strncpy((char *)m_tRemoteConfigListBin.aDisplayName, pDisplayName, REMOTE_CONFIG_DISPLAY_NAME_LENGTH);
+	// Fixed size field, zero padded and not terminated when the name is full length
+	const size_t nLength = strlen(pDisplayName) < REMOTE_CONFIG_DISPLAY_NAME_LENGTH ? strlen(pDisplayName) : REMOTE_CONFIG_DISPLAY_NAME_LENGTH;
+
+	memset(m_tRemoteConfigListBin.aDisplayName, 0, REMOTE_CONFIG_DISPLAY_NAME_LENGTH);
+	memcpy(m_tRemoteConfigListBin.aDisplayName, pDisplayName, nLength);
 #ifndef NDEBUG
 	debug_dump((void *)&m_tRemoteConfigListBin, sizeof m_tRemoteConfigListBin);
 #endif
@@ -245,7 +250,8 @@ void RemoteConfig::SetDisplayName(const char *pDisplayName) {
 }
 
 int RemoteConfig::Run(void) {
-	uint16_t nForeignPort;
+	struct TNetworkPacket aPackets[UDP_RECV_BATCH];
+	int nResult = 0;
 
 	if (__builtin_expect((m_bDisable), 1)) {
 		return 0;
@@ -253,10 +259,26 @@ int RemoteConfig::Run(void) {
 
 	if (__builtin_expect((m_pTFTPFileServer != 0), 0)) {
 		m_pTFTPFileServer->Run();
+		SpiFlashInstall::Get()->WriteFirmwareRun(m_pTFTPBuffer, m_pTFTPFileServer->GetFileSize(), m_pTFTPFileServer->isDone());
+	}
+
+	const uint32_t nPackets = Network::Get()->RecvMany(m_nHandle, aPackets, UDP_RECV_BATCH);
+
+	for (uint32_t i = 0; i < nPackets; i++) {
+		m_nBytesReceived = aPackets[i].nSize < UDP_BUFFER_SIZE ? aPackets[i].nSize : UDP_BUFFER_SIZE;
+		m_nIPAddressFrom = aPackets[i].nFromIp;
+
+		memcpy(m_pUdpBuffer, aPackets[i].pData, m_nBytesReceived);
+
+		Network::Get()->RecvRelease(m_nHandle);
+
+		nResult = HandleRequest();
 	}
 
-	m_nBytesReceived = Network::Get()->RecvFrom(m_nHandle, m_pUdpBuffer, (uint16_t) UDP_BUFFER_SIZE, &m_nIPAddressFrom, &nForeignPort);
+	return nResult;
+}
 
+int RemoteConfig::HandleRequest(void) {
 	if (__builtin_expect((m_nBytesReceived < (int) UDP_DATA_MIN_SIZE), 1)) {
 		return 0;
 	}
@@ -1039,11 +1061,14 @@ void RemoteConfig::HandleTftpSet(void) {
 #ifndef NDEBUG
 			debug_dump((void *)m_pTFTPBuffer, 512);
 #endif
-			bSucces = SpiFlashInstall::Get()->WriteFirmware(m_pTFTPBuffer, nFileSize);
+			bSucces = SpiFlashInstall::Get()->WriteFirmwareEnd(m_pTFTPBuffer, nFileSize);
+		} else if (nFileSize != 0) {
+			// Aborted or not a valid image, the flash is not changed
+			bSucces = false;
+		}
 
-			if (!bSucces) {
-				Display::Get()->TextStatus("Error: TFTP", DISPLAY_7SEGMENT_MSG_ERROR_TFTP);
-			}
+		if (!bSucces) {
+			Display::Get()->TextStatus("Error: TFTP", DISPLAY_7SEGMENT_MSG_ERROR_TFTP);
 		}
 
 		printf("Delete TFTP Server\n");
@@ -30,6 +30,7 @@
 
 #include "tftpfileserver.h"
 #include "ubootheader.h"
+#include "spiflashinstall.h"
 
 #include "display.h"
 
@@ -84,18 +85,42 @@ bool TFTPFileServer::FileCreate(const char* pFileName, TTFTPMode tMode) {
 		return false;
 	}
 
+	// The accepted image is written to flash until the TFTP server is switched off
+	if (m_bDone) {
+		DEBUG_EXIT
+		return false;
+	}
+
 	printf("TFTP started ...\n");
 	Display::Get()->TextStatus("TFTP Started", DISPLAY_7SEGMENT_MSG_INFO_TFTP_STARTED);
 
 	m_nFileSize = 0;
+	m_bDone = false;
+
+	// The flash is only read while the transfer is running
+	if (!SpiFlashInstall::Get()->WriteFirmwareBegin(m_nSize)) {
+		DEBUG_EXIT
+		return false;
+	}
 
 	DEBUG_EXIT
 	return (true);
 }
 
+/*
+ * Only a complete and valid image is done, then it can be written to flash.
+ */
 bool TFTPFileServer::FileClose(void) {
 	DEBUG_ENTRY
 
+	UBootHeader uImage(m_pBuffer);
+
+	if (!uImage.IsImageValid(m_nFileSize)) {
+		DEBUG_PUTS("uImage is not valid");
+		DEBUG_EXIT
+		return false;
+	}
+
 	m_bDone = true;
 	Display::Get()->TextStatus("TFTP Ended", DISPLAY_7SEGMENT_MSG_INFO_TFTP_ENDED);
 
@@ -111,15 +136,19 @@ int TFTPFileServer::FileRead(void* pBuffer, unsigned nCount, unsigned nBlockNumb
 }
 
 int TFTPFileServer::FileWrite(const void* pBuffer, unsigned nCount, unsigned nBlockNumber) {
-	DEBUG_PRINTF("pBuffer=%p, nCount=%d, nBlockNumber=%d (%d)", pBuffer, nCount, nBlockNumber, m_nSize / 512);
+	const uint32_t nBlockSize = GetBlockSize();
+
+	DEBUG_PRINTF("pBuffer=%p, nCount=%d, nBlockNumber=%d, nBlockSize=%d", pBuffer, nCount, nBlockNumber, nBlockSize);
+
+	assert(nBlockNumber != 0);
 
-	if (nBlockNumber > (m_nSize / 512)) {
+	const uint32_t nOffset = (nBlockNumber - 1) * nBlockSize;
+
+	if ((nOffset + nCount) > m_nSize) {
 		m_nFileSize = 0;
 		return -1;
 	}
 
-	assert(nBlockNumber != 0);
-
 	if (nBlockNumber == 1) {
 		UBootHeader uImage((uint8_t *)pBuffer);
 		if (!uImage.IsValid()) {
@@ -128,13 +157,9 @@ int TFTPFileServer::FileWrite(const void* pBuffer, unsigned nCount, unsigned nBl
 		}
 	}
 
-	uint32_t nOffset = (nBlockNumber - 1) * 512;
-
-	assert((nOffset + nCount) <= m_nSize);
-
 	memcpy((void *)&m_pBuffer[nOffset], pBuffer, nCount);
 
-	m_nFileSize += nCount; //FIXME BUG When in retry ?
+	m_nFileSize = nOffset + nCount;
 
 	return nCount;
 }
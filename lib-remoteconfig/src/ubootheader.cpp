@@ -30,6 +30,18 @@ struct TImageHeader {
 	uint8_t ih_name[IH_NMLEN];	/* Image Name		*/
 };
 
+static uint32_t crc32_update(uint32_t nCrc, const uint8_t *pData, uint32_t nLength) {
+	for (uint32_t i = 0; i < nLength; i++) {
+		nCrc ^= pData[i];
+
+		for (uint32_t j = 0; j < 8; j++) {
+			nCrc = (nCrc >> 1) ^ (0xEDB88320 & (-(nCrc & 1)));
+		}
+	}
+
+	return nCrc;
+}
+
 UBootHeader::UBootHeader(uint8_t* pHeader): m_pHeader(pHeader), m_bIsValid(false) {
 	assert(pHeader != 0);
 
@@ -47,6 +59,37 @@ UBootHeader::~UBootHeader(void) {
 	m_bIsValid = false;
 }
 
+bool UBootHeader::IsImageValid(uint32_t nFileSize) {
+	if (!m_bIsValid || (nFileSize < sizeof(struct TImageHeader))) {
+		return false;
+	}
+
+	struct TImageHeader tImageHeader;
+	memcpy(&tImageHeader, m_pHeader, sizeof(struct TImageHeader));
+
+	const uint32_t nHeaderCrc = __builtin_bswap32(tImageHeader.ih_hcrc);
+	tImageHeader.ih_hcrc = 0;
+
+	if (nHeaderCrc != ~crc32_update(0xFFFFFFFF, (const uint8_t *) &tImageHeader, sizeof(struct TImageHeader))) {
+		printf("uImage: header CRC error\n");
+		return false;
+	}
+
+	const uint32_t nDataSize = __builtin_bswap32(tImageHeader.ih_size);
+
+	if (nDataSize > (nFileSize - sizeof(struct TImageHeader))) {
+		printf("uImage: %d bytes received, %d expected\n", (int) nFileSize, (int) (nDataSize + sizeof(struct TImageHeader)));
+		return false;
+	}
+
+	if (__builtin_bswap32(tImageHeader.ih_dcrc) != ~crc32_update(0xFFFFFFFF, &m_pHeader[sizeof(struct TImageHeader)], nDataSize)) {
+		printf("uImage: data CRC error\n");
+		return false;
+	}
+
+	return true;
+}
+
 void UBootHeader::Dump(void) {
 #ifndef NDEBUG
 	if (!m_bIsValid) {
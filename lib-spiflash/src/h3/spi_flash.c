@@ -39,6 +39,7 @@
 #include "h3_spi_internal.h"
 #include "h3_gpio.h"
 #include "h3_ccu.h"
+#include "h3_board.h"
 
 struct spi0_status {
 	bool		transfer_active;
@@ -307,6 +308,13 @@ int spi_init(void) {
 int spi_xfer(unsigned len, const void *dout, void *din, unsigned long flags) {
 
 	if (flags & SPI_XFER_BEGIN) {
+		// On the Orange Pi One the pixel output (lib-h3 h3_spi.c) uses SPI0 as well
+		if (EXT_SPI_NUMBER == 0) {
+			while (h3_spi_dma_tx_is_active()) {
+				// wait for the DMA to finish
+			}
+		}
+
 		h3_gpio_clr(H3_PORT_TO_GPIO(H3_GPIO_PORTC, 3));
 	}
 
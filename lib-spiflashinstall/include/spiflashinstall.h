@@ -37,6 +37,18 @@ public:
 
 	bool WriteFirmware(const uint8_t *pBuffer, uint32_t nSize);
 
+	/**
+	 * Staged firmware write. While the image is being received (bIsLast is false) the flash is only read:
+	 * the completed sectors are compared with the installed image.
+	 * With bIsLast the image must be complete and validated, then the differing sectors are erased and written.
+	 * WriteFirmwareRun does at most one sector compare, or one sector erase and write, per call.
+	 * nSize is the number of valid bytes in pBuffer so far.
+	 * It returns true as long as there is flash work pending.
+	 */
+	bool WriteFirmwareBegin(uint32_t nMaxSize);
+	bool WriteFirmwareRun(const uint8_t *pBuffer, uint32_t nSize, bool bIsLast);
+	bool WriteFirmwareEnd(const uint8_t *pBuffer, uint32_t nSize);
+
 private:
 	bool Open(const char *pFileName);
 	void Close(void);
@@ -44,6 +56,7 @@ private:
 	bool Diff(uint32_t nOffset);
 	void Write(uint32_t nOffset);
 	void Process(const char *pFileName, uint32_t nOffset);
+	bool IsFlashEqual(uint32_t nOffset, const uint8_t *pBuffer, uint32_t nLength);
 
 public:
 	static SpiFlashInstall* Get(void) {
@@ -60,6 +73,11 @@ private:
 	alignas(uint32_t) uint8_t *m_pFileBuffer;
 	alignas(uint32_t) uint8_t *m_pFlashBuffer;
 	FILE *m_pFile;
+	uint32_t m_nStagedMaxSize;
+	uint32_t m_nStagedCompared;
+	uint32_t m_nStagedWritten;
+	uint8_t *m_pStagedEqual;	///< Per sector, true when the received data equals the flash
+	bool m_bStagedError;
 };
 
 #endif /* SPIFLASHINSTALL_H_ */
@@ -25,6 +25,7 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <assert.h>
 
 #include "spiflashinstall.h"
@@ -49,6 +50,8 @@
 
 #define FLASH_SIZE_MINIMUM	0x200000
 
+#define STAGED_COMPARE_CHUNK	256
+
 static const char sFileUbootSpi[] ALIGNED = "uboot.spi";
 static const char sFileuImage[] ALIGNED = "uImage";
 
@@ -65,7 +68,12 @@ SpiFlashInstall::SpiFlashInstall(void):
 	m_nFlashSize(0),
 	m_pFileBuffer(0),
 	m_pFlashBuffer(0),
-	m_pFile(0)
+	m_pFile(0),
+	m_nStagedMaxSize(0),
+	m_nStagedCompared(0),
+	m_nStagedWritten(0),
+	m_pStagedEqual(0),
+	m_bStagedError(true)
 {
 	DEBUG_ENTRY
 
@@ -127,6 +135,10 @@ SpiFlashInstall::~SpiFlashInstall(void) {
 		delete[] m_pFlashBuffer;
 	}
 
+	if (m_pStagedEqual != 0) {
+		delete[] m_pStagedEqual;
+	}
+
 	DEBUG_EXIT
 }
 
@@ -352,3 +364,137 @@ bool SpiFlashInstall::WriteFirmware(const uint8_t* pBuffer, uint32_t nSize) {
 
 	DEBUG_EXIT
 }
+
+bool SpiFlashInstall::WriteFirmwareBegin(uint32_t nMaxSize) {
+	DEBUG_ENTRY
+
+	const uint32_t nSectorSize = spi_flash_get_sector_size();
+
+	m_nStagedMaxSize = (nMaxSize + nSectorSize - 1) & ~(nSectorSize - 1);
+	m_nStagedCompared = 0;
+	m_nStagedWritten = 0;
+	m_bStagedError = false;
+
+	DEBUG_PRINTF("(%d + %d)=%d, m_nFlashSize=%d", OFFSET_UIMAGE, m_nStagedMaxSize, (OFFSET_UIMAGE + m_nStagedMaxSize), m_nFlashSize);
+
+	if ((OFFSET_UIMAGE + m_nStagedMaxSize) > m_nFlashSize) {
+		printf("error: flash size %d > %d\n", (OFFSET_UIMAGE + m_nStagedMaxSize), m_nFlashSize);
+		m_bStagedError = true;
+		DEBUG_EXIT
+		return false;
+	}
+
+	if (m_pStagedEqual != 0) {
+		delete[] m_pStagedEqual;
+	}
+
+	m_pStagedEqual = new uint8_t[m_nStagedMaxSize / nSectorSize];
+	assert(m_pStagedEqual != 0);
+
+	DEBUG_EXIT
+	return true;
+}
+
+bool SpiFlashInstall::IsFlashEqual(uint32_t nOffset, const uint8_t *pBuffer, uint32_t nLength) {
+	uint8_t aChunk[STAGED_COMPARE_CHUNK] ALIGNED;
+
+	for (uint32_t i = 0; i < nLength; i += STAGED_COMPARE_CHUNK) {
+		const uint32_t nChunk = (nLength - i) < STAGED_COMPARE_CHUNK ? (nLength - i) : STAGED_COMPARE_CHUNK;
+
+		if (spi_flash_cmd_read_fast(OFFSET_UIMAGE + nOffset + i, nChunk, aChunk) < 0) {
+			return false;
+		}
+
+		if (memcmp(aChunk, &pBuffer[nOffset + i], nChunk) != 0) {
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/*
+ * The installed image is not touched before the transfer has completed and
+ * the image is validated, an aborted transfer leaves the node bootable.
+ * The compare of the completed sectors overlaps with the network receive,
+ * afterwards only the sectors that differ are erased and written.
+ */
+bool SpiFlashInstall::WriteFirmwareRun(const uint8_t *pBuffer, uint32_t nSize, bool bIsLast) {
+	if (__builtin_expect((m_bStagedError || (nSize == 0)), 0)) {
+		return false;
+	}
+
+	assert(pBuffer != 0);
+
+	if (nSize > m_nStagedMaxSize) {
+		printf("error: firmware size %d > %d\n", nSize, m_nStagedMaxSize);
+		m_bStagedError = true;
+		return false;
+	}
+
+	const uint32_t nSectorSize = spi_flash_get_sector_size();
+
+	if (!bIsLast) {
+		if ((m_nStagedCompared + nSectorSize) <= nSize) {
+			m_pStagedEqual[m_nStagedCompared / nSectorSize] = IsFlashEqual(m_nStagedCompared, pBuffer, nSectorSize);
+			m_nStagedCompared += nSectorSize;
+			return true;
+		}
+
+		return false;
+	}
+
+	if (m_nStagedWritten >= nSize) {
+		return false;
+	}
+
+	const uint32_t nLength = (nSize - m_nStagedWritten) < nSectorSize ? (nSize - m_nStagedWritten) : nSectorSize;
+
+	if ((m_nStagedWritten < m_nStagedCompared) && m_pStagedEqual[m_nStagedWritten / nSectorSize]) {
+		m_nStagedWritten += nLength;
+		return true;
+	}
+
+	DEBUG_PRINTF("Write %x:%d", OFFSET_UIMAGE + m_nStagedWritten, nLength);
+
+	if (spi_flash_cmd_erase(OFFSET_UIMAGE + m_nStagedWritten, nSectorSize) < 0) {
+		printf("error: flash erase\n");
+		m_bStagedError = true;
+		return false;
+	}
+
+	if (spi_flash_cmd_write_multi(OFFSET_UIMAGE + m_nStagedWritten, nLength, &pBuffer[m_nStagedWritten]) < 0) {
+		printf("error: flash write\n");
+		m_bStagedError = true;
+		return false;
+	}
+
+	if (!IsFlashEqual(m_nStagedWritten, pBuffer, nLength)) {
+		printf("error: flash verify\n");
+		m_bStagedError = true;
+		return false;
+	}
+
+	m_nStagedWritten += nLength;
+	return true;
+}
+
+bool SpiFlashInstall::WriteFirmwareEnd(const uint8_t *pBuffer, uint32_t nSize) {
+	DEBUG_ENTRY
+
+	while (WriteFirmwareRun(pBuffer, nSize, true))
+		;
+
+	const bool bSucces = (!m_bStagedError) && (m_nStagedWritten == nSize);
+
+	DEBUG_PRINTF("m_nStagedWritten=%d, nSize=%d, bSucces=%d", m_nStagedWritten, nSize, bSucces);
+
+	m_bStagedError = true;
+
+	if (bSucces) {
+		Display::Get()->Status(DISPLAY_7SEGMENT_MSG_INFO_SPI_DONE);
+	}
+
+	DEBUG_EXIT
+	return bSucces;
+}
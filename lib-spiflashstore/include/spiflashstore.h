@@ -34,6 +34,9 @@
 #include "storeartnet4.h"
 
 #define SPI_FLASH_STORE_SIZE	4096
+#if !defined (SPI_FLASH_STORE_SECTORS)
+ #define SPI_FLASH_STORE_SECTORS	4	///< Ring of journal sectors at the end of the flash
+#endif
 
 enum TStore {
 	STORE_NETWORK,
@@ -91,7 +94,13 @@ public:
 
 private:
 	bool Init(void);
+	bool Load(void);
+	bool LoadLegacy(void);
 	uint32_t GetStoreOffset(enum TStore tStore);
+	void SetDirty(uint32_t nIndex, uint32_t nStart, uint32_t nEnd);
+	bool Append(uint32_t nOffset, uint32_t nLength);
+	void WriteRecord(uint32_t nAddress, uint32_t nOffset, uint32_t nLength);
+	void Compact(void);
 
 public:
 	static SpiFlashStore* Get(void) {
@@ -109,6 +118,17 @@ private:
 	uint32_t m_nSpiFlashStoreSize;
 	TStoreState m_tState;
 
+	// Journal
+	uint32_t m_nSector;			///< Sector in the ring with the newest snapshot
+	uint32_t m_nGeneration;		///< Generation of that sector
+	uint32_t m_nSequence;		///< Next record sequence number
+	uint32_t m_nWriteOffset;	///< Next record in the sector
+	bool m_bCompact;			///< The next Flash starts a new sector with a snapshot
+	struct TDirty {
+		uint16_t nStart;
+		uint16_t nEnd;
+	} m_aDirty[STORE_LAST + 1];	///< Changed range per store, the last one is the header with the UUID
+
 	StoreNetwork m_StoreNetwork;
 	StoreArtNet m_StoreArtNet;
 	StoreArtNet4 m_StoreArtNet4;
@@ -25,6 +25,7 @@
 
 #include <stdint.h>
 #include <stdio.h>
+#include <string.h>
 #include <assert.h>
 
 #include "spiflashstore.h"
@@ -42,13 +43,71 @@ static const uint32_t s_aStorSize[STORE_LAST]  = {96,        144,       32,    6
 static const char s_aStoreName[STORE_LAST][12] = {"Network", "Art-Net3", "DMX", "WS28xx", "E1.31", "LTC", "MIDI", "Art-Net4", "OSC Server", "TLC59711", "USB Pro", "RDM Device", "RConfig", "TCNet", "OSC Client", "Display", "SparkFun"};
 #endif
 
+/*
+ * The store is a journal in a ring of SPI_FLASH_STORE_SECTORS sectors.
+ * A sector starts with a complete snapshot of the store data, followed by
+ * records with the changed ranges only. When a sector is full, the next one
+ * in the ring is erased and gets a new snapshot. The sector header is written
+ * after the snapshot, so at power-fail the previous sector is still valid.
+ */
+
+static const uint8_t s_aJournalMagic[] = {'A', 'v', 'V', 'J'};
+
+struct TJournalSector {
+	uint8_t aMagic[4];
+	uint32_t nGeneration;
+	uint32_t nCrc;				///< Over aMagic and nGeneration
+	uint32_t nReserved;
+};
+
+struct TJournalRecord {
+	uint32_t nSequence;
+	uint16_t nOffset;			///< In m_aSpiFlashData
+	uint16_t nLength;
+	uint32_t nCrc;				///< Over nSequence, nOffset, nLength and the data
+};
+
+#define JOURNAL_RECORD_SIZE(x)	(sizeof(struct TJournalRecord) + (((x) + 3) & ~3U))
+#define JOURNAL_READ_CHUNK		64
+
+static uint32_t crc32_update(uint32_t nCrc, const uint8_t *pData, uint32_t nLength) {
+	for (uint32_t i = 0; i < nLength; i++) {
+		nCrc ^= pData[i];
+
+		for (uint32_t j = 0; j < 8; j++) {
+			nCrc = (nCrc >> 1) ^ (0xEDB88320 & (-(nCrc & 1)));
+		}
+	}
+
+	return nCrc;
+}
+
 SpiFlashStore *SpiFlashStore::s_pThis = 0;
 
-SpiFlashStore::SpiFlashStore(void): m_bHaveFlashChip(false), m_bIsNew(false), m_nStartAddress(0), m_nSpiFlashStoreSize(SPI_FLASH_STORE_SIZE), m_tState(STORE_STATE_IDLE) {
+SpiFlashStore::SpiFlashStore(void):
+	m_bHaveFlashChip(false),
+	m_bIsNew(false),
+	m_nStartAddress(0),
+	m_nSpiFlashStoreSize(OFFSET_STORES),
+	m_tState(STORE_STATE_IDLE),
+	m_nSector(SPI_FLASH_STORE_SECTORS - 1),
+	m_nGeneration(0),
+	m_nSequence(0),
+	m_nWriteOffset(SPI_FLASH_STORE_SIZE),
+	m_bCompact(true)
+{
 	DEBUG_ENTRY
 
 	s_pThis = this;
 
+	memset(m_aDirty, 0, sizeof(m_aDirty));
+
+	for (uint32_t j = 0; j < STORE_LAST; j++) {
+		m_nSpiFlashStoreSize += s_aStorSize[j];
+	}
+
+	assert(JOURNAL_RECORD_SIZE(m_nSpiFlashStoreSize) + sizeof(struct TJournalSector) <= SPI_FLASH_STORE_SIZE);
+
 	if (spi_flash_probe(0, 0, 0) < 0) {
 		DEBUG_PUTS("No SPI flash chip");
 	} else {
@@ -57,12 +116,6 @@ SpiFlashStore::SpiFlashStore(void): m_bHaveFlashChip(false), m_bIsNew(false), m_
 	}
 
 	if (m_bHaveFlashChip) {
-		m_nSpiFlashStoreSize = OFFSET_STORES;
-
-		for (uint32_t j = 0; j < STORE_LAST; j++) {
-			m_nSpiFlashStoreSize += s_aStorSize[j];
-		}
-
 		DEBUG_PRINTF("OFFSET_STORES=%d", (int) OFFSET_STORES);
 		DEBUG_PRINTF("m_nSpiFlashStoreSize=%d", m_nSpiFlashStoreSize);
 
@@ -89,29 +142,21 @@ bool SpiFlashStore::Init(void) {
 		return false;
 	}
 
-	m_nStartAddress = spi_flash_get_size() - nEraseSize;
+	m_nStartAddress = spi_flash_get_size() - SPI_FLASH_STORE_SECTORS * nEraseSize;
 	assert(!(m_nStartAddress % nEraseSize));
 
 	if (m_nStartAddress % nEraseSize) {
 		return false;
 	}
 
-	spi_flash_cmd_read_fast(m_nStartAddress, (size_t) SPI_FLASH_STORE_SIZE, (void *) &m_aSpiFlashData);
-
-	bool bSignatureOK = true;
-
-	for (uint32_t i = 0; i < sizeof(s_aSignature); i++) {
-		if (s_aSignature[i] != m_aSpiFlashData[i]) {
-			m_aSpiFlashData[i] = s_aSignature[i];
-			bSignatureOK = false;
-		}
-	}
-
-	if (__builtin_expect(!bSignatureOK, 0)) {
+	if (!Load() && !LoadLegacy()) {
 		DEBUG_PUTS("No signature");
 
 		m_bIsNew = true;
 
+		memset(m_aSpiFlashData, 0xFF, sizeof(m_aSpiFlashData));
+		memcpy(m_aSpiFlashData, s_aSignature, sizeof(s_aSignature));
+
 		// Clear bSetList
 		for (uint32_t j = 0; j < STORE_LAST; j++) {
 			const uint32_t nOffset = GetStoreOffset((enum TStore) j);
@@ -120,20 +165,17 @@ bool SpiFlashStore::Init(void) {
 			m_aSpiFlashData[k++] = 0x00;
 			m_aSpiFlashData[k++] = 0x00;
 			m_aSpiFlashData[k++] = 0x00;
-
-			// Clear rest of data
-			for (; k < nOffset + s_aStorSize[j]; k++) {
-				m_aSpiFlashData[k] = 0xFF;
-			}
 		}
 
+		m_bCompact = true;
 		m_tState = STORE_STATE_CHANGED;
 
 		return true;
 	}
 
 	for (uint32_t j = 0; j < STORE_LAST; j++) {
-		uint8_t *pbSetList = &m_aSpiFlashData[GetStoreOffset((enum TStore) j)];
+		const uint32_t nOffset = GetStoreOffset((enum TStore) j);
+		uint8_t *pbSetList = &m_aSpiFlashData[nOffset];
 		if ((pbSetList[0] == 0xFF) && (pbSetList[1] == 0xFF) && (pbSetList[2] == 0xFF) && (pbSetList[3] == 0xFF)) {
 			DEBUG_PRINTF("[%s]: bSetList \'FF...FF\'", s_aStoreName[j]);
 			// Clear bSetList
@@ -142,6 +184,7 @@ bool SpiFlashStore::Init(void) {
 			*pbSetList++ = 0x00;
 			*pbSetList = 0x00;
 
+			SetDirty(j, nOffset, nOffset + 4);
 			m_tState = STORE_STATE_CHANGED;
 		}
 	}
@@ -149,6 +192,121 @@ bool SpiFlashStore::Init(void) {
 	return true;
 }
 
+/*
+ * Rebuild the store data from the newest valid sector in the ring.
+ */
+bool SpiFlashStore::Load(void) {
+	struct TJournalSector Sector;
+	uint32_t nBest = SPI_FLASH_STORE_SECTORS;
+
+	for (uint32_t i = 0; i < SPI_FLASH_STORE_SECTORS; i++) {
+		spi_flash_cmd_read_fast(m_nStartAddress + i * SPI_FLASH_STORE_SIZE, sizeof(struct TJournalSector), (void *) &Sector);
+
+		if (memcmp(Sector.aMagic, s_aJournalMagic, sizeof(s_aJournalMagic)) != 0) {
+			continue;
+		}
+
+		if (Sector.nCrc != ~crc32_update(0xFFFFFFFF, (const uint8_t *) &Sector, 8)) {
+			continue;
+		}
+
+		if ((nBest == SPI_FLASH_STORE_SECTORS) || ((int32_t) (Sector.nGeneration - m_nGeneration) > 0)) {
+			nBest = i;
+			m_nGeneration = Sector.nGeneration;
+		}
+	}
+
+	if (nBest == SPI_FLASH_STORE_SECTORS) {
+		return false;
+	}
+
+	DEBUG_PRINTF("Sector %d, generation %d", nBest, m_nGeneration);
+
+	m_nSector = nBest;
+	m_bCompact = false;
+
+	memset(m_aSpiFlashData, 0xFF, sizeof(m_aSpiFlashData));
+
+	const uint32_t nSectorAddress = m_nStartAddress + m_nSector * SPI_FLASH_STORE_SIZE;
+	uint32_t nOffset = sizeof(struct TJournalSector);
+
+	while ((nOffset + sizeof(struct TJournalRecord)) <= SPI_FLASH_STORE_SIZE) {
+		struct TJournalRecord Record;
+
+		spi_flash_cmd_read_fast(nSectorAddress + nOffset, sizeof(struct TJournalRecord), (void *) &Record);
+
+		if ((Record.nSequence == 0xFFFFFFFF) && (Record.nOffset == 0xFFFF) && (Record.nLength == 0xFFFF)) {
+			break;	// Erased, this is the end of the journal
+		}
+
+		if (((Record.nOffset + Record.nLength) > m_nSpiFlashStoreSize) || ((nOffset + JOURNAL_RECORD_SIZE(Record.nLength)) > SPI_FLASH_STORE_SIZE)) {
+			m_bCompact = true;
+			break;
+		}
+
+		const uint32_t nDataAddress = nSectorAddress + nOffset + sizeof(struct TJournalRecord);
+		uint32_t nCrc = crc32_update(0xFFFFFFFF, (const uint8_t *) &Record, 8);
+
+		for (uint32_t i = 0; i < Record.nLength; i += JOURNAL_READ_CHUNK) {
+			uint8_t aChunk[JOURNAL_READ_CHUNK];
+			const uint32_t nChunk = (Record.nLength - i) < JOURNAL_READ_CHUNK ? (Record.nLength - i) : JOURNAL_READ_CHUNK;
+
+			spi_flash_cmd_read_fast(nDataAddress + i, nChunk, (void *) aChunk);
+			nCrc = crc32_update(nCrc, aChunk, nChunk);
+		}
+
+		if (Record.nCrc != ~nCrc) {
+			DEBUG_PRINTF("Record %d : CRC error", Record.nSequence);
+			// Torn write, the next Flash starts a new sector
+			m_bCompact = true;
+			break;
+		}
+
+		spi_flash_cmd_read_fast(nDataAddress, Record.nLength, (void *) &m_aSpiFlashData[Record.nOffset]);
+
+		m_nSequence = Record.nSequence + 1;
+		nOffset += JOURNAL_RECORD_SIZE(Record.nLength);
+	}
+
+	m_nWriteOffset = nOffset;
+
+	DEBUG_PRINTF("m_nWriteOffset=%d, m_nSequence=%d", m_nWriteOffset, m_nSequence);
+
+	for (uint32_t i = 0; i < sizeof(s_aSignature); i++) {
+		if (s_aSignature[i] != m_aSpiFlashData[i]) {
+			return false;
+		}
+	}
+
+	if (m_bCompact) {
+		m_tState = STORE_STATE_CHANGED;
+	}
+
+	return true;
+}
+
+/*
+ * The single sector store of the previous firmware, it is the last sector
+ * of the ring. It is migrated into the journal with the first Flash.
+ */
+bool SpiFlashStore::LoadLegacy(void) {
+	spi_flash_cmd_read_fast(m_nStartAddress + (SPI_FLASH_STORE_SECTORS - 1) * SPI_FLASH_STORE_SIZE, (size_t) SPI_FLASH_STORE_SIZE, (void *) &m_aSpiFlashData);
+
+	for (uint32_t i = 0; i < sizeof(s_aSignature); i++) {
+		if (s_aSignature[i] != m_aSpiFlashData[i]) {
+			return false;
+		}
+	}
+
+	DEBUG_PUTS("Legacy store");
+
+	m_nSector = SPI_FLASH_STORE_SECTORS - 1;
+	m_bCompact = true;
+	m_tState = STORE_STATE_CHANGED;
+
+	return true;
+}
+
 uint32_t SpiFlashStore::GetStoreOffset(enum TStore tStore) {
 	assert(tStore < STORE_LAST);
 
@@ -185,8 +343,15 @@ void SpiFlashStore::Update(enum TStore tStore, uint32_t nOffset, void* pData, ui
 	const uint8_t *src = (uint8_t *) pData;
 	uint8_t *dst = (uint8_t *) &m_aSpiFlashData[nBase];
 
+	uint32_t nFirst = 0;
+	uint32_t nLast = 0;
+
 	for (uint32_t i = 0; i < nDataLength; i++) {
 		if (*src != *dst) {
+			if (!bIsChanged) {
+				nFirst = i;
+			}
+			nLast = i;
 			bIsChanged = true;
 			*dst = *src;
 		}
@@ -198,11 +363,19 @@ void SpiFlashStore::Update(enum TStore tStore, uint32_t nOffset, void* pData, ui
 		m_tState = STORE_STATE_CHANGED;
 	}
 
+	if (bIsChanged) {
+		SetDirty(tStore, nBase + nFirst, nBase + nLast + 1);
+	}
+
 	if ((0 != nOffset) && (bIsChanged)) {
 		assert(bSetList != 0);
 
-		uint32_t *p = (uint32_t *) &m_aSpiFlashData[GetStoreOffset(tStore)];
+		const uint32_t nStoreOffset = GetStoreOffset(tStore);
+
+		uint32_t *p = (uint32_t *) &m_aSpiFlashData[nStoreOffset];
 		*p |= bSetList;
+
+		SetDirty(tStore, nStoreOffset, nStoreOffset + 4);
 	}
 
 	DEBUG_PRINTF("m_tState=%d", m_tState);
@@ -284,6 +457,82 @@ void SpiFlashStore::Dump(void) {
 #endif
 }
 
+void SpiFlashStore::SetDirty(uint32_t nIndex, uint32_t nStart, uint32_t nEnd) {
+	assert(nIndex <= STORE_LAST);
+	assert(nStart < nEnd);
+
+	struct TDirty *p = &m_aDirty[nIndex];
+
+	if (p->nEnd == 0) {
+		p->nStart = (uint16_t) nStart;
+		p->nEnd = (uint16_t) nEnd;
+		return;
+	}
+
+	if (nStart < p->nStart) {
+		p->nStart = (uint16_t) nStart;
+	}
+
+	if (nEnd > p->nEnd) {
+		p->nEnd = (uint16_t) nEnd;
+	}
+}
+
+void SpiFlashStore::WriteRecord(uint32_t nAddress, uint32_t nOffset, uint32_t nLength) {
+	struct TJournalRecord Record;
+
+	Record.nSequence = m_nSequence++;
+	Record.nOffset = (uint16_t) nOffset;
+	Record.nLength = (uint16_t) nLength;
+
+	const uint32_t nCrc = crc32_update(0xFFFFFFFF, (const uint8_t *) &Record, 8);
+	Record.nCrc = ~crc32_update(nCrc, &m_aSpiFlashData[nOffset], nLength);
+
+	spi_flash_cmd_write_multi(nAddress, sizeof(struct TJournalRecord), (const void *) &Record);
+	spi_flash_cmd_write_multi(nAddress + sizeof(struct TJournalRecord), nLength, (const void *) &m_aSpiFlashData[nOffset]);
+}
+
+bool SpiFlashStore::Append(uint32_t nOffset, uint32_t nLength) {
+	if (m_bCompact || ((m_nWriteOffset + JOURNAL_RECORD_SIZE(nLength)) > SPI_FLASH_STORE_SIZE)) {
+		return false;
+	}
+
+	DEBUG_PRINTF("Append %d:%d at %d", nOffset, nLength, m_nWriteOffset);
+
+	WriteRecord(m_nStartAddress + m_nSector * SPI_FLASH_STORE_SIZE + m_nWriteOffset, nOffset, nLength);
+
+	m_nWriteOffset += JOURNAL_RECORD_SIZE(nLength);
+
+	return true;
+}
+
+/*
+ * The next sector in the ring is erased. Write the snapshot, then the sector header.
+ */
+void SpiFlashStore::Compact(void) {
+	const uint32_t nSector = (m_nSector + 1) % SPI_FLASH_STORE_SECTORS;
+	const uint32_t nSectorAddress = m_nStartAddress + nSector * SPI_FLASH_STORE_SIZE;
+
+	WriteRecord(nSectorAddress + sizeof(struct TJournalSector), 0, m_nSpiFlashStoreSize);
+
+	struct TJournalSector Sector;
+
+	memcpy(Sector.aMagic, s_aJournalMagic, sizeof(s_aJournalMagic));
+	Sector.nGeneration = ++m_nGeneration;
+	Sector.nCrc = ~crc32_update(0xFFFFFFFF, (const uint8_t *) &Sector, 8);
+	Sector.nReserved = 0xFFFFFFFF;
+
+	spi_flash_cmd_write_multi(nSectorAddress, sizeof(struct TJournalSector), (const void *) &Sector);
+
+	DEBUG_PRINTF("Sector %d, generation %d", nSector, m_nGeneration);
+
+	m_nSector = nSector;
+	m_nWriteOffset = sizeof(struct TJournalSector) + JOURNAL_RECORD_SIZE(m_nSpiFlashStoreSize);
+	m_bCompact = false;
+
+	memset(m_aDirty, 0, sizeof(m_aDirty));
+}
+
 bool SpiFlashStore::Flash(void) {
 	if (__builtin_expect((m_tState == STORE_STATE_IDLE), 1)) {
 		return false;
@@ -301,12 +550,28 @@ bool SpiFlashStore::Flash(void) {
 
 	switch (m_tState) {
 		case STORE_STATE_CHANGED:
-			spi_flash_cmd_erase(m_nStartAddress, (size_t) SPI_FLASH_STORE_SIZE);
+			// Only the changed ranges are appended, no erase
+			for (uint32_t j = 0; (j <= STORE_LAST) && (!m_bCompact); j++) {
+				if (m_aDirty[j].nEnd != 0) {
+					if (Append(m_aDirty[j].nStart, m_aDirty[j].nEnd - m_aDirty[j].nStart)) {
+						m_aDirty[j].nEnd = 0;
+					} else {
+						m_bCompact = true;
+					}
+				}
+			}
+
+			if (!m_bCompact) {
+				m_tState = STORE_STATE_IDLE;
+				break;
+			}
+
+			spi_flash_cmd_erase(m_nStartAddress + ((m_nSector + 1) % SPI_FLASH_STORE_SECTORS) * SPI_FLASH_STORE_SIZE, (size_t) SPI_FLASH_STORE_SIZE);
 			m_tState = STORE_STATE_ERASED;
 			return true;
 			break;
 		case STORE_STATE_ERASED:
-			spi_flash_cmd_write_multi(m_nStartAddress, (size_t) m_nSpiFlashStoreSize, (const void *)&m_aSpiFlashData);
+			Compact();
 			m_tState = STORE_STATE_IDLE;
 			break;
 		default:
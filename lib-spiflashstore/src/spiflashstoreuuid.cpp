@@ -42,6 +42,10 @@ void SpiFlashStore::UuidUpdate(const uuid_t uuid) {
 		src++;
 	}
 
+	if (bIsChanged) {
+		SetDirty(STORE_LAST, 16, 16 + sizeof(uuid_t));
+	}
+
 	if (bIsChanged && (m_tState != STORE_STATE_ERASED)) {
 		m_tState = STORE_STATE_CHANGED;
 	}
@@ -29,6 +29,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+#define TFTP_BLKSIZE_DEFAULT	512		///< RFC 1350
+#define TFTP_BLKSIZE_MAX		1468	///< Fits in an Ethernet frame
+
+#if !defined (TFTP_WINDOWSIZE_MAX)
+ #define TFTP_WINDOWSIZE_MAX	8		///< RFC 7440, also the receive queue depth
+#endif
+
 enum TTFTPMode {
 	TFTP_MODE_BINARY,
 	TFTP_MODE_ASCII
@@ -47,7 +54,16 @@ public:
 	virtual int FileRead(void *pBuffer, unsigned nCount, unsigned nBlockNumber)=0;
 	virtual int FileWrite(const void *pBuffer, unsigned nCount, unsigned nBlockNumber)=0;
 
+	/**
+	 * The negotiated block size, nBlockNumber of FileRead/FileWrite is in these units.
+	 */
+	uint16_t GetBlockSize(void) const {
+		return m_nBlockSize;
+	}
+
 private:
+	bool ParseOptions(const char *pOptions, const char *pEnd);
+	void SendOptionAck(void);
 	void HandleRequest(void);
 	void HandleRecvAck(void);
 	void HandleRecvData(void);
@@ -58,14 +74,19 @@ private:
 private:
 	int m_nState;
 	int m_nIdx;
-	uint8_t m_Buffer[528];
+	uint8_t m_Buffer[4 + TFTP_BLKSIZE_MAX];
 	uint32_t m_nFromIp;
 	uint16_t m_nFromPort;
 	uint16_t m_nLength;
 	uint16_t m_nBlockNumber;
 	uint16_t m_nDataLength;
 	uint16_t m_nPacketLength;
+	uint16_t m_nBlockSize;
+	uint16_t m_nWindowSize;
+	uint16_t m_nWindowCount;
 	bool m_bIsLastBlock;
+	bool m_bHaveOptions;
+	bool m_bIsGap;
 };
 
 #endif /* TFTPDAEMON_H_ */
@@ -25,9 +25,13 @@
 
 /*
  * https://tools.ietf.org/html/rfc1350
+ * https://tools.ietf.org/html/rfc2347 Option Extension
+ * https://tools.ietf.org/html/rfc2348 Blocksize Option
+ * https://tools.ietf.org/html/rfc7440 Windowsize Option
  */
 
 #include <stdint.h>
+#include <stdio.h>
 #include <string.h>
 #include <assert.h>
 
@@ -50,7 +54,8 @@ enum TOpCode {
 	OP_CODE_WRQ = 2,			///< Write request (WRQ)
 	OP_CODE_DATA = 3,			///< Data (DATA)
 	OP_CODE_ACK = 4,			///< Acknowledgment (ACK)
-	OP_CODE_ERROR = 5			///< Error (ERROR)
+	OP_CODE_ERROR = 5,			///< Error (ERROR)
+	OP_CODE_OACK = 6			///< Option Acknowledgment (OACK)
 };
 
 enum TErrorCode {
@@ -69,8 +74,13 @@ enum TErrorCode {
 #define MAX_MODE_LEN			16
 #define MIN_FILENAME_MODE_LEN	(1+1+1+1)
 #define MAX_FILENAME_MODE_LEN	(MAX_FILENAME_LEN+1+MAX_MODE_LEN+1)
-#define MAX_DATA_LEN			512
+#define MAX_DATA_LEN			TFTP_BLKSIZE_MAX
 #define MAX_ERRMSG_LEN			128
+#define MIN_BLKSIZE				8
+
+#ifndef MIN
+ #define MIN(a, b) ((a) < (b) ? (a) : (b))
+#endif
 
 #if  !defined (PACKED)
  #define PACKED __attribute__((packed))
@@ -107,7 +117,12 @@ TFTPDaemon::TFTPDaemon(void):
 		m_nBlockNumber(0),
 		m_nDataLength(0),
 		m_nPacketLength(0),
-		m_bIsLastBlock(false)
+		m_nBlockSize(TFTP_BLKSIZE_DEFAULT),
+		m_nWindowSize(1),
+		m_nWindowCount(0),
+		m_bIsLastBlock(false),
+		m_bHaveOptions(false),
+		m_bIsGap(false)
 {
 	assert(Network::Get() != 0);
 	memset(m_Buffer, 0, sizeof(m_Buffer));
@@ -130,8 +145,13 @@ bool TFTPDaemon::Run(void) {
 		DEBUG_PRINTF("m_nIdx=%d", m_nIdx);
 
 		m_nBlockNumber = 0;
+		m_nBlockSize = TFTP_BLKSIZE_DEFAULT;
+		m_nWindowSize = 1;
+		m_nWindowCount = 0;
 		m_nState = STATE_WAITING_RQ;
 		m_bIsLastBlock = false;
+		m_bHaveOptions = false;
+		m_bIsGap = false;
 		memset(&m_Buffer, 0, sizeof(struct TTFTPReqPacket));
 	} else {
 		m_nLength = Network::Get()->RecvFrom(m_nIdx, (uint8_t *) &m_Buffer, sizeof(m_Buffer), &m_nFromIp, &m_nFromPort);
@@ -151,7 +171,7 @@ bool TFTPDaemon::Run(void) {
 			}
 			break;
 		case STATE_WRQ_RECV_PACKET:
-			if (m_nLength <= sizeof(struct TTFTPDataPacket)) {
+			if ((m_nLength >= 4) && (m_nLength <= (4 + m_nBlockSize))) {
 				HandleRecvData();
 			}
 			break;
@@ -165,9 +185,82 @@ bool TFTPDaemon::Run(void) {
 	return true;
 }
 
+/*
+ * Accepted options are stored, unknown options and values are ignored (RFC 2347).
+ */
+bool TFTPDaemon::ParseOptions(const char *pOptions, const char *pEnd) {
+	bool bHaveOptions = false;
+
+	while (pOptions < pEnd) {
+		const char *pName = pOptions;
+		const char *pValue = pName + strlen(pName) + 1;
+
+		if (pValue >= pEnd) {
+			break;
+		}
+
+		pOptions = pValue + strlen(pValue) + 1;
+
+		uint32_t nValue = 0;
+		const char *p = pValue;
+
+		while ((*p >= '0') && (*p <= '9') && (nValue <= 0xFFFF)) {
+			nValue = nValue * 10 + (uint32_t) (*p++ - '0');
+		}
+
+		if ((p == pValue) || (*p != '\0')) {
+			continue;
+		}
+
+		DEBUG_PRINTF("%s=%d", pName, (int) nValue);
+
+		if (strcasecmp(pName, "blksize") == 0) {
+			if (nValue >= MIN_BLKSIZE) {
+				m_nBlockSize = nValue < TFTP_BLKSIZE_MAX ? (uint16_t) nValue : TFTP_BLKSIZE_MAX;
+				bHaveOptions = true;
+			}
+		} else if (strcasecmp(pName, "windowsize") == 0) {
+			if (nValue >= 1) {
+				m_nWindowSize = nValue < TFTP_WINDOWSIZE_MAX ? (uint16_t) nValue : TFTP_WINDOWSIZE_MAX;
+				bHaveOptions = true;
+			}
+		}
+	}
+
+	return bHaveOptions;
+}
+
+void TFTPDaemon::SendOptionAck(void) {
+	char *p = (char *) &m_Buffer[2];
+
+	m_Buffer[0] = 0;
+	m_Buffer[1] = OP_CODE_OACK;
+
+	if (m_nBlockSize != TFTP_BLKSIZE_DEFAULT) {
+		p += sprintf(p, "blksize") + 1;
+		p += sprintf(p, "%d", m_nBlockSize) + 1;
+	}
+
+	if (m_nWindowSize != 1) {
+		p += sprintf(p, "windowsize") + 1;
+		p += sprintf(p, "%d", m_nWindowSize) + 1;
+	}
+
+	DEBUG_PRINTF("Sending OACK to " IPSTR ":%d, m_nBlockSize=%d, m_nWindowSize=%d", IP2STR(m_nFromIp), m_nFromPort, m_nBlockSize, m_nWindowSize);
+
+	Network::Get()->SendTo(m_nIdx, (uint8_t *) &m_Buffer, (uint16_t) (p - (char *) m_Buffer), m_nFromIp, m_nFromPort);
+}
+
 void TFTPDaemon::HandleRequest(void) {
 	struct TTFTPReqPacket *packet = (struct TTFTPReqPacket *) &m_Buffer;
 
+	if (m_nLength >= sizeof(m_Buffer)) {
+		SendError(ERROR_CODE_ILL_OPER, "Invalid operation");
+		return;
+	}
+
+	m_Buffer[m_nLength] = '\0';
+
 	const uint16_t nOpCode = __builtin_bswap16(packet->OpCode);
 
 	if ((nOpCode != OP_CODE_RRQ && nOpCode != OP_CODE_WRQ)) {
@@ -197,6 +290,8 @@ void TFTPDaemon::HandleRequest(void) {
 
 	DEBUG_PRINTF("Incoming %s request from " IPSTR " %s %s", nOpCode == OP_CODE_RRQ ? "read" : "write", IP2STR(m_nFromIp), pFileName, pMode);
 
+	m_bHaveOptions = ParseOptions(pMode + strlen(pMode) + 1, (const char *) &m_Buffer[m_nLength]);
+
 	switch (nOpCode) {
 		case OP_CODE_RRQ:
 			if(!FileOpen(pFileName, tMode)) {
@@ -204,9 +299,15 @@ void TFTPDaemon::HandleRequest(void) {
 				m_nState = STATE_WAITING_RQ;
 			} else {
 				Network::Get()->End(TFTP_UDP_PORT);
-				m_nIdx = Network::Get()->Begin(m_nFromPort);
-				m_nState = STATE_RRQ_SEND_PACKET;
-				DoRead();
+				m_nIdx = Network::Get()->BeginDepth(m_nFromPort, m_nWindowSize);
+				if (m_bHaveOptions) {
+					// The client acknowledges the OACK with block 0
+					SendOptionAck();
+					m_nState = STATE_RRQ_RECV_ACK;
+				} else {
+					m_nState = STATE_RRQ_SEND_PACKET;
+					DoRead();
+				}
 			}
 			break;
 		case OP_CODE_WRQ:
@@ -215,9 +316,15 @@ void TFTPDaemon::HandleRequest(void) {
 				m_nState = STATE_WAITING_RQ;
 			} else {
 				Network::Get()->End(TFTP_UDP_PORT);
-				m_nIdx = Network::Get()->Begin(m_nFromPort);
-				m_nState = STATE_WRQ_SEND_ACK;
-				DoWriteAck();
+				m_nIdx = Network::Get()->BeginDepth(m_nFromPort, m_nWindowSize);
+				if (m_bHaveOptions) {
+					// The OACK replaces the ACK of block 0
+					SendOptionAck();
+					m_nState = STATE_WRQ_RECV_PACKET;
+				} else {
+					m_nState = STATE_WRQ_SEND_ACK;
+					DoWriteAck();
+				}
 			}
 			break;
 		default:
@@ -231,26 +338,26 @@ void TFTPDaemon::SendError (uint16_t nErrorCode, const char *pErrorMessage) {
 
 	ErrorPacket.OpCode = __builtin_bswap16 (OP_CODE_ERROR);
 	ErrorPacket.ErrorCode = __builtin_bswap16 (nErrorCode);
-	strncpy(ErrorPacket.ErrMsg, pErrorMessage, sizeof(ErrorPacket.ErrMsg));
 
-	Network::Get()->SendTo(m_nIdx, (uint8_t *)&ErrorPacket, sizeof ErrorPacket, m_nFromIp, m_nFromPort);
+	const uint32_t nMessageLength = MIN(strlen(pErrorMessage), sizeof(ErrorPacket.ErrMsg) - 1);
+	memcpy(ErrorPacket.ErrMsg, pErrorMessage, nMessageLength);
+	ErrorPacket.ErrMsg[nMessageLength] = '\0';
+
+	// Only the message and its terminating zero are sent
+	Network::Get()->SendTo(m_nIdx, (uint8_t *)&ErrorPacket, (uint16_t) (4 + nMessageLength + 1), m_nFromIp, m_nFromPort);
 }
 
 void TFTPDaemon::DoRead(void) {
 	struct TTFTPDataPacket *packet = (struct TTFTPDataPacket *) &m_Buffer;
 
 	if (m_nState == STATE_RRQ_SEND_PACKET) {
-		m_nDataLength = FileRead(packet->Data, MAX_DATA_LEN, ++m_nBlockNumber);
+		m_nDataLength = FileRead(packet->Data, m_nBlockSize, ++m_nBlockNumber);
 
 		packet->OpCode = __builtin_bswap16(OP_CODE_DATA);
 		packet->BlockNumber = __builtin_bswap16(m_nBlockNumber);
 
 		m_nPacketLength = sizeof packet->OpCode + sizeof packet->BlockNumber + m_nDataLength;
-		m_bIsLastBlock = m_nDataLength < MAX_DATA_LEN;
-
-		if (m_bIsLastBlock) {
-			FileClose();
-		}
+		m_bIsLastBlock = m_nDataLength < m_nBlockSize;
 
 		DEBUG_PRINTF("m_nDataLength=%d, m_nPacketLength=%d, m_bIsLastBlock=%d", m_nDataLength, m_nPacketLength, m_bIsLastBlock);
 	}
@@ -259,18 +366,37 @@ void TFTPDaemon::DoRead(void) {
 
 	Network::Get()->SendTo(m_nIdx, (uint8_t *) &m_Buffer, m_nPacketLength, m_nFromIp, m_nFromPort);
 
-	m_nState = STATE_RRQ_RECV_ACK;
+	// A window of blocks is sent before waiting for the ACK
+	m_nWindowCount++;
+	m_nState = (m_bIsLastBlock || (m_nWindowCount >= m_nWindowSize)) ? STATE_RRQ_RECV_ACK : STATE_RRQ_SEND_PACKET;
 }
 
 void TFTPDaemon::HandleRecvAck(void) {
 	struct TTFTPAckPacket *packet = (struct TTFTPAckPacket *) &m_Buffer;
 
 	if (packet->OpCode == __builtin_bswap16(OP_CODE_ACK)) {
+		const uint16_t nBlockNumber = __builtin_bswap16(packet->BlockNumber);
+
+		DEBUG_PRINTF("Incoming from " IPSTR ", BlockNumber=%d, m_nBlockNumber=%d", IP2STR(m_nFromIp), nBlockNumber, m_nBlockNumber);
 
-		DEBUG_PRINTF("Incoming from " IPSTR ", BlockNumber=%d, m_nBlockNumber=%d", IP2STR(m_nFromIp), __builtin_bswap16(packet->BlockNumber), m_nBlockNumber	);
+		// The number of blocks sent after the acknowledged one
+		const uint16_t nAhead = m_nBlockNumber - nBlockNumber;
 
-		if (packet->BlockNumber == __builtin_bswap16(m_nBlockNumber)) {
-			m_nState = m_bIsLastBlock ? STATE_INIT : STATE_RRQ_SEND_PACKET;
+		if (nAhead == 0) {
+			if (m_bIsLastBlock) {
+				FileClose();
+				m_nState = STATE_INIT;
+			} else {
+				m_nWindowCount = 0;
+				m_nState = STATE_RRQ_SEND_PACKET;
+			}
+		} else if ((nAhead < m_nWindowCount) || ((m_nWindowSize > 1) && (nAhead == m_nWindowCount))) {
+			// Blocks are lost, continue after the acknowledged block.
+			// A duplicate ACK in lock-step is ignored (Sorcerer's Apprentice).
+			m_nBlockNumber = nBlockNumber;
+			m_nWindowCount = 0;
+			m_bIsLastBlock = false;
+			m_nState = STATE_RRQ_SEND_PACKET;
 		}
 	}
 }
@@ -281,29 +407,48 @@ void TFTPDaemon::DoWriteAck(void) {
 	packet->OpCode = __builtin_bswap16(OP_CODE_ACK);
 	packet->BlockNumber =  __builtin_bswap16(m_nBlockNumber);
 	m_nState = m_bIsLastBlock ? STATE_INIT : STATE_WRQ_RECV_PACKET;
+	m_nWindowCount = 0;
 
 	DEBUG_PRINTF("Sending to " IPSTR ":%d, m_nState=%d", IP2STR(m_nFromIp), m_nFromPort, m_nState);
 
 	Network::Get()->SendTo(m_nIdx, (uint8_t *) &m_Buffer, sizeof(struct TTFTPAckPacket), m_nFromIp, m_nFromPort);
 }
 
+/*
+ * Only the next block in sequence is written. The ACK is sent at the end of
+ * a window, for the last block, or once when a gap is detected (RFC 7440).
+ */
 void TFTPDaemon::HandleRecvData(void) {
 	struct TTFTPDataPacket *packet = (struct TTFTPDataPacket *) &m_Buffer;
 
 	if (packet->OpCode == __builtin_bswap16(OP_CODE_DATA)) {
+		const uint16_t nBlockNumber = __builtin_bswap16(packet->BlockNumber);
+
 		m_nDataLength = m_nLength - 4;
-		m_nBlockNumber = __builtin_bswap16(packet->BlockNumber);
 
-		DEBUG_PRINTF("Incoming from " IPSTR ", m_nLength=%d, m_nBlockNumber=%d, m_nDataLength=%d", IP2STR(m_nFromIp), m_nLength, m_nBlockNumber,m_nDataLength);
+		DEBUG_PRINTF("Incoming from " IPSTR ", m_nLength=%d, nBlockNumber=%d, m_nDataLength=%d", IP2STR(m_nFromIp), m_nLength, nBlockNumber, m_nDataLength);
+
+		if (nBlockNumber != (uint16_t) (m_nBlockNumber + 1)) {
+			if ((nBlockNumber == m_nBlockNumber) || (!m_bIsGap)) {
+				// Our ACK was lost, or a block of this window is lost
+				m_bIsGap = (nBlockNumber != m_nBlockNumber);
+				DoWriteAck();
+			}
+			return;
+		}
+
+		m_bIsGap = false;
 
-		if (m_nDataLength == FileWrite(packet->Data, m_nDataLength, m_nBlockNumber)) {
+		if (m_nDataLength == FileWrite(packet->Data, m_nDataLength, nBlockNumber)) {
+			m_nBlockNumber = nBlockNumber;
 
-			if (m_nDataLength < MAX_DATA_LEN) {
+			if (m_nDataLength < m_nBlockSize) {
 				m_bIsLastBlock = true;
 				FileClose();
+				DoWriteAck();
+			} else if (++m_nWindowCount >= m_nWindowSize) {
+				DoWriteAck();
 			}
-
-			DoWriteAck();
 		} else {
 			SendError(ERROR_CODE_DISK_FULL, "Write failed");
 			m_nState = STATE_INIT;
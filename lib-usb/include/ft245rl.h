@@ -37,9 +37,11 @@ extern void FT245RL_init(void);
 
 extern bool FT245RL_data_available(void);
 extern uint8_t FT245RL_read_data();
+extern uint32_t FT245RL_read_block(uint8_t *, uint32_t);
 
 extern bool FT245RL_can_write(void);
 extern void FT245RL_write_data(uint8_t);
+extern void FT245RL_write_block(const uint8_t *, uint32_t);
 
 #ifdef __cplusplus
 }
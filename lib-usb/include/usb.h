@@ -38,6 +38,17 @@ extern "C" {
 extern uint8_t usb_read_byte(void);
 extern void usb_send_byte(uint8_t);
 
+inline static void usb_send_block(const uint8_t *data, uint32_t length) {
+	FT245RL_write_block(data, length);
+}
+
+/*
+ * Does not block, returns the number of bytes read.
+ */
+inline static uint32_t usb_read_block(uint8_t *data, uint32_t max_length) {
+	return FT245RL_read_block(data, max_length);
+}
+
 inline static const bool usb_read_is_byte_available(void) {
 	return FT245RL_data_available();
 }
@@ -68,6 +68,15 @@
 #define NOP_COUNT_READ 24
 #define NOP_COUNT_WRITE 2
 
+#define DATA_GPIO_MASK	((1 << D0) | (1 << D1) | (1 << D2) | (1 << D3) | (1 << D4) | (1 << D5) | (1 << D6) | (1 << D7))
+
+// D3 D1 D0 D4 D7 D6 D5 are on PA10..PA16, D2 is on PA6
+#define DATA_GPIO_HIGH_SHIFT	10
+#define DATA_GPIO_HIGH_MASK		0x7F
+
+static uint32_t s_data_to_gpio[256];							///< Byte -> PA data register bits
+static uint8_t s_gpio_to_data[DATA_GPIO_HIGH_MASK + 1];			///< PA10..PA16 -> byte (without D2)
+
 /**
  * Set the GPIOs for data to output
  */
@@ -128,6 +137,34 @@ static void data_gpio_fsel_input() {
 	H3_PIO_PORTA->CFG2 = value;
 }
 
+static void data_gpio_init_tables(void) {
+	uint32_t i;
+
+	for (i = 0; i < sizeof(s_data_to_gpio) / sizeof(s_data_to_gpio[0]); i++) {
+		uint32_t out_gpio = (i & 1) ? (1 << D0) : 0;
+		out_gpio |= (i & 2) ? (1 << D1) : 0;
+		out_gpio |= (i & 4) ? (1 << D2) : 0;
+		out_gpio |= (i & 8) ? (1 << D3) : 0;
+		out_gpio |= (i & 16) ? (1 << D4) : 0;
+		out_gpio |= (i & 32) ? (1 << D5) : 0;
+		out_gpio |= (i & 64) ? (1 << D6) : 0;
+		out_gpio |= (i & 128) ? (1 << D7) : 0;
+		s_data_to_gpio[i] = out_gpio;
+	}
+
+	for (i = 0; i < sizeof(s_gpio_to_data) / sizeof(s_gpio_to_data[0]); i++) {
+		const uint32_t in_gpio = i << DATA_GPIO_HIGH_SHIFT;
+		uint8_t data = in_gpio & (1 << D0) ? 1 : 0;
+		data |= in_gpio & (1 << D1) ? 2 : 0;
+		data |= in_gpio & (1 << D3) ? 8 : 0;
+		data |= in_gpio & (1 << D4) ? 16 : 0;
+		data |= in_gpio & (1 << D5) ? 32 : 0;
+		data |= in_gpio & (1 << D6) ? 64 : 0;
+		data |= in_gpio & (1 << D7) ? 128 : 0;
+		s_gpio_to_data[i] = data;
+	}
+}
+
 /**
  * Set RD#, WR to output, TXE#, RXF# to input.
  * Set RD# to high, set WR to low
@@ -159,14 +196,15 @@ void FT245RL_init(void) {
 	h3_gpio_set(_RD);
 	// WR	low
 	h3_gpio_clr(WR);
+
+	data_gpio_init_tables();
 }
 
 /**
- * Write 8-bits to USB
+ * The data GPIOs must be set to output.
  */
-void FT245RL_write_data(uint8_t data) {
+inline static void write_byte(uint8_t data) {
 	uint8_t i;
-	data_gpio_fsel_output();
 	// Raise WR to start the write.
 	h3_gpio_set(WR);
 	i = NOP_COUNT_WRITE;
@@ -174,16 +212,7 @@ void FT245RL_write_data(uint8_t data) {
 		asm volatile("nop"::);
 	}
 	// Put the data on the bus.
-	uint32_t out_gpio = H3_PIO_PORTA->DAT & ~( (1 << D0) | (1 << D1) | (1 << D2) | (1 << D3) | (1 << D4) | (1 << D5) | (1 << D6) | (1 << D7));
-	out_gpio |= (data & 1) ? (1 << D0) : 0;
-	out_gpio |= (data & 2) ? (1 << D1) : 0;
-	out_gpio |= (data & 4) ? (1 << D2) : 0;
-	out_gpio |= (data & 8) ? (1 << D3) : 0;
-	out_gpio |= (data & 16) ? (1 << D4) : 0;
-	out_gpio |= (data & 32) ? (1 << D5) : 0;
-	out_gpio |= (data & 64) ? (1 << D6) : 0;
-	out_gpio |= (data & 128) ? (1 << D7) : 0;
-	H3_PIO_PORTA->DAT = out_gpio;
+	H3_PIO_PORTA->DAT = (H3_PIO_PORTA->DAT & ~DATA_GPIO_MASK) | s_data_to_gpio[data];
 	i = NOP_COUNT_WRITE;
 	for (; i > 0; i--) {
 		asm volatile("nop"::);
@@ -193,10 +222,9 @@ void FT245RL_write_data(uint8_t data) {
 }
 
 /**
- * Read 8-bits from USB
+ * The data GPIOs must be set to input.
  */
-uint8_t FT245RL_read_data() {
-	data_gpio_fsel_input();
+inline static uint8_t read_byte(void) {
 	h3_gpio_clr(_RD);
 	// Wait for the FT245 to respond with data.
 	uint8_t i = NOP_COUNT_READ;
@@ -205,19 +233,64 @@ uint8_t FT245RL_read_data() {
 	}
 	// Read the data from the data port.
 	const uint32_t in_gpio = H3_PIO_PORTA->DAT;
-	uint8_t data = in_gpio & (1 << D0) ? 1 : 0;
-	data |= in_gpio & (1 << D1) ? 2 : 0;
-	data |= in_gpio & (1 << D2) ? 4 : 0;
-	data |= in_gpio & (1 << D3) ? 8 : 0;
-	data |= in_gpio & (1 << D4) ? 16 : 0;
-	data |= in_gpio & (1 << D5) ? 32 : 0;
-	data |= in_gpio & (1 << D6) ? 64 : 0;
-	data |= in_gpio & (1 << D7) ? 128 : 0;
+	const uint8_t data = s_gpio_to_data[(in_gpio >> DATA_GPIO_HIGH_SHIFT) & DATA_GPIO_HIGH_MASK] | (in_gpio & (1 << D2) ? 4 : 0);
 	// Bring RD# back up so the FT245 can let go of the data.
 	h3_gpio_set(_RD);
 	return data;
 }
 
+/**
+ * Write 8-bits to USB
+ */
+void FT245RL_write_data(uint8_t data) {
+	data_gpio_fsel_output();
+	write_byte(data);
+}
+
+/**
+ * Write a block to USB, waiting for TXE# before each byte.
+ * The data GPIOs are set to output once for the whole block.
+ */
+void FT245RL_write_block(const uint8_t *data, uint32_t length) {
+	data_gpio_fsel_output();
+
+	while (length-- != 0) {
+		while (H3_PIO_PORTA->DAT & (1 << _TXE))
+			;
+		write_byte(*data++);
+	}
+}
+
+/**
+ * Read 8-bits from USB
+ */
+uint8_t FT245RL_read_data() {
+	data_gpio_fsel_input();
+	return read_byte();
+}
+
+/**
+ * Read from USB as long as RXF# is low, at most max_length bytes.
+ * The data GPIOs are set to input once for the whole block.
+ *
+ * @return The number of bytes read
+ */
+uint32_t FT245RL_read_block(uint8_t *data, uint32_t max_length) {
+	uint32_t length = 0;
+
+	if (H3_PIO_PORTA->DAT & (1 << _RXF)) {
+		return 0;
+	}
+
+	data_gpio_fsel_input();
+
+	while ((length < max_length) && !(H3_PIO_PORTA->DAT & (1 << _RXF))) {
+		data[length++] = read_byte();
+	}
+
+	return length;
+}
+
 /**
  * Read RXF#
  */
@@ -148,15 +148,10 @@ void FT245RL_init(void) {
 }
 
 /**
- * @ingroup ft245rl
- *
- * Write 8-bits to USB
- *
- * @param data
+ * The data GPIOs must be set to output.
  */
-void FT245RL_write_data(const uint8_t data) {
+inline static void write_byte(const uint8_t data) {
 	uint8_t i;
-	data_gpio_fsel_output();
 	// Raise WR to start the write.
 	bcm2835_gpio_set(WR);
 	dmb();
@@ -179,14 +174,9 @@ void FT245RL_write_data(const uint8_t data) {
 }
 
 /**
- * @ingroup ft245rl
- *
- * Read 8-bits from USB
- *
- * @return
+ * The data GPIOs must be set to input.
  */
-const uint8_t FT245RL_read_data() {
-	data_gpio_fsel_input();
+inline static uint8_t read_byte(void) {
 	bcm2835_gpio_clr(_RD);
 	dmb();
 	// Wait for the FT245 to respond with data.
@@ -203,6 +193,76 @@ const uint8_t FT245RL_read_data() {
 	return data;
 }
 
+/**
+ * @ingroup ft245rl
+ *
+ * Write 8-bits to USB
+ *
+ * @param data
+ */
+void FT245RL_write_data(const uint8_t data) {
+	data_gpio_fsel_output();
+	write_byte(data);
+}
+
+/**
+ * @ingroup ft245rl
+ *
+ * Write a block to USB, waiting for TXE# before each byte.
+ * The data GPIOs are set to output once for the whole block.
+ *
+ * @param data
+ * @param length
+ */
+void FT245RL_write_block(const uint8_t *data, uint32_t length) {
+	data_gpio_fsel_output();
+
+	while (length-- != 0) {
+		while (BCM2835_GPIO->GPLEV0 & (1 << 24))
+			;
+		write_byte(*data++);
+	}
+}
+
+/**
+ * @ingroup ft245rl
+ *
+ * Read 8-bits from USB
+ *
+ * @return
+ */
+const uint8_t FT245RL_read_data() {
+	data_gpio_fsel_input();
+	return read_byte();
+}
+
+/**
+ * @ingroup ft245rl
+ *
+ * Read from USB as long as RXF# is low, at most max_length bytes.
+ * The data GPIOs are set to input once for the whole block.
+ *
+ * @param data
+ * @param max_length
+ * @return The number of bytes read
+ */
+uint32_t FT245RL_read_block(uint8_t *data, uint32_t max_length) {
+	uint32_t length = 0;
+
+	dmb();
+	if (BCM2835_GPIO->GPLEV0 & (1 << 25)) {
+		return 0;
+	}
+
+	data_gpio_fsel_input();
+
+	while ((length < max_length) && !(BCM2835_GPIO->GPLEV0 & (1 << 25))) {
+		data[length++] = read_byte();
+	}
+
+	return length;
+}
+
 /**
  * @ingroup ft245rl
  *
@@ -27,10 +27,16 @@
 #define WIDGET_USB_H_
 
 #include <stdint.h>
+#include <stdbool.h>
+
+#define WIDGET_USB_DATA_MAX		600	///< Largest message data, both directions
 
 extern void widget_usb_send_header(const uint8_t, const uint16_t);
+extern void widget_usb_send_byte(const uint8_t);
 extern void widget_usb_send_data(const uint8_t *, const uint16_t);
 extern void widget_usb_send_footer(void);
 extern void widget_usb_send_message(const uint8_t, const uint8_t *, const uint16_t);
 
+extern bool widget_usb_read_message(uint8_t *, uint8_t *, uint16_t, uint16_t *);
+
 #endif /* WIDGET_USB_H_ */
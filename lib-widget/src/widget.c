@@ -51,7 +51,7 @@
  #define ALIGNED __attribute__ ((aligned (4)))
 #endif
 
-#define WIDGET_DATA_BUFFER_SIZE		600							///<
+#define WIDGET_DATA_BUFFER_SIZE		WIDGET_USB_DATA_MAX			///<
 
 static uint8_t widget_data[WIDGET_DATA_BUFFER_SIZE] ALIGNED;	///< Message between widget and the USB host
 static _widget_mode widget_mode = MODE_DMX_RDM;					///< \ref _widget_mode
@@ -175,7 +175,7 @@ void widget_received_dmx_packet(void) {
 	monitor_line(MONITOR_LINE_STATUS, NULL);
 
 	widget_usb_send_header(RECEIVED_DMX_PACKET, length + 1);
-	usb_send_byte(0); 	// DMX Receive status
+	widget_usb_send_byte(0); 	// DMX Receive status
 	widget_usb_send_data(dmx_data, length);
 	widget_usb_send_footer();
 }
@@ -212,7 +212,7 @@ void widget_received_rdm_packet(void) {
 		monitor_line(MONITOR_LINE_STATUS, "RECEIVED_RDM_PACKET SC:0xCC");
 
 		widget_usb_send_header(RECEIVED_DMX_PACKET, 1 + message_length);
-		usb_send_byte(0); 	// RDM Receive status
+		widget_usb_send_byte(0); 	// RDM Receive status
 		widget_usb_send_data(rdm_data, message_length);
 		widget_usb_send_footer();
 
@@ -230,7 +230,7 @@ void widget_received_rdm_packet(void) {
 		monitor_line(MONITOR_LINE_STATUS, "RECEIVED_RDM_PACKET SC:0xFE");
 
 		widget_usb_send_header(RECEIVED_DMX_PACKET, 1 + message_length);
-		usb_send_byte(0); 	// RDM Receive status
+		widget_usb_send_byte(0); 	// RDM Receive status
 		widget_usb_send_data(rdm_data, message_length);
 		widget_usb_send_footer();
 
@@ -500,61 +500,47 @@ static void widget_get_name_reply(void) {
 
 /**
  *
- * Read bytes from host
+ * Handle a complete message from host, the bytes are collected in the receive ring of \ref widget_usb.c
  *
  * This function is called from the poll table in \ref main.c
  */
 void widget_receive_data_from_host(void) {
-	if (usb_read_is_byte_available()) {
-		const uint8_t c = usb_read_byte();
-
-		if (AMF_START_CODE == c) {
-			const uint8_t label = usb_read_byte();	// Label
-			const uint8_t lsb = usb_read_byte();	// Data length LSB
-			const uint8_t msb = usb_read_byte();	// Data length MSB
-			const uint16_t data_length = ((uint16_t) ((uint16_t) msb << 8)) | ((uint16_t) lsb);
-
-			uint16_t i;
-			for (i = 0; i < data_length; i++) {
-				widget_data[i] = usb_read_byte();
-			}
-
-			while ((AMF_END_CODE != usb_read_byte()) && (i++ < (sizeof(widget_data) / sizeof(widget_data[0]))))
-				;
-
-			monitor_line(MONITOR_LINE_LABEL, "L:%d:%d(%d)", label, data_length, i);
-
-			switch (label) {
-			case GET_WIDGET_PARAMS:
-				widget_get_params_reply();
-				break;
-			case GET_WIDGET_SN_REQUEST:
-				widget_get_sn_reply();
-				break;
-			case SET_WIDGET_PARAMS:
-				widget_set_params();
-				break;
-			case GET_WIDGET_NAME_LABEL:
-				widget_get_name_reply();
-				break;
-			case MANUFACTURER_LABEL:
-				widget_get_manufacturer_reply();
-				break;
-			case OUTPUT_ONLY_SEND_DMX_PACKET_REQUEST:
-				widget_send_dmx_packet_request_output_only(data_length);
-				break;
-			case RECEIVE_DMX_ON_CHANGE:
-				widget_receive_dmx_on_change();
-				break;
-			case SEND_RDM_PACKET_REQUEST:
-				widget_send_rdm_packet_request(data_length);
-				break;
-			case SEND_RDM_DISCOVERY_REQUEST:
-				widget_send_rdm_discovery_request(data_length);
-				break;
-			default:
-				break;
-			}
+	uint8_t label;
+	uint16_t data_length;
+
+	if (widget_usb_read_message(&label, widget_data, sizeof(widget_data) / sizeof(widget_data[0]), &data_length)) {
+		monitor_line(MONITOR_LINE_LABEL, "L:%d:%d", label, data_length);
+
+		switch (label) {
+		case GET_WIDGET_PARAMS:
+			widget_get_params_reply();
+			break;
+		case GET_WIDGET_SN_REQUEST:
+			widget_get_sn_reply();
+			break;
+		case SET_WIDGET_PARAMS:
+			widget_set_params();
+			break;
+		case GET_WIDGET_NAME_LABEL:
+			widget_get_name_reply();
+			break;
+		case MANUFACTURER_LABEL:
+			widget_get_manufacturer_reply();
+			break;
+		case OUTPUT_ONLY_SEND_DMX_PACKET_REQUEST:
+			widget_send_dmx_packet_request_output_only(data_length);
+			break;
+		case RECEIVE_DMX_ON_CHANGE:
+			widget_receive_dmx_on_change();
+			break;
+		case SEND_RDM_PACKET_REQUEST:
+			widget_send_rdm_packet_request(data_length);
+			break;
+		case SEND_RDM_DISCOVERY_REQUEST:
+			widget_send_rdm_discovery_request(data_length);
+			break;
+		default:
+			break;
 		}
 	}
 }
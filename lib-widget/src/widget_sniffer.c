@@ -63,13 +63,13 @@ static void usb_send_package(const uint8_t *data, uint16_t start, uint16_t data_
 		widget_usb_send_header((uint8_t) SNIFFER_PACKET, (uint16_t) SNIFFER_PACKET_SIZE);
 
 		for (i = 0; i < data_length; i++) {
-			usb_send_byte(DATA_MASK);
-			usb_send_byte(data[i + start]);
+			widget_usb_send_byte(DATA_MASK);
+			widget_usb_send_byte(data[i + start]);
 		}
 
 		for (i = data_length; i < SNIFFER_PACKET_SIZE / 2; i++) {
-			usb_send_byte((uint8_t) CONTROL_MASK);
-			usb_send_byte(0x02);
+			widget_usb_send_byte((uint8_t) CONTROL_MASK);
+			widget_usb_send_byte(0x02);
 		}
 
 		widget_usb_send_footer();
@@ -77,8 +77,8 @@ static void usb_send_package(const uint8_t *data, uint16_t start, uint16_t data_
 		widget_usb_send_header((uint8_t) SNIFFER_PACKET, (uint16_t) SNIFFER_PACKET_SIZE);
 
 		for (i = 0; i < SNIFFER_PACKET_SIZE / 2; i++) {
-			usb_send_byte((uint8_t) DATA_MASK);
-			usb_send_byte(data[i + start]);
+			widget_usb_send_byte((uint8_t) DATA_MASK);
+			widget_usb_send_byte(data[i + start]);
 		}
 
 		widget_usb_send_footer();
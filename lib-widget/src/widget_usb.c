@@ -24,26 +24,77 @@
  */
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include "widget.h"
+#include "widget_usb.h"
 #include "usb.h"
 
+#ifndef ALIGNED
+ #define ALIGNED __attribute__ ((aligned (4)))
+#endif
+
+#define HEADER_SIZE			4											///< Start code, label, length LSB and MSB
+#define TX_BUFFER_SIZE		(HEADER_SIZE + WIDGET_USB_DATA_MAX + 1)		///< Complete widget message
+#define RX_RING_SIZE		1024										///< Must be a power of 2
+#define RX_RING_MASK		(RX_RING_SIZE - 1)
+
+typedef enum {
+	RX_STATE_START,
+	RX_STATE_LABEL,
+	RX_STATE_LENGTH_LSB,
+	RX_STATE_LENGTH_MSB,
+	RX_STATE_DATA,
+	RX_STATE_END
+} _rx_state;
+
+static uint8_t tx_buffer[TX_BUFFER_SIZE] ALIGNED;	///< The message is assembled here and written as one block
+static uint32_t tx_length;							///<
+
+static uint8_t rx_ring[RX_RING_SIZE] ALIGNED;		///< Filled from the FT245 RX FIFO
+static uint32_t rx_head;							///< Write index, free running
+static uint32_t rx_tail;							///< Read index, free running
+
+static _rx_state rx_state = RX_STATE_START;			///<
+static uint8_t rx_label;							///<
+static uint16_t rx_length;							///<
+static uint16_t rx_index;							///<
+
 void widget_usb_send_header(uint8_t label, uint16_t length) {
-	usb_send_byte(AMF_START_CODE);
-	usb_send_byte(label);
-	usb_send_byte((uint8_t) (length & 0x00FF));
-	usb_send_byte((uint8_t) (length >> 8));
+	tx_buffer[0] = AMF_START_CODE;
+	tx_buffer[1] = label;
+	tx_buffer[2] = (uint8_t) (length & 0x00FF);
+	tx_buffer[3] = (uint8_t) (length >> 8);
+	tx_length = HEADER_SIZE;
+}
+
+void widget_usb_send_byte(uint8_t data) {
+	if (tx_length < (TX_BUFFER_SIZE - 1)) {
+		tx_buffer[tx_length++] = data;
+	}
 }
 
 void widget_usb_send_data(const uint8_t *data, uint16_t length) {
 	uint32_t i;
+
+	if (length > (TX_BUFFER_SIZE - 1 - tx_length)) {
+		length = (uint16_t) (TX_BUFFER_SIZE - 1 - tx_length);
+	}
+
 	for (i = 0; i < length; i++) {
-		usb_send_byte(data[i]);
+		tx_buffer[tx_length + i] = data[i];
 	}
+
+	tx_length += length;
 }
 
+/**
+ * Completes the message and hands it to the USB backend as one block.
+ */
 void widget_usb_send_footer(void) {
-	usb_send_byte(AMF_END_CODE);
+	tx_buffer[tx_length++] = AMF_END_CODE;
+	usb_send_block(tx_buffer, tx_length);
+	tx_length = 0;
 }
 
 void widget_usb_send_message(uint8_t label, const uint8_t *data, uint16_t length) {
@@ -51,3 +102,89 @@ void widget_usb_send_message(uint8_t label, const uint8_t *data, uint16_t length
 	widget_usb_send_data(data, length);
 	widget_usb_send_footer();
 }
+
+/**
+ * Drains the FT245 RX FIFO into the ring, without waiting.
+ */
+static void rx_ring_fill(void) {
+	for (;;) {
+		const uint32_t head = rx_head & RX_RING_MASK;
+		uint32_t space = RX_RING_SIZE - (rx_head - rx_tail);
+
+		if (space == 0) {
+			return;
+		}
+
+		if (space > (RX_RING_SIZE - head)) {
+			space = RX_RING_SIZE - head;
+		}
+
+		const uint32_t length = usb_read_block(&rx_ring[head], space);
+
+		rx_head += length;
+
+		if (length < space) {
+			return;
+		}
+	}
+}
+
+/**
+ * Parses complete messages out of the receive ring.
+ *
+ * @param label Label of the received message
+ * @param data Buffer for the message data
+ * @param max_length Size of data
+ * @param length Length of the received message data
+ * @return true when a complete message has been received
+ */
+bool widget_usb_read_message(uint8_t *label, uint8_t *data, uint16_t max_length, uint16_t *length) {
+	rx_ring_fill();
+
+	while (rx_tail != rx_head) {
+		const uint8_t c = rx_ring[rx_tail++ & RX_RING_MASK];
+
+		switch (rx_state) {
+		case RX_STATE_START:
+			if (c == AMF_START_CODE) {
+				rx_state = RX_STATE_LABEL;
+			}
+			break;
+		case RX_STATE_LABEL:
+			rx_label = c;
+			rx_state = RX_STATE_LENGTH_LSB;
+			break;
+		case RX_STATE_LENGTH_LSB:
+			rx_length = c;
+			rx_state = RX_STATE_LENGTH_MSB;
+			break;
+		case RX_STATE_LENGTH_MSB:
+			rx_length |= (uint16_t) ((uint16_t) c << 8);
+			rx_index = 0;
+			rx_state = (rx_length == 0) ? RX_STATE_END : RX_STATE_DATA;
+			break;
+		case RX_STATE_DATA:
+			if (rx_index < max_length) {
+				data[rx_index] = c;
+			}
+			if (++rx_index == rx_length) {
+				rx_state = RX_STATE_END;
+			}
+			break;
+		case RX_STATE_END:
+			rx_state = RX_STATE_START;
+			// Malformed or too long messages are dropped
+			if ((c == AMF_END_CODE) && (rx_length <= max_length)) {
+				*label = rx_label;
+				*length = rx_length;
+				return true;
+			}
+			break;
+		default:
+			rx_state = RX_STATE_START;
+			break;
+		}
+	}
+
+	return false;
+}
@@ -88,19 +88,26 @@ public:
 	void SetLED(uint32_t nLEDIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 	void SetLED(uint32_t nLEDIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
 
+	// pData is RGB, or RGBW for SK6812W, for each LED
+	void SetLEDs(uint32_t nLEDIndex, const uint8_t *pData, uint32_t nLEDCount);
+	// All LEDs get the colour pColour
+	void FillLEDs(uint32_t nLEDIndex, const uint8_t *pColour, uint32_t nLEDCount);
+
 	void Update(void);
 	void Blackout(void);
 
-#if defined (__circle__)
+#if defined (__circle__) || defined (WS28XX_SPI_DMA)
 	bool IsUpdating (void) const; // returns TRUE while DMA operation is active
 #else
-	 	bool IsUpdating (void) const {
+	bool IsUpdating (void) const {
 		return false;
 	}
 #endif
 
 private:
+	void SetupLookupTable(void);
 	void SetColorWS28xx(uint32_t nOffset, uint8_t nValue);
+	uint32_t GetOffset(uint32_t nLEDIndex) const;
 
 #if defined (__circle__)
 private:
@@ -118,6 +125,9 @@ private:
 	uint8_t *m_pBlackoutBuffer;
 	volatile bool m_bUpdating;
 	uint8_t m_nHighCode;
+	uint8_t m_nBytesPerLED;
+	uint8_t m_aColourOrder[4];
+	uint64_t m_aLookupTable[256];	// Colour byte -> 8 SPI bytes, MSB first
 #if defined (__circle__)
 	uint8_t *m_pReadBuffer;
 	CSPIMasterDMA m_SPIMaster;
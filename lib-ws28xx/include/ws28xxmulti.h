@@ -74,14 +74,23 @@ public:
 	void SetLED(uint8_t nPort, uint16_t nLedIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue);
 	void SetLED(uint8_t nPort, uint16_t nLedIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite);
 
+	/**
+	 * Bulk update of nLedCount LEDs, starting at nLedIndex.
+	 * pData is in DMX order, RGB or RGBW (SK6812W) per LED.
+	 */
+	void SetPort(uint8_t nPort, uint16_t nLedIndex, const uint8_t *pData, uint16_t nLedCount);
+
 	void Update(void);
 	void Blackout(void);
 
+	bool IsUpdating(void) const; // returns TRUE while DMA operation is active (WS28XXMULTI_DMA)
+
 private:
 	uint8_t CalculateBits(uint8_t nNanoSeconds);
 	uint8_t ReverseBits(uint8_t nBits);
 	bool SetupSI5351A(void);
 	bool SetupMCP23017(uint8_t nT0H, uint8_t nT1H);
+	void SetupDMA(void);
 	void Generate800kHz(const uint32_t *pBuffer);
 
 private:
@@ -93,6 +102,7 @@ private:
 	uint32_t m_nBufSize;
 	uint32_t *m_pBuffer;
 	uint32_t *m_pBlackoutBuffer;
+	uint8_t m_aColourOrder[4];
 };
 
 #endif /* WS28XXMULTI_H_ */
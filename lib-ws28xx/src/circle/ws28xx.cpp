@@ -60,6 +60,8 @@ WS28xx::WS28xx (CInterruptSystem *pInterruptSystem, TWS28XXType Type, uint16_t n
 		m_nBufSize += 8;
 	}
 
+	SetupLookupTable();
+
 	m_pBuffer = new u8[m_nBufSize];
 	assert(m_pBuffer != 0);
 
@@ -28,7 +28,15 @@
 
 #include "ws28xxmulti.h"
 
+#include "h3.h"
 #include "h3_gpio.h"
+#if defined (WS28XXMULTI_DMA)
+# include "h3_board.h"
+# include "h3_ccu.h"
+# include "h3_dma.h"
+# include "c/hardware.h"
+# include "arm/synchronize.h"
+#endif
 
 #include "si5351a.h"
 #include "mcp23017.h"
@@ -56,8 +64,55 @@ enum {
 
 #define DATA_MASK	((1 << PULSE) | (1 << ENABLE) | (1 << OUT3) | (1 << OUT2) | (1 << OUT1) | (1 << OUT0))
 
-#define BIT_SET(a,b) 	((a) |= (1<<(b)))
-#define BIT_CLEAR(a,b) 	((a) &= ~(1<<(b)))
+#if defined (WS28XXMULTI_DMA)
+/*
+ * The DMA writes the whole H3_PIO_PORTA->DAT register for every GPIO word. The H3 has no
+ * set/clear registers, so every other Port A GPIO output is overwritten while a frame is sent.
+ * The DMA output is therefore only allowed on a whitelist, where all Port A users are known.
+ * The DMA output is opt-in : add WS28XXMULTI_DMA to the DEFINES of the Makefile.H3.
+ * The bit timing depends on the AHB1 clock and DMA_WAIT_CYCLES, it is not measured on hardware yet.
+ *
+ * Orange Pi Zero / Orange Pi One with the 4 outputs pixel board :
+ *  PA0-PA3, PA6, PA18	OUTx, PULSE, ENABLE (this driver)
+ *  PA4, PA5			UART0, function mode, not affected by DAT
+ *  PA11, PA12			I2C0 (SI5351A, MCP23017, display), function mode, not affected by DAT
+ *  PA15 (One), PA17 (Zero)	Status LED, GPIO output -> taken from hardware_led_get()
+ *  PA19 (Zero)			External LED, GPIO output -> taken from hardware_led_get()
+ *
+ * A LED change while a frame is being sent shows with the next frame.
+ * Any other board, or a firmware using other Port A GPIO outputs (FT245RL, ESP8266), must use the CPU output.
+ */
+#if !(defined (ORANGE_PI) || defined (ORANGE_PI_ONE))
+# error "WS28XXMULTI_DMA : the Port A usage is only known for the Orange Pi Zero and the Orange Pi One"
+#endif
+
+#if defined (DO_NOT_USE_EXTERNAL_LED)
+# define LED_MASK	(1U << H3_BOARD_STATUS_LED)
+#else
+# define LED_MASK	((1U << H3_BOARD_STATUS_LED) | ((H3_GPIO_TO_PORT(GPIO_EXT_16) == H3_GPIO_PORTA) ? (1U << H3_GPIO_TO_NUMBER(GPIO_EXT_16)) : 0))
+#endif
+
+/*
+ * The GPIO words are written to H3_PIO_PORTA->DAT by DMA, paced by the DMA wait cycles.
+ * One word each 1.25us with AHB1 at 200MHz, the value is trimmed for the bus transfer itself.
+ */
+#define DMA_CHANNEL			4
+#define DMA_CHL				H3_DMA_CHL4
+#define DMA_WAIT_CYCLES		240
+#define DMA_WIDTH_32BIT		2
+
+#define TX_BUFFER_WORDS		(LEDCOUNT_RGBW_MAX * SINGLE_RGBW)	// >= LEDCOUNT_RGB_MAX * SINGLE_RGB
+
+/*
+ * INFO The coherent region is shared with lib-dmx (dmx_multi) and the codec, which are not used together with the pixel output
+ */
+struct coherent_region {
+	struct sunxi_dma_lli lli;
+	uint32_t txbuffer[TX_BUFFER_WORDS + 1] __attribute__ ((aligned (64)));	// + 1 for the final ENABLE word
+};
+
+static struct coherent_region *p_coherent_region = (struct coherent_region *)(H3_MEM_COHERENT_REGION + MEGABYTE/2);
+#endif
 
 static TWS28xxMultiType s_NotSupported[] = {WS28XXMULTI_WS2801_NOT_SUPPORTED, WS28XXMULTI_APA102_NOT_SUPPORTED};
 
@@ -86,14 +141,33 @@ WS28xxMulti::WS28xxMulti(TWS28xxMultiType tWS28xxMultiType, uint16_t nLedCount,
 
 	if (m_tWS28xxMultiType == WS28XXMULTI_SK6812W) {
 		m_nLedCount =  nLedCount <= LEDCOUNT_RGBW_MAX ? nLedCount : LEDCOUNT_RGBW_MAX;
-		m_nBufSize = nLedCount * SINGLE_RGBW;
+		m_nBufSize = m_nLedCount * SINGLE_RGBW;
 	} else {
 		m_nLedCount =  nLedCount <= LEDCOUNT_RGB_MAX ? nLedCount : LEDCOUNT_RGB_MAX;
-		m_nBufSize = nLedCount * SINGLE_RGB;
+		m_nBufSize = m_nLedCount * SINGLE_RGB;
 	}
 
 	DEBUG_PRINTF("type=%d, count=%d, active=%d, bufsize=%d", m_tWS28xxMultiType, m_nLedCount, m_nActiveOutputs, m_nBufSize);
 
+	// Index of the colour in the DMX data, in the order sent on the wire
+	if (m_tWS28xxMultiType == WS28XXMULTI_WS2811) {
+		// RGB
+		m_aColourOrder[0] = 0;
+		m_aColourOrder[1] = 1;
+		m_aColourOrder[2] = 2;
+	} else if (m_tWS28xxMultiType == WS28XXMULTI_UCS1903) {
+		// BRG
+		m_aColourOrder[0] = 2;
+		m_aColourOrder[1] = 0;
+		m_aColourOrder[2] = 1;
+	} else {
+		// GRB
+		m_aColourOrder[0] = 1;
+		m_aColourOrder[1] = 0;
+		m_aColourOrder[2] = 2;
+	}
+	m_aColourOrder[3] = 3;
+
 	h3_gpio_fsel(OUT0, GPIO_FSEL_OUTPUT);
 	h3_gpio_clr(OUT0);
 	h3_gpio_fsel(OUT1, GPIO_FSEL_OUTPUT);
@@ -130,10 +204,18 @@ WS28xxMulti::WS28xxMulti(TWS28xxMultiType tWS28xxMultiType, uint16_t nLedCount,
 		m_pBlackoutBuffer[i] = d;
 	}
 
+#if defined (WS28XXMULTI_DMA)
+	SetupDMA();
+#endif
+
 	DEBUG_EXIT
 }
 
 WS28xxMulti::~WS28xxMulti(void) {
+	while (IsUpdating()) {
+		// wait for the DMA to finish
+	}
+
 	delete [] m_pBlackoutBuffer;
 	m_pBlackoutBuffer = 0;
 
@@ -141,75 +223,39 @@ WS28xxMulti::~WS28xxMulti(void) {
 	m_pBuffer = 0;
 }
 
+/*
+ * Branch-free bit-plane encoder. Each colour byte is spread over 8 GPIO words,
+ * MSB first, 4 words at a time in a 128-bit vector (NEON).
+ */
+typedef uint32_t vu32 __attribute__ ((vector_size (16)));
+
+static inline void set_colour(uint32_t *pBuffer, uint32_t nPort, uint32_t nValue) {
+	const vu32 shiftHi = { 7, 6, 5, 4 };
+	const vu32 shiftLo = { 3, 2, 1, 0 };
+	const vu32 value = { nValue, nValue, nValue, nValue };
+	const uint32_t nClear = ~(1U << nPort);
+	vu32 hi, lo;
+
+	__builtin_memcpy(&hi, &pBuffer[0], sizeof(vu32));
+	__builtin_memcpy(&lo, &pBuffer[4], sizeof(vu32));
+
+	hi = (hi & nClear) | (((value >> shiftHi) & 1) << nPort);
+	lo = (lo & nClear) | (((value >> shiftLo) & 1) << nPort);
+
+	__builtin_memcpy(&pBuffer[0], &hi, sizeof(vu32));
+	__builtin_memcpy(&pBuffer[4], &lo, sizeof(vu32));
+}
+
 void WS28xxMulti::SetLED(uint8_t nPort, uint16_t nLedIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue) {
 	assert(nPort < WS28XXMULTI_ACTIVE_PORTS_MAX);
 	assert(nLedIndex < m_nLedCount);
 
-	uint32_t j = 0;
-	uint32_t k = nLedIndex * SINGLE_RGB;
-
-	for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
-		if (m_tWS28xxMultiType == WS28XXMULTI_WS2811) {
-			// RGB
-			if (mask & nRed) {
-				BIT_SET(m_pBuffer[k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[k + j], nPort);
-			}
-
-			if (mask & nGreen) {
-				BIT_SET(m_pBuffer[8 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[8 + k + j], nPort);
-			}
-
-			if (mask & nBlue) {
-				BIT_SET(m_pBuffer[16 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[16 + k + j], nPort);
-			}
-		} else if  (m_tWS28xxMultiType == WS28XXMULTI_UCS1903) {
-			// BRG
-			if (mask & nBlue) {
-				BIT_SET(m_pBuffer[k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[k + j], nPort);
-			}
-
-			if (mask & nRed) {
-				BIT_SET(m_pBuffer[8 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[8 + k + j], nPort);
-			}
-
-			if (mask & nGreen) {
-				BIT_SET(m_pBuffer[16 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[16 + k + j], nPort);
-			}
-		} else {
-			// GRB
-			if (mask & nGreen) {
-				BIT_SET(m_pBuffer[k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[k + j], nPort);
-			}
-
-			if (mask & nRed) {
-				BIT_SET(m_pBuffer[8 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[8 + k + j], nPort);
-			}
-
-			if (mask & nBlue) {
-				BIT_SET(m_pBuffer[16 + k + j], nPort);
-			} else {
-				BIT_CLEAR(m_pBuffer[16 + k + j], nPort);
-			}
-		}
+	const uint8_t aRgb[3] = { nRed, nGreen, nBlue };
+	uint32_t *p = &m_pBuffer[nLedIndex * SINGLE_RGB];
 
-		j++;
-	}
+	set_colour(&p[0], nPort, aRgb[m_aColourOrder[0]]);
+	set_colour(&p[8], nPort, aRgb[m_aColourOrder[1]]);
+	set_colour(&p[16], nPort, aRgb[m_aColourOrder[2]]);
 }
 
 void WS28xxMulti::SetLED(uint8_t nPort, uint16_t nLedIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite) {
@@ -217,36 +263,43 @@ void WS28xxMulti::SetLED(uint8_t nPort, uint16_t nLedIndex, uint8_t nRed, uint8_
 	assert(nLedIndex < m_nLedCount);
 	assert(m_tWS28xxMultiType == WS28XXMULTI_SK6812W);
 
-	uint32_t j = 0;
-	uint32_t k = nLedIndex * SINGLE_RGBW;
+	uint32_t *p = &m_pBuffer[nLedIndex * SINGLE_RGBW];
 
-	for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
-		// GRB
-		if (mask & nGreen) {
-			BIT_SET(m_pBuffer[k + j], nPort);
-		} else {
-			BIT_CLEAR(m_pBuffer[k + j], nPort);
-		}
+	// GRBW
+	set_colour(&p[0], nPort, nGreen);
+	set_colour(&p[8], nPort, nRed);
+	set_colour(&p[16], nPort, nBlue);
+	set_colour(&p[24], nPort, nWhite);
+}
 
-		if (mask & nRed) {
-			BIT_SET(m_pBuffer[8 + k + j], nPort);
-		} else {
-			BIT_CLEAR(m_pBuffer[8 + k + j], nPort);
-		}
+void WS28xxMulti::SetPort(uint8_t nPort, uint16_t nLedIndex, const uint8_t *pData, uint16_t nLedCount) {
+	assert(nPort < WS28XXMULTI_ACTIVE_PORTS_MAX);
+	assert(pData != 0);
+	assert((nLedIndex + nLedCount) <= m_nLedCount);
 
-		if (mask & nBlue) {
-			BIT_SET(m_pBuffer[16 + k + j], nPort);
-		} else {
-			BIT_CLEAR(m_pBuffer[16 + k + j], nPort);
+	if (m_tWS28xxMultiType == WS28XXMULTI_SK6812W) {
+		uint32_t *p = &m_pBuffer[nLedIndex * SINGLE_RGBW];
+
+		for (uint32_t i = 0; i < nLedCount; i++) {
+			set_colour(&p[0], nPort, pData[m_aColourOrder[0]]);
+			set_colour(&p[8], nPort, pData[m_aColourOrder[1]]);
+			set_colour(&p[16], nPort, pData[m_aColourOrder[2]]);
+			set_colour(&p[24], nPort, pData[m_aColourOrder[3]]);
+			p += SINGLE_RGBW;
+			pData += 4;
 		}
 
-		if (mask & nWhite) {
-			BIT_SET(m_pBuffer[24 + k + j], nPort);
-		} else {
-			BIT_CLEAR(m_pBuffer[24 + k + j], nPort);
-		}
+		return;
+	}
 
-		j++;
+	uint32_t *p = &m_pBuffer[nLedIndex * SINGLE_RGB];
+
+	for (uint32_t i = 0; i < nLedCount; i++) {
+		set_colour(&p[0], nPort, pData[m_aColourOrder[0]]);
+		set_colour(&p[8], nPort, pData[m_aColourOrder[1]]);
+		set_colour(&p[16], nPort, pData[m_aColourOrder[2]]);
+		p += SINGLE_RGB;
+		pData += 3;
 	}
 }
 
@@ -262,6 +315,66 @@ void WS28xxMulti::Blackout(void) {
 	DEBUG_EXIT
 }
 
+#if defined (WS28XXMULTI_DMA)
+bool WS28xxMulti::IsUpdating(void) const {
+	return (H3_DMA->STA & (1 << DMA_CHANNEL)) != 0;
+}
+
+void WS28xxMulti::SetupDMA(void) {
+	assert(m_nBufSize <= TX_BUFFER_WORDS);
+
+	H3_CCU->BUS_SOFT_RESET0 |= CCU_BUS_SOFT_RESET0_DMA;
+	H3_CCU->BUS_CLK_GATING0 |= CCU_BUS_CLK_GATING0_DMA;
+
+	struct sunxi_dma_lli *lli = &p_coherent_region->lli;
+
+	lli->cfg = DMA_CHAN_CFG_DST_IO_MODE | DMA_CHAN_CFG_SRC_LINEAR_MODE
+			| DMA_CHAN_CFG_SRC_DRQ(DRQSRC_SDRAM) | DMA_CHAN_CFG_DST_DRQ(DRQSRC_SDRAM)
+			| DMA_CHAN_CFG_SRC_WIDTH(DMA_WIDTH_32BIT) | DMA_CHAN_CFG_DST_WIDTH(DMA_WIDTH_32BIT);
+	lli->src = (uint32_t) &p_coherent_region->txbuffer[0];
+	lli->dst = (uint32_t) &H3_PIO_PORTA->DAT;
+	lli->len = (m_nBufSize + 1) * sizeof(uint32_t);
+	lli->para = DMA_WAIT_CYCLES;
+	lli->p_lli_next = DMA_LLI_LAST_ITEM;
+}
+
+/*
+ * Non-blocking. The frame is copied into the DMA buffer, then m_pBuffer is free for the next frame.
+ * When the previous frame is still being sent, this waits for it.
+ */
+void WS28xxMulti::Generate800kHz(const uint32_t* pBuffer) {
+	while (IsUpdating()) {
+		// wait for the previous frame
+	}
+
+	// The other Port A outputs keep their current level, the LEDs get their requested level (see the whitelist above)
+	uint32_t nOther = H3_PIO_PORTA->DAT & (~(DATA_MASK | LED_MASK));
+
+	if (hardware_led_get() != 0) {
+		nOther |= LED_MASK;
+	}
+
+	uint32_t *pTxBuffer = p_coherent_region->txbuffer;
+
+	for (uint32_t i = 0; i < m_nBufSize; i++) {
+		pTxBuffer[i] = pBuffer[i] | nOther;
+	}
+
+	pTxBuffer[m_nBufSize] = pBuffer[m_nBufSize - 1] | nOther | (1 << ENABLE);
+
+	dmb();
+
+	DMA_CHL->DESC_ADDR = (uint32_t) &p_coherent_region->lli;
+	DMA_CHL->EN = DMA_CHAN_ENABLE_START;
+}
+#else
+bool WS28xxMulti::IsUpdating(void) const {
+	return false;
+}
+
+/*
+ * Blocking. Each GPIO word is a read-modify-write of DAT, so the other Port A outputs are not touched.
+ */
 void WS28xxMulti::Generate800kHz(const uint32_t* pBuffer) {
 	uint32_t i = 0;
 	const uint32_t d = (125 * 24) / 100;
@@ -292,6 +405,7 @@ void WS28xxMulti::Generate800kHz(const uint32_t* pBuffer) {
 	dat |= (1 << ENABLE);
 	H3_PIO_PORTA->DAT = dat;
 }
+#endif
 
 uint8_t WS28xxMulti::ReverseBits(uint8_t nBits) {
 	const uint32_t input = (uint32_t) nBits;
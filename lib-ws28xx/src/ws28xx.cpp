@@ -34,6 +34,10 @@
 
 #include "hal_spi.h"
 
+#if defined (WS28XX_SPI_DMA) && defined (ARM_ALLOW_MULTI_CORE)
+# error "WS28XX_SPI_DMA : the SPI flash waits for the DMA output on the same core only"
+#endif
+
 WS28xx::WS28xx(TWS28XXType Type, uint16_t nLEDCount, uint32_t nClockSpeed) :
 	m_tLEDType(Type),
 	m_nLEDCount(nLEDCount),
@@ -59,6 +63,8 @@ WS28xx::WS28xx(TWS28XXType Type, uint16_t nLEDCount, uint32_t nClockSpeed) :
 		m_nBufSize += 8;
 	}
 
+	SetupLookupTable();
+
 	m_pBuffer = new uint8_t[m_nBufSize];
 	assert(m_pBuffer != 0);
 
@@ -104,6 +110,10 @@ WS28xx::WS28xx(TWS28XXType Type, uint16_t nLEDCount, uint32_t nClockSpeed) :
 }
 
 WS28xx::~WS28xx(void) {
+	while (IsUpdating()) {
+		// wait for the DMA to finish
+	}
+
 	delete [] m_pBlackoutBuffer;
 	m_pBlackoutBuffer = 0;
 
@@ -111,14 +121,34 @@ WS28xx::~WS28xx(void) {
 	m_pBuffer = 0;
 }
 
+/*
+ * With WS28XX_SPI_DMA, m_pBuffer is the back buffer and the SPI DMA buffer is the front buffer.
+ * The frame is copied into the DMA buffer and this returns, so the next frame can be set while the
+ * current frame is shifted out. When the previous frame is still being sent, this waits for it.
+ * The asynchronous output is opt-in (DEFINES in the Makefile.H3), it is not tested on hardware.
+ */
 void WS28xx::Update(void) {
 	assert (m_pBuffer != 0);
 
+#if defined (WS28XX_SPI_DMA)
+	FUNC_PREFIX(spi_dma_tx_start((const char *) m_pBuffer, m_nBufSize));
+#else
 	FUNC_PREFIX(spi_writenb((char *) m_pBuffer, m_nBufSize));
+#endif
 }
 
 void WS28xx::Blackout(void) {
 	assert (m_pBlackoutBuffer != 0);
 
+#if defined (WS28XX_SPI_DMA)
+	FUNC_PREFIX(spi_dma_tx_start((const char *) m_pBlackoutBuffer, m_nBufSize));
+#else
 	FUNC_PREFIX(spi_writenb((char *) m_pBlackoutBuffer, m_nBufSize));
+#endif
 }
+
+#if defined (WS28XX_SPI_DMA)
+bool WS28xx::IsUpdating(void) const {
+	return FUNC_PREFIX(spi_dma_tx_is_active());
+}
+#endif
@@ -24,6 +24,7 @@
  */
 
 #include <stdint.h>
+#include <string.h>
 #include <assert.h>
 
 #include "ws28xx.h"
@@ -92,18 +93,131 @@ void WS28xx::SetLED(uint32_t nLEDIndex, uint8_t nRed, uint8_t nGreen, uint8_t nB
 
 void WS28xx::SetColorWS28xx(uint32_t nOffset, uint8_t nValue) {
 	assert(m_tLEDType != WS2801);
-	uint8_t mask;
-
 	assert(nOffset + 7 < m_nBufSize);
 
-	for (mask = 0x80; mask != 0; mask >>= 1) {
-		if (nValue & mask) {
-			m_pBuffer[nOffset] = m_nHighCode;
-		} else {
-			m_pBuffer[nOffset] = 0xC0;	// Same for all
+	__builtin_memcpy(&m_pBuffer[nOffset], &m_aLookupTable[nValue], 8);
+}
+
+/*
+ * Called from the constructor, before the buffers are initialized
+ */
+void WS28xx::SetupLookupTable(void) {
+	// Index of the colour in the RGB(W) data, in the order sent on the wire
+	if ((m_tLEDType == WS2801) || (m_tLEDType == APA102) || (m_tLEDType == WS2811) || (m_tLEDType == UCS2903)) {
+		// RGB
+		m_aColourOrder[0] = 0;
+		m_aColourOrder[1] = 1;
+		m_aColourOrder[2] = 2;
+	} else if (m_tLEDType == UCS1903) {
+		// BRG
+		m_aColourOrder[0] = 2;
+		m_aColourOrder[1] = 0;
+		m_aColourOrder[2] = 1;
+	} else {
+		// GRB
+		m_aColourOrder[0] = 1;
+		m_aColourOrder[1] = 0;
+		m_aColourOrder[2] = 2;
+	}
+	m_aColourOrder[3] = 3;
+
+	if (m_tLEDType == WS2801) {
+		m_nBytesPerLED = 3;
+	} else if (m_tLEDType == APA102) {
+		m_nBytesPerLED = 4;
+	} else if (m_tLEDType == SK6812W) {
+		m_nBytesPerLED = 4 * 8;
+	} else {
+		m_nBytesPerLED = 3 * 8;
+	}
+
+	for (uint32_t nValue = 0; nValue < 256; nValue++) {
+		uint8_t aCodes[8];
+		uint32_t nMask = 0x80;
+
+		for (uint32_t i = 0; i < 8; i++) {
+			aCodes[i] = (nValue & nMask) ? m_nHighCode : 0xC0;	// 0xC0 is the same for all
+			nMask >>= 1;
+		}
+
+		memcpy(&m_aLookupTable[nValue], aCodes, 8);
+	}
+}
+
+uint32_t WS28xx::GetOffset(uint32_t nLEDIndex) const {
+	if (m_tLEDType == APA102) {
+		return 4 + (nLEDIndex * 4);
+	}
+
+	return nLEDIndex * m_nBytesPerLED;
+}
+
+void WS28xx::SetLEDs(uint32_t nLEDIndex, const uint8_t *pData, uint32_t nLEDCount) {
+	assert(!m_bUpdating);
+
+	assert(m_pBuffer != 0);
+	assert(pData != 0);
+	assert(nLEDIndex + nLEDCount <= m_nLEDCount);
+
+	uint8_t *p = &m_pBuffer[GetOffset(nLEDIndex)];
+	const uint32_t nOrder0 = m_aColourOrder[0];
+	const uint32_t nOrder1 = m_aColourOrder[1];
+	const uint32_t nOrder2 = m_aColourOrder[2];
+
+	if (m_tLEDType == APA102) {
+		for (uint32_t i = 0; i < nLEDCount; i++) {
+			p[0] = m_nGlobalBrightness;
+			p[1] = pData[nOrder0];
+			p[2] = pData[nOrder1];
+			p[3] = pData[nOrder2];
+			p += 4;
+			pData += 3;
+		}
+	} else if (m_tLEDType == WS2801) {
+		for (uint32_t i = 0; i < nLEDCount; i++) {
+			p[0] = pData[nOrder0];
+			p[1] = pData[nOrder1];
+			p[2] = pData[nOrder2];
+			p += 3;
+			pData += 3;
 		}
+	} else if (m_tLEDType == SK6812W) {
+		for (uint32_t i = 0; i < nLEDCount; i++) {
+			__builtin_memcpy(&p[0], &m_aLookupTable[pData[nOrder0]], 8);
+			__builtin_memcpy(&p[8], &m_aLookupTable[pData[nOrder1]], 8);
+			__builtin_memcpy(&p[16], &m_aLookupTable[pData[nOrder2]], 8);
+			__builtin_memcpy(&p[24], &m_aLookupTable[pData[3]], 8);
+			p += 32;
+			pData += 4;
+		}
+	} else {
+		for (uint32_t i = 0; i < nLEDCount; i++) {
+			__builtin_memcpy(&p[0], &m_aLookupTable[pData[nOrder0]], 8);
+			__builtin_memcpy(&p[8], &m_aLookupTable[pData[nOrder1]], 8);
+			__builtin_memcpy(&p[16], &m_aLookupTable[pData[nOrder2]], 8);
+			p += 24;
+			pData += 3;
+		}
+	}
+}
+
+void WS28xx::FillLEDs(uint32_t nLEDIndex, const uint8_t *pColour, uint32_t nLEDCount) {
+	assert(pColour != 0);
+	assert(nLEDIndex + nLEDCount <= m_nLEDCount);
+
+	if (nLEDCount == 0) {
+		return;
+	}
+
+	SetLEDs(nLEDIndex, pColour, 1);
+
+	// The other LEDs get a copy of the encoded first LED
+	const uint8_t *pSrc = &m_pBuffer[GetOffset(nLEDIndex)];
+	uint8_t *pDst = &m_pBuffer[GetOffset(nLEDIndex + 1)];
 
-		nOffset++;
+	for (uint32_t i = 1; i < nLEDCount; i++) {
+		memcpy(pDst, pSrc, m_nBytesPerLED);
+		pDst += m_nBytesPerLED;
 	}
 }
 
@@ -157,25 +157,16 @@ void WS28xxDmx::SetData(uint8_t nPortId, const uint8_t *pData, uint16_t nLength)
 #endif
 #endif
 
+#if defined (__circle__)
+	// The circle WS28xx encodes into the DMA buffer, the others into a back buffer
 	while (m_pLEDStripe->IsUpdating()) {
 		// wait for completion
 	}
+#endif
 
-	for (uint32_t j = beginIndex; j < endIndex; j++) {
-		__builtin_prefetch(&pData[i]);
-		if (m_tLedType == SK6812W) {
-			if (i + 3 > nLength) {
-				break;
-			}
-			m_pLEDStripe->SetLED(j, pData[i], pData[i + 1], pData[i + 2], pData[i + 3]);
-			i = i + 4;
-		} else {
-			if (i + 2 > nLength) {
-				break;
-			}
-			m_pLEDStripe->SetLED(j, pData[i], pData[i + 1], pData[i + 2]);
-			i = i + 3;
-		}
+	if ((endIndex > beginIndex) && (i < nLength)) {
+		const uint32_t nLEDCount = MIN((endIndex - beginIndex), ((nLength - i) / m_nChannelsPerLed));
+		m_pLEDStripe->SetLEDs(beginIndex, &pData[i], nLEDCount);
 	}
 
 	if (nPortId == m_nPortIdLast) {
@@ -69,9 +69,12 @@ void WS28xxDmxGrouping::SetData(uint8_t nPort, const uint8_t* pData, uint16_t nL
 		Start();
 	}
 
+#if defined (__circle__)
+	// The circle WS28xx encodes into the DMA buffer, the others into a back buffer
 	while (m_pLEDStripe->IsUpdating()) {
 		// wait for completion
 	}
+#endif
 
 //	const uint8_t *p = pData + m_nDmxStartAddress - 1;
 	bool bIsChanged = false;
@@ -94,24 +97,12 @@ void WS28xxDmxGrouping::SetData(uint8_t nPort, const uint8_t* pData, uint16_t nL
 		uint32_t i = 0;
 		uint32_t d = 0;
 
-		if (m_tLedType == SK6812W) {
-			for (uint32_t g = 0; g < m_nGroups; g++) {
-				__builtin_prefetch(&m_pDmxData[d]);
-				for (uint32_t k = 0; k < m_nLEDGroupCount; k++) {
-					m_pLEDStripe->SetLED(k + i, m_pDmxData[d + 0], m_pDmxData[d + 1], m_pDmxData[d + 2], m_pDmxData[d + 3]);
-				}
-				i = i + m_nLEDGroupCount;
-				d = d + 4;
-			}
-		} else {
-			for (uint32_t g = 0; g < m_nGroups; g++) {
-				__builtin_prefetch(&m_pDmxData[d]);
-				for (uint32_t k = 0; k < m_nLEDGroupCount; k++) {
-					m_pLEDStripe->SetLED(k + i, m_pDmxData[d + 0], m_pDmxData[d + 1], m_pDmxData[d + 2]);
-				}
-				i = i + m_nLEDGroupCount;
-				d = d + 3;
-			}
+		const uint32_t nChannelsPerLed = (m_tLedType == SK6812W) ? 4 : 3;
+
+		for (uint32_t g = 0; g < m_nGroups; g++) {
+			m_pLEDStripe->FillLEDs(i, &m_pDmxData[d], m_nLEDGroupCount);
+			i = i + m_nLEDGroupCount;
+			d = d + nChannelsPerLed;
 		}
 
 		if (!m_bBlackout) {
@@ -104,7 +104,6 @@ void WS28xxDmxMulti::SetData(uint8_t nPortId, const uint8_t* pData, uint16_t nLe
 	assert(pData != 0);
 	assert(nLength <= DMX_MAX_CHANNELS);
 
-	uint32_t i = 0;
 	uint32_t beginIndex, endIndex;
 
 	if (__builtin_expect((m_pLEDStripe == 0), 0)) {
@@ -145,21 +144,8 @@ void WS28xxDmxMulti::SetData(uint8_t nPortId, const uint8_t* pData, uint16_t nLe
 			(int ) nPortId, (int ) nLength, (int ) nOutIndex,
 			(int )nPortId & ~m_nUniverses & 0x03, (int)beginIndex, (int)endIndex);
 
-	for (uint32_t j = beginIndex; j < endIndex; j++) {
-		__builtin_prefetch(&pData[i]);
-		if (m_tLedType == WS28XXMULTI_SK6812W) {
-			if (i + 3 > nLength) {
-				break;
-			}
-			m_pLEDStripe->SetLED(nOutIndex, j, pData[i], pData[i + 1], pData[i + 2], pData[i + 3]);
-			i = i + 4;
-		} else {
-			if (i + 2 > nLength) {
-				break;
-			}
-			m_pLEDStripe->SetLED(nOutIndex, j, pData[i], pData[i + 1], pData[i + 2]);
-			i = i + 3;
-		}
+	if (endIndex > beginIndex) {
+		m_pLEDStripe->SetPort(nOutIndex, beginIndex, pData, endIndex - beginIndex);
 	}
 
 	if (nPortId == m_nPortIdLast) {
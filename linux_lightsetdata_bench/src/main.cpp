@@ -0,0 +1,241 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "lightsetdata.h"
+
+#define DMX_LENGTH	512
+#define ITERATIONS	200000
+#define SOURCES		4
+
+/*
+ * The byte loops as they were in ArtNetNode / E131Bridge.
+ * Auto-vectorization is disabled, so these are the scalar reference.
+ */
+#define SCALAR	__attribute__ ((noinline, optimize ("no-tree-vectorize")))
+
+static bool SCALAR scalar_copy(uint8_t *pDst, const uint8_t *pSrc, uint32_t nLength) {
+	bool isChanged = false;
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		if (pDst[i] != pSrc[i]) {
+			isChanged = true;
+		}
+		pDst[i] = pSrc[i];
+	}
+
+	return isChanged;
+}
+
+static bool SCALAR scalar_merge_htp(uint8_t *pDst, const uint8_t *pDataA, const uint8_t *pDataB, uint32_t nLength) {
+	bool isChanged = false;
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		const uint8_t nData = pDataA[i] > pDataB[i] ? pDataA[i] : pDataB[i];
+		if (pDst[i] != nData) {
+			isChanged = true;
+		}
+		pDst[i] = nData;
+	}
+
+	return isChanged;
+}
+
+static bool SCALAR scalar_merge_htp_n(uint8_t *pDst, const uint8_t * const *ppData, uint32_t nSources, uint32_t nLength) {
+	bool isChanged = false;
+
+	for (uint32_t i = 0; i < nLength; i++) {
+		uint8_t nData = 0;
+		for (uint32_t nSource = 0; nSource < nSources; nSource++) {
+			nData = ppData[nSource][i] > nData ? ppData[nSource][i] : nData;
+		}
+		if (pDst[i] != nData) {
+			isChanged = true;
+		}
+		pDst[i] = nData;
+	}
+
+	return isChanged;
+}
+
+static uint64_t micros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static void fill(uint8_t *p, uint32_t nLength) {
+	for (uint32_t i = 0; i < nLength; i++) {
+		p[i] = (uint8_t) rand();
+	}
+}
+
+static uint8_t s_Source[SOURCES][DMX_LENGTH + 1];
+static uint8_t s_DstScalar[DMX_LENGTH + 1];
+static uint8_t s_DstVector[DMX_LENGTH + 1];
+
+static int verify(void) {
+	const uint8_t *ppData[SOURCES] = { s_Source[0], s_Source[1], s_Source[2], s_Source[3] };
+	int nErrors = 0;
+
+	for (uint32_t nRun = 0; nRun < 64; nRun++) {
+		for (uint32_t nLength = 0; nLength <= DMX_LENGTH; nLength++) {
+			for (uint32_t i = 0; i < SOURCES; i++) {
+				fill(s_Source[i], DMX_LENGTH);
+			}
+
+			// Start equal, and change a single slot in every other run
+			fill(s_DstScalar, DMX_LENGTH);
+
+			if ((nRun & 1) == 0) {
+				memcpy(s_DstScalar, s_Source[0], DMX_LENGTH);
+				if (nLength != 0) {
+					s_DstScalar[rand() % nLength] ^= 0x01;
+				}
+			}
+
+			memcpy(s_DstVector, s_DstScalar, DMX_LENGTH);
+
+			bool bScalar = scalar_copy(s_DstScalar, s_Source[0], nLength);
+			bool bVector = LightSetData::Copy(s_DstVector, s_Source[0], nLength);
+
+			if ((bScalar != bVector) || (memcmp(s_DstScalar, s_DstVector, DMX_LENGTH) != 0)) {
+				printf("Copy mismatch, length %u\n", nLength);
+				nErrors++;
+			}
+
+			// The second copy has no changes
+			if (LightSetData::Copy(s_DstVector, s_Source[0], nLength)) {
+				printf("Copy unchanged mismatch, length %u\n", nLength);
+				nErrors++;
+			}
+
+			bScalar = scalar_merge_htp(s_DstScalar, s_Source[0], s_Source[1], nLength);
+			bVector = LightSetData::MergeHtp(s_DstVector, s_Source[0], s_Source[1], nLength);
+
+			if ((bScalar != bVector) || (memcmp(s_DstScalar, s_DstVector, DMX_LENGTH) != 0)) {
+				printf("MergeHtp mismatch, length %u\n", nLength);
+				nErrors++;
+			}
+
+			for (uint32_t nSources = 1; nSources <= SOURCES; nSources++) {
+				bScalar = scalar_merge_htp_n(s_DstScalar, ppData, nSources, nLength);
+				bVector = LightSetData::MergeHtp(s_DstVector, ppData, nSources, nLength);
+
+				if ((bScalar != bVector) || (memcmp(s_DstScalar, s_DstVector, DMX_LENGTH) != 0)) {
+					printf("MergeHtp %u sources mismatch, length %u\n", nSources, nLength);
+					nErrors++;
+				}
+			}
+		}
+	}
+
+	return nErrors;
+}
+
+static void report(const char *pName, uint64_t nScalar, uint64_t nVector) {
+	printf("%-18s scalar %6.1f ns  vector %6.1f ns  speedup %.1fx\n", pName,
+			(double) nScalar * 1000 / ITERATIONS, (double) nVector * 1000 / ITERATIONS,
+			nVector == 0 ? 0 : (double) nScalar / (double) nVector);
+}
+
+int main(int argc, char **argv) {
+	const uint8_t *ppData[SOURCES] = { s_Source[0], s_Source[1], s_Source[2], s_Source[3] };
+	uint32_t nChanged = 0;
+	uint64_t nStart;
+
+	srand(1);
+
+	const int nErrors = verify();
+
+	printf("Verify : %s\n", nErrors == 0 ? "scalar and vector results are identical" : "FAILED");
+
+	for (uint32_t i = 0; i < SOURCES; i++) {
+		fill(s_Source[i], DMX_LENGTH);
+	}
+
+	printf("%d iterations, %d slots\n", ITERATIONS, DMX_LENGTH);
+
+	// Unchanged frames, the common case for a steady stream
+	memcpy(s_DstScalar, s_Source[0], DMX_LENGTH);
+	memcpy(s_DstVector, s_Source[0], DMX_LENGTH);
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += scalar_copy(s_DstScalar, s_Source[0], DMX_LENGTH);
+	}
+	const uint64_t nCopyScalar = micros() - nStart;
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += LightSetData::Copy(s_DstVector, s_Source[0], DMX_LENGTH);
+	}
+	const uint64_t nCopyVector = micros() - nStart;
+
+	report("Copy", nCopyScalar, nCopyVector);
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += scalar_merge_htp(s_DstScalar, s_Source[i & 1], s_Source[2], DMX_LENGTH);
+	}
+	const uint64_t nMergeScalar = micros() - nStart;
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += LightSetData::MergeHtp(s_DstVector, s_Source[i & 1], s_Source[2], DMX_LENGTH);
+	}
+	const uint64_t nMergeVector = micros() - nStart;
+
+	report("MergeHtp", nMergeScalar, nMergeVector);
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += scalar_merge_htp_n(s_DstScalar, ppData, SOURCES, DMX_LENGTH);
+	}
+	const uint64_t nMergeNScalar = micros() - nStart;
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		nChanged += LightSetData::MergeHtp(s_DstVector, ppData, SOURCES, DMX_LENGTH);
+	}
+	const uint64_t nMergeNVector = micros() - nStart;
+
+	report("MergeHtp 4 sources", nMergeNScalar, nMergeNVector);
+
+	if (memcmp(s_DstScalar, s_DstVector, DMX_LENGTH) != 0) {
+		printf("Benchmark results differ\n");
+		return -1;
+	}
+
+	printf("(%u)\n", nChanged);
+
+	return nErrors == 0 ? 0 : -1;
+}
@@ -0,0 +1,207 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+#include "hardware.h"
+#include "networklinux.h"
+
+#include "rdmhandler.h"
+#include "rdmdeviceresponder.h"
+#include "rdmpersonality.h"
+#include "rdmidentify.h"
+#include "rdm.h"
+#include "rdm_e120.h"
+
+#include "lightset.h"
+
+#define ITERATIONS	20000
+#define DMX_FOOTPRINT	4
+
+/*
+ * The GET requests a controller sends to a responder it has just discovered,
+ * including the probes for PIDs this responder does not support.
+ * The Linux build of lib-rdmsensor always has the CPU temperature as sensor 0.
+ */
+struct TSweep {
+	uint16_t nParamId;
+	uint8_t nParamDataLength;
+	uint8_t nParamData;
+	uint8_t nResponseType;
+	uint16_t nReason;
+};
+
+static const struct TSweep s_Sweep[] = {
+	{ E120_SUPPORTED_PARAMETERS,			0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DEVICE_INFO,						0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_PARAMETER_DESCRIPTION,			2, 0, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_UNKNOWN_PID },
+	{ E120_SOFTWARE_VERSION_LABEL,			0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_BOOT_SOFTWARE_VERSION_ID,		0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DEVICE_MODEL_DESCRIPTION,		0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_MANUFACTURER_LABEL,				0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DEVICE_LABEL,					0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_PRODUCT_DETAIL_ID_LIST,			0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DMX_PERSONALITY,					0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DMX_PERSONALITY_DESCRIPTION,		1, 1, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_DMX_START_ADDRESS,				0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_SLOT_INFO,						0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_SENSOR_DEFINITION,				1, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E120_SENSOR_DEFINITION,				1, 1, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_DATA_OUT_OF_RANGE },
+	{ E120_STATUS_MESSAGES,					1, 0, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_UNKNOWN_PID },
+	{ E120_LAMP_HOURS,						0, 0, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_UNKNOWN_PID },
+	{ E137_2_LIST_INTERFACES,				0, 0, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_UNKNOWN_PID },
+	{ 0x8000,								0, 0, E120_RESPONSE_TYPE_NACK_REASON, E120_NR_UNKNOWN_PID },
+	{ E120_IDENTIFY_DEVICE,					0, 0, E120_RESPONSE_TYPE_ACK, 0 },
+	{ E137_1_IDENTIFY_MODE,					0, 0, E120_RESPONSE_TYPE_ACK, 0 }
+};
+
+#define SWEEP_LENGTH	(sizeof(s_Sweep) / sizeof(s_Sweep[0]))
+
+class LightSetNull: public LightSet {
+public:
+	void Start(uint8_t nPort) {
+	}
+	void Stop(uint8_t nPort) {
+	}
+	void SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	}
+	uint16_t GetDmxFootprint(void) {
+		return DMX_FOOTPRINT;
+	}
+};
+
+class IdentifyNull: public RDMIdentify {
+public:
+	void SetMode(TRdmIdentifyMode nMode) {
+		m_nMode = nMode;
+	}
+};
+
+static const uint8_t CONTROLLER_UID[RDM_UID_SIZE] = { 0x7F, 0xF0, 0x00, 0x00, 0x00, 0x01 };
+
+static uint8_t s_Request[SWEEP_LENGTH][sizeof(struct TRdmMessageNoSc)];
+static uint8_t s_Response[sizeof(struct TRdmMessage)];
+
+static void build_requests(const uint8_t *pUid) {
+	for (uint32_t i = 0; i < SWEEP_LENGTH; i++) {
+		struct TRdmMessageNoSc *p = (struct TRdmMessageNoSc *) s_Request[i];
+
+		p->sub_start_code = E120_SC_SUB_MESSAGE;
+		p->message_length = RDM_MESSAGE_MINIMUM_SIZE + s_Sweep[i].nParamDataLength;
+		memcpy(p->destination_uid, pUid, RDM_UID_SIZE);
+		memcpy(p->source_uid, CONTROLLER_UID, RDM_UID_SIZE);
+		p->transaction_number = (uint8_t) i;
+		p->slot16.port_id = 1;
+		p->message_count = 0;
+		p->sub_device[0] = 0;
+		p->sub_device[1] = 0;
+		p->command_class = E120_GET_COMMAND;
+		p->param_id[0] = (uint8_t) (s_Sweep[i].nParamId >> 8);
+		p->param_id[1] = (uint8_t) s_Sweep[i].nParamId;
+		p->param_data_length = s_Sweep[i].nParamDataLength;
+		p->param_data[0] = 0;
+		p->param_data[s_Sweep[i].nParamDataLength == 0 ? 0 : s_Sweep[i].nParamDataLength - 1] = s_Sweep[i].nParamData;
+	}
+}
+
+static int verify(RDMHandler &handler) {
+	int nErrors = 0;
+
+	for (uint32_t i = 0; i < SWEEP_LENGTH; i++) {
+		const struct TRdmMessage *p = (const struct TRdmMessage *) s_Response;
+
+		handler.HandleData(s_Request[i], s_Response);
+
+		const uint16_t nParamId = (p->param_id[0] << 8) + p->param_id[1];
+		const uint16_t nReason = (p->param_data[0] << 8) + p->param_data[1];
+
+		if ((p->start_code != E120_SC_RDM) || (nParamId != s_Sweep[i].nParamId) || (p->slot16.response_type != s_Sweep[i].nResponseType)) {
+			printf("PID 0x%.4X : unexpected response, PID 0x%.4X, response type %d\n", s_Sweep[i].nParamId, nParamId, (int) p->slot16.response_type);
+			nErrors++;
+		} else if ((s_Sweep[i].nResponseType == E120_RESPONSE_TYPE_NACK_REASON) && (nReason != s_Sweep[i].nReason)) {
+			printf("PID 0x%.4X : NACK reason 0x%.4X, expected 0x%.4X\n", s_Sweep[i].nParamId, nReason, s_Sweep[i].nReason);
+			nErrors++;
+		}
+	}
+
+	return nErrors;
+}
+
+static uint64_t micros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+int main(int argc, char **argv) {
+	Hardware hw;
+	NetworkLinux nw;
+
+	if (!RDMHandler::IsPidTablesSorted()) {
+		printf("RDMHandler : PID tables are not sorted on pid\n");
+		return -1;
+	}
+
+	printf("RDMHandler : PID tables are sorted\n");
+
+	LightSetNull lightSet;
+	IdentifyNull identify;
+	RDMPersonality personality("PID check", DMX_FOOTPRINT);
+	RDMDeviceResponder responder(&personality, &lightSet, false);
+
+	responder.Init();
+
+	RDMHandler handler;
+
+	build_requests(responder.GetUID());
+
+	const int nErrors = verify(handler);
+
+	if (nErrors != 0) {
+		printf("Sweep : %d unexpected responses\n", nErrors);
+		return -1;
+	}
+
+	printf("Sweep : %u requests, all responses as expected\n", (unsigned) SWEEP_LENGTH);
+
+	const uint64_t nStart = micros();
+
+	for (uint32_t nIteration = 0; nIteration < ITERATIONS; nIteration++) {
+		for (uint32_t i = 0; i < SWEEP_LENGTH; i++) {
+			handler.HandleData(s_Request[i], s_Response);
+		}
+	}
+
+	const uint64_t nTime = micros() - nStart;
+
+	printf("Sweep : %d iterations, %.1f us per sweep, %.1f ns per request\n", ITERATIONS,
+			(double) nTime / ITERATIONS, (double) nTime * 1000 / (ITERATIONS * SWEEP_LENGTH));
+
+	return 0;
+}
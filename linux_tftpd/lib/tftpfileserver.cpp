@@ -0,0 +1,87 @@
+/**
+ * @file tftpfileserver.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <string.h>
+
+#include "tftpfileserver.h"
+
+TFTPFileServer::TFTPFileServer(void): m_pFile(0) {
+}
+
+TFTPFileServer::~TFTPFileServer(void) {
+	FileClose();
+}
+
+/*
+ * Only the files in the current directory are served
+ */
+bool TFTPFileServer::IsValidFileName(const char *pFileName) {
+	return (pFileName[0] != '\0') && (strchr(pFileName, '/') == 0) && (strcmp(pFileName, "..") != 0) && (strcmp(pFileName, ".") != 0);
+}
+
+bool TFTPFileServer::FileOpen(const char* pFileName, TTFTPMode tMode) {
+	if (!IsValidFileName(pFileName)) {
+		return false;
+	}
+
+	m_pFile = fopen(pFileName, "rb");
+	return (m_pFile != NULL);
+}
+
+bool TFTPFileServer::FileCreate(const char* pFileName, TTFTPMode tMode) {
+	if (!IsValidFileName(pFileName)) {
+		return false;
+	}
+
+	m_pFile = fopen(pFileName, "wb");
+	return (m_pFile != NULL);
+}
+
+bool TFTPFileServer::FileClose(void) {
+	if (m_pFile != 0) {
+		fclose(m_pFile);
+		m_pFile = 0;
+	}
+	return true;
+}
+
+/*
+ * With a window, blocks can be requested again. Hence the seek.
+ */
+int TFTPFileServer::FileRead(void* pBuffer, unsigned nCount, unsigned nBlockNumber) {
+	if (fseek(m_pFile, (long) (nBlockNumber - 1) * GetBlockSize(), SEEK_SET) != 0) {
+		return -1;
+	}
+	return fread(pBuffer, 1, nCount, m_pFile);
+}
+
+int TFTPFileServer::FileWrite(const void* pBuffer, unsigned nCount, unsigned nBlockNumber) {
+	if (fseek(m_pFile, (long) (nBlockNumber - 1) * GetBlockSize(), SEEK_SET) != 0) {
+		return -1;
+	}
+	return fwrite(pBuffer, 1, nCount, m_pFile);
+}
@@ -0,0 +1,66 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <unistd.h>
+
+#include "hardware.h"
+#include "networklinux.h"
+
+#include "tftpfileserver.h"
+
+int main(int argc, char **argv) {
+	Hardware hw;
+	NetworkLinux nw;
+
+	if (argc < 3) {
+		printf("Usage: %s ip_address|interface_name directory\n", argv[0]);
+		return -1;
+	}
+
+	if (chdir(argv[2]) != 0) {
+		perror(argv[2]);
+		return -1;
+	}
+
+	if (nw.Init(argv[1]) < 0) {
+		fprintf(stderr, "Not able to start the network\n");
+		return -1;
+	}
+
+	nw.Print();
+
+	printf("TFTP server, directory %s\n", argv[2]);
+
+	TFTPFileServer server;
+
+	for (;;) {
+		server.Run();
+	}
+
+	return 0;
+}
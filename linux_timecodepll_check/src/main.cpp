@@ -0,0 +1,305 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "h3/timecodepll.h"
+#include "ltc.h"
+#include "timecodeconst.h"
+
+#include "softtimersim.h"
+
+#define FREEWHEEL_FRAMES	10
+#define SOURCE_PERIOD_US	40040	///< 25 fps, the source is 0.1% slow
+#define SOURCE_JITTER_US	6000	///< Arrival of the frames, uniform
+#define OUTPUT_DEVIATION_US	500		///< Maximum deviation of the output frame interval
+
+/*
+ * A timecode source with jitter, on the simulated time.
+ * The frames drive the PLL; the output frames and quarter frames are collected in TStats.
+ */
+
+enum TSourceState {
+	SOURCE_RUNNING,
+	SOURCE_STOPPED,
+	SOURCE_PAUSED
+};
+
+struct TStats {
+	uint32_t nFrames;
+	uint32_t nQuarterFrames;
+	uint32_t nRelocks;
+	uint32_t nSequenceErrors;
+	uint32_t nDeviationMax;
+	uint32_t nTimersMax;
+	struct TLtcTimeCode tLast;
+};
+
+static uint32_t s_nNowUs;
+static struct TLtcTimeCode s_tSource;	///< Next frame of the source
+static struct TLtcTimeCode s_tInput;	///< Last frame received by the PLL
+static uint32_t s_nSourceUs;			///< Next frame time of the source
+static uint32_t s_nArrivalUs;
+static bool s_bArrival;
+
+static bool is_equal(const struct TLtcTimeCode *pA, const struct TLtcTimeCode *pB) {
+	return (pA->nFrames == pB->nFrames) && (pA->nSeconds == pB->nSeconds) && (pA->nMinutes == pB->nMinutes) && (pA->nHours == pB->nHours);
+}
+
+// EBU only, the drop frame count is checked with fixed frames in check_drop_frame
+static void next_ebu(struct TLtcTimeCode *pTimeCode) {
+	if (++pTimeCode->nFrames == 25) {
+		pTimeCode->nFrames = 0;
+		if (++pTimeCode->nSeconds == 60) {
+			pTimeCode->nSeconds = 0;
+			if (++pTimeCode->nMinutes == 60) {
+				pTimeCode->nMinutes = 0;
+				pTimeCode->nHours = (pTimeCode->nHours + 1) % 24;
+			}
+		}
+	}
+}
+
+static void run(TimeCodePll &pll, uint32_t nDurationUs, TSourceState tState, struct TStats *pStats) {
+	const uint32_t nEndUs = s_nNowUs + nDurationUs;
+	uint32_t nPreviousUs = 0;
+
+	memset(pStats, 0, sizeof(struct TStats));
+
+	for (; s_nNowUs != nEndUs; s_nNowUs++) {
+		soft_timer_sim_run(s_nNowUs);
+
+		if (s_bArrival && (s_nNowUs == s_nArrivalUs)) {
+			s_bArrival = false;
+			s_tInput = s_tSource;
+
+			pll.Input(&s_tInput, s_nNowUs);
+
+			if (tState == SOURCE_RUNNING) {
+				next_ebu(&s_tSource);
+			}
+		}
+
+		// The source clock keeps running, a stopped source does not send
+		if (s_nNowUs == s_nSourceUs) {
+			s_nSourceUs += SOURCE_PERIOD_US;
+			s_nArrivalUs = s_nNowUs + (uint32_t) (rand() % SOURCE_JITTER_US);
+			s_bArrival = (tState != SOURCE_STOPPED);
+		}
+
+		if (pll.IsMidiQuarterFrame()) {
+			pStats->nQuarterFrames++;
+		}
+
+		struct TLtcTimeCode tTimeCode;
+		bool bRelocked;
+
+		if (pll.GetTimeCode(&tTimeCode, bRelocked)) {
+			if (bRelocked) {
+				pStats->nRelocks++;
+			} else if (pStats->nFrames != 0) {
+				struct TLtcTimeCode tNext = pStats->tLast;
+				next_ebu(&tNext);
+
+				if (!is_equal(&tTimeCode, &tNext) && !is_equal(&tTimeCode, &s_tInput)) {
+					pStats->nSequenceErrors++;
+				}
+
+				const uint32_t nDeviation = (uint32_t) abs((int32_t) (s_nNowUs - nPreviousUs) - SOURCE_PERIOD_US);
+
+				if (nDeviation > pStats->nDeviationMax) {
+					pStats->nDeviationMax = nDeviation;
+				}
+			}
+
+			pStats->nFrames++;
+			pStats->tLast = tTimeCode;
+			nPreviousUs = s_nNowUs;
+		}
+
+		if (soft_timer_sim_active() > pStats->nTimersMax) {
+			pStats->nTimersMax = soft_timer_sim_active();
+		}
+	}
+}
+
+static void print(const char *pName, const struct TStats *pStats, const TimeCodePll &pll) {
+	printf("%-10s: frames %u, quarter frames %u, relocks %u, sequence errors %u, deviation max %u us, locked %s, output %.2d:%.2d:%.2d.%.2d\n", pName,
+			(unsigned) pStats->nFrames, (unsigned) pStats->nQuarterFrames, (unsigned) pStats->nRelocks,
+			(unsigned) pStats->nSequenceErrors, (unsigned) pStats->nDeviationMax, pll.IsLocked() ? "Yes" : "No",
+			pStats->tLast.nHours, pStats->tLast.nMinutes, pStats->tLast.nSeconds, pStats->tLast.nFrames);
+}
+
+static int check(bool bCondition, const char *pMessage) {
+	if (!bCondition) {
+		printf(" FAILED : %s\n", pMessage);
+		return 1;
+	}
+
+	return 0;
+}
+
+static int check_jitter(TimeCodePll &pll) {
+	struct TStats tStats;
+	int nErrors = 0;
+
+	run(pll, 3000000, SOURCE_RUNNING, &tStats);
+	print("Lock", &tStats, pll);
+
+	nErrors += check(pll.IsLocked(), "not locked");
+	nErrors += check(tStats.nRelocks == 1, "more than one lock");
+
+	run(pll, 8000000, SOURCE_RUNNING, &tStats);
+	print("Jitter", &tStats, pll);
+
+	nErrors += check(tStats.nRelocks == 0, "relocked on jitter");
+	nErrors += check(tStats.nSequenceErrors == 0, "output frames out of sequence");
+	nErrors += check(tStats.nDeviationMax <= OUTPUT_DEVIATION_US, "output frame interval deviation");
+	nErrors += check(abs((int32_t) tStats.nQuarterFrames - (int32_t) (4 * tStats.nFrames)) <= 4, "not 4 quarter frames per frame");
+	nErrors += check(tStats.nTimersMax == 1, "more than one timer");
+
+	return nErrors;
+}
+
+static int check_freewheel(TimeCodePll &pll) {
+	struct TStats tStats;
+	int nErrors = 0;
+
+	run(pll, 2000000, SOURCE_STOPPED, &tStats);
+	print("Freewheel", &tStats, pll);
+
+	struct TLtcTimeCode tExpected = s_tInput;
+
+	for (uint32_t i = 0; i < FREEWHEEL_FRAMES; i++) {
+		next_ebu(&tExpected);
+	}
+
+	nErrors += check(is_equal(&tStats.tLast, &tExpected), "not freewheeling for the freewheel frames");
+	nErrors += check(tStats.nSequenceErrors == 0, "freewheel frames out of sequence");
+	nErrors += check(!pll.IsLocked(), "still locked");
+	nErrors += check(tStats.nTimersMax <= 1, "more than one timer");
+	nErrors += check(soft_timer_sim_active() == 0, "timer running when unlocked");
+
+	return nErrors;
+}
+
+static int check_pause(TimeCodePll &pll) {
+	struct TStats tStats;
+	int nErrors = 0;
+
+	run(pll, 1000000, SOURCE_PAUSED, &tStats);
+	print("Pause", &tStats, pll);
+
+	nErrors += check(pll.IsLocked(), "not locked");
+	nErrors += check(tStats.nRelocks == 1, "no relock");
+	nErrors += check(tStats.nFrames <= 3, "output does not hold");
+	nErrors += check(is_equal(&tStats.tLast, &s_tInput), "output is not the paused frame");
+
+	run(pll, 2000000, SOURCE_RUNNING, &tStats);
+	print("Resume", &tStats, pll);
+
+	nErrors += check(pll.IsLocked(), "not locked");
+	nErrors += check(tStats.nRelocks == 1, "no relock");
+	nErrors += check(tStats.nSequenceErrors == 0, "output frames out of sequence");
+
+	return nErrors;
+}
+
+/*
+ * Drop frame: frames 0 and 1 are skipped at the start of each minute, except for every tenth minute.
+ */
+static int check_drop_frame(void) {
+	static const struct TLtcTimeCode s_Input[] = {
+		{ 29, 59, 0, 1, TC_TYPE_DF },
+		{ 29, 59, 9, 1, TC_TYPE_DF }
+	};
+	static const struct TLtcTimeCode s_Expected[] = {
+		{ 2, 0, 1, 1, TC_TYPE_DF },
+		{ 0, 0, 10, 1, TC_TYPE_DF }
+	};
+	int nErrors = 0;
+
+	for (uint32_t i = 0; i < sizeof(s_Input) / sizeof(s_Input[0]); i++) {
+		TimeCodePll pll;
+		struct TLtcTimeCode tTimeCode;
+		bool bRelocked;
+		uint32_t nFrames = 0;
+
+		pll.Input(&s_Input[i], s_nNowUs);
+
+		while (nFrames < 2) {
+			soft_timer_sim_run(++s_nNowUs);
+
+			if (pll.GetTimeCode(&tTimeCode, bRelocked)) {
+				nFrames++;
+			}
+		}
+
+		printf("Drop frame: %.2d:%.2d:%.2d.%.2d -> %.2d:%.2d:%.2d.%.2d\n",
+				s_Input[i].nHours, s_Input[i].nMinutes, s_Input[i].nSeconds, s_Input[i].nFrames,
+				tTimeCode.nHours, tTimeCode.nMinutes, tTimeCode.nSeconds, tTimeCode.nFrames);
+
+		nErrors += check(is_equal(&tTimeCode, &s_Expected[i]), "drop frame count");
+	}
+
+	return nErrors;
+}
+
+int main(int argc, char **argv) {
+	int nErrors = 0;
+
+	srand(1);
+
+	s_tSource.nHours = 1;
+	s_tSource.nType = TC_TYPE_EBU;
+	s_nSourceUs = 1000;
+
+	{
+		TimeCodePll pll;
+
+		pll.SetFreewheelFrames(FREEWHEEL_FRAMES);
+
+		nErrors += check_jitter(pll);
+		nErrors += check_freewheel(pll);
+		nErrors += check_pause(pll);
+
+		pll.Print();
+	}
+
+	nErrors += check_drop_frame();
+
+	if (nErrors != 0) {
+		printf("TimeCodePll : %d checks failed\n", nErrors);
+		return -1;
+	}
+
+	printf("TimeCodePll : all checks passed\n");
+
+	return 0;
+}
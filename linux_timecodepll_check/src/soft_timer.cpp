@@ -0,0 +1,86 @@
+/**
+ * @file soft_timer.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "soft_timer.h"
+#include "softtimersim.h"
+
+#include "h3.h"
+
+struct T_H3_TIMER h3_timer;
+
+struct TSoftTimer {
+	thunk_soft_timer_t func;
+	uint32_t nDeadline;
+};
+
+static struct TSoftTimer s_Timers[SOFT_TIMER_MAX];
+
+int32_t soft_timer_oneshot(thunk_soft_timer_t func, uint32_t delay_us, uint32_t slack_us) {
+	for (int32_t i = 0; i < SOFT_TIMER_MAX; i++) {
+		if (s_Timers[i].func == 0) {
+			s_Timers[i].func = func;
+			s_Timers[i].nDeadline = h3_timer.AVS_CNT1 + delay_us;
+			return i;
+		}
+	}
+
+	return -1;
+}
+
+void soft_timer_cancel(int32_t id) {
+	if ((id >= 0) && (id < SOFT_TIMER_MAX)) {
+		s_Timers[id].func = 0;
+	}
+}
+
+void soft_timer_sim_run(uint32_t nNowUs) {
+	h3_timer.AVS_CNT1 = nNowUs;
+
+	for (int32_t i = 0; i < SOFT_TIMER_MAX; i++) {
+		if ((s_Timers[i].func != 0) && ((int32_t) (nNowUs - s_Timers[i].nDeadline) >= 0)) {
+			const thunk_soft_timer_t func = s_Timers[i].func;
+
+			// A one-shot timer is released when it expires
+			s_Timers[i].func = 0;
+			func(nNowUs);
+		}
+	}
+}
+
+uint32_t soft_timer_sim_active(void) {
+	uint32_t nActive = 0;
+
+	for (int32_t i = 0; i < SOFT_TIMER_MAX; i++) {
+		if (s_Timers[i].func != 0) {
+			nActive++;
+		}
+	}
+
+	return nActive;
+}
@@ -0,0 +1,55 @@
+/**
+ * @file ft245rlsim.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef FT245RLSIM_H_
+#define FT245RLSIM_H_
+
+#include <stdint.h>
+
+/*
+ * Host stand-in for the FT245RL: the receive FIFO is a buffer that is handed out in chunks,
+ * the transmitted blocks are recorded.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A read returns at most max_chunk bytes, as when only part of a message is in the FT245 FIFO.
+ */
+extern void ft245rl_sim_set_rx(const uint8_t *data, uint32_t length);
+extern void ft245rl_sim_set_max_chunk(uint32_t max_chunk);
+extern uint32_t ft245rl_sim_get_rx_available(void);
+
+extern const uint8_t *ft245rl_sim_get_tx(uint32_t *length, uint32_t *blocks);
+extern void ft245rl_sim_clear_tx(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* FT245RLSIM_H_ */
@@ -0,0 +1,91 @@
+/**
+ * @file ft245rl.c
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdint.h>
+#include <string.h>
+
+#include "ft245rl.h"
+#include "ft245rlsim.h"
+
+#define TX_BUFFER_SIZE	2048
+
+static const uint8_t *rx_data;
+static uint32_t rx_length;
+static uint32_t rx_max_chunk = 1;
+
+static uint8_t tx_buffer[TX_BUFFER_SIZE];
+static uint32_t tx_length;
+static uint32_t tx_blocks;
+
+void ft245rl_sim_set_rx(const uint8_t *data, uint32_t length) {
+	rx_data = data;
+	rx_length = length;
+}
+
+void ft245rl_sim_set_max_chunk(uint32_t max_chunk) {
+	rx_max_chunk = max_chunk;
+}
+
+uint32_t ft245rl_sim_get_rx_available(void) {
+	return rx_length;
+}
+
+const uint8_t *ft245rl_sim_get_tx(uint32_t *length, uint32_t *blocks) {
+	*length = tx_length;
+	*blocks = tx_blocks;
+	return tx_buffer;
+}
+
+void ft245rl_sim_clear_tx(void) {
+	tx_length = 0;
+	tx_blocks = 0;
+}
+
+uint32_t FT245RL_read_block(uint8_t *data, uint32_t max_length) {
+	uint32_t length = rx_length < max_length ? rx_length : max_length;
+
+	if (length > rx_max_chunk) {
+		length = rx_max_chunk;
+	}
+
+	memcpy(data, rx_data, length);
+
+	rx_data += length;
+	rx_length -= length;
+
+	return length;
+}
+
+void FT245RL_write_block(const uint8_t *data, uint32_t length) {
+	if (length > (TX_BUFFER_SIZE - tx_length)) {
+		length = TX_BUFFER_SIZE - tx_length;
+	}
+
+	memcpy(&tx_buffer[tx_length], data, length);
+
+	tx_length += length;
+	tx_blocks++;
+}
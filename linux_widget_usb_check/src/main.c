@@ -0,0 +1,232 @@
+/**
+ * @file main.c
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "widget.h"
+#include "widget_usb.h"
+
+#include "ft245rlsim.h"
+
+#define MESSAGES		300
+#define STREAM_SIZE		(MESSAGES * (WIDGET_USB_DATA_MAX + 32))
+#define GUARD_SIZE		16
+#define GUARD_BYTE		0xA5
+
+/*
+ * A stream of widget messages, with bytes in between, too long messages and messages without end code.
+ * Only the valid messages must be received, whatever the chunks the FT245 FIFO hands out.
+ */
+
+typedef enum {
+	MESSAGE_VALID,
+	MESSAGE_TOO_LONG,
+	MESSAGE_NO_END_CODE
+} _message_type;
+
+struct _expected {
+	uint8_t label;
+	uint16_t length;
+	uint32_t offset;	///< Data in stream
+};
+
+static uint8_t stream[STREAM_SIZE];
+static uint32_t stream_length;
+static struct _expected expected[MESSAGES];
+static uint32_t expected_count;
+
+static uint8_t data[WIDGET_USB_DATA_MAX + GUARD_SIZE];
+
+static void build_stream(void) {
+	uint32_t i, j;
+
+	stream_length = 0;
+	expected_count = 0;
+
+	for (i = 0; i < MESSAGES; i++) {
+		const _message_type type = (i % 17 == 5) ? MESSAGE_TOO_LONG : ((i % 13 == 7) ? MESSAGE_NO_END_CODE : MESSAGE_VALID);
+		const uint16_t length = (type == MESSAGE_TOO_LONG) ? (WIDGET_USB_DATA_MAX + 1 + (i % 7)) : (uint16_t) ((i * 37) % (WIDGET_USB_DATA_MAX + 1));
+		const uint8_t label = (uint8_t) (i % 11);
+
+		// Bytes in between messages are skipped, until the start code
+		for (j = 0; j < (i % 3); j++) {
+			stream[stream_length++] = 0x11;
+		}
+
+		stream[stream_length++] = AMF_START_CODE;
+		stream[stream_length++] = label;
+		stream[stream_length++] = (uint8_t) (length & 0xFF);
+		stream[stream_length++] = (uint8_t) (length >> 8);
+
+		if (type == MESSAGE_VALID) {
+			expected[expected_count].label = label;
+			expected[expected_count].length = length;
+			expected[expected_count].offset = stream_length;
+			expected_count++;
+		}
+
+		// The data contains start and end codes
+		for (j = 0; j < length; j++) {
+			stream[stream_length++] = (uint8_t) (i + j);
+		}
+
+		stream[stream_length++] = (type == MESSAGE_NO_END_CODE) ? 0x00 : AMF_END_CODE;
+	}
+}
+
+static int receive(uint32_t max_chunk) {
+	uint32_t received = 0;
+	uint32_t calls = 0;
+	int errors = 0;
+	uint8_t label;
+	uint16_t length;
+
+	srand(max_chunk);
+
+	ft245rl_sim_set_rx(stream, stream_length);
+	memset(data, GUARD_BYTE, sizeof(data));
+
+	for (;;) {
+		ft245rl_sim_set_max_chunk(max_chunk == 0 ? (uint32_t) (1 + rand() % 700) : max_chunk);
+		calls++;
+
+		if (widget_usb_read_message(&label, data, WIDGET_USB_DATA_MAX, &length)) {
+			if (received == expected_count) {
+				printf(" message %u : not expected\n", (unsigned) received);
+				errors++;
+			} else if ((label != expected[received].label) || (length != expected[received].length)
+					|| (memcmp(data, &stream[expected[received].offset], length) != 0)) {
+				printf(" message %u : label %u length %u, expected label %u length %u\n", (unsigned) received,
+						(unsigned) label, (unsigned) length, (unsigned) expected[received].label, (unsigned) expected[received].length);
+				errors++;
+			}
+
+			received++;
+		} else if (ft245rl_sim_get_rx_available() == 0) {
+			break;
+		}
+	}
+
+	for (length = WIDGET_USB_DATA_MAX; length < sizeof(data); length++) {
+		if (data[length] != GUARD_BYTE) {
+			printf(" data written past max_length\n");
+			errors++;
+			break;
+		}
+	}
+
+	if (received != expected_count) {
+		printf(" received %u messages, expected %u\n", (unsigned) received, (unsigned) expected_count);
+		errors++;
+	}
+
+	printf("Receive : chunks of %s%u bytes, %u calls, %u messages%s\n", max_chunk == 0 ? "1 - " : "",
+			max_chunk == 0 ? 700 : (unsigned) max_chunk, (unsigned) calls, (unsigned) received, errors == 0 ? "" : " FAILED");
+
+	return errors;
+}
+
+static int send(void) {
+	const uint8_t *tx;
+	uint32_t tx_length, tx_blocks, i;
+	int errors = 0;
+
+	for (i = 0; i < WIDGET_USB_DATA_MAX; i++) {
+		data[i] = (uint8_t) i;
+	}
+
+	ft245rl_sim_clear_tx();
+	widget_usb_send_message(6, data, 513);
+
+	tx = ft245rl_sim_get_tx(&tx_length, &tx_blocks);
+
+	if ((tx_blocks != 1) || (tx_length != 4 + 513 + 1) || (tx[0] != AMF_START_CODE) || (tx[1] != 6) || (tx[2] != (513 & 0xFF)) || (tx[3] != (513 >> 8))
+			|| (memcmp(&tx[4], data, 513) != 0) || (tx[4 + 513] != AMF_END_CODE)) {
+		printf(" send message : %u blocks, %u bytes\n", (unsigned) tx_blocks, (unsigned) tx_length);
+		errors++;
+	}
+
+	// The status byte and the data are sent as one block with the header and the footer
+	ft245rl_sim_clear_tx();
+	widget_usb_send_header(5, 1 + 4);
+	widget_usb_send_byte(0);
+	widget_usb_send_data(data, 4);
+	widget_usb_send_footer();
+
+	tx = ft245rl_sim_get_tx(&tx_length, &tx_blocks);
+
+	if ((tx_blocks != 1) || (tx_length != 4 + 1 + 4 + 1) || (tx[4] != 0) || (memcmp(&tx[5], data, 4) != 0) || (tx[9] != AMF_END_CODE)) {
+		printf(" send header, byte, data, footer : %u blocks, %u bytes\n", (unsigned) tx_blocks, (unsigned) tx_length);
+		errors++;
+	}
+
+	// Data beyond the buffer is cut, the end code is still sent
+	ft245rl_sim_clear_tx();
+	widget_usb_send_header(6, WIDGET_USB_DATA_MAX);
+	widget_usb_send_data(data, WIDGET_USB_DATA_MAX);
+	widget_usb_send_data(data, 8);
+	widget_usb_send_footer();
+
+	tx = ft245rl_sim_get_tx(&tx_length, &tx_blocks);
+
+	if ((tx_blocks != 1) || (tx_length != 4 + WIDGET_USB_DATA_MAX + 1) || (tx[tx_length - 1] != AMF_END_CODE)) {
+		printf(" send past the buffer : %u blocks, %u bytes\n", (unsigned) tx_blocks, (unsigned) tx_length);
+		errors++;
+	}
+
+	printf("Send : %s\n", errors == 0 ? "one block per message" : "FAILED");
+
+	return errors;
+}
+
+int main(int argc, char **argv) {
+	static const uint32_t chunks[] = { 1, 7, 64, 256, 1024, 4096, 0 };
+	uint32_t i;
+	int errors = 0;
+
+	build_stream();
+
+	printf("Stream : %u bytes, %u messages, %u valid\n", (unsigned) stream_length, MESSAGES, (unsigned) expected_count);
+
+	for (i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++) {
+		errors += receive(chunks[i]);
+	}
+
+	errors += send();
+
+	if (errors != 0) {
+		printf("widget_usb : %d checks failed\n", errors);
+		return -1;
+	}
+
+	printf("widget_usb : all checks passed\n");
+
+	return 0;
+}
@@ -0,0 +1,272 @@
+/**
+ * @file main.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "ws28xx.h"
+
+#define ITERATIONS		20000
+#define UNIVERSE_RGB	170
+#define UNIVERSE_RGBW	128
+
+extern uint8_t *g_pSpiFrame;
+extern uint32_t g_nSpiFrameSize;
+
+/*
+ * The encoder as it was in ws28xxcommon.cpp, before the lookup table.
+ * It writes into a copy of the blackout frame.
+ */
+class Reference {
+public:
+	Reference(TWS28XXType tType, uint8_t nHighCode, uint32_t nSize): m_tType(tType), m_nHighCode(nHighCode) {
+		m_pBuffer = new uint8_t[nSize];
+		memcpy(m_pBuffer, g_pSpiFrame, nSize);
+	}
+
+	~Reference(void) {
+		delete [] m_pBuffer;
+	}
+
+	uint8_t *GetBuffer(void) {
+		return m_pBuffer;
+	}
+
+	void __attribute__ ((noinline)) SetLED(uint32_t nLEDIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue) {
+		if (m_tType == APA102) {
+			uint32_t nOffset = 4 + (nLEDIndex * 4);
+			m_pBuffer[nOffset] = 0xFF;
+			m_pBuffer[nOffset + 1] = nRed;
+			m_pBuffer[nOffset + 2] = nGreen;
+			m_pBuffer[nOffset + 3] = nBlue;
+		} else if (m_tType == WS2801) {
+			uint32_t nOffset = nLEDIndex * 3;
+			m_pBuffer[nOffset] = nRed;
+			m_pBuffer[nOffset + 1] = nGreen;
+			m_pBuffer[nOffset + 2] = nBlue;
+		} else if ((m_tType == WS2811) || (m_tType == UCS2903)) {
+			uint32_t nOffset = nLEDIndex * 3 * 8;
+			SetColorWS28xx(nOffset, nRed);
+			SetColorWS28xx(nOffset + 8, nGreen);
+			SetColorWS28xx(nOffset + 16, nBlue);
+		} else if (m_tType == UCS1903) {
+			uint32_t nOffset = nLEDIndex * 3 * 8;
+			SetColorWS28xx(nOffset, nBlue);
+			SetColorWS28xx(nOffset + 8, nRed);
+			SetColorWS28xx(nOffset + 16, nGreen);
+		} else {
+			uint32_t nOffset = nLEDIndex * 3 * 8;
+			SetColorWS28xx(nOffset, nGreen);
+			SetColorWS28xx(nOffset + 8, nRed);
+			SetColorWS28xx(nOffset + 16, nBlue);
+		}
+	}
+
+	void __attribute__ ((noinline)) SetLED(uint32_t nLEDIndex, uint8_t nRed, uint8_t nGreen, uint8_t nBlue, uint8_t nWhite) {
+		uint32_t nOffset = nLEDIndex * 4 * 8;
+		SetColorWS28xx(nOffset, nGreen);
+		SetColorWS28xx(nOffset + 8, nRed);
+		SetColorWS28xx(nOffset + 16, nBlue);
+		SetColorWS28xx(nOffset + 24, nWhite);
+	}
+
+private:
+	void SetColorWS28xx(uint32_t nOffset, uint8_t nValue) {
+		for (uint8_t mask = 0x80; mask != 0; mask >>= 1) {
+			if (nValue & mask) {
+				m_pBuffer[nOffset] = m_nHighCode;
+			} else {
+				m_pBuffer[nOffset] = 0xC0;
+			}
+			nOffset++;
+		}
+	}
+
+private:
+	TWS28XXType m_tType;
+	uint8_t m_nHighCode;
+	uint8_t *m_pBuffer;
+};
+
+static const TWS28XXType s_Types[] = { WS2801, WS2811, WS2812, WS2812B, WS2813, WS2815, SK6812, SK6812W, APA102, UCS1903, UCS2903 };
+
+static uint8_t s_Data[UNIVERSE_RGB * 4];
+
+static uint64_t micros(void) {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+static void fill(uint8_t *p, uint32_t nLength) {
+	for (uint32_t i = 0; i < nLength; i++) {
+		p[i] = (uint8_t) rand();
+	}
+}
+
+static uint8_t high_code(TWS28XXType tType) {
+	return tType == WS2812B ? 0xF8 : (((tType == UCS1903) || (tType == UCS2903)) ? 0xFC : 0xF0);
+}
+
+static void reference_set(Reference& ref, TWS28XXType tType, uint32_t nLEDIndex, const uint8_t *pData, uint32_t nLEDCount) {
+	for (uint32_t i = 0; i < nLEDCount; i++) {
+		if (tType == SK6812W) {
+			ref.SetLED(nLEDIndex + i, pData[0], pData[1], pData[2], pData[3]);
+			pData += 4;
+		} else {
+			ref.SetLED(nLEDIndex + i, pData[0], pData[1], pData[2]);
+			pData += 3;
+		}
+	}
+}
+
+static bool compare(const char *pName, TWS28XXType tType, Reference& ref, WS28xx& ws28xx) {
+	ws28xx.Update();
+
+	if (memcmp(ref.GetBuffer(), g_pSpiFrame, g_nSpiFrameSize) != 0) {
+		printf("%s mismatch, type %d\n", pName, tType);
+		return false;
+	}
+
+	return true;
+}
+
+static int verify(void) {
+	const uint32_t nLEDCount = 64;
+	int nErrors = 0;
+
+	for (uint32_t t = 0; t < sizeof(s_Types) / sizeof(s_Types[0]); t++) {
+		const TWS28XXType tType = s_Types[t];
+		const uint32_t nChannels = tType == SK6812W ? 4 : 3;
+
+		WS28xx ws28xx(tType, nLEDCount);
+		Reference ref(tType, high_code(tType), g_nSpiFrameSize);
+
+		for (uint32_t nRun = 0; nRun < 256; nRun++) {
+			fill(s_Data, nLEDCount * nChannels);
+
+			// Every colour byte value is seen
+			s_Data[0] = (uint8_t) nRun;
+
+			const uint32_t nIndex = (uint32_t) rand() % nLEDCount;
+			const uint32_t nCount = (uint32_t) rand() % (nLEDCount - nIndex + 1);
+
+			reference_set(ref, tType, nIndex, s_Data, nCount);
+
+			ws28xx.SetLEDs(nIndex, s_Data, nCount);
+			nErrors += compare("SetLEDs", tType, ref, ws28xx) ? 0 : 1;
+
+			fill(s_Data, nChannels);
+			reference_set(ref, tType, nIndex, s_Data, 1);
+
+			if (tType == SK6812W) {
+				ws28xx.SetLED(nIndex, s_Data[0], s_Data[1], s_Data[2], s_Data[3]);
+			} else {
+				ws28xx.SetLED(nIndex, s_Data[0], s_Data[1], s_Data[2]);
+			}
+			nErrors += compare("SetLED", tType, ref, ws28xx) ? 0 : 1;
+
+			for (uint32_t i = 0; i < nCount; i++) {
+				reference_set(ref, tType, nIndex + i, s_Data, 1);
+			}
+
+			ws28xx.FillLEDs(nIndex, s_Data, nCount);
+			nErrors += compare("FillLEDs", tType, ref, ws28xx) ? 0 : 1;
+		}
+	}
+
+	return nErrors;
+}
+
+static void report(const char *pName, uint64_t nLoop, uint64_t nLookup) {
+	printf("%-18s bit loop %7.1f ns  lookup table %7.1f ns  speedup %.1fx\n", pName,
+			(double) nLoop * 1000 / ITERATIONS, (double) nLookup * 1000 / ITERATIONS,
+			nLookup == 0 ? 0 : (double) nLoop / (double) nLookup);
+}
+
+static int benchmark(const char *pName, TWS28XXType tType, uint32_t nLEDCount) {
+	WS28xx ws28xx(tType, nLEDCount);
+	Reference ref(tType, high_code(tType), g_nSpiFrameSize);
+	uint64_t nStart;
+
+	fill(s_Data, sizeof(s_Data));
+
+	// As in WS28xxDmx::SetData, before and after
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		s_Data[0] = (uint8_t) i;
+		reference_set(ref, tType, 0, s_Data, nLEDCount);
+	}
+	const uint64_t nLoop = micros() - nStart;
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		s_Data[0] = (uint8_t) i;
+		ws28xx.SetLEDs(0, s_Data, nLEDCount);
+	}
+	const uint64_t nLookup = micros() - nStart;
+
+	report(pName, nLoop, nLookup);
+
+	// As in WS28xxDmxGrouping::SetData, before and after
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		s_Data[0] = (uint8_t) i;
+		for (uint32_t j = 0; j < nLEDCount; j++) {
+			reference_set(ref, tType, j, s_Data, 1);
+		}
+	}
+	const uint64_t nFillLoop = micros() - nStart;
+
+	nStart = micros();
+	for (uint32_t i = 0; i < ITERATIONS; i++) {
+		s_Data[0] = (uint8_t) i;
+		ws28xx.FillLEDs(0, s_Data, nLEDCount);
+	}
+	const uint64_t nFillLookup = micros() - nStart;
+
+	report("  grouping", nFillLoop, nFillLookup);
+
+	return compare("Benchmark", tType, ref, ws28xx) ? 0 : 1;
+}
+
+int main(int argc, char **argv) {
+	srand(1);
+
+	int nErrors = verify();
+
+	printf("Verify : %s\n", nErrors == 0 ? "bit loop and lookup table frames are identical" : "FAILED");
+
+	printf("%d iterations, one universe\n", ITERATIONS);
+
+	nErrors += benchmark("WS2812B 170 RGB", WS2812B, UNIVERSE_RGB);
+	nErrors += benchmark("SK6812W 128 RGBW", SK6812W, UNIVERSE_RGBW);
+
+	return nErrors == 0 ? 0 : -1;
+}
@@ -96,6 +96,8 @@ void notmain(void) {
 
 		(void) dmxreceiver.Run(nLength);
 
+		dmxmonitor.Run();
+
 		const uint32_t nMicrosNow = hw.Micros();
 
 		if (nMicrosNow - nMicrosPrevious > (uint32_t) (1E6 / 2)) {
@@ -137,6 +137,7 @@ void notmain(void) {
 		hw.WatchdogFeed();
 		nw.Run();
 		node.Run();
+		monitor.Run();
 		lb.Run();
 		display.Run();
 	}
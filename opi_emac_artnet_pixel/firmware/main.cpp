@@ -56,6 +56,11 @@
 #include "tlc59711dmxparams.h"
 #include "tlc59711dmx.h"
 #include "storetlc59711.h"
+#if defined (ARM_ALLOW_MULTI_CORE)
+// Output on core 1
+# include "lightsetsmp.h"
+# include "arm/smp.h"
+#endif
 
 #include "spiflashinstall.h"
 #include "spiflashstore.h"
@@ -187,7 +192,23 @@ void notmain(void) {
 		}
 	}
 
+#if defined (ARM_ALLOW_MULTI_CORE)
+	// The output is created here, so core 1 does not use the heap
+	pSpi->Start(0);
+	pSpi->Stop(0);
+
+	// Core 0 runs the network, core 1 the pixel output. When core 1 does not start, all runs on core 0.
+	LightSetSmp lightSetSmp(pSpi);
+
+	if (smp_start_core(1, smp_run_queue)) {
+		node.SetOutput(&lightSetSmp);
+	} else {
+		console_error("Core 1 did not start\n");
+		node.SetOutput(pSpi);
+	}
+#else
 	node.SetOutput(pSpi);
+#endif
 	node.Print();
 
 	pSpi->Print();
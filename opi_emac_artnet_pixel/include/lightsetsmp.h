@@ -0,0 +1,81 @@
+/**
+ * @file lightsetsmp.h
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#ifndef LIGHTSETSMP_H_
+#define LIGHTSETSMP_H_
+
+#include <stdint.h>
+
+#include "lightset.h"
+
+#include "arm/smp.h"
+#include "arm/spsc.h"
+
+#define LIGHTSET_SMP_FRAMES		SMP_RUN_QUEUE_SIZE	///< Frames in flight, never more than the run queue can hold
+
+struct TLightSetSmpFrame;
+
+/*
+ * Runs the output LightSet on a secondary core. The network stays on core 0.
+ * The calls are queued in order with smp_queue_work. The frame buffers go back to core 0 through an spsc queue.
+ * The RDM calls are queued as well, core 0 waits for their result.
+ */
+class LightSetSmp: public LightSet {
+public:
+	LightSetSmp(LightSet *pLightSet, uint32_t nCoreNumber = 1);
+	~LightSetSmp(void);
+
+	void Start(uint8_t nPort);
+	void Stop(uint8_t nPort);
+
+	void SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength);
+
+	void Print(void);
+
+public: // RDM Optional
+	bool SetDmxStartAddress(uint16_t nDmxStartAddress);
+	uint16_t GetDmxStartAddress(void);
+
+	uint16_t GetDmxFootprint(void);
+
+	bool GetSlotInfo(uint16_t nSlotOffset, struct TLightSetSlotInfo &tSlotInfo);
+
+private:
+	struct TLightSetSmpFrame *GetFrame(void);
+	void Queue(struct TLightSetSmpFrame *pFrame);
+	void Call(struct TLightSetSmpFrame *pFrame);
+
+	static void Run(void *p);
+
+private:
+	LightSet *m_pLightSet;
+	uint32_t m_nCoreNumber;
+	struct TLightSetSmpFrame *m_pFrames;
+	struct spsc_queue m_FreeQueue;				///< Producer is the output core, consumer is core 0
+	void *m_pFreeEntries[LIGHTSET_SMP_FRAMES];
+};
+
+#endif /* LIGHTSETSMP_H_ */
@@ -0,0 +1,239 @@
+/**
+ * @file lightsetsmp.cpp
+ *
+ */
+/* Copyright (C) 2019 by Arjan van Vught mailto:info@raspberrypi-dmx.nl
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+
+ * The above copyright notice and this permission notice shall be included in
+ * all copies or substantial portions of the Software.
+
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN
+ * THE SOFTWARE.
+ */
+
+
+#if defined (ARM_ALLOW_MULTI_CORE)
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "lightsetsmp.h"
+#include "lightset.h"
+
+#include "arm/smp.h"
+#include "arm/spsc.h"
+#include "arm/synchronize.h"
+
+enum TLightSetSmpCommand {
+	LIGHTSET_SMP_START,
+	LIGHTSET_SMP_STOP,
+	LIGHTSET_SMP_DATA,
+	LIGHTSET_SMP_SET_DMX_START_ADDRESS,
+	LIGHTSET_SMP_GET_DMX_START_ADDRESS,
+	LIGHTSET_SMP_GET_DMX_FOOTPRINT,
+	LIGHTSET_SMP_GET_SLOT_INFO
+};
+
+struct TLightSetSmpFrame {
+	LightSetSmp *pLightSetSmp;
+	uint8_t nCommand;
+	uint8_t nPort;
+	uint16_t nLength;
+	uint8_t data[DMX_UNIVERSE_SIZE];
+	// RDM calls
+	uint16_t nValue;							///< Argument or result
+	bool bResult;
+	struct TLightSetSlotInfo *pSlotInfo;
+	volatile bool bDone;						///< Set by the output core
+};
+
+LightSetSmp::LightSetSmp(LightSet *pLightSet, uint32_t nCoreNumber):
+	m_pLightSet(pLightSet),
+	m_nCoreNumber(nCoreNumber)
+{
+	assert(m_pLightSet != 0);
+	assert(m_nCoreNumber != 0);
+
+	m_pFrames = new TLightSetSmpFrame[LIGHTSET_SMP_FRAMES];
+	assert(m_pFrames != 0);
+
+	spsc_init(&m_FreeQueue, m_pFreeEntries, LIGHTSET_SMP_FRAMES);
+
+	// Nothing is queued yet, so core 0 can fill the free queue
+	for (uint32_t i = 0; i < LIGHTSET_SMP_FRAMES; i++) {
+		m_pFrames[i].pLightSetSmp = this;
+		spsc_push(&m_FreeQueue, &m_pFrames[i]);
+	}
+}
+
+LightSetSmp::~LightSetSmp(void) {
+	delete [] m_pFrames;
+	m_pFrames = 0;
+}
+
+/*
+ * All frames in flight means the output core is behind. Wait for it, the calls must not get lost.
+ */
+TLightSetSmpFrame *LightSetSmp::GetFrame(void) {
+	TLightSetSmpFrame *pFrame;
+
+	while ((pFrame = (TLightSetSmpFrame *) spsc_pop(&m_FreeQueue)) == 0) {
+		// wait for the output core
+	}
+
+	return pFrame;
+}
+
+void LightSetSmp::Queue(TLightSetSmpFrame *pFrame) {
+	// Cannot fail, there are no more frames than run queue entries
+	const bool isQueued = smp_queue_work(m_nCoreNumber, Run, pFrame);
+	assert(isQueued);
+	(void) isQueued;
+}
+
+/*
+ * Core 0 waits until the output core did run the call, the frame then is back in the free queue.
+ * Core 0 is the only consumer of the free queue, the results can still be read.
+ */
+void LightSetSmp::Call(TLightSetSmpFrame *pFrame) {
+	pFrame->bDone = false;
+
+	Queue(pFrame);
+
+	while (!pFrame->bDone) {
+		// wait for the output core
+	}
+
+	dmb();	// The results are read after bDone
+}
+
+/*
+ * Output core
+ */
+void LightSetSmp::Run(void *p) {
+	TLightSetSmpFrame *pFrame = (TLightSetSmpFrame *) p;
+	LightSetSmp *pThis = pFrame->pLightSetSmp;
+
+	switch (pFrame->nCommand) {
+	case LIGHTSET_SMP_START:
+		pThis->m_pLightSet->Start(pFrame->nPort);
+		break;
+	case LIGHTSET_SMP_STOP:
+		pThis->m_pLightSet->Stop(pFrame->nPort);
+		break;
+	case LIGHTSET_SMP_DATA:
+		pThis->m_pLightSet->SetData(pFrame->nPort, pFrame->data, pFrame->nLength);
+		break;
+	case LIGHTSET_SMP_SET_DMX_START_ADDRESS:
+		pFrame->bResult = pThis->m_pLightSet->SetDmxStartAddress(pFrame->nValue);
+		break;
+	case LIGHTSET_SMP_GET_DMX_START_ADDRESS:
+		pFrame->nValue = pThis->m_pLightSet->GetDmxStartAddress();
+		break;
+	case LIGHTSET_SMP_GET_DMX_FOOTPRINT:
+		pFrame->nValue = pThis->m_pLightSet->GetDmxFootprint();
+		break;
+	case LIGHTSET_SMP_GET_SLOT_INFO:
+		pFrame->bResult = pThis->m_pLightSet->GetSlotInfo(pFrame->nValue, *pFrame->pSlotInfo);
+		break;
+	default:
+		break;
+	}
+
+	dmb();	// The results are written before bDone
+	pFrame->bDone = true;
+
+	spsc_push(&pThis->m_FreeQueue, pFrame);
+}
+
+void LightSetSmp::Start(uint8_t nPort) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_START;
+	pFrame->nPort = nPort;
+
+	Queue(pFrame);
+}
+
+void LightSetSmp::Stop(uint8_t nPort) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_STOP;
+	pFrame->nPort = nPort;
+
+	Queue(pFrame);
+}
+
+void LightSetSmp::SetData(uint8_t nPort, const uint8_t *pData, uint16_t nLength) {
+	assert(pData != 0);
+	assert(nLength <= DMX_UNIVERSE_SIZE);
+
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_DATA;
+	pFrame->nPort = nPort;
+	pFrame->nLength = nLength;
+	memcpy(pFrame->data, pData, nLength);
+
+	Queue(pFrame);
+}
+
+void LightSetSmp::Print(void) {
+	m_pLightSet->Print();
+}
+
+bool LightSetSmp::SetDmxStartAddress(uint16_t nDmxStartAddress) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_SET_DMX_START_ADDRESS;
+	pFrame->nValue = nDmxStartAddress;
+
+	Call(pFrame);
+
+	return pFrame->bResult;
+}
+
+uint16_t LightSetSmp::GetDmxStartAddress(void) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_GET_DMX_START_ADDRESS;
+
+	Call(pFrame);
+
+	return pFrame->nValue;
+}
+
+uint16_t LightSetSmp::GetDmxFootprint(void) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_GET_DMX_FOOTPRINT;
+
+	Call(pFrame);
+
+	return pFrame->nValue;
+}
+
+bool LightSetSmp::GetSlotInfo(uint16_t nSlotOffset, struct TLightSetSlotInfo &tSlotInfo) {
+	TLightSetSmpFrame *pFrame = GetFrame();
+
+	pFrame->nCommand = LIGHTSET_SMP_GET_SLOT_INFO;
+	pFrame->nValue = nSlotOffset;
+	pFrame->pSlotInfo = &tSlotInfo;
+
+	Call(pFrame);
+
+	return pFrame->bResult;
+}
+#endif
@@ -127,6 +127,7 @@ void notmain(void) {
 		hw.WatchdogFeed();
 		nw.Run();
 		bridge.Run();
+		monitor.Run();
 		lb.Run();
 		display.Run();
 	}
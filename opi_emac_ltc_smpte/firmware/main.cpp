@@ -75,6 +75,9 @@
 #include "h3/tcnetreader.h"
 #include "h3/ltcgenerator.h"
 #include "h3/rtpmidireader.h"
+#include "h3/timecodepll.h"
+
+#include "soft_timer.h"
 
 #include "spiflashinstall.h"
 
@@ -90,6 +93,8 @@
 
 #include "software_version.h"
 
+#define SOFT_TIMER_PRINT_INTERVAL_MILLIS	(60 * 1000)	///< Report the timer statistics once they hold run-time data
+
 extern "C" {
 
 __attribute__((noinline)) static void print_disabled(bool b, const char *p) {
@@ -153,6 +158,9 @@ void notmain(void) {
 	RtpMidi rtpMidi;
 	OSCServer oscServer;
 
+	TimeCodePll timeCodePll;
+	timeCodePll.SetFreewheelFrames(ltcParams.GetFreewheelFrames());
+
 	LtcReader ltcReader(&node, &tLtcDisabledOutputs);
 	MidiReader midiReader(&node, &tLtcDisabledOutputs);
 	ArtNetReader artnetReader(&tLtcDisabledOutputs);
@@ -277,6 +285,10 @@ void notmain(void) {
 	tcnet.Print();
 	ltcGenerator.Print();
 
+	if (source != LTC_READER_SOURCE_INTERNAL) {
+		timeCodePll.Print();
+	}
+
 	RemoteConfig remoteConfig(REMOTE_CONFIG_LTC, REMOTE_CONFIG_MODE_TIMECODE, 1 + source);
 
 	StoreRemoteConfig storeRemoteConfig;
@@ -342,6 +354,8 @@ void notmain(void) {
 
 	hw.WatchdogInit();
 
+	uint32_t nMillisSoftTimerPrint = hw.Millis();
+
 	for (;;) {
 		hw.WatchdogFeed();
 		nw.Run();
@@ -399,6 +413,11 @@ void notmain(void) {
 		}
 
 		lb.Run();
+
+		if ((hw.Millis() - nMillisSoftTimerPrint) >= SOFT_TIMER_PRINT_INTERVAL_MILLIS) {
+			nMillisSoftTimerPrint = hw.Millis();
+			soft_timer_print();
+		}
 	}
 }
 
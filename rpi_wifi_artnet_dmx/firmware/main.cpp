@@ -341,6 +341,9 @@ void notmain(void) {
 		node.Run();
 		if (tOutputType == LIGHTSET_OUTPUT_TYPE_MONITOR) {
 			timesync.ShowSystemTime();
+#ifndef H3
+			monitor.Run();
+#endif
 		}
 		lb.Run();
 #if defined (ORANGE_PI)
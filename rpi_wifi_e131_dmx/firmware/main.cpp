@@ -296,6 +296,9 @@ void notmain(void) {
 	for (;;) {
 		hw.WatchdogFeed();
 		(void) bridge.Run();
+#ifndef H3
+		monitor.Run();
+#endif
 		lb.Run();
 	}
 }
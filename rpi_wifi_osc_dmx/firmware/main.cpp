@@ -277,6 +277,9 @@ void notmain(void) {
 	for (;;) {
 		hw.WatchdogFeed();
 		server.Run();
+#ifndef H3
+		monitor.Run();
+#endif
 		lb.Run();
 	}
 }